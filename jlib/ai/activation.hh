@@ -0,0 +1,269 @@
+/* -*- mode: C++ c-basic-offset: 4  -*-
+ *
+ * Copyright (c) 2026 Joey Yandle <xoloki@gmail.com>
+ *
+ */
+
+#ifndef JLIB_AI_ACTIVATION_HH
+#define JLIB_AI_ACTIVATION_HH
+
+#include <jlib/math/matrix.hh>
+#include <jlib/math/activation.hh>
+
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace jlib {
+namespace ai {
+
+// an activation function and its derivative, looked up by name so that
+// models can record which one each layer uses.  sigmoid, tanh, relu,
+// leaky_relu and softmax are always there; add registers others, or
+// replaces one, and should be done before any network looks it up
+template<typename T>
+struct activation {
+    typedef void (*forward_function)(const math::matrix<T>& x, math::matrix<T>& y);
+    typedef void (*backward_function)(const math::matrix<T>& e, const math::matrix<T>& y, math::matrix<T>& d);
+
+    std::string name;
+    // y = f(x), one sample per column; y may be x
+    forward_function forward;
+    // d = e times the derivative of f where it gave y; d may be e or y
+    backward_function backward;
+
+    static const activation& get(const std::string& name);
+    static void add(const activation& a);
+    static std::vector<std::string> names();
+
+    // the slope of leaky_relu below zero
+    static constexpr double LEAK = 0.01;
+
+protected:
+    struct registry {
+        std::mutex lock;
+        // nodes never move, so what get returns stays good
+        std::map<std::string, activation> entries;
+
+        registry();
+    };
+
+    static registry& instance();
+
+    // apply an elementwise kernel to a, b and out over their storage, which
+    // must share a layout; anything else goes through a copy in out's layout
+    template<typename F>
+    static void elementwise(const math::matrix<T>& a, const math::matrix<T>& b, math::matrix<T>& out, F f);
+
+    static void sigmoid(const math::matrix<T>& x, math::matrix<T>& y);
+    static void tanh(const math::matrix<T>& x, math::matrix<T>& y);
+    static void relu(const math::matrix<T>& x, math::matrix<T>& y);
+    static void leaky_relu(const math::matrix<T>& x, math::matrix<T>& y);
+    static void softmax(const math::matrix<T>& x, math::matrix<T>& y);
+
+    static void sigmoid_backward(const math::matrix<T>& e, const math::matrix<T>& y, math::matrix<T>& d);
+    static void tanh_backward(const math::matrix<T>& e, const math::matrix<T>& y, math::matrix<T>& d);
+    static void relu_backward(const math::matrix<T>& e, const math::matrix<T>& y, math::matrix<T>& d);
+    static void leaky_relu_backward(const math::matrix<T>& e, const math::matrix<T>& y, math::matrix<T>& d);
+    static void softmax_backward(const math::matrix<T>& e, const math::matrix<T>& y, math::matrix<T>& d);
+};
+
+template<typename T>
+constexpr double activation<T>::LEAK;
+
+
+template<typename T>
+activation<T>::registry::registry() {
+    const activation builtin[] = {
+        { "sigmoid", &activation::sigmoid, &activation::sigmoid_backward },
+        { "tanh", &activation::tanh, &activation::tanh_backward },
+        { "relu", &activation::relu, &activation::relu_backward },
+        { "leaky_relu", &activation::leaky_relu, &activation::leaky_relu_backward },
+        { "softmax", &activation::softmax, &activation::softmax_backward },
+    };
+    for(const activation& a : builtin) {
+        entries.insert(std::make_pair(a.name, a));
+    }
+}
+
+template<typename T>
+typename activation<T>::registry& activation<T>::instance() {
+    static registry r;
+    return r;
+}
+
+template<typename T>
+const activation<T>& activation<T>::get(const std::string& name) {
+    registry& r = instance();
+    std::lock_guard<std::mutex> guard(r.lock);
+
+    auto i = r.entries.find(name);
+    if(i == r.entries.end())
+        throw std::runtime_error("unknown activation function: " + name);
+    return i->second;
+}
+
+template<typename T>
+void activation<T>::add(const activation& a) {
+    if(!a.forward || !a.backward)
+        throw std::runtime_error("activation " + a.name + " needs forward and backward functions");
+
+    registry& r = instance();
+    std::lock_guard<std::mutex> guard(r.lock);
+    r.entries[a.name] = a;
+}
+
+template<typename T>
+std::vector<std::string> activation<T>::names() {
+    registry& r = instance();
+    std::lock_guard<std::mutex> guard(r.lock);
+
+    std::vector<std::string> result;
+    for(const auto& e : r.entries) {
+        result.push_back(e.first);
+    }
+    return result;
+}
+
+template<typename T>
+template<typename F>
+void activation<T>::elementwise(const math::matrix<T>& a, const math::matrix<T>& b, math::matrix<T>& out, F f) {
+    if(a.M != out.M || a.N != out.N)
+        throw typename math::matrix<T>::mismatched(a.M, a.N, out.M, out.N);
+    if(b.M != out.M || b.N != out.N)
+        throw typename math::matrix<T>::mismatched(b.M, b.N, out.M, out.N);
+
+    const bool layout = out.is_transposed();
+    if(a.is_transposed() != layout || b.is_transposed() != layout) {
+        auto like = [layout](const math::matrix<T>& m) {
+            if(m.is_transposed() == layout)
+                return m;
+            if(!layout)
+                return math::matrix<T>(math::leaf<T>(m));
+            return math::matrix<T>(math::leaf<T>(m.transpose())).transpose();
+        };
+        elementwise(like(a), like(b), out, f);
+        return;
+    }
+
+    const std::size_t size = std::size_t(out.M) * out.N;
+    const T* pa = a.data();
+    const T* pb = b.data();
+    T* po = out.data();
+    math::parallel_for(size, math::ELEMENTWISE_GRAIN, [&](std::size_t begin, std::size_t end) {
+            f(end - begin, pa + begin, pb + begin, po + begin);
+        }, size);
+}
+
+template<typename T>
+void activation<T>::sigmoid(const math::matrix<T>& x, math::matrix<T>& y) {
+    elementwise(x, x, y, [](std::size_t n, const T* a, const T*, T* out) {
+            math::kernel::activations<T>::sigmoid(n, a, out);
+        });
+}
+
+template<typename T>
+void activation<T>::tanh(const math::matrix<T>& x, math::matrix<T>& y) {
+    elementwise(x, x, y, [](std::size_t n, const T* a, const T*, T* out) {
+            math::kernel::activations<T>::tanh(n, a, out);
+        });
+}
+
+template<typename T>
+void activation<T>::relu(const math::matrix<T>& x, math::matrix<T>& y) {
+    elementwise(x, x, y, [](std::size_t n, const T* a, const T*, T* out) {
+            math::kernel::activations<T>::relu(n, a, out);
+        });
+}
+
+template<typename T>
+void activation<T>::leaky_relu(const math::matrix<T>& x, math::matrix<T>& y) {
+    elementwise(x, x, y, [](std::size_t n, const T* a, const T*, T* out) {
+            math::kernel::activations<T>::leaky_relu(n, T(LEAK), a, out);
+        });
+}
+
+template<typename T>
+void activation<T>::sigmoid_backward(const math::matrix<T>& e, const math::matrix<T>& y, math::matrix<T>& d) {
+    elementwise(e, y, d, [](std::size_t n, const T* a, const T* b, T* out) {
+            math::kernel::activations<T>::sigmoid_backward(n, a, b, out);
+        });
+}
+
+template<typename T>
+void activation<T>::tanh_backward(const math::matrix<T>& e, const math::matrix<T>& y, math::matrix<T>& d) {
+    elementwise(e, y, d, [](std::size_t n, const T* a, const T* b, T* out) {
+            math::kernel::activations<T>::tanh_backward(n, a, b, out);
+        });
+}
+
+template<typename T>
+void activation<T>::relu_backward(const math::matrix<T>& e, const math::matrix<T>& y, math::matrix<T>& d) {
+    elementwise(e, y, d, [](std::size_t n, const T* a, const T* b, T* out) {
+            math::kernel::activations<T>::relu_backward(n, a, b, out);
+        });
+}
+
+template<typename T>
+void activation<T>::leaky_relu_backward(const math::matrix<T>& e, const math::matrix<T>& y, math::matrix<T>& d) {
+    elementwise(e, y, d, [](std::size_t n, const T* a, const T* b, T* out) {
+            math::kernel::activations<T>::leaky_relu_backward(n, T(LEAK), a, b, out);
+        });
+}
+
+template<typename T>
+void activation<T>::softmax(const math::matrix<T>& x, math::matrix<T>& y) {
+    if(x.M != y.M || x.N != y.N)
+        throw typename math::matrix<T>::mismatched(x.M, x.N, y.M, y.N);
+
+    // over each column, so both have to be column-major
+    if(x.is_transposed() || y.is_transposed()) {
+        math::matrix<T> cx{math::leaf<T>(x)};
+        math::matrix<T> cy(x.M, x.N, math::UNINITIALIZED);
+        softmax(cx, cy);
+        math::assign(y, math::leaf<T>(cy));
+        return;
+    }
+
+    const T* px = x.data();
+    T* py = y.data();
+    const std::size_t rows = x.M;
+    const std::size_t cols = std::max<std::size_t>(1, math::ELEMENTWISE_GRAIN / std::max<std::size_t>(rows, 1));
+    math::parallel_for(x.N, cols, [&](std::size_t begin, std::size_t end) {
+            math::kernel::activations<T>::softmax(rows, end - begin, px + begin * rows, py + begin * rows);
+        }, rows * x.N);
+}
+
+template<typename T>
+void activation<T>::softmax_backward(const math::matrix<T>& e, const math::matrix<T>& y, math::matrix<T>& d) {
+    if(e.M != d.M || e.N != d.N)
+        throw typename math::matrix<T>::mismatched(e.M, e.N, d.M, d.N);
+    if(y.M != d.M || y.N != d.N)
+        throw typename math::matrix<T>::mismatched(y.M, y.N, d.M, d.N);
+
+    if(e.is_transposed() || y.is_transposed() || d.is_transposed()) {
+        math::matrix<T> ce{math::leaf<T>(e)};
+        math::matrix<T> cy{math::leaf<T>(y)};
+        math::matrix<T> cd(d.M, d.N, math::UNINITIALIZED);
+        softmax_backward(ce, cy, cd);
+        math::assign(d, math::leaf<T>(cd));
+        return;
+    }
+
+    const T* pe = e.data();
+    const T* py = y.data();
+    T* pd = d.data();
+    const std::size_t rows = d.M;
+    const std::size_t cols = std::max<std::size_t>(1, math::ELEMENTWISE_GRAIN / std::max<std::size_t>(rows, 1));
+    math::parallel_for(d.N, cols, [&](std::size_t begin, std::size_t end) {
+            math::kernel::activations<T>::softmax_backward(rows, end - begin, pe + begin * rows,
+                                                           py + begin * rows, pd + begin * rows);
+        }, rows * d.N);
+}
+
+}
+}
+
+#endif //JLIB_AI_ACTIVATION_HH
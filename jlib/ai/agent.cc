@@ -32,6 +32,18 @@ Agent::Agent()
 Agent::~Agent() {
 }
 
+Action::ptr Agent::choose(const Percept::map& percepts) {
+    return agent(percepts);
+}
+
+Agent::ptr Agent::clone() const {
+    return ptr();
+}
+
+void Agent::seed(random::result_type s) {
+    mRandom.seed(s);
+}
+
 
 }
 }
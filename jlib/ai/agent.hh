@@ -27,6 +27,8 @@
 
 #include <jlib/sys/object.hh>
 
+#include <random>
+
 
 namespace jlib {
 namespace ai {
@@ -35,13 +37,31 @@ class Agent : public sys::Object {
 public:
     typedef Glib::RefPtr<Agent> ptr;
     typedef std::list<ptr> list;
+    typedef std::mt19937_64 random;
 
     Agent();
     virtual ~Agent();
 
     virtual Action::ptr agent(const Percept::map percepts) = 0;
 
+    // what the environment asks each step.  this hands agent() a copy of
+    // the percepts; agents that would rather not copy them override this
+    // too
+    virtual Action::ptr choose(const Percept::map& percepts);
+
+    // a copy with its own state, for an environment cloned onto another
+    // thread.  agents that can't be copied give none
+    virtual ptr clone() const;
+
+    // called by the environment at the start of every episode
+    virtual void seed(random::result_type s);
+
+protected:
+    // for agents that choose at random; seeded per episode
+    random& rng() { return mRandom; }
+
 private:
+    random mRandom;
 };
 
 
@@ -0,0 +1,172 @@
+/* -*- mode: C++ c-basic-offset: 4  -*-
+ *
+ * Copyright (c) 2026 Joey Yandle <xoloki@gmail.com>
+ *
+ */
+
+#ifndef JLIB_AI_BACKEND_HH
+#define JLIB_AI_BACKEND_HH
+
+#include <jlib/math/matrix.hh>
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace jlib {
+namespace ai {
+
+// where a network's matrix products run.  the network keeps its weights
+// and scratch in host matrices and hands them to the backend for every
+// product, so a backend only has to provide the two kernels below; one
+// that needs memory of its own should keep it between calls.
+//
+// backends are looked up by name, and each network gets its own.  "cpu",
+// the blocked simd gemm in math threaded over math::set_threads, is always
+// there and is the default; others, such as "cuda" from libjcuda, add
+// themselves when they are linked in
+template<typename T>
+class backend {
+public:
+    typedef std::shared_ptr<backend> ptr;
+    typedef std::function<ptr()> factory;
+
+    virtual ~backend() {}
+
+    virtual std::string name() const = 0;
+
+    // C = alpha * op(A) * op(B) + beta * C, column-major with leading
+    // dimensions, as math::kernel::gemm
+    virtual void gemm(bool ta, bool tb, unsigned int m, unsigned int n, unsigned int k,
+                      T alpha, const T* a, unsigned int lda, const T* b, unsigned int ldb,
+                      T beta, T* c, unsigned int ldc) = 0;
+
+    // y += alpha * x
+    virtual void axpy(std::size_t n, T alpha, const T* x, T* y) = 0;
+
+    // the same for matrices in either layout, as math::gemm and math::axpy
+    void gemm(T alpha, const math::matrix<T>& a, math::trans opa, const math::matrix<T>& b, math::trans opb,
+              T beta, math::matrix<T>& c);
+    void axpy(T alpha, const math::matrix<T>& x, math::matrix<T>& y);
+
+    static ptr get(const std::string& name);
+    static void add(const std::string& name, factory f);
+    static std::vector<std::string> names();
+
+protected:
+    struct registry {
+        std::mutex lock;
+        std::map<std::string, factory> entries;
+
+        registry();
+    };
+
+    static registry& instance();
+};
+
+// math::kernel::gemm, and an axpy spread over parallel_for
+template<typename T>
+class cpu_backend : public backend<T> {
+public:
+    std::string name() const { return "cpu"; }
+
+    void gemm(bool ta, bool tb, unsigned int m, unsigned int n, unsigned int k,
+              T alpha, const T* a, unsigned int lda, const T* b, unsigned int ldb,
+              T beta, T* c, unsigned int ldc);
+    void axpy(std::size_t n, T alpha, const T* x, T* y);
+
+    using backend<T>::gemm;
+    using backend<T>::axpy;
+};
+
+
+template<typename T>
+backend<T>::registry::registry() {
+    entries["cpu"] = []() { return ptr(new cpu_backend<T>()); };
+}
+
+template<typename T>
+typename backend<T>::registry& backend<T>::instance() {
+    static registry r;
+    return r;
+}
+
+template<typename T>
+typename backend<T>::ptr backend<T>::get(const std::string& name) {
+    factory f;
+    {
+        registry& r = instance();
+        std::lock_guard<std::mutex> guard(r.lock);
+        auto i = r.entries.find(name);
+        if(i == r.entries.end())
+            throw std::runtime_error("unknown compute backend: " + name);
+        f = i->second;
+    }
+    return f();
+}
+
+template<typename T>
+void backend<T>::add(const std::string& name, factory f) {
+    registry& r = instance();
+    std::lock_guard<std::mutex> guard(r.lock);
+    r.entries[name] = f;
+}
+
+template<typename T>
+std::vector<std::string> backend<T>::names() {
+    registry& r = instance();
+    std::lock_guard<std::mutex> guard(r.lock);
+
+    std::vector<std::string> result;
+    for(const auto& e : r.entries) {
+        result.push_back(e.first);
+    }
+    return result;
+}
+
+template<typename T>
+void backend<T>::gemm(T alpha, const math::matrix<T>& a, math::trans opa, const math::matrix<T>& b, math::trans opb,
+                      T beta, math::matrix<T>& c) {
+    math::gemm_layout(alpha, a, opa, b, opb, beta, c,
+                      [this](bool ta, bool tb, uint m, uint n, uint k, T alpha, const T* a, uint lda,
+                             const T* b, uint ldb, T beta, T* c, uint ldc) {
+                          gemm(ta, tb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+                      });
+}
+
+template<typename T>
+void backend<T>::axpy(T alpha, const math::matrix<T>& x, math::matrix<T>& y) {
+    if(x.M != y.M || x.N != y.N)
+        throw typename math::matrix<T>::mismatched(x.M, x.N, y.M, y.N);
+
+    if(x.is_transposed() != y.is_transposed()) {
+        math::axpy(alpha, x, y);
+        return;
+    }
+    axpy(std::size_t(y.M) * y.N, alpha, x.data(), y.data());
+}
+
+template<typename T>
+void cpu_backend<T>::gemm(bool ta, bool tb, unsigned int m, unsigned int n, unsigned int k,
+                          T alpha, const T* a, unsigned int lda, const T* b, unsigned int ldb,
+                          T beta, T* c, unsigned int ldc) {
+    math::kernel::gemm(ta, tb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+}
+
+template<typename T>
+void cpu_backend<T>::axpy(std::size_t n, T alpha, const T* x, T* y) {
+    math::parallel_for(n, math::ELEMENTWISE_GRAIN, [&](std::size_t begin, std::size_t end) {
+            for(std::size_t i = begin; i < end; i++) {
+                y[i] += alpha * x[i];
+            }
+        }, n);
+}
+
+}
+}
+
+#endif //JLIB_AI_BACKEND_HH
@@ -0,0 +1,263 @@
+/* -*- mode: C++ c-basic-offset: 4  -*-
+ *
+ * Copyright (c) 2026 Joey Yandle <xoloki@gmail.com>
+ *
+ */
+
+#ifndef JLIB_AI_BATCHER_HH
+#define JLIB_AI_BATCHER_HH
+
+#include <jlib/math/matrix.hh>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace jlib {
+namespace ai {
+
+// dynamic batching for a network's queries.  any number of threads submit
+// one sample at a time; a worker waits until max_batch samples are queued,
+// or the oldest has waited max_wait microseconds, and answers all of them
+// with one batched query, so that under load the cost of each gemm is
+// shared by as many samples as are waiting.  query is only ever called from
+// the worker
+template<typename T>
+class Batcher {
+public:
+    typedef std::function<math::matrix<T>(const math::matrix<T>&)> query_function;
+    typedef std::chrono::steady_clock clock;
+
+    // latencies kept for the percentiles; past this the oldest are replaced
+    static const std::size_t LATENCIES = 1 << 16;
+
+    // what happened since the last report that reset
+    struct stats {
+        std::size_t requests;
+        std::size_t batches;
+        // waiting now, and the most that were waiting when a batch was taken
+        std::size_t queued;
+        std::size_t max_queued;
+        // sizes[i] batches of [2^i, 2^(i+1)) samples
+        std::vector<std::size_t> sizes;
+        // microseconds from submit to answer
+        double p50;
+        double p99;
+    };
+
+    Batcher(uint features, query_function query, uint max_batch = 64, uint max_wait = 500);
+    // answers whatever is still queued
+    ~Batcher();
+
+    // the column of query's output for input, which must have features values
+    std::future<math::matrix<T>> submit(std::vector<T> input);
+
+    stats report(bool reset = true);
+
+protected:
+    struct request {
+        std::vector<T> input;
+        std::promise<math::matrix<T>> answer;
+        clock::time_point when;
+    };
+
+    void run();
+    void answer(std::vector<request>& batch);
+
+    uint m_features;
+    query_function m_query;
+    uint m_max_batch;
+    std::chrono::microseconds m_max_wait;
+
+    std::mutex m_lock;
+    std::condition_variable m_ready;
+    std::deque<request> m_queue;
+    bool m_stop;
+
+    std::mutex m_stats_lock;
+    stats m_stats;
+    std::vector<double> m_latencies;
+    std::size_t m_next;
+
+    std::thread m_worker;
+};
+
+
+template<typename T>
+const std::size_t Batcher<T>::LATENCIES;
+
+
+template<typename T>
+Batcher<T>::Batcher(uint features, query_function query, uint max_batch, uint max_wait)
+    : m_features(features),
+      m_query(query),
+      m_max_batch(std::max(max_batch, 1u)),
+      m_max_wait(max_wait),
+      m_stop(false),
+      m_stats(),
+      m_next(0)
+{
+    m_worker = std::thread([this]() { run(); });
+}
+
+template<typename T>
+Batcher<T>::~Batcher() {
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_stop = true;
+    }
+    m_ready.notify_all();
+    m_worker.join();
+}
+
+template<typename T>
+std::future<math::matrix<T>> Batcher<T>::submit(std::vector<T> input) {
+    if(input.size() != m_features)
+        throw std::runtime_error("expected " + std::to_string(m_features) + " inputs, got " +
+                                 std::to_string(input.size()));
+
+    request r;
+    r.input.swap(input);
+    r.when = clock::now();
+    std::future<math::matrix<T>> ret = r.answer.get_future();
+
+    bool first;
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_queue.push_back(std::move(r));
+        first = (m_queue.size() == 1 || m_queue.size() == m_max_batch);
+    }
+    // the worker only needs waking to start a wait, or to cut one short
+    if(first)
+        m_ready.notify_one();
+
+    return ret;
+}
+
+template<typename T>
+typename Batcher<T>::stats Batcher<T>::report(bool reset) {
+    std::size_t queued;
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        queued = m_queue.size();
+    }
+
+    std::lock_guard<std::mutex> guard(m_stats_lock);
+    stats ret = m_stats;
+    ret.queued = queued;
+
+    std::vector<double>& l = m_latencies;
+    ret.p50 = ret.p99 = 0;
+    if(!l.empty()) {
+        auto at = [&l](double q) {
+            auto i = l.begin() + std::min<std::size_t>(l.size() - 1, std::size_t(q * l.size()));
+            std::nth_element(l.begin(), i, l.end());
+            return *i;
+        };
+        ret.p50 = at(0.50);
+        ret.p99 = at(0.99);
+    }
+
+    if(reset) {
+        m_stats = stats();
+        m_latencies.clear();
+        m_next = 0;
+    }
+    return ret;
+}
+
+template<typename T>
+void Batcher<T>::run() {
+    std::vector<request> batch;
+    std::unique_lock<std::mutex> lock(m_lock);
+    while(true) {
+        m_ready.wait(lock, [this]() { return m_stop || !m_queue.empty(); });
+        if(m_queue.empty())
+            return;
+
+        // give the batch until the oldest request's deadline to fill
+        const clock::time_point deadline = m_queue.front().when + m_max_wait;
+        m_ready.wait_until(lock, deadline, [this]() { return m_stop || m_queue.size() >= m_max_batch; });
+
+        const std::size_t waiting = m_queue.size();
+        const std::size_t n = std::min<std::size_t>(waiting, m_max_batch);
+        for(std::size_t i = 0; i < n; i++) {
+            batch.push_back(std::move(m_queue.front()));
+            m_queue.pop_front();
+        }
+
+        lock.unlock();
+        {
+            std::lock_guard<std::mutex> guard(m_stats_lock);
+            m_stats.max_queued = std::max(m_stats.max_queued, waiting);
+        }
+        answer(batch);
+        batch.clear();
+        lock.lock();
+    }
+}
+
+template<typename T>
+void Batcher<T>::answer(std::vector<request>& batch) {
+    const uint n = batch.size();
+    math::matrix<T> out(0, 0, math::UNINITIALIZED);
+    std::exception_ptr failed;
+    try {
+        math::matrix<T> in(m_features, n, math::UNINITIALIZED);
+        for(uint c = 0; c < n; c++) {
+            std::copy(batch[c].input.begin(), batch[c].input.end(), in.data() + std::size_t(c) * m_features);
+        }
+
+        out = m_query(in);
+        if(out.N != n)
+            throw std::runtime_error("query gave " + std::to_string(out.N) + " answers for " + std::to_string(n));
+    } catch(...) {
+        failed = std::current_exception();
+    }
+
+    // counted before anyone is answered, so a report after an answer has it
+    {
+        const clock::time_point now = clock::now();
+        std::lock_guard<std::mutex> guard(m_stats_lock);
+        m_stats.requests += n;
+        m_stats.batches++;
+        uint bucket = 0;
+        while((2u << bucket) <= n) bucket++;
+        if(m_stats.sizes.size() <= bucket)
+            m_stats.sizes.resize(bucket + 1);
+        m_stats.sizes[bucket]++;
+        for(const request& r : batch) {
+            const double us = std::chrono::duration<double, std::micro>(now - r.when).count();
+            if(m_latencies.size() < LATENCIES)
+                m_latencies.push_back(us);
+            else
+                m_latencies[m_next++ % LATENCIES] = us;
+        }
+    }
+
+    for(uint c = 0; c < n; c++) {
+        if(failed) {
+            batch[c].answer.set_exception(failed);
+            continue;
+        }
+
+        math::matrix<T> column(out.M, 1, math::UNINITIALIZED);
+        for(uint r = 0; r < out.M; r++) {
+            column(r, 0) = out(r, c);
+        }
+        batch[c].answer.set_value(column);
+    }
+}
+
+}
+}
+
+#endif //JLIB_AI_BATCHER_HH
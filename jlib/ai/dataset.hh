@@ -0,0 +1,276 @@
+/* -*- mode: C++ c-basic-offset: 4  -*-
+ *
+ * Copyright (c) 2026 Joey Yandle <xoloki@gmail.com>
+ *
+ */
+
+#ifndef JLIB_AI_DATASET_HH
+#define JLIB_AI_DATASET_HH
+
+#include <jlib/math/matrix.hh>
+#include <jlib/sys/mapping.hh>
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+#include <cstring>
+
+namespace jlib {
+namespace ai {
+
+// labelled samples, one per column of a single column-major matrix, read
+// from either a csv of "label,value,value,..." lines or an IDX image file
+// and its labels, as MNIST is distributed.  every value v is stored as
+// v * scale + offset.  files are mapped rather than read, and csv lines are
+// parsed in parallel straight into the matrix
+template<typename T>
+class dataset {
+public:
+    // the scaling the jneural apps train on: 0..255 to 0.01..1.0
+    static constexpr double PIXEL_SCALE = 0.99 / 255.0;
+    static constexpr double PIXEL_OFFSET = 0.01;
+
+    static dataset csv(const std::string& path, T scale = T(PIXEL_SCALE), T offset = T(PIXEL_OFFSET));
+    static dataset idx(const std::string& images, const std::string& labels,
+                       T scale = T(PIXEL_SCALE), T offset = T(PIXEL_OFFSET));
+
+    // an IDX file by its magic number, with the labels found by swapping
+    // "images-idx3" for "labels-idx1" in its name; anything else as csv
+    static dataset load(const std::string& path, T scale = T(PIXEL_SCALE), T offset = T(PIXEL_OFFSET));
+
+    std::size_t size() const { return m_labels.size(); }
+    uint features() const { return m_samples.M; }
+
+    int label(std::size_t i) const { return m_labels[i]; }
+    const std::vector<int>& labels() const { return m_labels; }
+
+    // features x size()
+    const math::matrix<T>& samples() const { return m_samples; }
+
+    // samples [begin, begin+width), sharing storage with the dataset
+    math::matrix<T> batch(std::size_t begin, uint width) const;
+    math::matrix<T> sample(std::size_t i) const { return batch(i, 1); }
+
+    // samples order[begin], order[begin+1], ... copied into out, which is
+    // resized only if it is the wrong shape, for a shuffle the dataset is
+    // shared by
+    void gather(const std::vector<std::size_t>& order, std::size_t begin, uint width, math::matrix<T>& out) const;
+
+    // put the samples themselves in a random order, so that every batch of
+    // the epoch after is a view.  one pass over the data
+    template<typename G>
+    void shuffle(G& generator);
+
+protected:
+    dataset(uint features, std::size_t count);
+
+    math::matrix<T> m_samples;
+    std::vector<int> m_labels;
+};
+
+template<typename T>
+constexpr double dataset<T>::PIXEL_SCALE;
+template<typename T>
+constexpr double dataset<T>::PIXEL_OFFSET;
+
+
+namespace scan {
+
+// a decimal integer at p, with an optional leading '-', leaving p past it;
+// false, with p where it was, if there are no digits
+inline
+bool number(const char*& p, const char* end, int64_t& value) {
+    const char* start = p;
+    const bool negative = (p < end && *p == '-');
+    if(negative)
+        p++;
+    const char* digits = p;
+    int64_t v = 0;
+    while(p < end && uint32_t(*p - '0') < 10) {
+        v = v * 10 + (*p - '0');
+        p++;
+    }
+    if(p == digits) {
+        p = start;
+        return false;
+    }
+    value = (negative ? -v : v);
+    return true;
+}
+
+inline
+uint32_t big32(const char* p) {
+    const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+    return (uint32_t(u[0]) << 24) | (uint32_t(u[1]) << 16) | (uint32_t(u[2]) << 8) | uint32_t(u[3]);
+}
+
+}
+
+template<typename T>
+dataset<T>::dataset(uint features, std::size_t count)
+    : m_samples(features, count, math::UNINITIALIZED),
+      m_labels(count)
+{
+}
+
+template<typename T>
+dataset<T> dataset<T>::csv(const std::string& path, T scale, T offset) {
+    sys::mapping::ptr file = sys::mapping::open(path);
+    const char* data = file->data();
+    const char* end = data + file->size();
+
+    // where every non-empty line starts and ends, without the line ending
+    std::vector<const char*> starts, stops;
+    for(const char* p = data; p < end; ) {
+        const char* nl = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        const char* stop = (nl ? nl : end);
+        const char* trimmed = (stop > p && stop[-1] == '\r' ? stop - 1 : stop);
+        if(trimmed > p) {
+            starts.push_back(p);
+            stops.push_back(trimmed);
+        }
+        p = stop + 1;
+    }
+
+    if(starts.empty())
+        throw std::runtime_error(path + ": no samples");
+
+    const uint features = std::count(starts.front(), stops.front(), ',');
+    dataset ret(features, starts.size());
+    T* out = ret.m_samples.data();
+
+    std::vector<std::size_t> bad(starts.size(), 0);
+    math::parallel_for(starts.size(), 256, [&](std::size_t begin, std::size_t finish) {
+            for(std::size_t i = begin; i < finish; i++) {
+                const char* p = starts[i];
+                const char* stop = stops[i];
+                T* column = out + i * features;
+
+                int64_t v;
+                bool ok = scan::number(p, stop, v);
+                ret.m_labels[i] = int(v);
+
+                uint n = 0;
+                while(ok && p < stop && *p == ',' && n < features) {
+                    p++;
+                    ok = scan::number(p, stop, v);
+                    column[n++] = T(v) * scale + offset;
+                }
+
+                if(!ok || p != stop || n != features)
+                    bad[i] = 1;
+            }
+        }, std::size_t(features) * starts.size());
+
+    for(std::size_t i = 0; i < bad.size(); i++) {
+        if(bad[i])
+            throw std::runtime_error(path + ": line " + std::to_string(i + 1) + " is not a label and " +
+                                     std::to_string(features) + " values");
+    }
+
+    return ret;
+}
+
+template<typename T>
+dataset<T> dataset<T>::idx(const std::string& images, const std::string& labels, T scale, T offset) {
+    sys::mapping::ptr ifile = sys::mapping::open(images);
+    sys::mapping::ptr lfile = sys::mapping::open(labels);
+
+    // unsigned bytes, in three and one dimensions
+    if(ifile->size() < 16 || scan::big32(ifile->data()) != 0x00000803)
+        throw std::runtime_error(images + ": not an IDX image file");
+    if(lfile->size() < 8 || scan::big32(lfile->data()) != 0x00000801)
+        throw std::runtime_error(labels + ": not an IDX label file");
+
+    const std::size_t count = scan::big32(ifile->data() + 4);
+    const std::size_t features = std::size_t(scan::big32(ifile->data() + 8)) * scan::big32(ifile->data() + 12);
+    if(scan::big32(lfile->data() + 4) != count)
+        throw std::runtime_error(labels + ": " + std::to_string(scan::big32(lfile->data() + 4)) +
+                                 " labels for " + std::to_string(count) + " images");
+    if((ifile->size() - 16) / std::max<std::size_t>(features, 1) < count || lfile->size() - 8 < count)
+        throw std::runtime_error(images + ": truncated");
+
+    dataset ret(features, count);
+    const unsigned char* pixels = reinterpret_cast<const unsigned char*>(ifile->data() + 16);
+    const unsigned char* tags = reinterpret_cast<const unsigned char*>(lfile->data() + 8);
+    T* out = ret.m_samples.data();
+
+    // each image is already a column's worth of contiguous bytes
+    const std::size_t total = count * features;
+    math::parallel_for(total, math::ELEMENTWISE_GRAIN, [&](std::size_t begin, std::size_t end) {
+            for(std::size_t i = begin; i < end; i++) {
+                out[i] = T(pixels[i]) * scale + offset;
+            }
+        }, total);
+    for(std::size_t i = 0; i < count; i++) {
+        ret.m_labels[i] = tags[i];
+    }
+
+    return ret;
+}
+
+template<typename T>
+dataset<T> dataset<T>::load(const std::string& path, T scale, T offset) {
+    {
+        sys::mapping::ptr file = sys::mapping::open(path);
+        if(file->size() < 4 || scan::big32(file->data()) != 0x00000803)
+            return csv(path, scale, offset);
+    }
+
+    std::string labels = path;
+    const std::string::size_type at = labels.find("images-idx3");
+    if(at == std::string::npos)
+        throw std::runtime_error(path + ": cannot tell where the labels for these images are");
+    labels.replace(at, 11, "labels-idx1");
+
+    return idx(path, labels, scale, offset);
+}
+
+template<typename T>
+math::matrix<T> dataset<T>::batch(std::size_t begin, uint width) const {
+    if(begin + width > size())
+        throw std::out_of_range("samples " + std::to_string(begin) + " to " + std::to_string(begin + width) +
+                                " of " + std::to_string(size()));
+    return math::matrix<T>(features(), width, math::buffer<T>(m_samples, begin * features(), std::size_t(width) * features()));
+}
+
+template<typename T>
+void dataset<T>::gather(const std::vector<std::size_t>& order, std::size_t begin, uint width, math::matrix<T>& out) const {
+    if(out.M != features() || out.N != width || out.is_transposed())
+        out = math::matrix<T>(features(), width, math::UNINITIALIZED);
+
+    const T* in = m_samples.data();
+    for(uint c = 0; c < width; c++) {
+        const T* column = in + order[begin + c] * features();
+        std::copy(column, column + features(), out.data() + std::size_t(c) * features());
+    }
+}
+
+template<typename T>
+template<typename G>
+void dataset<T>::shuffle(G& generator) {
+    std::vector<std::size_t> order(size());
+    for(std::size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::shuffle(order.begin(), order.end(), generator);
+
+    math::matrix<T> shuffled(features(), size(), math::UNINITIALIZED);
+    std::vector<int> labels(size());
+    gather(order, 0, size(), shuffled);
+    for(std::size_t i = 0; i < order.size(); i++) {
+        labels[i] = m_labels[order[i]];
+    }
+
+    m_samples = shuffled;
+    m_labels.swap(labels);
+}
+
+}
+}
+
+#endif //JLIB_AI_DATASET_HH
@@ -21,11 +21,16 @@
 
 #include <jlib/ai/environment.hh>
 
+#include <cstdint>
+#include <stdexcept>
+
 
 namespace jlib {
 namespace ai {
 
 Environment::Environment() 
+    : mSeed(random::default_seed),
+      mSeeded(false)
 {
 
 }
@@ -33,6 +38,10 @@ Environment::Environment()
 Environment::~Environment() {
 }
 
+void Environment::perceive(Agent::ptr agent, Percept::map& percepts) {
+    percepts = perceive(agent);
+}
+
 Environment::score Environment::run() {
     Environment::score s = 0;
 
@@ -48,12 +57,45 @@ Environment::score Environment::run(int x) {
     Environment::score s = 0;
 
     for(int i = 0; i < x; i++) {
+        if(mSeeded)
+            episode(i);
         s += run();
     }
 
     return s/x;
 }
 
+void Environment::add(Agent::ptr agent) {
+    mAgents.push_back(agent);
+}
+
+std::unique_ptr<Environment> Environment::clone() const {
+    return std::unique_ptr<Environment>();
+}
+
+void Environment::clone_agents() {
+    for(Agent::list::iterator i = mAgents.begin(); i != mAgents.end(); i++) {
+        Agent::ptr agent = (*i)->clone();
+        if(!agent)
+            throw std::logic_error("ai::Environment: clone of an agent without Agent::clone");
+        *i = agent;
+    }
+}
+
+void Environment::seed(random::result_type s) {
+    mSeed = s;
+    mSeeded = true;
+}
+
+void Environment::episode(std::size_t i) {
+    std::seed_seq seq { uint32_t(mSeed), uint32_t(mSeed >> 32), uint32_t(i), uint32_t(uint64_t(i) >> 32) };
+    mRandom.seed(seq);
+
+    for(Agent::list::iterator a = mAgents.begin(); a != mAgents.end(); a++) {
+        (*a)->seed(mRandom());
+    }
+}
+
 
 }
 }
@@ -26,6 +26,9 @@
 #include <jlib/ai/action.hh>
 #include <jlib/ai/agent.hh>
 
+#include <cstddef>
+#include <memory>
+
 
 namespace jlib {
 namespace ai {
@@ -33,22 +36,54 @@ namespace ai {
 class Environment {
 public:
     typedef double score;
+    typedef Agent::random random;
 
     Environment();
     virtual ~Environment();
 
     virtual Percept::ptr perceive(Agent::ptr agent, Percept::sense s) = 0;
     virtual Percept::map perceive(Agent::ptr agent) = 0;
+    // the same into a map kept from step to step, so its nodes are reused
+    virtual void perceive(Agent::ptr agent, Percept::map& percepts);
 
     virtual void act(Action::ptr a) = 0;
 
+    // one episode for every agent, scored by the last
     virtual score run();
+    // the average of x episodes.  once seed() has been called, these are
+    // episodes 0 to x-1, each started by episode()
     virtual score run(int x);
 
     virtual score run(Agent::ptr agent) = 0;
 
+    void add(Agent::ptr agent);
+    const Agent::list& agents() const { return mAgents; }
+
+    // a copy of this environment and its agents, for running episodes on
+    // another thread; see Runner.  environments that can't be copied give
+    // none, and are run on the calling thread
+    virtual std::unique_ptr<Environment> clone() const;
+
+    // episodes draw from a generator seeded by this and their number, and
+    // never by when or where they ran, so any number of threads gives the
+    // same scores.  until it is called run(x) leaves the generators alone
+    void seed(random::result_type s);
+
+    // reseed this environment, and then each agent from it, for episode i
+    void episode(std::size_t i);
+
+protected:
+    // for subclasses' clone, after copying: swap the agents, which a copy
+    // shares with the original, for their Agent::clone
+    void clone_agents();
+
+    random& rng() { return mRandom; }
+
 private:
     Agent::list mAgents;
+    random::result_type mSeed;
+    bool mSeeded;
+    random mRandom;
 };
 
 
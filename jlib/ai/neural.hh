@@ -4,20 +4,35 @@
  * 
  */
 
+#ifndef JLIB_AI_NEURAL_HH
+#define JLIB_AI_NEURAL_HH
+
+#include <jlib/ai/activation.hh>
+#include <jlib/ai/backend.hh>
 #include <jlib/math/matrix.hh>
 #include <jlib/util/util.hh>
 #include <jlib/util/json.hh>
+#include <jlib/sys/mapping.hh>
 
+#include <algorithm>
 #include <functional>
 #include <random>
 #include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
 #include <tuple>
 
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 
 namespace jlib {
 namespace ai {
 
+template<typename T>
+class QuantizedNetwork;
+
 template<typename T>
 class NeuralNetwork {
 public:
@@ -25,20 +40,85 @@ public:
 
     NeuralNetwork(util::json::object::ptr p);
 
+    // a model written by save.  the weights are used straight out of the
+    // mapped file, copied only as training writes to them, unless the file
+    // holds a different scalar type than T
+    explicit NeuralNetwork(const std::string& path);
+
     template<typename... Args>
     NeuralNetwork(double lrate, uint ninput, uint noutput, Args&&... args)
         : NeuralNetwork(lrate, ninput, std::vector<uint>({args...}), noutput)
     {
     }
 
+    // train returns the output errors of the step.  training works in
+    // scratch space the network owns, so a network must not be trained
+    // from two threads at once; queries may run alongside each other
     math::matrix<T> train(math::matrix<T> inputs, math::matrix<T> targets);
     math::matrix<T> query(math::matrix<T> inputs);
 
+    // one sample per column.  train_batch takes a single step along the
+    // gradient averaged over the batch, so the rate means the same thing
+    // at any batch size; train on the same columns would sum it instead
+    math::matrix<T> train_batch(const math::matrix<T>& inputs, const math::matrix<T>& targets);
+    math::matrix<T> query_batch(const math::matrix<T>& inputs);
+
+    // train and train_batch without copying out the errors, so a step
+    // allocates nothing once the network has seen a batch of that width
+    void learn(const math::matrix<T>& inputs, const math::matrix<T>& targets);
+    void learn_batch(const math::matrix<T>& inputs, const math::matrix<T>& targets);
+
+    // scratch for one forward and backward pass, kept between calls so a
+    // pass allocates nothing once it has seen a batch of that width
+    struct workspace {
+        std::vector<math::matrix<T>> outputs;
+        std::vector<math::matrix<T>> errors;
+        std::vector<math::matrix<T>> deltas;
+    };
+
+    // the change train would make to each layer's weights at a rate of 1,
+    // summed over the columns of inputs, into grads.  unlike train every
+    // error is propagated back through the weights as they are, and nothing
+    // is written to the network, so calls with their own workspace and
+    // gradients may run alongside each other
+    void gradient(const math::matrix<T>& inputs, const math::matrix<T>& targets,
+                  std::vector<math::matrix<T>>& grads, workspace& scratch);
+    // weights(i) += rate * grads[i]
+    void apply(const std::vector<math::matrix<T>>& grads, T rate);
+
+    // the activation function applied after layer i of weights, by the
+    // name it is registered under; every layer starts out as sigmoid
+    void set_activation(const std::string& name);
+    void set_activation(uint layer, const std::string& name);
+    const std::string& get_activation(uint layer) const;
+
+    // what every product in train, query and gradient runs on, "cpu"
+    // unless set.  a backend's memory outlives the calls it makes, so set
+    // it once rather than per batch
+    void set_backend(const std::string& name);
+    void set_backend(typename backend<T>::ptr b);
+    typename backend<T>::ptr get_backend() const;
+
     util::json::object::ptr json();
 
+    // binary models, all little-endian:
+    //   char[8] "jlib-nn\0", uint32 version, uint32 bytes per weight,
+    //   float64 rate, uint32 inputs, uint32 outputs, uint32 hidden layers,
+    //   uint32 nodes per hidden layer, then per layer of weights uint32
+    //   rows, uint32 cols, uint64 offset, then per layer the activation as
+    //   uint32 length and that many bytes of name.  each block of weights
+    //   is stored column-major at a multiple of 64 bytes from the start of
+    //   the file.  version 1 had no activations and is read as sigmoid
+    static const uint32_t MODEL_VERSION = 2;
+    void save(const std::string& path);
+
     std::default_random_engine& get_generator();
 
     void set_rate(double rate);
+    double get_rate() const;
+
+    uint get_inputs() const;
+    uint get_outputs() const;
     
 protected:
     uint m_ninput;
@@ -48,8 +128,34 @@ protected:
     math::matrix<T> m_wih;
     math::matrix<T> m_who;
     std::vector<math::matrix<T>> m_deep;
-    std::function<math::matrix<T>(math::matrix<T>)> m_activation_function;
+    // one per layer of weights, owned by the registry
+    std::vector<const activation<T>*> m_activations;
+    typename backend<T>::ptr m_backend = backend<T>::get("cpu");
     std::default_random_engine m_generator;
+
+    // weights feeding layer i+1: wih, then the deep layers, then who
+    uint layers() const;
+    math::matrix<T>& weights(uint i);
+    const math::matrix<T>& weights(uint i) const;
+
+    // size a workspace for a batch of the given width
+    void reserve(workspace& scratch, uint batch);
+
+    // forward and backward over every column of inputs, moving the weights
+    // by rate times the summed gradient.  the output errors are left in
+    // the last of m_scratch.errors
+    void step(const math::matrix<T>& inputs, const math::matrix<T>& targets, T rate);
+
+    // a copy of the errors the last step left in m_scratch
+    math::matrix<T> errors() const;
+
+    // what train and train_batch work in
+    workspace m_scratch;
+
+    // every layer sigmoid, unless it already has one
+    void init_activation();
+
+    friend class QuantizedNetwork<T>;
 };
 
 template<typename T>
@@ -89,14 +195,7 @@ NeuralNetwork<T>::NeuralNetwork(double lrate, uint ninput, const std::vector<uin
             });
     }
 
-    // sigmoid function
-    m_activation_function = [](math::matrix<T> input) {
-        math::matrix<T> output(input.M, input.N);
-        input.foreach_index([&](uint r, uint c, T& val) {
-                output(r, c) = (1.0 / (1.0 + exp(-val))); //tanh(val);
-            });
-        return output;
-    }; 
+    init_activation();
 }
 
 
@@ -125,97 +224,373 @@ NeuralNetwork<T>::NeuralNetwork(util::json::object::ptr p)
     if(m_nhidden.empty())
         throw std::runtime_error("Need at least one hidden layer");
 
+    // look each array up once rather than once per weight
+    util::json::object::ptr wih = p->obj("wih");
     m_wih = math::matrix<T>(m_nhidden.front(), m_ninput);
     m_wih.foreach_index([&](uint r, uint c, T& x) {
-            x = p->obj("wih")->get(r*m_ninput + c);
+            x = wih->get(r*m_ninput + c);
         });
 
+    util::json::object::ptr deep = p->obj("deep");
     for(int i = 1; i < m_nhidden.size(); i++) {
         // add a deep matrix from [i-1] to [i]
+        util::json::object::ptr d = deep->obj(i-1);
 	m_deep.push_back(math::matrix<T>(m_nhidden[i], m_nhidden[i-1]));
 	m_deep.back().foreach_index([&](uint r, uint c, T& x) {
-		x = p->obj("deep")->obj(i-1)->get(r*m_nhidden[i-1] + c);
+		x = d->get(r*m_nhidden[i-1] + c);
             });
     }
 
+    util::json::object::ptr who = p->obj("who");
     m_who = math::matrix<T>(m_noutput, m_nhidden.back());
     m_who.foreach_index([&](uint r, uint c, T& x) {
-            x = p->obj("who")->get(r*m_nhidden.back() + c);
+            x = who->get(r*m_nhidden.back() + c);
         });
-    
-    // sigmoid function
-    m_activation_function = [](math::matrix<T> input) {
-        math::matrix<T> output(input.M, input.N);
-        input.foreach_index([&](uint r, uint c, T& val) {
-                output(r, c) = (1.0 / (1.0 + exp(-val))); //tanh(val);
-            });
-        return output;
-    }; 
+
+    // older models have no activation field, and were all sigmoid
+    util::json::object::ptr act = p->obj("activation");
+    if(act->is(util::json::object::type_array)) {
+        if(act->size() != layers())
+            throw std::runtime_error("Need one activation per layer, not " + std::to_string(act->size()));
+        for(uint i = 0; i < layers(); i++) {
+            const std::string name = act->get(i);
+            m_activations.push_back(&activation<T>::get(name));
+        }
+    }
+
+    init_activation();
 }
-    
-template<typename T>
-math::matrix<T> NeuralNetwork<T>::train(math::matrix<T> inputs, math::matrix<T> targets){
-    //std::cout << "wih[" << m_wih.M << "," << m_wih.N << "]" << " * " << "inputs[" << inputs.M << "," << inputs.N << "]" << std::endl;
 
-    math::matrix<T> hidden_inputs = m_wih * inputs;
-    math::matrix<T> hidden_outputs = m_activation_function(hidden_inputs);
+namespace model {
 
-    math::matrix<T> deep_inputs = hidden_inputs;
-    math::matrix<T> deep_outputs = hidden_outputs;
+inline
+uint32_t get32(const char* p) {
+    const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+    return uint32_t(u[0]) | (uint32_t(u[1]) << 8) | (uint32_t(u[2]) << 16) | (uint32_t(u[3]) << 24);
+}
 
-    std::vector<math::matrix<T>> deep_inputs_cache;
-    std::vector<math::matrix<T>> deep_outputs_cache;
+inline
+uint64_t get64(const char* p) {
+    return uint64_t(get32(p)) | (uint64_t(get32(p + 4)) << 32);
+}
 
-    for(auto& deep : m_deep) {
-        deep_inputs_cache.push_back(deep_outputs);
+inline
+void put32(std::string& s, uint32_t x) {
+    for(int i = 0; i < 4; i++) {
+        s.push_back(char((x >> (8 * i)) & 0xff));
+    }
+}
 
-        deep_inputs = deep * deep_outputs;
-        deep_outputs = m_activation_function(deep_inputs);
+inline
+void put64(std::string& s, uint64_t x) {
+    put32(s, uint32_t(x));
+    put32(s, uint32_t(x >> 32));
+}
 
-        deep_outputs_cache.push_back(deep_outputs);
+// the scalar at p, stored little-endian in the given width
+template<typename T>
+T get(const char* p, uint32_t width) {
+    if(width == 4) {
+        uint32_t bits = get32(p);
+        float f;
+        std::memcpy(&f, &bits, 4);
+        return T(f);
     }
 
-    math::matrix<T> final_inputs = m_who * deep_outputs;
-    math::matrix<T> final_outputs = m_activation_function(final_inputs);
-    //std::cout << "final_outputs[" << final_outputs.M << "," << final_outputs.N << "] \n" << final_outputs << std::endl;
-    
-    math::matrix<T> output_errors = targets - final_outputs;
-    //std::cout << "output_errors[" << output_errors.M << "," << output_errors.N << "] \n" << output_errors << std::endl;
+    uint64_t bits = get64(p);
+    double d;
+    std::memcpy(&d, &bits, 8);
+    return T(d);
+}
 
-    m_who += m_lrate * (((output_errors ^ final_outputs ^ (1.0 - final_outputs)) * deep_outputs.transpose()));
+inline
+bool little_endian() {
+    const uint32_t one = 1;
+    char c;
+    std::memcpy(&c, &one, 1);
+    return c == 1;
+}
 
-    math::matrix<T> deep_errors = output_errors;
-    math::matrix<T> deep = m_who;
-    
-    //for(auto x = m_deep.rbegin(); x != m_deep.rend(); x++) {
-    for(int i = m_deep.size() - 1; i >= 0; i--) {
-        deep_errors = deep.transpose() * deep_errors;
-        m_deep[i] += m_lrate * (((deep_errors ^ deep_outputs_cache[i] ^ (1.0 - deep_outputs_cache[i])) * deep_inputs_cache[i].transpose()));
-        deep = m_deep[i];
+const char MAGIC[8] = { 'j', 'l', 'i', 'b', '-', 'n', 'n', '\0' };
+const std::size_t ALIGN = 64;
+
+// json models are whatever ends in .json, anything else is binary
+inline
+bool is_json(const std::string& path) {
+    const std::string ext = ".json";
+    return path.size() >= ext.size() && path.compare(path.size() - ext.size(), ext.size(), ext) == 0;
+}
+
+// a network from either kind of model file, by its extension
+template<typename T>
+std::unique_ptr<NeuralNetwork<T>> load(const std::string& path) {
+    if(is_json(path)) {
+        std::ifstream ifs(path);
+        std::string cache((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+        return std::unique_ptr<NeuralNetwork<T>>(new NeuralNetwork<T>(util::json::object::create(cache)));
     }
+    return std::unique_ptr<NeuralNetwork<T>>(new NeuralNetwork<T>(path));
+}
 
-    math::matrix<T> hidden_errors = deep.transpose() * deep_errors;
-    //std::cout << "hidden_errors[" << hidden_errors.M << "," << hidden_errors.N << "] \n" << hidden_errors << std::endl;
-    
-    m_wih += m_lrate * ((hidden_errors ^ hidden_outputs ^ (1.0 - hidden_outputs)) * inputs.transpose());
+}
 
-    return output_errors;
+template<typename T>
+NeuralNetwork<T>::NeuralNetwork(const std::string& path)
+    : m_wih(1, 1),
+      m_who(1, 1)
+{
+    sys::mapping::ptr file = sys::mapping::open(path);
+    const char* data = file->data();
+    const std::size_t size = file->size();
+
+    auto need = [&](std::size_t end) {
+        if(end > size)
+            throw std::runtime_error(path + ": truncated model");
+    };
+
+    need(28);
+    if(std::memcmp(data, model::MAGIC, 8) != 0)
+        throw std::runtime_error(path + ": not a model");
+
+    const uint32_t version = model::get32(data + 8);
+    if(version != 1 && version != MODEL_VERSION)
+        throw std::runtime_error(path + ": unknown model version " + std::to_string(version));
+
+    const uint32_t width = model::get32(data + 12);
+    if(width != 4 && width != 8)
+        throw std::runtime_error(path + ": unknown weight size " + std::to_string(width));
+
+    m_lrate = model::get<double>(data + 16, 8);
+    m_ninput = model::get32(data + 24);
+
+    need(36);
+    m_noutput = model::get32(data + 28);
+    const uint32_t nhidden = model::get32(data + 32);
+    if(nhidden == 0)
+        throw std::runtime_error("Need at least one hidden layer");
+
+    std::size_t at = 36;
+    need(at + 4 * std::size_t(nhidden));
+    for(uint32_t i = 0; i < nhidden; i++, at += 4) {
+        m_nhidden.push_back(model::get32(data + at));
+    }
+
+    // weights can stay in the file when they are already what T looks like
+    const bool mapped = (width == sizeof(T) && model::little_endian());
+
+    std::vector<math::matrix<T>> loaded;
+    for(uint i = 0; i < m_nhidden.size() + 1; i++, at += 16) {
+        need(at + 16);
+        const uint rows = model::get32(data + at);
+        const uint cols = model::get32(data + at + 4);
+        const uint64_t offset = model::get64(data + at + 8);
+
+        const uint expected_rows = (i < m_nhidden.size() ? m_nhidden[i] : m_noutput);
+        const uint expected_cols = (i == 0 ? m_ninput : m_nhidden[i - 1]);
+        if(rows != expected_rows || cols != expected_cols)
+            throw std::runtime_error(path + ": layer " + std::to_string(i) + " has the wrong shape");
+        if(offset % model::ALIGN || offset > size || (size - offset) / width < std::size_t(rows) * cols)
+            throw std::runtime_error(path + ": layer " + std::to_string(i) + " is out of bounds");
+
+        const std::size_t count = std::size_t(rows) * cols;
+        if(mapped) {
+            T* block = reinterpret_cast<T*>(file->data() + offset);
+            loaded.push_back(math::matrix<T>(rows, cols, math::buffer<T>(block, count, file)));
+        } else {
+            math::matrix<T> w(rows, cols, math::UNINITIALIZED);
+            for(std::size_t j = 0; j < count; j++) {
+                w.data()[j] = model::get<T>(data + offset + j * width, width);
+            }
+            loaded.push_back(w);
+        }
+    }
+
+    m_wih = loaded.front();
+    m_deep.assign(loaded.begin() + 1, loaded.end() - 1);
+    m_who = loaded.back();
+
+    for(uint i = 0; version > 1 && i < layers(); i++) {
+        need(at + 4);
+        const uint32_t length = model::get32(data + at);
+        at += 4;
+        need(at + length);
+        m_activations.push_back(&activation<T>::get(std::string(data + at, length)));
+        at += length;
+    }
+
+    init_activation();
+}
+    
+template<typename T>
+math::matrix<T> NeuralNetwork<T>::train(math::matrix<T> inputs, math::matrix<T> targets){
+    learn(inputs, targets);
+    return errors();
 }
     
 template<typename T>
 math::matrix<T> NeuralNetwork<T>::query(math::matrix<T> inputs) {
-    math::matrix<T> hidden_inputs = m_wih * inputs;
-    math::matrix<T> hidden_outputs = m_activation_function(hidden_inputs);
+    return query_batch(inputs);
+}
 
-    for(auto& deep : m_deep) {
-        hidden_inputs = deep * hidden_outputs;
-        hidden_outputs = m_activation_function(hidden_inputs);
+template<typename T>
+math::matrix<T> NeuralNetwork<T>::train_batch(const math::matrix<T>& inputs, const math::matrix<T>& targets) {
+    learn_batch(inputs, targets);
+    return errors();
+}
+
+template<typename T>
+void NeuralNetwork<T>::learn(const math::matrix<T>& inputs, const math::matrix<T>& targets) {
+    step(inputs, targets, T(m_lrate));
+}
+
+template<typename T>
+void NeuralNetwork<T>::learn_batch(const math::matrix<T>& inputs, const math::matrix<T>& targets) {
+    if(inputs.N != targets.N)
+        throw typename math::matrix<T>::mismatched(inputs.M, inputs.N, targets.M, targets.N);
+
+    step(inputs, targets, T(m_lrate / std::max(inputs.N, 1u)));
+}
+
+template<typename T>
+math::matrix<T> NeuralNetwork<T>::query_batch(const math::matrix<T>& inputs) {
+    // no shared scratch here, so queries may run alongside each other.
+    // layers alternate between two buffers sized for the widest one
+    uint widest = 0;
+    for(uint i = 0; i < layers(); i++) {
+        widest = std::max(widest, weights(i).M);
     }
 
-    math::matrix<T> final_inputs = m_who * hidden_outputs;
-    math::matrix<T> final_outputs = m_activation_function(final_inputs);
-    
-    return final_outputs;
+    const math::buffer<T> ping(widest * inputs.N, math::UNINITIALIZED);
+    const math::buffer<T> pong(widest * inputs.N, math::UNINITIALIZED);
+
+    math::matrix<T> outputs = inputs;
+    for(uint i = 0; i < layers(); i++) {
+        math::matrix<T> next(weights(i).M, inputs.N, (i % 2 ? pong : ping));
+        m_backend->gemm(T(1), weights(i), math::NOTRANS, outputs, math::NOTRANS, T(0), next);
+        m_activations[i]->forward(next, next);
+        outputs = next;
+    }
+
+    return outputs;
+}
+
+template<typename T>
+void NeuralNetwork<T>::step(const math::matrix<T>& inputs, const math::matrix<T>& targets, T rate) {
+    const uint n = layers();
+    workspace& w = m_scratch;
+    reserve(w, inputs.N);
+
+    // forward, keeping every layer's output for the backward pass
+    for(uint i = 0; i < n; i++) {
+        const math::matrix<T>& in = (i == 0 ? inputs : w.outputs[i - 1]);
+        m_backend->gemm(T(1), weights(i), math::NOTRANS, in, math::NOTRANS, T(0), w.outputs[i]);
+        m_activations[i]->forward(w.outputs[i], w.outputs[i]);
+    }
+
+    math::assign(w.errors[n - 1], targets - w.outputs[n - 1]);
+
+    // backward from the output layer.  each layer's errors are propagated
+    // through weights that have already been updated, as they always were
+    for(int i = n - 1; i >= 0; i--) {
+        const math::matrix<T>& in = (i == 0 ? inputs : w.outputs[i - 1]);
+        const math::matrix<T>& out = w.outputs[i];
+
+        m_activations[i]->backward(w.errors[i], out, w.deltas[i]);
+        m_backend->gemm(rate, w.deltas[i], math::NOTRANS, in, math::TRANS, T(1), weights(i));
+
+        if(i > 0)
+            m_backend->gemm(T(1), weights(i), math::TRANS, w.errors[i], math::NOTRANS, T(0), w.errors[i - 1]);
+    }
+}
+
+template<typename T>
+math::matrix<T> NeuralNetwork<T>::errors() const {
+    // matrix copies share storage, and the next step overwrites this one's
+    const math::matrix<T>& last = m_scratch.errors.back();
+    math::matrix<T> ret(last.M, last.N, math::UNINITIALIZED);
+    math::assign(ret, math::leaf<T>(last));
+    return ret;
+}
+
+template<typename T>
+void NeuralNetwork<T>::gradient(const math::matrix<T>& inputs, const math::matrix<T>& targets,
+                                std::vector<math::matrix<T>>& grads, workspace& w) {
+    if(inputs.N != targets.N)
+        throw typename math::matrix<T>::mismatched(inputs.M, inputs.N, targets.M, targets.N);
+
+    const uint n = layers();
+    reserve(w, inputs.N);
+    if(grads.size() != n) {
+        grads.clear();
+        for(uint i = 0; i < n; i++) {
+            grads.push_back(math::matrix<T>(weights(i).M, weights(i).N, math::UNINITIALIZED));
+        }
+    }
+
+    for(uint i = 0; i < n; i++) {
+        const math::matrix<T>& in = (i == 0 ? inputs : w.outputs[i - 1]);
+        m_backend->gemm(T(1), weights(i), math::NOTRANS, in, math::NOTRANS, T(0), w.outputs[i]);
+        m_activations[i]->forward(w.outputs[i], w.outputs[i]);
+    }
+
+    math::assign(w.errors[n - 1], targets - w.outputs[n - 1]);
+
+    for(int i = n - 1; i >= 0; i--) {
+        const math::matrix<T>& in = (i == 0 ? inputs : w.outputs[i - 1]);
+        const math::matrix<T>& out = w.outputs[i];
+
+        m_activations[i]->backward(w.errors[i], out, w.deltas[i]);
+        m_backend->gemm(T(1), w.deltas[i], math::NOTRANS, in, math::TRANS, T(0), grads[i]);
+
+        if(i > 0)
+            m_backend->gemm(T(1), weights(i), math::TRANS, w.errors[i], math::NOTRANS, T(0), w.errors[i - 1]);
+    }
+}
+
+template<typename T>
+void NeuralNetwork<T>::apply(const std::vector<math::matrix<T>>& grads, T rate) {
+    for(uint i = 0; i < layers(); i++) {
+        m_backend->axpy(rate, grads[i], weights(i));
+    }
+}
+
+template<typename T>
+uint NeuralNetwork<T>::layers() const {
+    return m_deep.size() + 2;
+}
+
+template<typename T>
+math::matrix<T>& NeuralNetwork<T>::weights(uint i) {
+    if(i == 0)
+        return m_wih;
+    if(i <= m_deep.size())
+        return m_deep[i - 1];
+    return m_who;
+}
+
+template<typename T>
+const math::matrix<T>& NeuralNetwork<T>::weights(uint i) const {
+    if(i == 0)
+        return m_wih;
+    if(i <= m_deep.size())
+        return m_deep[i - 1];
+    return m_who;
+}
+
+template<typename T>
+void NeuralNetwork<T>::reserve(workspace& w, uint batch) {
+    const uint n = layers();
+    if(w.outputs.size() == n && w.outputs.front().N == batch)
+        return;
+
+    w.outputs.clear();
+    w.errors.clear();
+    w.deltas.clear();
+    for(uint i = 0; i < n; i++) {
+        w.outputs.push_back(math::matrix<T>(weights(i).M, batch));
+        w.errors.push_back(math::matrix<T>(weights(i).M, batch));
+        w.deltas.push_back(math::matrix<T>(weights(i).M, batch));
+    }
 }
 
 template<typename T>    
@@ -254,10 +629,122 @@ util::json::object::ptr NeuralNetwork<T>::json() {
             who->add(x);
         });
     p->add("who", who);
+
+    util::json::array::ptr act = util::json::array::create();
+    for(const activation<T>* a : m_activations) {
+        act->add(a->name);
+    }
+    p->add("activation", act);
 	
     return p;
 }
 
+template<typename T>
+void NeuralNetwork<T>::save(const std::string& path) {
+    static_assert(sizeof(T) == 4 || sizeof(T) == 8, "models hold float or double weights");
+
+    std::string header(model::MAGIC, 8);
+    model::put32(header, MODEL_VERSION);
+    model::put32(header, sizeof(T));
+    uint64_t rate;
+    const double lrate = m_lrate;
+    std::memcpy(&rate, &lrate, 8);
+    model::put64(header, rate);
+    model::put32(header, m_ninput);
+    model::put32(header, m_noutput);
+    model::put32(header, m_nhidden.size());
+    for(uint h : m_nhidden) {
+        model::put32(header, h);
+    }
+
+    // the header's own length decides where the first block goes
+    auto align = [](std::size_t x) {
+        return (x + model::ALIGN - 1) / model::ALIGN * model::ALIGN;
+    };
+
+    std::string names;
+    for(const activation<T>* a : m_activations) {
+        model::put32(names, a->name.size());
+        names += a->name;
+    }
+
+    std::vector<uint64_t> offsets;
+    std::size_t at = align(header.size() + 16 * layers() + names.size());
+    for(uint i = 0; i < layers(); i++) {
+        offsets.push_back(at);
+        at = align(at + std::size_t(weights(i).M) * weights(i).N * sizeof(T));
+    }
+
+    for(uint i = 0; i < layers(); i++) {
+        model::put32(header, weights(i).M);
+        model::put32(header, weights(i).N);
+        model::put64(header, offsets[i]);
+    }
+    header += names;
+
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    ofs.write(header.data(), header.size());
+
+    std::string block;
+    for(uint i = 0; i < layers(); i++) {
+        block.assign(offsets[i] - ofs.tellp(), '\0');
+        ofs.write(block.data(), block.size());
+
+        // column-major, as the matrix keeps it unless it is a transpose
+        const math::matrix<T>& w = weights(i);
+        if(model::little_endian() && !w.is_transposed()) {
+            ofs.write(reinterpret_cast<const char*>(w.data()), std::size_t(w.M) * w.N * sizeof(T));
+            continue;
+        }
+
+        block.clear();
+        block.reserve(std::size_t(w.M) * w.N * sizeof(T));
+        for(uint c = 0; c < w.N; c++) {
+            for(uint r = 0; r < w.M; r++) {
+                const T x = w(r, c);
+                if(sizeof(T) == 4) {
+                    uint32_t bits;
+                    std::memcpy(&bits, &x, 4);
+                    model::put32(block, bits);
+                } else {
+                    uint64_t bits;
+                    std::memcpy(&bits, &x, 8);
+                    model::put64(block, bits);
+                }
+            }
+        }
+        ofs.write(block.data(), block.size());
+    }
+
+    if(!ofs)
+        throw std::runtime_error(path + ": could not write model");
+}
+
+template<typename T>
+void NeuralNetwork<T>::init_activation() {
+    if(m_activations.size() != layers())
+        m_activations.assign(layers(), &activation<T>::get("sigmoid"));
+}
+
+template<typename T>
+void NeuralNetwork<T>::set_activation(const std::string& name) {
+    m_activations.assign(layers(), &activation<T>::get(name));
+}
+
+template<typename T>
+void NeuralNetwork<T>::set_activation(uint layer, const std::string& name) {
+    if(layer >= layers())
+        throw std::out_of_range("no layer " + std::to_string(layer) + " of " + std::to_string(layers()));
+    m_activations[layer] = &activation<T>::get(name);
+}
+
+template<typename T>
+const std::string& NeuralNetwork<T>::get_activation(uint layer) const {
+    if(layer >= layers())
+        throw std::out_of_range("no layer " + std::to_string(layer) + " of " + std::to_string(layers()));
+    return m_activations[layer]->name;
+}
+
 template<typename T>    
 std::default_random_engine& NeuralNetwork<T>::get_generator() {
     return m_generator;
@@ -267,6 +754,40 @@ template<typename T>
 void NeuralNetwork<T>::set_rate(double rate) {
     m_lrate = rate;
 }
+
+template<typename T>
+double NeuralNetwork<T>::get_rate() const {
+    return m_lrate;
+}
+
+template<typename T>
+void NeuralNetwork<T>::set_backend(const std::string& name) {
+    m_backend = backend<T>::get(name);
+}
+
+template<typename T>
+void NeuralNetwork<T>::set_backend(typename backend<T>::ptr b) {
+    if(!b)
+        throw std::runtime_error("no compute backend");
+    m_backend = b;
+}
+
+template<typename T>
+typename backend<T>::ptr NeuralNetwork<T>::get_backend() const {
+    return m_backend;
+}
+
+template<typename T>
+uint NeuralNetwork<T>::get_inputs() const {
+    return m_ninput;
+}
+
+template<typename T>
+uint NeuralNetwork<T>::get_outputs() const {
+    return m_noutput;
+}
     
 }
 }
+
+#endif //JLIB_AI_NEURAL_HH
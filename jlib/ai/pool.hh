@@ -0,0 +1,86 @@
+/* -*- mode: C++ c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2026 Joey Yandle <xoloki@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+#ifndef JLIB_AI_POOL_HH
+#define JLIB_AI_POOL_HH
+
+#include <glibmm/refptr.h>
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace jlib {
+namespace ai {
+
+// percepts and actions made afresh every step, kept for reuse.  the pool
+// holds a reference to everything it has made, so an object is free again
+// once nobody else does; get hands that back rather than allocating.
+//
+// sys::Object counts references without atomics, so a pool and what it
+// hands out belong to one thread.  copies start empty, which lets an
+// environment holding pools be cloned for another thread
+template<typename T>
+class pool {
+public:
+    typedef Glib::RefPtr<T> ptr;
+
+    pool() : m_next(0) {}
+    pool(const pool&) : m_next(0) {}
+    pool& operator=(const pool&) { return *this; }
+
+    // an object nobody else holds, or a new T(args...) when they are all in
+    // use.  a reused object keeps whatever was last put in it, so set every
+    // field before handing it on
+    template<typename... A>
+    ptr get(A&&... args);
+
+    std::size_t size() const { return m_objects.size(); }
+
+protected:
+    std::vector<ptr> m_objects;
+    // where the last free object was found; objects tend to come back in
+    // the order they were handed out
+    std::size_t m_next;
+};
+
+
+template<typename T>
+template<typename... A>
+typename pool<T>::ptr pool<T>::get(A&&... args) {
+    const std::size_t n = m_objects.size();
+    for(std::size_t i = 0; i < n; i++) {
+        const std::size_t j = (m_next + i) % n;
+        if(m_objects[j]->refcount() == 1) {
+            m_next = j + 1;
+            return m_objects[j];
+        }
+    }
+
+    ptr p(new T(std::forward<A>(args)...));
+    m_objects.push_back(p);
+    m_next = 0;
+    return p;
+}
+
+}
+}
+
+#endif //JLIB_AI_POOL_HH
@@ -0,0 +1,157 @@
+/* -*- mode: C++ c-basic-offset: 4  -*-
+ *
+ * Copyright (c) 2026 Joey Yandle <xoloki@gmail.com>
+ *
+ */
+
+#ifndef JLIB_AI_QUANTIZED_HH
+#define JLIB_AI_QUANTIZED_HH
+
+#include <jlib/ai/neural.hh>
+#include <jlib/math/int8.hh>
+
+#include <algorithm>
+#include <vector>
+
+#include <cmath>
+#include <cstdint>
+
+namespace jlib {
+namespace ai {
+
+// a trained NeuralNetwork with its weights rounded to 8 bits, for queries
+// only.  each row of weights gets its own scale, and each column of
+// activations is scaled as it goes into a layer, so the products are
+// integer dot products and only the activation functions work in T.
+// answers are close to the network's, not the same
+template<typename T>
+class QuantizedNetwork {
+public:
+    explicit QuantizedNetwork(const NeuralNetwork<T>& nn);
+
+    // as NeuralNetwork, one sample per column
+    math::matrix<T> query(math::matrix<T> inputs);
+    math::matrix<T> query_batch(const math::matrix<T>& inputs);
+
+    // what the weights and their scales take up
+    std::size_t bytes() const;
+
+protected:
+    struct layer {
+        uint rows;
+        uint cols;
+        // cols rounded up to math::kernel::INT8_PAD
+        uint stride;
+        // row-major, zero past cols
+        std::vector<int8_t> weights;
+        // weight = scale * quantized weight, per row
+        std::vector<T> scale;
+        // 128 times each row's sum, taken back out of every product for the
+        // zero point the activations are stored with
+        std::vector<int32_t> offset;
+        const activation<T>* f;
+    };
+
+    std::vector<layer> m_layers;
+};
+
+
+template<typename T>
+QuantizedNetwork<T>::QuantizedNetwork(const NeuralNetwork<T>& nn) {
+    const uint pad = math::kernel::INT8_PAD;
+
+    for(uint i = 0; i < nn.layers(); i++) {
+        const math::matrix<T>& w = nn.weights(i);
+        layer l;
+        l.rows = w.M;
+        l.cols = w.N;
+        l.stride = (w.N + pad - 1) / pad * pad;
+        l.weights.assign(std::size_t(l.rows) * l.stride, 0);
+        l.scale.resize(l.rows);
+        l.offset.resize(l.rows);
+        l.f = nn.m_activations[i];
+
+        for(uint r = 0; r < l.rows; r++) {
+            T top = T(0);
+            for(uint c = 0; c < l.cols; c++) {
+                top = std::max(top, T(std::fabs(w(r, c))));
+            }
+
+            const T scale = (top > T(0) ? top / T(127) : T(1));
+            int32_t sum = 0;
+            for(uint c = 0; c < l.cols; c++) {
+                const long q = std::lrint(w(r, c) / scale);
+                l.weights[std::size_t(r) * l.stride + c] = int8_t(std::max(-127L, std::min(127L, q)));
+                sum += l.weights[std::size_t(r) * l.stride + c];
+            }
+
+            l.scale[r] = scale;
+            l.offset[r] = 128 * sum;
+        }
+
+        m_layers.push_back(l);
+    }
+}
+
+template<typename T>
+math::matrix<T> QuantizedNetwork<T>::query(math::matrix<T> inputs) {
+    return query_batch(inputs);
+}
+
+template<typename T>
+math::matrix<T> QuantizedNetwork<T>::query_batch(const math::matrix<T>& inputs) {
+    if(inputs.M != m_layers.front().cols)
+        throw typename math::matrix<T>::mismatched(m_layers.front().rows, m_layers.front().cols, inputs.M, inputs.N);
+
+    // nothing shared is written, so queries may run alongside each other
+    const uint n = inputs.N;
+    std::vector<uint8_t> q;
+    std::vector<T> scale(n);
+    std::vector<int32_t> sums;
+
+    math::matrix<T> x = (inputs.is_transposed() ? math::matrix<T>(math::leaf<T>(inputs)) : inputs);
+    for(const layer& l : m_layers) {
+        // 128 is zero, so the padding adds nothing even before the weights' zeros
+        q.assign(std::size_t(l.stride) * n, 128);
+        for(uint j = 0; j < n; j++) {
+            scale[j] = math::kernel::int8_quantize(l.cols, x.data() + std::size_t(j) * l.cols,
+                                                   q.data() + std::size_t(j) * l.stride);
+        }
+
+        sums.resize(std::size_t(l.rows) * n);
+        const std::size_t work = std::size_t(l.rows) * l.stride * n;
+        math::parallel_for(l.rows, 64, [&](std::size_t begin, std::size_t end) {
+                math::kernel::int8_dot(end - begin, n, l.stride,
+                                       l.weights.data() + begin * l.stride, l.stride,
+                                       q.data(), l.stride, sums.data() + begin, l.rows);
+            }, work);
+
+        math::matrix<T> y(l.rows, n, math::UNINITIALIZED);
+        T* py = y.data();
+        for(uint j = 0; j < n; j++) {
+            for(uint i = 0; i < l.rows; i++) {
+                const std::size_t at = std::size_t(j) * l.rows + i;
+                py[at] = T(sums[at] - l.offset[i]) * l.scale[i] * scale[j];
+            }
+        }
+
+        l.f->forward(y, y);
+        x = y;
+    }
+
+    return x;
+}
+
+template<typename T>
+std::size_t QuantizedNetwork<T>::bytes() const {
+    std::size_t total = 0;
+    for(const layer& l : m_layers) {
+        total += l.weights.size() + l.scale.size() * sizeof(T) + l.offset.size() * sizeof(int32_t);
+    }
+    return total;
+}
+
+}
+}
+
+#endif //JLIB_AI_QUANTIZED_HH
@@ -0,0 +1,78 @@
+/* -*- mode: C++ c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2026 Joey Yandle <xoloki@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+
+#include <jlib/ai/runner.hh>
+
+#include <algorithm>
+#include <atomic>
+
+
+namespace jlib {
+namespace ai {
+
+Runner::Runner(unsigned int threads)
+    : mThreads(std::max(threads, 1u)),
+      mPool(new sys::pool(mThreads - 1))
+{
+
+}
+
+Environment::score Runner::run(Environment& env, int x) {
+    mScores.assign(std::max(x, 0), 0);
+    if(x <= 0)
+        return 0;
+
+    // sys::Object reference counts aren't atomic, so no environment or
+    // agent may be shared between workers, and the clones are made here
+    std::vector<std::unique_ptr<Environment>> clones;
+    const unsigned int workers = std::min<unsigned int>(mThreads, x);
+    for(unsigned int w = 0; w < workers; w++) {
+        std::unique_ptr<Environment> e = env.clone();
+        if(!e)
+            break;
+        clones.push_back(std::move(e));
+    }
+
+    std::atomic<std::size_t> next(0);
+    auto worker = [&](Environment& e) {
+        for(std::size_t i = next++; i < std::size_t(x); i = next++) {
+            e.episode(i);
+            mScores[i] = e.run();
+        }
+    };
+
+    if(clones.empty()) {
+        worker(env);
+    } else {
+        mPool->run(clones.size(), [&](std::size_t w) { worker(*clones[w]); });
+    }
+
+    Environment::score s = 0;
+    for(int i = 0; i < x; i++) {
+        s += mScores[i];
+    }
+
+    return s/x;
+}
+
+
+}
+}
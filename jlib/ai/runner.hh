@@ -0,0 +1,64 @@
+/* -*- mode: C++ c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2026 Joey Yandle <xoloki@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+#ifndef JLIB_AI_RUNNER_HH
+#define JLIB_AI_RUNNER_HH
+
+
+#include <jlib/ai/environment.hh>
+#include <jlib/sys/sync.hh>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+
+namespace jlib {
+namespace ai {
+
+// runs an environment's episodes on a pool of threads.  every thread gets
+// its own clone of the environment and its agents, made up front on the
+// calling thread, and takes the next episode as it finishes one.  episodes
+// are seeded by number (see Environment::episode) and their scores summed
+// in order, so the result is the one env.run(x) gives once env is seeded,
+// for any number of threads
+class Runner {
+public:
+    Runner(unsigned int threads = std::thread::hardware_concurrency());
+
+    // the average score of episodes 0 to x-1.  env itself is only run when
+    // it can't be cloned
+    Environment::score run(Environment& env, int x);
+
+    // each episode's score from the last run, by episode
+    const std::vector<Environment::score>& scores() const { return mScores; }
+
+private:
+    unsigned int mThreads;
+    // the calling thread is one of the workers
+    std::unique_ptr<sys::pool> mPool;
+    std::vector<Environment::score> mScores;
+};
+
+
+}
+}
+
+#endif //JLIB_AI_RUNNER_HH
@@ -0,0 +1,211 @@
+/* -*- mode: C++ c-basic-offset: 4  -*-
+ *
+ * Copyright (c) 2026 Joey Yandle <xoloki@gmail.com>
+ *
+ */
+
+#ifndef JLIB_AI_TRAINER_HH
+#define JLIB_AI_TRAINER_HH
+
+#include <jlib/ai/neural.hh>
+#include <jlib/sys/sync.hh>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace jlib {
+namespace ai {
+
+// data parallel training for a NeuralNetwork.  a batch is cut into shards
+// of columns, and each worker works out the gradient of its shards with its
+// own scratch space.
+//
+// SYNCHRONOUS sums the shard gradients pairwise, in a fixed tree, and then
+// takes one step, the same step train_batch would take if it held the
+// weights still for the backward pass.  the result depends only on the
+// shards, so it is reproducible for a given thread count; with
+// set_deterministic(true) shards are a fixed width and it is reproducible
+// for any thread count.
+//
+// HOGWILD has every worker step the shared weights as soon as a shard is
+// done, without any locking, while the others read them.  there is no
+// reduction and no waiting, but the result depends on scheduling.
+//
+// leave math::set_threads at 1 while training this way; the workers are
+// already using every core
+template<typename T>
+class Trainer {
+public:
+    enum MODE { SYNCHRONOUS, HOGWILD };
+
+    // columns per shard when deterministic, and always for HOGWILD
+    static const uint GRAIN = 16;
+
+    Trainer(NeuralNetwork<T>& nn, unsigned int threads = std::thread::hardware_concurrency(), MODE mode = SYNCHRONOUS);
+
+    void set_mode(MODE mode);
+    void set_deterministic(bool on);
+
+    // one sample per column, at the network's rate averaged over the batch
+    // as with NeuralNetwork::train_batch
+    void train_batch(const math::matrix<T>& inputs, const math::matrix<T>& targets);
+
+    // every column once, in order, batch columns at a time
+    void train_epoch(const math::matrix<T>& inputs, const math::matrix<T>& targets, uint batch);
+
+protected:
+    struct shard {
+        typename NeuralNetwork<T>::workspace scratch;
+        std::vector<math::matrix<T>> grads;
+    };
+
+    // columns [begin, begin+width) of a column-major matrix, sharing storage
+    static math::matrix<T> columns(const math::matrix<T>& m, uint begin, uint width);
+    static math::matrix<T> column_major(const math::matrix<T>& m);
+
+    void synchronous(const math::matrix<T>& inputs, const math::matrix<T>& targets);
+    void hogwild(const math::matrix<T>& inputs, const math::matrix<T>& targets);
+
+    // m_shards[0].grads += every other shard's, pairwise
+    void reduce(uint n);
+
+    NeuralNetwork<T>& m_nn;
+    unsigned int m_threads;
+    MODE m_mode;
+    bool m_deterministic;
+    // the calling thread is one of the workers
+    std::unique_ptr<sys::pool> m_pool;
+    std::vector<shard> m_shards;
+};
+
+template<typename T>
+const uint Trainer<T>::GRAIN;
+
+
+template<typename T>
+Trainer<T>::Trainer(NeuralNetwork<T>& nn, unsigned int threads, MODE mode)
+    : m_nn(nn),
+      m_threads(std::max(threads, 1u)),
+      m_mode(mode),
+      m_deterministic(false),
+      m_pool(new sys::pool(m_threads - 1))
+{
+}
+
+template<typename T>
+void Trainer<T>::set_mode(MODE mode) {
+    m_mode = mode;
+}
+
+template<typename T>
+void Trainer<T>::set_deterministic(bool on) {
+    m_deterministic = on;
+}
+
+template<typename T>
+void Trainer<T>::train_batch(const math::matrix<T>& inputs, const math::matrix<T>& targets) {
+    if(inputs.N != targets.N)
+        throw typename math::matrix<T>::mismatched(inputs.M, inputs.N, targets.M, targets.N);
+    if(inputs.N == 0)
+        return;
+
+    const math::matrix<T> in = column_major(inputs);
+    const math::matrix<T> out = column_major(targets);
+
+    if(m_mode == HOGWILD)
+        hogwild(in, out);
+    else
+        synchronous(in, out);
+}
+
+template<typename T>
+void Trainer<T>::train_epoch(const math::matrix<T>& inputs, const math::matrix<T>& targets, uint batch) {
+    if(inputs.N != targets.N)
+        throw typename math::matrix<T>::mismatched(inputs.M, inputs.N, targets.M, targets.N);
+
+    const math::matrix<T> in = column_major(inputs);
+    const math::matrix<T> out = column_major(targets);
+
+    batch = std::max(batch, 1u);
+    for(uint b = 0; b < in.N; b += batch) {
+        const uint width = std::min(batch, in.N - b);
+        train_batch(columns(in, b, width), columns(out, b, width));
+    }
+}
+
+template<typename T>
+math::matrix<T> Trainer<T>::columns(const math::matrix<T>& m, uint begin, uint width) {
+    return math::matrix<T>(m.M, width, math::buffer<T>(m, begin * m.M, width * m.M));
+}
+
+template<typename T>
+math::matrix<T> Trainer<T>::column_major(const math::matrix<T>& m) {
+    if(!m.is_transposed())
+        return m;
+    return math::matrix<T>(math::leaf<T>(m));
+}
+
+template<typename T>
+void Trainer<T>::synchronous(const math::matrix<T>& inputs, const math::matrix<T>& targets) {
+    const uint n = inputs.N;
+    const uint width = (m_deterministic ? GRAIN : (n + m_threads - 1) / m_threads);
+    const uint count = (n + width - 1) / width;
+    if(m_shards.size() < count)
+        m_shards.resize(count);
+
+    m_pool->run(count, [&](std::size_t s) {
+            const uint begin = s * width;
+            const uint w = std::min(width, n - begin);
+            m_nn.gradient(columns(inputs, begin, w), columns(targets, begin, w),
+                          m_shards[s].grads, m_shards[s].scratch);
+        });
+
+    reduce(count);
+    m_nn.apply(m_shards[0].grads, T(m_nn.get_rate() / n));
+}
+
+template<typename T>
+void Trainer<T>::hogwild(const math::matrix<T>& inputs, const math::matrix<T>& targets) {
+    const uint n = inputs.N;
+    const uint count = (n + GRAIN - 1) / GRAIN;
+    const uint workers = std::min(m_threads, count);
+    if(m_shards.size() < workers)
+        m_shards.resize(workers);
+
+    // each worker keeps its own scratch and takes shards until none are left
+    std::atomic<uint> next(0);
+    const T rate = T(m_nn.get_rate() / n);
+    m_pool->run(workers, [&](std::size_t s) {
+            shard& mine = m_shards[s];
+            for(uint i = next++; i < count; i = next++) {
+                const uint begin = i * GRAIN;
+                const uint w = std::min(GRAIN, n - begin);
+                m_nn.gradient(columns(inputs, begin, w), columns(targets, begin, w),
+                              mine.grads, mine.scratch);
+                m_nn.apply(mine.grads, rate);
+            }
+        });
+}
+
+template<typename T>
+void Trainer<T>::reduce(uint n) {
+    const uint layers = m_shards[0].grads.size();
+
+    for(uint stride = 1; stride < n; stride *= 2) {
+        // shards i and i+stride for every i a multiple of 2*stride
+        const uint pairs = (n - stride + 2 * stride - 1) / (2 * stride);
+        m_pool->run(pairs * layers, [&](std::size_t j) {
+                const uint i = (j / layers) * 2 * stride;
+                const uint l = j % layers;
+                math::axpy(T(1), m_shards[i + stride].grads[l], m_shards[i].grads[l]);
+            });
+    }
+}
+
+}
+}
+
+#endif //JLIB_AI_TRAINER_HH
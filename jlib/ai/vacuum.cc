@@ -21,12 +21,44 @@
 
 #include <jlib/ai/vacuum.hh>
 
+#include <stdexcept>
+#include <utility>
+
 
 namespace jlib {
 namespace ai {
 namespace vacuum {
 
-Environment::Environment() 
+const Percept::sense Environment::LOCATION;
+const Percept::sense Environment::CLEANLINESS;
+
+Action::ptr Agent::move(const location& l) {
+    Move::ptr m = mMoves.get(l);
+    m->loc = l;
+    return m;
+}
+
+Action::ptr Agent::clean() {
+    return mCleans.get();
+}
+
+Environment::Environment(std::vector<location> squares, unsigned int steps, double dirt)
+    : mSquares(squares),
+      mSteps(steps),
+      mDirt(dirt),
+      mCleanCount(0)
+{
+    if(mSquares.empty())
+        throw std::invalid_argument("ai::vacuum::Environment: no squares");
+}
+
+Environment::Environment(const Environment& e)
+    : ai::Environment(e),
+      mSquares(e.mSquares),
+      mSteps(e.mSteps),
+      mDirt(e.mDirt),
+      mClean(e.mClean),
+      mCleanCount(e.mCleanCount)
 {
     
 }
@@ -35,24 +67,43 @@ Percept::ptr Environment::perceive(Agent::ptr agent, Percept::sense s) {
     Percept::ptr ret;
 
     switch(s) {
-    case LOCATION:
-        ret = Percept::ptr(new Location(mLocations[agent]));
+    case LOCATION: {
+        Location::ptr l = mLocationPercepts.get(location());
+        l->loc = mLocations[agent];
+        ret = l;
         break;
-    case CLEANLINESS:
-        ret = Percept::ptr(new Cleanliness(mClean[mLocations[agent]]));
+    }
+    case CLEANLINESS: {
+        Cleanliness::ptr c = mCleanlinessPercepts.get(false);
+        c->clean = mClean[mLocations[agent]];
+        ret = c;
         break;
     }
+    }
 
     return ret;
 }
 
 Percept::map Environment::perceive(Agent::ptr agent) {
     Percept::map ret;
+    perceive(agent, ret);
+    return ret;
+}
 
-    ret[LOCATION] = perceive(agent, LOCATION);
-    ret[CLEANLINESS] = perceive(agent, CLEANLINESS);
+void Environment::perceive(Agent::ptr agent, Percept::map& percepts) {
+    // let go of last step's percepts first, so the pools hand them back
+    Percept::ptr& l = percepts[LOCATION];
+    l.reset();
+    l = perceive(agent, LOCATION);
 
-    return ret;
+    Percept::ptr& c = percepts[CLEANLINESS];
+    c.reset();
+    c = perceive(agent, CLEANLINESS);
+}
+
+void Environment::act(Action::ptr a) {
+    if(mCurrent)
+        act(mCurrent, a);
 }
 
 void Environment::act(Agent::ptr agent, Action::ptr a) {
@@ -60,11 +111,47 @@ void Environment::act(Agent::ptr agent, Action::ptr a) {
     Clean::ptr clean = Clean::ptr::cast_dynamic(a);
 
     if(move) {
-        mLocations[agent] = move->loc;
+        // there's nowhere to go but the squares
+        if(mClean.find(move->loc) != mClean.end())
+            mLocations[agent] = move->loc;
     } else if(clean) {
-        location l = mLocations[agent];
-        mClean[l] = true;
+        bool& c = mClean[mLocations[agent]];
+        if(!c) {
+            c = true;
+            mCleanCount++;
+        }
+    }
+}
+
+Environment::score Environment::run(Agent::ptr agent) {
+    std::bernoulli_distribution dirty(mDirt);
+    mClean.clear();
+    mCleanCount = 0;
+    for(std::size_t i = 0; i < mSquares.size(); i++) {
+        const bool c = !dirty(rng());
+        mClean[mSquares[i]] = c;
+        mCleanCount += c;
     }
+
+    std::uniform_int_distribution<std::size_t> square(0, mSquares.size() - 1);
+    mLocations[agent] = mSquares[square(rng())];
+    mCurrent = agent;
+
+    score s = 0;
+    for(unsigned int t = 0; t < mSteps; t++) {
+        perceive(agent, mPercepts);
+        act(agent, agent->choose(mPercepts));
+        s += mCleanCount;
+    }
+
+    mCurrent.reset();
+    return s;
+}
+
+std::unique_ptr<ai::Environment> Environment::clone() const {
+    std::unique_ptr<Environment> e(new Environment(*this));
+    e->clone_agents();
+    return std::move(e);
 }
 
 
@@ -23,6 +23,7 @@
 
 
 #include <jlib/ai/environment.hh>
+#include <jlib/ai/pool.hh>
 
 #include <vector>
 
@@ -49,12 +50,16 @@ public:
 
 class Location : public Percept {
 public:
+    typedef Glib::RefPtr<Location> ptr;
+
     Location(location l) : loc(l) {}
     location loc;
 };
 
 class Cleanliness : public Percept {
 public:
+    typedef Glib::RefPtr<Cleanliness> ptr;
+
     Cleanliness(bool b) : clean(b) {}
     bool clean;
 };
@@ -62,23 +67,59 @@ public:
 class Agent : public ai::Agent {
 public:
 
+protected:
+    // actions from pools, so choosing one doesn't allocate
+    Action::ptr move(const location& l);
+    Action::ptr clean();
+
+private:
+    pool<Move> mMoves;
+    pool<Clean> mCleans;
 };
 
+// the vacuum world: squares that are each clean or dirty, and agents that
+// perceive their square and its state, and move to a square or clean the
+// one they're on.  an episode starts each square dirty with probability
+// dirt and the agent on a random square, and lasts the given number of
+// steps, scoring a point for every clean square at the end of each
 class Environment : public ai::Environment {
 public:
     static const Percept::sense LOCATION = 0;
     static const Percept::sense CLEANLINESS = 1;
 
-    Environment();
+    Environment(std::vector<location> squares = { location(1, 0), location(1, 1) },
+                unsigned int steps = 1000, double dirt = 0.5);
+    // the squares and their state and the same agents, but not the agents'
+    // places or anything pooled, which belong to the original's episodes
+    Environment(const Environment& e);
     virtual ~Environment() {}
 
     virtual Percept::ptr perceive(Agent::ptr agent, Percept::sense s);
     virtual Percept::map perceive(Agent::ptr agent);
+    virtual void perceive(Agent::ptr agent, Percept::map& percepts);
 
+    // for the agent whose episode is running
+    virtual void act(Action::ptr a);
     virtual void act(Agent::ptr agent, Action::ptr a);
+
+    using ai::Environment::run;
+    virtual score run(Agent::ptr agent);
+
+    virtual std::unique_ptr<ai::Environment> clone() const;
+
 private:
+    std::vector<location> mSquares;
+    unsigned int mSteps;
+    double mDirt;
+
     std::map<Agent::ptr, location> mLocations;
     std::map<location, bool> mClean;
+    std::size_t mCleanCount;
+
+    Agent::ptr mCurrent;
+    Percept::map mPercepts;
+    pool<Location> mLocationPercepts;
+    pool<Cleanliness> mCleanlinessPercepts;
 };
 
 
@@ -92,6 +92,8 @@ HyperPlot<T,Plot>::HyperPlot(uint n, std::vector< std::pair<T,T> > c, uint w, ui
       up(n),
       shape(CUBOID)
 {
+    // nothing here overrides transform
+    this->fixed_transform = true;
     initialize(n);
 }
 
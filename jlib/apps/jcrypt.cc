@@ -18,7 +18,10 @@
  * 
  */
 
+#include <fstream>
 #include <iostream>
+#include <sstream>
+#include <sys/resource.h>
 #include <unistd.h>
 
 #include <cmath>
@@ -29,10 +32,57 @@
 
 using namespace jlib::crypt;
 
+// peak resident set size so far, in kilobytes
+long peak_rss() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// encrypt file to id, to file.gpg, either through streams or by reading
+// all of it into a string first, and report the peak rss
+int encrypt_file(std::string id, std::string file, bool stream) {
+    gpg::init(GPGME_PROTOCOL_OpenPGP);
+
+    gpg::ctx ctx;
+    gpg::key::list l = gpg::list_keys(id);
+    if(l.empty()) {
+        std::cerr << "no keys for id " << id << std::endl;
+        return 1;
+    }
+
+    const long before = peak_rss();
+    std::ifstream in(file.c_str(), std::ios::binary);
+    std::ofstream out((file + ".gpg").c_str(), std::ios::binary);
+    if(!in || !out) {
+        std::cerr << "couldn't open " << file << " or " << file << ".gpg" << std::endl;
+        return 1;
+    }
+
+    if(stream) {
+        ctx.op_encrypt(l, in, out);
+    } else {
+        std::ostringstream text;
+        text << in.rdbuf();
+        gpg::data::ptr plain = gpg::data::create(text.str());
+        gpg::data::ptr cipher = gpg::data::create();
+        ctx.op_encrypt(l, plain, cipher);
+        out << cipher->read();
+    }
+
+    std::cout << (stream ? "streamed" : "in memory") << ": peak rss " << (peak_rss() / 1024) << "MB, "
+              << ((peak_rss() - before) / 1024) << "MB over the " << (before / 1024) << "MB before" << std::endl;
+    return 0;
+}
 
 int main(int argc, char** argv) {
 
     try {
+        // jcrypt --stream|--memory ID FILE
+        if(argc > 3 && (std::string(argv[1]) == "--stream" || std::string(argv[1]) == "--memory")) {
+            return encrypt_file(argv[2], argv[3], std::string(argv[1]) == "--stream");
+        }
+
         std::string id = "joey@divisionbyzero.com";
         if(argc > 1) {
             id = argv[1];
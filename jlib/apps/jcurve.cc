@@ -18,16 +18,263 @@
  * 
  */
 
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
 #include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include <jlib/crypt/curve.hh>
+#include <jlib/crypt/groth.hh>
+#include <jlib/crypt/schnorr.hh>
+#include <jlib/math/parallel.hh>
 
+using namespace jlib;
 using namespace jlib::crypt;
 
+typedef std::chrono::high_resolution_clock Clock;
+
+// run f until at least min_seconds have passed, return seconds per call
+double time(std::function<void()> f, double min_seconds = 0.25) {
+    std::size_t runs = 0;
+    const Clock::time_point start = Clock::now();
+    double s = 0;
+    do {
+        f();
+        runs++;
+        s = std::chrono::duration<double>(Clock::now() - start).count();
+    } while(s < min_seconds);
+    return s / runs;
+}
+
+// sum of N scalar multiples, a Point at a time against curve::multiexp,
+// for N = 1, 2, 4, ... max
+void bench_multiexp(std::size_t max) {
+    std::cout << "multiexp, ms" << std::endl;
+    for(std::size_t n = 1; n <= max; n *= 2) {
+        std::vector<curve::Point> points;
+        std::vector<curve::Scalar> scalars;
+        for(std::size_t i = 0; i < n; i++) {
+            points.push_back(curve::Point::random());
+            scalars.push_back(curve::Scalar::random());
+        }
+
+        curve::Point sum, fast;
+        const double naive = time([&]() {
+                sum = curve::Point::zero();
+                for(std::size_t i = 0; i < n; i++) {
+                    sum += points[i] * scalars[i];
+                }
+            });
+        const double pippenger = time([&]() { fast = curve::multiexp(points, scalars); });
+
+        std::cout << "  N " << std::setw(6) << n << std::fixed << std::setprecision(3)
+                  << "  naive " << std::setw(10) << (naive * 1e3)
+                  << "  multiexp " << std::setw(9) << (pippenger * 1e3)
+                  << std::setprecision(1) << "  x" << std::setw(5) << (naive / pippenger)
+                  << (sum == fast ? "" : "  MISMATCH") << std::endl;
+    }
+}
+
+// a groth one of many proof over N = 2, 4, ... max commitments
+void bench_groth(std::size_t max) {
+    std::cout << "groth zero proof, ms" << std::endl;
+    for(std::size_t n = 2; n <= max; n *= 2) {
+        const curve::Scalar r = curve::Scalar::random();
+        std::vector<curve::Commitment> c;
+        for(std::size_t i = 0; i < n; i++) {
+            c.push_back(i == 1 ? curve::Commitment(curve::Scalar::zero(), r) : curve::Commitment(curve::Scalar::random()));
+        }
+
+        groth::ZeroProof proof;
+        bool ok = false;
+        const double prove = time([&]() { proof = groth::prove(c, 1, r); }, 0);
+        const double verify = time([&]() { ok = groth::verify(proof); }, 0);
+
+        std::cout << "  N " << std::setw(6) << n << std::fixed << std::setprecision(1)
+                  << "  prove " << std::setw(9) << (prove * 1e3)
+                  << "  verify " << std::setw(8) << (verify * 1e3)
+                  << (ok ? "" : "  FAILED") << std::endl;
+    }
+}
+
+// proofs verified per second one at a time, and with verify_batch in
+// batches of 1, 10, ... max.  the proofs are made once, max of each kind
+template<typename P>
+void bench_batch(const std::string& name, const std::vector<P>& proofs) {
+    // one at a time doesn't depend on how many there are
+    const std::size_t some = std::min<std::size_t>(proofs.size(), 1000);
+    bool ok = true;
+    const double single = time([&]() {
+            for(std::size_t i = 0; i < some; i++) {
+                ok &= verify(proofs[i]);
+            }
+        }, 0) / some;
+
+    std::cout << "  " << name << std::fixed << std::setprecision(0)
+              << "  verify " << std::setw(8) << (1 / single) << "/s" << (ok ? "" : "  FAILED") << std::endl;
+
+    for(std::size_t n = 1; n <= proofs.size(); n *= 10) {
+        const std::vector<P> batch(proofs.begin(), proofs.begin() + n);
+        std::vector<std::size_t> bad;
+        const double s = time([&]() { bad = verify_batch(batch); }, 0.1);
+
+        std::cout << "    batch " << std::setw(6) << n << "  " << std::setw(8) << (n / s) << "/s"
+                  << std::setprecision(1) << "  x" << std::setw(5) << (single * n / s) << std::setprecision(0)
+                  << (bad.empty() ? "" : "  FAILED") << std::endl;
+    }
+}
+
+void bench_batch(std::size_t max) {
+    const curve::BasePoint G;
+    std::vector<schnorr::Proof> proofs;
+    std::vector<schnorr::DoubleProof> doubles;
+    std::vector<groth::BinaryProof> binaries;
+    for(std::size_t i = 0; i < max; i++) {
+        const curve::Scalar x = curve::Scalar::random();
+        proofs.push_back(schnorr::prove(G, x * G, x));
+
+        const schnorr::DoubleProof d;
+        const curve::Scalar s = curve::Scalar::random(), t = curve::Scalar::random();
+        doubles.push_back(schnorr::prove(d.g * s + d.h * t, s, t));
+
+        binaries.push_back(groth::prove(i % 2 ? curve::Scalar::one() : curve::Scalar::zero(), curve::Scalar::random()));
+    }
+
+    std::cout << "batch verification, proofs/s" << std::endl;
+    bench_batch("schnorr::Proof", proofs);
+    bench_batch("schnorr::DoubleProof", doubles);
+    bench_batch("groth::BinaryProof", binaries);
+}
+
+// pedersen commitments per second, from the FixedBase tables against
+// libsodium's base point and variable base products, and x^k by square and
+// multiply against the powers ladder
+void bench_commit(std::size_t max) {
+    std::vector<curve::Scalar> values, blinds;
+    for(std::size_t i = 0; i < max; i++) {
+        values.push_back(curve::Scalar::random());
+        blinds.push_back(curve::Scalar::random());
+    }
+
+    bool ok = true;
+    const double sodium = time([&]() {
+            for(std::size_t i = 0; i < max; i++) {
+                curve::Point p = values[i] * curve::Commitment::G + blinds[i] * curve::Commitment::H;
+                ok &= (p != curve::Point::zero());
+            }
+        }) / max;
+    const double table = time([&]() {
+            for(std::size_t i = 0; i < max; i++) {
+                curve::Commitment c(values[i], blinds[i]);
+                ok &= (c != curve::Point::zero());
+            }
+        }) / max;
+    const double base = time([&]() {
+            for(std::size_t i = 0; i < max; i++) {
+                ok &= (values[i] * curve::Commitment::G != curve::Point::zero());
+            }
+        }) / max;
+
+    std::cout << "commitments/s" << std::fixed << std::setprecision(0) << std::endl
+              << "  value * G + blind * H  " << std::setw(8) << (1 / sodium) << std::endl
+              << "  Commitment             " << std::setw(8) << (1 / table)
+              << std::setprecision(1) << "  x" << (sodium / table) << std::setprecision(0) << std::endl
+              << "  value * G alone        " << std::setw(8) << (1 / base) << (ok ? "" : "  FAILED") << std::endl;
+
+    const curve::Scalar x = values[0];
+    const int n = 64;
+    const double ladder = time([&]() { ok &= (curve::powers(x, n)[n] != curve::Scalar::zero()); });
+    const double each = time([&]() {
+            for(int k = 0; k <= n; k++) {
+                ok &= ((x^k) != curve::Scalar::zero());
+            }
+        });
+    std::cout << "x^0 .. x^" << n << ", us" << std::setprecision(1) << std::endl
+              << "  x^k each " << std::setw(8) << (each * 1e6) << std::endl
+              << "  powers   " << std::setw(8) << (ladder * 1e6) << std::endl;
+}
+
+// groth zero proofs over N = 1024, 2048, ... max commitments, on 1, 2,
+// 4, ... threads up to the hardware's
+void bench_prove(std::size_t max) {
+    const unsigned int hardware = std::max(std::thread::hardware_concurrency(), 1u);
+    std::vector<unsigned int> counts;
+    for(unsigned int threads = 1; threads < hardware; threads *= 2) {
+        counts.push_back(threads);
+    }
+    counts.push_back(hardware);
+
+    std::cout << "groth zero proof prove, ms" << std::endl;
+    for(std::size_t n = 1024; n <= max; n *= 2) {
+        const curve::Scalar r = curve::Scalar::random();
+        std::vector<curve::Commitment> c;
+        for(std::size_t i = 0; i < n; i++) {
+            c.push_back(i == n / 3 ? curve::Commitment(curve::Scalar::zero(), r) : curve::Commitment(curve::Scalar::random()));
+        }
+
+        std::cout << "  N " << std::setw(6) << n << std::fixed << std::setprecision(1);
+        double one = 0;
+        bool ok = true;
+        for(unsigned int threads : counts) {
+            math::set_threads(threads);
+            groth::ZeroProof proof;
+            const double s = time([&]() { proof = groth::prove(c, n / 3, r); }, 0);
+            if(threads == 1)
+                one = s;
+            ok &= groth::verify(proof);
+
+            std::cout << "  threads " << threads << " " << std::setw(9) << (s * 1e3)
+                      << " (x" << (one / s) << ")";
+        }
+        std::cout << (ok ? "" : "  FAILED") << std::endl;
+    }
+    math::set_threads(1);
+}
+
+void usage() {
+    std::cout << "usage: jcurve [multiexp|groth|batch|commit|prove] [--max N]" << std::endl;
+}
 
 int main(int argc, char** argv) {
+    std::string mode = "multiexp";
+    std::size_t max = 0;
+
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if(arg == "--max") {
+            max = std::stoul(argv[++i]);
+        } else if(arg == "--help" || arg == "-h") {
+            usage();
+            return 0;
+        } else if(arg[0] != '-') {
+            mode = arg;
+        } else {
+            std::cerr << "WARNING: unknown arg '" << arg << "'" << std::endl;
+        }
+    }
+
     try {
-        
+        if(sodium_init() < 0)
+            throw std::runtime_error("sodium_init failed");
+
+        if(mode == "multiexp") {
+            bench_multiexp(max ? max : 4096);
+        } else if(mode == "groth") {
+            bench_groth(max ? max : 4096);
+        } else if(mode == "batch") {
+            bench_batch(max ? max : 10000);
+        } else if(mode == "commit") {
+            bench_commit(max ? max : 1000);
+        } else if(mode == "prove") {
+            bench_prove(max ? max : 65536);
+        } else {
+            usage();
+            return 1;
+        }
     }
     catch(std::exception& e) {
         std::cerr << e.what() << std::endl;
@@ -39,4 +286,3 @@ int main(int argc, char** argv) {
 
     return 0;
 }
-
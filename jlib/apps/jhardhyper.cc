@@ -29,6 +29,7 @@
 #include <glibmm/timer.h>
 
 #include <jlib/math/math.hh>
+#include <jlib/math/fixed.hh>
 #include <jlib/math/Plot.hh>
 #include <jlib/glut/main.hh>
 #include <GL/glut.h>
@@ -143,6 +144,34 @@ using namespace jlib::math;
 typedef GLdouble T;
 
 
+// the projections HPlot::transform applies from d down to 4, each followed
+// by the perspective divide and the drop to d-1 dimensions
+template<typename T, uint d, bool = (d > 3)>
+struct hyper_chain {
+    hyper_chain(const std::vector< std::pair<T,T> >&) {}
+
+    math::fixed_vertex<T,3> apply(const math::fixed_vertex<T,d>& v) const {
+        return v.template change<3>();
+    }
+};
+
+template<typename T, uint d>
+struct hyper_chain<T, d, true> {
+    hyper_chain(const std::vector< std::pair<T,T> >& clip)
+        : p(math::matrix<T>::project(d, clip)),
+          next(clip)
+    {}
+
+    math::fixed_vertex<T,3> apply(const math::fixed_vertex<T,d>& v) const {
+        math::fixed_vertex<T,d> ret;
+        ret = p * v();
+        ret.normalize();
+        return next.apply(ret.template change<d-1>());
+    }
+
+    math::fixed_matrix<T,d+1,d+1> p;
+    hyper_chain<T,d-1> next;
+};
 
 
 template<typename T>
@@ -152,12 +181,21 @@ public:
 
     virtual void draw();
 
-    virtual void draw_point(math::vertex<T> p);
-    virtual void draw_line(math::vertex<T> p1, math::vertex<T> p2);
+    // every vertex arrives in three dimensions, ready for glVertex4dv
+    virtual void draw_point(const math::fixed_vertex<T,3>& p);
+    virtual void draw_line(const math::fixed_vertex<T,3>& p1, const math::fixed_vertex<T,3>& p2);
 
 protected:
     virtual math::vertex<T> transform(const math::vertex<T>& v) const;
 
+    template<uint N>
+    void project_fixed(const math::object<T>& object);
+    template<uint N>
+    void project(const math::object<T>& object, std::integral_constant<uint,N>);
+    void project(const math::object<T>& object, std::integral_constant<uint,0>);
+
+    // each vertex of the object being drawn, after transform
+    std::vector< math::fixed_vertex<T,3> > projected;
 };
 
 template<typename T>
@@ -165,12 +203,13 @@ inline
 HPlot<T>::HPlot(uint n, std::vector< std::pair<T,T> > c, uint w, uint h) 
     : glut::Plot<T>(n, c, w, h)
 {    
-
+    // project_fixed does the work of HPlot::transform
+    this->fixed_transform = true;
 }
 
 template<typename T>
 inline
-void HPlot<T>::draw_point(math::vertex<T> p) {
+void HPlot<T>::draw_point(const math::fixed_vertex<T,3>& p) {
     glBegin(GL_POINTS);
     //glVertex3d(p[0], p[1], p[2]);
     glVertex4dv(p.data());
@@ -179,10 +218,8 @@ void HPlot<T>::draw_point(math::vertex<T> p) {
 
 template<typename T>
 inline
-void HPlot<T>::draw_line(math::vertex<T> p1, math::vertex<T> p2) {
+void HPlot<T>::draw_line(const math::fixed_vertex<T,3>& p1, const math::fixed_vertex<T,3>& p2) {
     glBegin(GL_LINES);
-    //std::cout << "HPlot<T>::draw_line: p1.D: " << p1.D << "\n" << static_cast< math::matrix<T> >(p1) << std::endl
-    //          << "p2.D: " << p2.D << "\n" << static_cast< math::matrix<T> >(p2) << std::endl;
     glVertex4dv(p1.data());
     glVertex4dv(p2.data());
     //glVertex4d(p1[0], p1[1], p1[2], p1[3]);
@@ -197,31 +234,23 @@ inline
 void HPlot<T>::draw() {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    typename std::list< math::object<T> >::iterator i = math::Plot<T>::objects.begin();
-    for(; i != math::Plot<T>::objects.end(); i++) {
-        std::map<math::vertex<T>, math::vertex<T> > transformed;
+    typename std::list< math::object<T> >::iterator i = this->objects.begin();
+    typename std::list< std::vector< std::vector<uint> > >::iterator e = this->edges.begin();
+    for(; i != this->objects.end(); i++, e++) {
         math::object<T>& object = *i;
 
-        for(uint j = 0; j < object.size(); j++) {
-            math::vertex<T>& v1 = object[j];
-            math::vertex<T> tv1 = transform(v1);
-
-            transformed.insert(std::make_pair(v1, tv1));
-        }
+        projected.resize(object.size());
+        if(this->fixed_transform)
+            project(object, std::integral_constant<uint,math::FIXED_DIMENSIONS>());
+        else
+            project(object, std::integral_constant<uint,0>());
 
         for(uint j = 0; j < object.size(); j++) {
-            math::vertex<T>& v1 = object[j];
-            math::vertex<T>& tv1 = transformed.find(v1)->second;
-
-            draw_point(tv1);
-            
-            std::list< math::vertex<T> > adjacent = object.adjacent(j);
-            typename std::list< math::vertex<T> >::iterator k;
-            for(k = adjacent.begin(); k != adjacent.end(); k++) {
-                math::vertex<T>& v2 = *k;
-                math::vertex<T>& tv2 = transformed.find(v2)->second;
-
-                draw_line(tv1, tv2);
+            draw_point(projected[j]);
+
+            const std::vector<uint>& adjacent = (*e)[j];
+            for(uint k = 0; k < adjacent.size(); k++) {
+                draw_line(projected[j], projected[adjacent[k]]);
             }
         }
     }
@@ -229,6 +258,40 @@ void HPlot<T>::draw() {
 	glutSwapBuffers();    
 }
 
+template<typename T>
+template<uint N>
+inline
+void HPlot<T>::project(const math::object<T>& object, std::integral_constant<uint,N>) {
+    if(this->D == N)
+        project_fixed<N>(object);
+    else
+        project(object, std::integral_constant<uint,N-1>());
+}
+
+template<typename T>
+inline
+void HPlot<T>::project(const math::object<T>& object, std::integral_constant<uint,0>) {
+    for(uint j = 0; j < object.size(); j++) {
+        projected[j] = math::fixed_vertex<T,3>(transform(object[j]));
+    }
+}
+
+// transform for a D known at compile time, into projected
+template<typename T>
+template<uint N>
+inline
+void HPlot<T>::project_fixed(const math::object<T>& object) {
+    const math::fixed_matrix<T,N+1,N+1> view(this->modelview.top());
+    const hyper_chain<T,N> chain(this->clip);
+
+    for(uint j = 0; j < object.size(); j++) {
+        math::fixed_vertex<T,N> v(object[j]);
+        math::fixed_vertex<T,N> ret;
+        ret = view * v();
+        projected[j] = chain.apply(ret);
+    }
+}
+
 template<typename T>
 inline
 math::vertex<T> HPlot<T>::transform(const math::vertex<T>& vertex) const {
@@ -270,8 +333,8 @@ public:
 
     virtual void change(uint n);
     virtual void draw();
-    virtual void draw_point(math::vertex<T> point);
-    virtual void draw_line(math::vertex<T> p1, math::vertex<T> p2);
+    virtual void draw_point(const math::fixed_vertex<T,3>& point);
+    virtual void draw_line(const math::fixed_vertex<T,3>& p1, const math::fixed_vertex<T,3>& p2);
 
     void key_pressed(unsigned char key,int x,int y);
     void button_pressed(int button, int state, int x, int y);
@@ -350,7 +413,7 @@ void HyperPlot<T,Plot>::change(uint n) {
 
 template<typename T, typename Plot>
 inline
-void HyperPlot<T,Plot>::draw_point(math::vertex<T> point) {
+void HyperPlot<T,Plot>::draw_point(const math::fixed_vertex<T,3>& point) {
     if(first) {
         triple<T> color; color.r = 0; color.b = 0; color.g = 0;
 
@@ -371,7 +434,7 @@ void HyperPlot<T,Plot>::draw_point(math::vertex<T> point) {
 
 template<typename T, typename Plot>
 inline
-void HyperPlot<T,Plot>::draw_line(math::vertex<T> p1, math::vertex<T> p2) {
+void HyperPlot<T,Plot>::draw_line(const math::fixed_vertex<T,3>& p1, const math::fixed_vertex<T,3>& p2) {
     triple<T> color = colors[i-1];
     //set_foreground(color.r, color.g, color.b);
     GLfloat fcolors[4];
@@ -384,7 +447,7 @@ void HyperPlot<T,Plot>::draw_line(math::vertex<T> p1, math::vertex<T> p2) {
     if(p2[p2.D] != 1)
         std::cout << "draw_line: p2[p2.D] = " << p2[p2.D] << std::endl;
 
-    math::vertex<T> mid(p2.D);
+    math::fixed_vertex<T,3> mid;
     std::cout << std::fixed;
     for(unsigned int i = 0; i < mid.D; i++) {
         mid[i] = (p1[i] + p2[i]) / 2;
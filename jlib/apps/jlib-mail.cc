@@ -20,15 +20,19 @@
 
 #include <jlib/net/net.hh>
 #include <jlib/net/Imap4Folder.hh>
+#include <jlib/net/MFolder.hh>
 
 #include <jlib/sys/sys.hh>
 #include <jlib/sys/object.hh>
 
 #include <jlib/util/util.hh>
+#include <jlib/util/Date.hh>
 #include <jlib/util/URL.hh>
 
 #include <sigc++/sigc++.h>
 
+#include <algorithm>
+#include <chrono>
 #include <string>
 #include <vector>
 #include <fstream>
@@ -36,6 +40,7 @@
 #include <exception>
 #include <sstream>
 #include <cstdlib>
+#include <cstring>
 
 #define CATCH_EXCEPTIONS 1
 
@@ -206,12 +211,131 @@ namespace jlib {
     }
 }
 
+// time MailFolder::sort on an mbox, against sorting the same positions
+// by parsing both DATE headers at every comparison
+int bench_sort(std::string path) {
+    typedef std::chrono::steady_clock clock;
+
+    clock::time_point start = clock::now();
+    jlib::net::MFolder folder(path);
+    folder.scan();
+    const double scan = std::chrono::duration<double>(clock::now() - start).count();
+
+    std::vector<unsigned int> order(folder.size());
+    for(unsigned int i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+
+    start = clock::now();
+    std::sort(order.begin(), order.end(), [&folder](unsigned int a, unsigned int b) {
+            jlib::util::Date d1; d1.set(folder.at(a)["DATE"]);
+            jlib::util::Date d2; d2.set(folder.at(b)["DATE"]);
+            return d1.time() < d2.time();
+        });
+    const double parsing = std::chrono::duration<double>(clock::now() - start).count();
+
+    start = clock::now();
+    folder.sort();
+    const double keyed = std::chrono::duration<double>(clock::now() - start).count();
+
+    std::cout << folder.size() << " messages: scan " << scan << "s, sort parsing dates "
+              << parsing << "s, sort on keys " << keyed << "s" << std::endl;
+    return 0;
+}
+
+// dates per second for every DATE header in an mbox: Date::parse alone,
+// Date::set with it, and the tokenizing auto_parse that set used before
+int bench_dates(std::string path) {
+    typedef std::chrono::steady_clock clock;
+    const int ROUNDS = 10;
+
+    jlib::net::MFolder folder(path);
+    folder.scan();
+
+    std::vector<std::string> dates;
+    for(unsigned int i = 0; i < folder.size(); i++) {
+        std::string date = folder.at(i).find("DATE");
+        if(date != "")
+            dates.push_back(date);
+    }
+    if(dates.empty()) {
+        std::cerr << path << " has no dated messages" << std::endl;
+        return 1;
+    }
+
+    std::vector<time_t> fast(dates.size()), slow(dates.size());
+    unsigned int missed = 0;
+    struct tm t;
+
+    clock::time_point start = clock::now();
+    for(int r = 0; r < ROUNDS; r++) {
+        missed = 0;
+        for(unsigned int i = 0; i < dates.size(); i++) {
+            if(!jlib::util::Date::parse(dates[i], &t))
+                missed++;
+        }
+    }
+    const double parse = std::chrono::duration<double>(clock::now() - start).count();
+
+    jlib::util::Date d;
+    start = clock::now();
+    for(int r = 0; r < ROUNDS; r++) {
+        for(unsigned int i = 0; i < dates.size(); i++) {
+            try {
+                d.set(dates[i]);
+                fast[i] = d.time();
+            } catch(std::exception& e) {
+                fast[i] = 0;
+            }
+        }
+    }
+    const double set = std::chrono::duration<double>(clock::now() - start).count();
+
+    start = clock::now();
+    for(int r = 0; r < ROUNDS; r++) {
+        for(unsigned int i = 0; i < dates.size(); i++) {
+            try {
+                std::memset(d.stm(), 0, sizeof(struct tm));
+                std::istringstream is(dates[i]);
+                d.auto_parse(is);
+                d.reinit();
+                slow[i] = d.time();
+            } catch(std::exception& e) {
+                slow[i] = 0;
+            }
+        }
+    }
+    const double tokenized = std::chrono::duration<double>(clock::now() - start).count();
+
+    unsigned int differ = 0;
+    for(unsigned int i = 0; i < dates.size(); i++) {
+        if(fast[i] != slow[i])
+            differ++;
+    }
+
+    const double n = double(dates.size()) * ROUNDS;
+    std::cout << dates.size() << " dates, " << missed << " off the fast path, "
+              << differ << " parsed differently by auto_parse" << std::endl
+              << "Date::parse " << n / parse << " dates/s" << std::endl
+              << "Date::set   " << n / set << " dates/s" << std::endl
+              << "auto_parse  " << n / tokenized << " dates/s" << std::endl;
+    return 0;
+}
+
 int main(int argc, char** argv) {
 #if CATCH_EXCEPTIONS
     try {
 #endif
         std::string url;
 
+        if(argc > 2 && std::string(argv[1]) == "--sort") {
+            return bench_sort(argv[2]);
+        }
+
+        if(argc > 2 && std::string(argv[1]) == "--dates") {
+            return bench_dates(argv[2]);
+        }
+
         if(argc > 1) {
             url = argv[1];
         }
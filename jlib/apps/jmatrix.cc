@@ -0,0 +1,717 @@
+/* -*- mode: C++ c-basic-offset: 4  -*-
+ *
+ * Copyright (c) 2026 Joey Yandle <xoloki@gmail.com>
+ *
+ */
+
+#include <jlib/math/matrix.hh>
+#include <jlib/ai/neural.hh>
+#include <jlib/ai/trainer.hh>
+#include <jlib/ai/activation.hh>
+#include <jlib/ai/quantized.hh>
+#include <jlib/ai/dataset.hh>
+#include <jlib/util/util.hh>
+
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iomanip>
+#include <iterator>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cstdio>
+
+using namespace jlib;
+
+typedef std::chrono::high_resolution_clock Clock;
+
+std::default_random_engine generator;
+
+template<typename T>
+math::matrix<T> random_matrix(uint m, uint n);
+
+template<typename T>
+math::matrix<T> naive(const math::matrix<T>& a, const math::matrix<T>& b);
+
+// run f until at least min_seconds have passed, return seconds per call
+double time(std::function<void()> f, double min_seconds = 0.25);
+
+template<typename T>
+void bench_gemm(uint m, uint n, uint k, bool transpose, bool run_naive);
+
+// gemm against strassen at several cutoffs, in effective (2n^3) GFLOP/s
+template<typename T>
+void bench_strassen(uint n, const std::vector<uint>& cutoffs);
+
+// the network's weight update, one temporary per operator against the fused form
+template<typename T>
+void bench_fuse(uint m, uint n, uint k);
+
+// a forward and backward pass written one temporary per operator, with the
+// allocator's pool on and off, timed and counted in system allocations
+template<typename T>
+void bench_alloc(const std::vector<uint>& layers, uint batch);
+
+// training and query throughput, one sample per call against train_batch
+// and query_batch at several batch sizes
+template<typename T>
+void bench_train(const std::vector<uint>& layers, const std::vector<uint>& batches);
+
+// saving and loading a model as json and in the binary format, with the
+// size of each file
+template<typename T>
+void bench_model(const std::vector<uint>& layers);
+
+// sigmoid and tanh over a layer's outputs, elementwise through the library's
+// exp against the registry's kernels at each instruction set
+template<typename T>
+void bench_activation(uint m, uint n);
+
+// query throughput of a network against its int8 quantization at each
+// instruction set, and how often they pick the same output
+template<typename T>
+void bench_quantize(const std::vector<uint>& layers, const std::vector<uint>& batches);
+
+// reading an MNIST-shaped csv of count samples a line at a time through
+// tokenize, as the jneural apps used to, against the dataset loader, and
+// the same samples as IDX files
+template<typename T>
+void bench_dataset(uint count);
+
+void usage();
+
+int main(int argc, char** argv) {
+    std::string mode = "gemm";
+    std::string type = "double";
+    bool run_naive = true;
+    bool transpose = false;
+    std::vector<uint> sizes;
+    std::vector<uint> cutoffs;
+
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if(arg == "--float") {
+            type = "float";
+        } else if(arg == "--double") {
+            type = "double";
+        } else if(arg == "--no-naive") {
+            run_naive = false;
+        } else if(arg == "--transpose") {
+            transpose = true;
+        } else if(arg == "--threads") {
+            math::set_threads(std::stoi(argv[++i]));
+        } else if(arg == "--cutoff") {
+            cutoffs.push_back(std::stoi(argv[++i]));
+        } else if(arg == "--size") {
+            sizes.push_back(std::stoi(argv[++i]));
+        } else if(arg == "--help" || arg == "-h") {
+            usage();
+            return 0;
+        } else if(arg[0] != '-') {
+            mode = arg;
+        } else {
+            std::cerr << "WARNING: unknown arg '" << arg << "'" << std::endl;
+        }
+    }
+
+    if(mode == "gemm") {
+        if(sizes.empty())
+            sizes = { 64, 128, 256, 512, 1024 };
+
+        std::cout << "square" << std::endl;
+        for(uint s : sizes) {
+            if(type == "float")
+                bench_gemm<float>(s, s, s, transpose, run_naive && s <= 1024);
+            else
+                bench_gemm<double>(s, s, s, transpose, run_naive && s <= 1024);
+        }
+
+        // shapes the neural network actually sees: weights times a column or thin batch
+        const uint tall[][3] = {
+            { 200, 1, 784 }, { 784, 1, 200 }, { 1000, 16, 784 }, { 8192, 16, 16 }, { 8192, 64, 64 },
+        };
+
+        std::cout << "tall-skinny" << std::endl;
+        for(auto& t : tall) {
+            if(type == "float")
+                bench_gemm<float>(t[0], t[1], t[2], transpose, run_naive);
+            else
+                bench_gemm<double>(t[0], t[1], t[2], transpose, run_naive);
+        }
+    } else if(mode == "strassen") {
+        if(sizes.empty())
+            sizes = { 256, 512, 1000, 1024, 2048 };
+        if(cutoffs.empty())
+            cutoffs = { 128, 256, 512, 1024 };
+
+        for(uint s : sizes) {
+            if(type == "float")
+                bench_strassen<float>(s, cutoffs);
+            else
+                bench_strassen<double>(s, cutoffs);
+        }
+    } else if(mode == "fuse") {
+        // [rows, cols] of the weights and the batch width, as in a 784-200-10 network
+        const uint shapes[][3] = {
+            { 200, 784, 1 }, { 10, 200, 1 }, { 200, 784, 16 }, { 10, 200, 16 }, { 1024, 1024, 64 },
+        };
+
+        for(auto& s : shapes) {
+            if(type == "float")
+                bench_fuse<float>(s[0], s[1], s[2]);
+            else
+                bench_fuse<double>(s[0], s[1], s[2]);
+        }
+    } else if(mode == "alloc") {
+        // layer widths of the networks jneural trains, and the batch width
+        const std::vector<uint> nets[] = {
+            { 784, 200, 10 }, { 784, 100, 50, 10 }, { 64, 64, 64, 64 },
+        };
+
+        for(auto& n : nets) {
+            for(uint batch : { 1u, 16u }) {
+                if(type == "float")
+                    bench_alloc<float>(n, batch);
+                else
+                    bench_alloc<double>(n, batch);
+            }
+        }
+    } else if(mode == "train") {
+        // the --size flags are batch sizes here
+        if(sizes.empty())
+            sizes = { 8, 32, 128 };
+
+        const std::vector<uint> nets[] = {
+            { 784, 100, 10 }, { 784, 200, 10 }, { 784, 100, 50, 10 },
+        };
+
+        for(auto& n : nets) {
+            if(type == "float")
+                bench_train<float>(n, sizes);
+            else
+                bench_train<double>(n, sizes);
+        }
+    } else if(mode == "model") {
+        const std::vector<uint> nets[] = {
+            { 784, 200, 10 }, { 784, 1000, 10 }, { 784, 1000, 1000, 10 },
+        };
+
+        for(auto& n : nets) {
+            if(type == "float")
+                bench_model<float>(n);
+            else
+                bench_model<double>(n);
+        }
+    } else if(mode == "activation") {
+        // a hidden layer's outputs at the batch widths train sees
+        const uint shapes[][2] = {
+            { 200, 1 }, { 200, 32 }, { 1000, 128 }, { 4096, 256 },
+        };
+
+        for(auto& s : shapes) {
+            if(type == "float")
+                bench_activation<float>(s[0], s[1]);
+            else
+                bench_activation<double>(s[0], s[1]);
+        }
+    } else if(mode == "quantize") {
+        // the --size flags are batch sizes here
+        if(sizes.empty())
+            sizes = { 1, 32, 256 };
+
+        const std::vector<uint> nets[] = {
+            { 784, 200, 10 }, { 784, 1000, 10 }, { 784, 1000, 1000, 10 },
+        };
+
+        for(auto& n : nets) {
+            if(type == "float")
+                bench_quantize<float>(n, sizes);
+            else
+                bench_quantize<double>(n, sizes);
+        }
+    } else if(mode == "dataset") {
+        // the --size flags are sample counts here
+        if(sizes.empty())
+            sizes = { 10000, 60000 };
+
+        for(uint n : sizes) {
+            if(type == "float")
+                bench_dataset<float>(n);
+            else
+                bench_dataset<double>(n);
+        }
+    } else {
+        usage();
+        return 1;
+    }
+
+    return 0;
+}
+
+void usage() {
+    std::cout << "usage: jmatrix [gemm|strassen|fuse|alloc|train|model|activation|quantize|dataset] [--float|--double] [--size N]... [--transpose] [--no-naive] [--threads N]" << std::endl;
+    std::cout << "                [--cutoff N]..." << std::endl;
+}
+
+template<typename T>
+math::matrix<T> random_matrix(uint m, uint n) {
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    math::matrix<T> ret(m, n);
+    ret.foreach([&](T& x) {
+            x = dist(generator);
+        });
+    return ret;
+}
+
+template<typename T>
+math::matrix<T> naive(const math::matrix<T>& a, const math::matrix<T>& b) {
+    math::matrix<T> ret(a.M, b.N);
+    for(uint j = 0; j < b.N; j++) {
+        for(uint i = 0; i < a.M; i++) {
+            T sum = 0;
+            for(uint k = 0; k < a.N; k++) {
+                sum += a(i,k) * b(k,j);
+            }
+            ret(i,j) = sum;
+        }
+    }
+    return ret;
+}
+
+double time(std::function<void()> f, double min_seconds) {
+    uint runs = 0;
+    Clock::time_point start = Clock::now();
+    double elapsed = 0;
+
+    do {
+        f();
+        runs++;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    } while(elapsed < min_seconds);
+
+    return elapsed / runs;
+}
+
+template<typename T>
+void bench_gemm(uint m, uint n, uint k, bool transpose, bool run_naive) {
+    math::matrix<T> a = random_matrix<T>(m, k);
+    math::matrix<T> b = transpose ? random_matrix<T>(n, k) : random_matrix<T>(k, n);
+    math::matrix<T> bop = transpose ? b.transpose() : b;
+    const double flops = 2.0 * m * n * k;
+
+    std::cout << "  [" << m << "," << k << "] * [" << k << "," << n << "]" << (transpose ? "^T" : "") << std::flush;
+
+    if(run_naive) {
+        double s = time([&]() { naive(a, bop); });
+        std::cout << "  naive " << std::setw(7) << std::fixed << std::setprecision(2) << (flops / s / 1e9) << std::flush;
+    }
+
+    math::kernel::isa best = math::kernel::get_isa();
+    for(int i = math::kernel::SCALAR; i <= math::kernel::detect(); i++) {
+        math::kernel::set_isa(static_cast<math::kernel::isa>(i));
+        double s = time([&]() { a * bop; });
+        std::cout << "  " << math::kernel::name(math::kernel::get_isa()) << " "
+                  << std::setw(7) << std::fixed << std::setprecision(2) << (flops / s / 1e9) << std::flush;
+    }
+    math::kernel::set_isa(best);
+
+    std::cout << "  GFLOP/s" << std::endl;
+}
+
+template<typename T>
+void bench_strassen(uint n, const std::vector<uint>& cutoffs) {
+    math::matrix<T> a = random_matrix<T>(n, n);
+    math::matrix<T> b = random_matrix<T>(n, n);
+    const double flops = 2.0 * n * n * n;
+    const std::size_t cutoff = math::kernel::get_strassen_cutoff();
+
+    std::cout << "  [" << n << "," << n << "]" << std::flush;
+
+    double s = time([&]() { a * b; });
+    std::cout << "  gemm " << std::setw(7) << std::fixed << std::setprecision(2) << (flops / s / 1e9) << std::flush;
+
+    for(uint c : cutoffs) {
+        math::kernel::set_strassen_cutoff(c);
+        s = time([&]() { math::strassen(a, b); });
+        std::cout << "  " << c << " " << std::setw(7) << std::fixed << std::setprecision(2) << (flops / s / 1e9) << std::flush;
+    }
+    math::kernel::set_strassen_cutoff(cutoff);
+
+    std::cout << "  GFLOP/s" << std::endl;
+}
+
+template<typename T>
+void bench_fuse(uint m, uint n, uint k) {
+    math::matrix<T> e = random_matrix<T>(m, k);
+    math::matrix<T> o = random_matrix<T>(m, k);
+    math::matrix<T> h = random_matrix<T>(n, k);
+    math::matrix<T> w = random_matrix<T>(m, n);
+    const double rate = 0.01;
+
+    std::cout << "  w[" << m << "," << n << "] += rate * ((e ^ o ^ (1 - o)) * h^T), batch " << k << std::flush;
+
+    double eager = time([&]() {
+            math::matrix<T> d1 = 1.0 - o;
+            math::matrix<T> d2 = e ^ o;
+            math::matrix<T> d3 = d2 ^ d1;
+            math::matrix<T> p = d3 * h.transpose();
+            math::matrix<T> u = rate * p;
+            w += u;
+        });
+    double fused = time([&]() {
+            w += rate * ((e ^ o ^ (1.0 - o)) * h.transpose());
+        });
+
+    std::cout << "  eager " << std::setw(8) << std::fixed << std::setprecision(2) << (eager * 1e6)
+              << "us  fused " << std::setw(8) << (fused * 1e6)
+              << "us  " << std::setprecision(2) << (eager / fused) << "x" << std::endl;
+}
+
+template<typename T>
+void bench_alloc(const std::vector<uint>& layers, uint batch) {
+    std::vector<math::matrix<T> > w;
+    for(uint i = 1; i < layers.size(); i++) {
+        w.push_back(random_matrix<T>(layers[i], layers[i-1]));
+    }
+    math::matrix<T> in = random_matrix<T>(layers.front(), batch);
+    math::matrix<T> target = random_matrix<T>(layers.back(), batch);
+    const T rate = 0.01;
+
+    auto step = [&]() {
+        std::vector<math::matrix<T> > out;
+        math::matrix<T> x = in;
+        for(auto& l : w) {
+            x = l * x;
+            out.push_back(x);
+        }
+
+        math::matrix<T> e = target - out.back();
+        for(int i = w.size() - 1; i >= 0; i--) {
+            const math::matrix<T>& prev = (i == 0 ? in : out[i-1]);
+            math::matrix<T> d = e ^ out[i];
+            w[i] += rate * (d * prev.transpose());
+            e = w[i].transpose() * e;
+        }
+    };
+
+    std::cout << "  [";
+    for(uint i = 0; i < layers.size(); i++) {
+        std::cout << (i ? "-" : "") << layers[i];
+    }
+    std::cout << "] batch " << std::setw(2) << batch << std::flush;
+
+    const bool pooling = math::allocator::get_pooling();
+    for(bool on : { false, true }) {
+        math::allocator::set_pooling(on);
+        step();
+
+        const std::size_t before = math::allocator::system_allocations();
+        const int calls = 100;
+        for(int i = 0; i < calls; i++) {
+            step();
+        }
+        const double per = double(math::allocator::system_allocations() - before) / calls;
+        const double s = time(step);
+
+        std::cout << (on ? "  pooled " : "  system ") << std::setw(8) << std::fixed << std::setprecision(2)
+                  << (s * 1e6) << "us " << std::setw(6) << std::setprecision(1) << per << " allocs" << std::flush;
+    }
+    math::allocator::set_pooling(pooling);
+
+    std::cout << std::endl;
+}
+
+template<typename T>
+void bench_train(const std::vector<uint>& layers, const std::vector<uint>& batches) {
+    const uint samples = 1024;
+    const std::vector<uint> hidden(layers.begin() + 1, layers.end() - 1);
+    ai::NeuralNetwork<T> nn(0.1, layers.front(), hidden, layers.back());
+
+    math::matrix<T> inputs = random_matrix<T>(layers.front(), samples);
+    math::matrix<T> targets = random_matrix<T>(layers.back(), samples);
+
+    // every sample, or every batch, cut out ahead of time
+    auto cut = [&](const math::matrix<T>& m, uint width) {
+        std::vector<math::matrix<T> > ret;
+        for(uint b = 0; b < samples; b += width) {
+            math::matrix<T> part(m.M, width, math::UNINITIALIZED);
+            std::copy(m.data() + std::size_t(b) * m.M, m.data() + std::size_t(b + width) * m.M, part.data());
+            ret.push_back(part);
+        }
+        return ret;
+    };
+
+    std::cout << "  [";
+    for(uint i = 0; i < layers.size(); i++) {
+        std::cout << (i ? "-" : "") << layers[i];
+    }
+    std::cout << "] samples/s" << std::endl;
+
+    std::vector<math::matrix<T> > in = cut(inputs, 1);
+    std::vector<math::matrix<T> > out = cut(targets, 1);
+    double train = time([&]() {
+            for(uint i = 0; i < in.size(); i++) {
+                nn.learn(in[i], out[i]);
+            }
+        });
+    double query = time([&]() {
+            for(uint i = 0; i < in.size(); i++) {
+                nn.query(in[i]);
+            }
+        });
+
+    std::cout << "    per sample  train " << std::setw(10) << std::fixed << std::setprecision(0) << (samples / train)
+              << "  query " << std::setw(10) << (samples / query) << std::endl;
+
+    for(uint b : batches) {
+        if(samples % b)
+            continue;
+
+        in = cut(inputs, b);
+        out = cut(targets, b);
+        double btrain = time([&]() {
+                for(uint i = 0; i < in.size(); i++) {
+                    nn.learn_batch(in[i], out[i]);
+                }
+            });
+        double bquery = time([&]() {
+                for(uint i = 0; i < in.size(); i++) {
+                    nn.query_batch(in[i]);
+                }
+            });
+
+        std::cout << "    batch " << std::setw(4) << b << "  train " << std::setw(10) << (samples / btrain)
+                  << "  query " << std::setw(10) << (samples / bquery)
+                  << "  " << std::setprecision(1) << (train / btrain) << "x " << (query / bquery) << "x"
+                  << std::setprecision(0) << std::endl;
+    }
+
+    // an epoch of batches of 128 through Trainer, on more and more threads
+    const uint hardware = std::max(std::thread::hardware_concurrency(), 1u);
+    std::vector<uint> counts;
+    for(uint threads = 1; threads < hardware; threads *= 2) {
+        counts.push_back(threads);
+    }
+    counts.push_back(hardware);
+
+    for(uint threads : counts) {
+        ai::Trainer<T> sync(nn, threads, ai::Trainer<T>::SYNCHRONOUS);
+        ai::Trainer<T> hogwild(nn, threads, ai::Trainer<T>::HOGWILD);
+        double s = time([&]() { sync.train_epoch(inputs, targets, 128); });
+        double h = time([&]() { hogwild.train_epoch(inputs, targets, 128); });
+
+        std::cout << "    threads " << std::setw(2) << threads << "  sync " << std::setw(10) << (samples / s)
+                  << "  hogwild " << std::setw(10) << (samples / h) << std::endl;
+    }
+}
+
+template<typename T>
+void bench_model(const std::vector<uint>& layers) {
+    const std::vector<uint> hidden(layers.begin() + 1, layers.end() - 1);
+    ai::NeuralNetwork<T> nn(0.1, layers.front(), hidden, layers.back());
+    const std::string json = "/tmp/jmatrix-model.json";
+    const std::string binary = "/tmp/jmatrix-model.nn";
+
+    auto size = [](const std::string& path) {
+        std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+        return double(ifs.tellg()) / (1 << 20);
+    };
+
+    std::cout << "  [";
+    for(uint i = 0; i < layers.size(); i++) {
+        std::cout << (i ? "-" : "") << layers[i];
+    }
+    std::cout << "]" << std::endl;
+
+    // json is slow enough that one run of each is plenty
+    double jsave = time([&]() {
+            std::ofstream ofs(json);
+            ofs << nn.json()->str(true);
+        }, 0);
+    double jload = time([&]() {
+            std::ifstream ifs(json);
+            std::string cache((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+            ai::NeuralNetwork<T> loaded(util::json::object::create(cache));
+        }, 0);
+
+    double bsave = time([&]() { nn.save(binary); });
+    double bload = time([&]() { ai::NeuralNetwork<T> loaded(binary); });
+
+    // loading maps the file, so the first pass over the weights pays for the reads
+    math::matrix<T> input = random_matrix<T>(layers.front(), 1);
+    double bquery = time([&]() {
+            ai::NeuralNetwork<T> loaded(binary);
+            loaded.query(input);
+        });
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "    json    " << std::setw(8) << size(json) << " MB  save " << std::setw(10) << (jsave * 1e3)
+              << " ms  load " << std::setw(10) << (jload * 1e3) << " ms" << std::endl
+              << "    binary  " << std::setw(8) << size(binary) << " MB  save " << std::setw(10) << (bsave * 1e3)
+              << " ms  load " << std::setw(10) << (bload * 1e3) << " ms  load+query " << std::setw(8)
+              << (bquery * 1e3) << " ms  " << std::setprecision(0) << (jload / bload) << "x" << std::endl;
+
+    std::remove(json.c_str());
+    std::remove(binary.c_str());
+}
+
+template<typename T>
+void bench_activation(uint m, uint n) {
+    const math::matrix<T> x = random_matrix<T>(m, n);
+    math::matrix<T> y(m, n);
+
+    std::cout << "  [" << m << "," << n << "]" << std::endl;
+
+    const math::kernel::isa best = math::kernel::get_isa();
+    for(const std::string name : { "sigmoid", "tanh" }) {
+        const bool sigmoid = (name == "sigmoid");
+        double old = time([&]() {
+                y.foreach_index([&](uint r, uint c, T& val) {
+                        val = (sigmoid ? T(1) / (T(1) + std::exp(-x(r, c))) : std::tanh(x(r, c)));
+                    }, math::PARALLEL);
+            });
+
+        std::cout << "    " << std::setw(8) << std::left << name << std::right << " std "
+                  << std::setw(9) << std::fixed << std::setprecision(2) << (old * 1e6) << "us" << std::flush;
+
+        const ai::activation<T>& f = ai::activation<T>::get(name);
+        for(int i = math::kernel::SCALAR; i <= best; i++) {
+            math::kernel::set_isa(math::kernel::isa(i));
+            double s = time([&]() { f.forward(x, y); });
+            std::cout << "  " << math::kernel::name(math::kernel::isa(i)) << " " << std::setw(9) << (s * 1e6)
+                      << "us " << std::setw(5) << (old / s) << "x" << std::flush;
+        }
+        math::kernel::set_isa(best);
+
+        std::cout << std::endl;
+    }
+}
+
+template<typename T>
+void bench_quantize(const std::vector<uint>& layers, const std::vector<uint>& batches) {
+    const std::vector<uint> hidden(layers.begin() + 1, layers.end() - 1);
+    ai::NeuralNetwork<T> nn(0.1, layers.front(), hidden, layers.back());
+    ai::QuantizedNetwork<T> q(nn);
+
+    std::size_t full = 0;
+    for(uint i = 1; i < layers.size(); i++) {
+        full += std::size_t(layers[i]) * layers[i-1] * sizeof(T);
+    }
+
+    std::cout << "  [";
+    for(uint i = 0; i < layers.size(); i++) {
+        std::cout << (i ? "-" : "") << layers[i];
+    }
+    std::cout << "] weights " << std::fixed << std::setprecision(2) << (full / double(1 << 20)) << " MB, int8 "
+              << (q.bytes() / double(1 << 20)) << " MB" << std::endl;
+
+    // inputs like pixels, which is what the network is trained on
+    std::uniform_real_distribution<T> dist(0, 1);
+    const math::kernel::isa best = math::kernel::get_isa();
+    for(uint batch : batches) {
+        math::matrix<T> input(layers.front(), batch);
+        input.foreach([&](T& x) { x = dist(generator); });
+
+        double s = time([&]() { nn.query_batch(input); });
+        std::cout << "    batch " << std::setw(3) << batch << "  " << (sizeof(T) == 4 ? "float " : "double")
+                  << std::setw(10) << std::setprecision(0) << (batch / s) << "/s" << std::flush;
+
+        for(int i = math::kernel::SCALAR; i <= best; i++) {
+            math::kernel::set_isa(math::kernel::isa(i));
+            double qs = time([&]() { q.query_batch(input); });
+            std::cout << "  " << math::kernel::name(math::kernel::isa(i))
+                      << (i == math::kernel::AVX512 && math::kernel::vnni() ? "-vnni" : "") << std::setw(10)
+                      << (batch / qs) << "/s " << std::setprecision(2) << std::setw(5) << (s / qs) << "x"
+                      << std::setprecision(0) << std::flush;
+        }
+        math::kernel::set_isa(best);
+
+        math::matrix<T> a = nn.query_batch(input);
+        math::matrix<T> b = q.query_batch(input);
+        uint agree = 0;
+        for(uint c = 0; c < batch; c++) {
+            uint x = 0, y = 0;
+            for(uint r = 1; r < a.M; r++) {
+                if(a(r, c) > a(x, c)) x = r;
+                if(b(r, c) > b(y, c)) y = r;
+            }
+            agree += (x == y);
+        }
+        std::cout << "  agree " << std::setprecision(1) << (100.0 * agree / batch) << "%" << std::endl;
+    }
+}
+
+template<typename T>
+void bench_dataset(uint count) {
+    const std::string csv = "/tmp/jmatrix-dataset.csv";
+    const std::string images = "/tmp/jmatrix-dataset-images-idx3-ubyte";
+    const std::string labels = "/tmp/jmatrix-dataset-labels-idx1-ubyte";
+    const uint features = 784;
+
+    // mostly blank pixels, like the digits
+    std::uniform_int_distribution<int> label(0, 9);
+    std::uniform_int_distribution<int> pixel(0, 255);
+    std::bernoulli_distribution ink(0.2);
+    {
+        std::ofstream ofs(csv);
+        std::ofstream ifs(images, std::ios::binary);
+        std::ofstream lfs(labels, std::ios::binary);
+        auto big32 = [](std::ofstream& os, uint32_t v) {
+            const char b[] = { char(v >> 24), char(v >> 16), char(v >> 8), char(v) };
+            os.write(b, 4);
+        };
+        big32(ifs, 0x803); big32(ifs, count); big32(ifs, 28); big32(ifs, 28);
+        big32(lfs, 0x801); big32(lfs, count);
+
+        std::string line;
+        for(uint i = 0; i < count; i++) {
+            const int l = label(generator);
+            lfs.put(char(l));
+            line = std::to_string(l);
+            for(uint j = 0; j < features; j++) {
+                const int p = (ink(generator) ? pixel(generator) : 0);
+                ifs.put(char(p));
+                line += ',';
+                line += std::to_string(p);
+            }
+            line += '\n';
+            ofs << line;
+        }
+    }
+
+    std::ifstream sfs(csv, std::ios::binary | std::ios::ate);
+    const double mb = double(sfs.tellg()) / (1 << 20);
+
+    std::size_t check = 0;
+    double old = time([&]() {
+            std::vector<std::tuple<int,math::matrix<T>>> inputs;
+            std::ifstream ifs(csv);
+            std::string line;
+            while(std::getline(ifs, line)) {
+                std::vector<std::string> inlist = util::tokenize(line, ",");
+                math::matrix<T> input(inlist.size() - 1, 1);
+                for(std::size_t i = 0; i < input.M; i++) {
+                    input(i, 0) = ((util::int_value(inlist[i+1]) / 255.0) * 0.99) + 0.01;
+                }
+                inputs.push_back(std::make_tuple(util::int_value(inlist.front()), input));
+            }
+            check = inputs.size();
+        }, 0);
+    double fast = time([&]() { check = ai::dataset<T>::csv(csv).size(); });
+    double idx = time([&]() { check = ai::dataset<T>::load(images).size(); });
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "  " << std::setw(6) << check << " samples, " << std::setw(7) << mb << " MB csv" << std::endl
+              << "    tokenize  " << std::setw(10) << (old * 1e3) << " ms  " << std::setw(7) << (mb / old) << " MB/s" << std::endl
+              << "    dataset   " << std::setw(10) << (fast * 1e3) << " ms  " << std::setw(7) << (mb / fast) << " MB/s  "
+              << std::setprecision(1) << (old / fast) << "x" << std::endl
+              << "    idx       " << std::setw(10) << std::setprecision(2) << (idx * 1e3) << " ms" << std::endl;
+
+    std::remove(csv.c_str());
+    std::remove(images.c_str());
+    std::remove(labels.c_str());
+}
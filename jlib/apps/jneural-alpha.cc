@@ -10,6 +10,7 @@
 #include <jlib/sys/Directory.hh>
 #include <jlib/sys/sys.hh>
 #include <jlib/ai/neural.hh>
+#include <jlib/ai/dataset.hh>
 
 #include <functional>
 #include <random>
@@ -136,25 +137,10 @@ int main(int argc, char** argv) {
 
     if(!train_mnist_path.empty()) {
         std::cout << "Loading mnist data from " << train_mnist_path << std::endl;
-        std::ifstream ifs(train_mnist_path);
-        while(ifs) {
-            std::string line;
-            std::getline(ifs, line);
-            if(ifs) {
-                std::vector<std::string> inlist = util::tokenize(line, ",");
-                int size = inlist.size() - 1;
-		
-                //std::cout << "Got " << size << " elements" << std::endl;
-		
-                int label = util::int_value(inlist.front());
-                math::matrix<double> input(size, 1);
-		
-                for(std::size_t i = 0; i < size; i++) {
-                    input(i, 0) = ((util::int_value(inlist[i+1]) / 255.0) * 0.99) + 0.01;
-                }
-
-                inputs.push_back(std::make_tuple(label, input));
-            }
+        // each sample is a column of the dataset, not a copy of one
+        const ai::dataset<T> mnist = ai::dataset<T>::load(train_mnist_path);
+        for(std::size_t i = 0; i < mnist.size(); i++) {
+            inputs.push_back(std::make_tuple(mnist.label(i), mnist.sample(i)));
         }
     }
 
@@ -189,7 +175,7 @@ int main(int argc, char** argv) {
                 
                 target(n, 0) = 0.99;
 		
-                nn->train(input, target);
+                nn->learn(input, target);
 		
                 target(n, 0) = 0.01;
             }
@@ -211,40 +197,22 @@ int main(int argc, char** argv) {
 
         uint count = 0, correct = 0;
   
-        std::ifstream tfs(test_mnist_path);
-        while(tfs) {
-            std::string line;
-            std::getline(tfs, line);
-            if(tfs) {
-                std::vector<std::string> inlist = util::tokenize(line, ",");
-                int size = inlist.size() - 1;
-  
-                //std::cout << "Got " << size << " elements" << std::endl;
-      
-                int label = util::int_value(inlist.front());
-                math::matrix<double> input(size, 1);
-      
-                for(std::size_t i = 0; i < size; i++) {
-                    input(i, 0) = ((util::int_value(inlist[i+1]) / 255.0) * 0.99) + 0.01;
+        const ai::dataset<T> tests = ai::dataset<T>::load(test_mnist_path);
+        for(std::size_t t = 0; t < tests.size(); t++) {
+            math::matrix<double> output = nn->query(tests.sample(t));
+
+            double max = output(0, 0);
+            uint x = 0;
+            for(uint i = 1; i < output.M; i++) {
+                if(output(i, 0) > max) {
+                    max = output(i, 0);
+                    x = i;
                 }
-
-                math::matrix<double> output = nn->query(input);
-
-                double max = output(0, 0);
-                uint x = 0;
-                for(uint i = 1; i < output.M; i++) {
-                    if(output(i, 0) > max) {
-                        max = output(i, 0);
-                        x = i;
-                    }
-                }
-      
-                //std::cout << "Expected " << label << " got " << x << std::endl;
-                count++;
-                if(label == x)
-                    correct++;
             }
 
+            count++;
+            if(tests.label(t) == int(x))
+                correct++;
         }
 
         double ratio = correct / double(count);
@@ -0,0 +1,44 @@
+/* -*- mode: C++ c-basic-offset: 4  -*-
+ * 
+ * Copyright (c) 2026 Joey Yandle <xoloki@gmail.com>
+ * 
+ */
+
+#include <jlib/util/json.hh>
+#include <jlib/ai/neural.hh>
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace jlib;
+
+typedef double T;
+
+int main(int argc, char** argv) {
+    if(argc != 3) {
+        std::cerr << "usage: jneural-convert <from> <to>" << std::endl;
+        std::cerr << "  converts models between json and the binary format by file extension" << std::endl;
+        return 1;
+    }
+
+    const std::string from = argv[1];
+    const std::string to = argv[2];
+
+    try {
+        std::unique_ptr<ai::NeuralNetwork<T>> nn = ai::model::load<T>(from);
+
+        if(ai::model::is_json(to)) {
+            std::ofstream ofs(to);
+            ofs << nn->json()->str(true);
+        } else {
+            nn->save(to);
+        }
+    } catch(std::exception& e) {
+        std::cerr << "jneural-convert: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,171 @@
+/* -*- mode: C++ c-basic-offset: 4  -*-
+ *
+ * Copyright (c) 2026 Joey Yandle <xoloki@gmail.com>
+ *
+ */
+
+#include <jlib/ai/dataset.hh>
+#include <jlib/sys/socketstream.hh>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cstdlib>
+
+#include <netinet/tcp.h>
+
+using namespace jlib;
+
+typedef double T;
+typedef std::chrono::steady_clock Clock;
+
+// load for jneural-serve: a number of connections, each sending requests
+// one after another as fast as they are answered, and then the latency
+// each saw, the rate overall, how many answers matched the labels, and
+// what the server counted
+
+sys::socketstream* connect(const std::string& host, uint port, const std::string& path) {
+    if(!path.empty())
+        return new sys::socketstream(path);
+
+    // a request is several writes, and nagle would hold the last one back
+    // until the server's delayed ack
+    sys::socketstream* s = new sys::socketstream(host, port);
+    int one = 1;
+    setsockopt(s->get_socket(), IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return s;
+}
+
+int main(int argc, char** argv) {
+    std::string host = "127.0.0.1";
+    uint port = 7070;
+    std::string path;
+    std::string test_mnist_path;
+    uint features = 784;
+    uint connections = 8;
+    uint requests = 1000;
+
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if(arg == "--host") {
+            host = argv[++i];
+        } else if(arg == "--port") {
+            port = std::atoi(argv[++i]);
+        } else if(arg == "--socket") {
+            path = argv[++i];
+        } else if(arg == "--test-mnist-path") {
+            test_mnist_path = argv[++i];
+        } else if(arg == "--features") {
+            features = std::atoi(argv[++i]);
+        } else if(arg == "--connections") {
+            connections = std::max(std::atoi(argv[++i]), 1);
+        } else if(arg == "--requests") {
+            requests = std::atoi(argv[++i]);
+        } else {
+            std::cerr << "WARNING: unknown arg '" << arg << "'" << std::endl;
+            std::cerr << "usage: jneural-load [--host A] [--port N | --socket PATH] [--test-mnist-path F | --features N]" << std::endl;
+            std::cerr << "                    [--connections N] [--requests N]" << std::endl;
+            return 1;
+        }
+    }
+
+    // the request lines, made once; random pixels without a test set
+    std::vector<std::string> lines;
+    std::vector<int> labels;
+    try {
+        if(!test_mnist_path.empty()) {
+            const ai::dataset<T> tests = ai::dataset<T>::load(test_mnist_path, 1, 0);
+            for(std::size_t i = 0; i < tests.size(); i++) {
+                math::matrix<T> s = tests.sample(i);
+                std::string line;
+                for(uint r = 0; r < s.M; r++) {
+                    line += (r ? "," : "") + std::to_string(int(s(r, 0)));
+                }
+                lines.push_back(line);
+                labels.push_back(tests.label(i));
+            }
+        } else {
+            std::default_random_engine generator;
+            std::uniform_int_distribution<int> pixel(0, 255);
+            for(uint i = 0; i < 1000; i++) {
+                std::string line;
+                for(uint r = 0; r < features; r++) {
+                    line += (r ? "," : "") + std::to_string(pixel(generator));
+                }
+                lines.push_back(line);
+            }
+        }
+    } catch(std::exception& e) {
+        std::cerr << "jneural-load: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::vector<std::vector<double>> latencies(connections);
+    std::atomic<std::size_t> correct(0), errors(0);
+    std::vector<std::thread> clients;
+    const Clock::time_point start = Clock::now();
+    for(uint c = 0; c < connections; c++) {
+        clients.push_back(std::thread([&, c]() {
+                    try {
+                        std::unique_ptr<sys::socketstream> s(connect(host, port, path));
+                        std::string answer;
+                        for(uint i = 0; i < requests; i++) {
+                            const std::size_t n = (std::size_t(c) * requests + i) % lines.size();
+                            const Clock::time_point sent = Clock::now();
+                            *s << lines[n] << std::endl;
+                            if(!std::getline(*s, answer))
+                                throw std::runtime_error("connection closed");
+                            latencies[c].push_back(std::chrono::duration<double, std::micro>(Clock::now() - sent).count());
+
+                            if(answer.compare(0, 6, "error:") == 0)
+                                errors++;
+                            else if(!labels.empty() && std::atoi(answer.c_str()) == labels[n])
+                                correct++;
+                        }
+                    } catch(std::exception& e) {
+                        std::cerr << "jneural-load: connection " << c << ": " << e.what() << std::endl;
+                        errors++;
+                    }
+                }));
+    }
+    for(auto& t : clients) {
+        t.join();
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<double> all;
+    for(auto& l : latencies) {
+        all.insert(all.end(), l.begin(), l.end());
+    }
+    std::sort(all.begin(), all.end());
+    auto at = [&all](double q) {
+        return all.empty() ? 0.0 : all[std::min<std::size_t>(all.size() - 1, std::size_t(q * all.size()))];
+    };
+
+    std::cout << std::fixed << std::setprecision(0)
+              << all.size() << " requests on " << connections << " connections in " << std::setprecision(2)
+              << seconds << "s: " << std::setprecision(0) << (all.size() / seconds) << "/s, p50 " << at(0.50)
+              << "us p99 " << at(0.99) << "us, " << errors << " errors" << std::endl;
+    if(!labels.empty() && !all.empty())
+        std::cout << std::setprecision(2) << (100.0 * correct / all.size()) << "% correct" << std::endl;
+
+    try {
+        std::unique_ptr<sys::socketstream> s(connect(host, port, path));
+        std::string stats;
+        *s << "stats" << std::endl;
+        if(std::getline(*s, stats))
+            std::cout << "server: " << stats << std::endl;
+    } catch(std::exception& e) {
+        std::cerr << "jneural-load: " << e.what() << std::endl;
+    }
+
+    return 0;
+}
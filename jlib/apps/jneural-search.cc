@@ -10,9 +10,16 @@
 #include <jlib/sys/Directory.hh>
 #include <jlib/sys/sys.hh>
 #include <jlib/ai/neural.hh>
+#include <jlib/ai/trainer.hh>
+#include <jlib/ai/quantized.hh>
+#include <jlib/ai/dataset.hh>
+#include <jlib/sys/sync.hh>
 
+#include <algorithm>
+#include <chrono>
 #include <functional>
 #include <random>
+#include <memory>
 #include <mutex>
 #include <fstream>
 #include <tuple>
@@ -27,9 +34,24 @@ using namespace jlib;
 using namespace jlib::util;
 
 typedef double T;
+typedef ai::dataset<T> samples;
+
+// one point of the hidden layer grid, trained an epoch at a time
+struct run {
+    std::vector<uint> hidden;
+    std::string output_file;
+    // built when the run first trains, and let go when it is finished
+    std::unique_ptr<ai::NeuralNetwork<T>> nn;
+    // where the run is in the grid, to break ties between equal scores
+    std::size_t index;
+    double rate;
+    uint epoch;
+    bool loaded;
+    // success rate on the test set after the last epoch, or -1
+    double score;
+};
 
 math::matrix<T> load(std::string path, uint r, uint c, bool greyscale = true);
-std::vector<std::tuple<int,math::matrix<T>>> load_mnist(std::string path);
 
 char convert(int n);
 int convert(char c);
@@ -50,7 +72,10 @@ int main(int argc, char** argv) {
     int ONODES = 62;
     const std::string S = "Sample";
     const std::string I = "img";
-    uint epochs = 1, train_multi = 1;
+    uint epochs = 1, batch_size = 1, threads = 1, jobs = 1, halving = 0;
+    bool hogwild = false, deterministic = false, quantize = false;
+    std::string activation = "sigmoid";
+    std::string backend = "cpu";
     std::string train_path, test_train_path, test_my_path, load_file, output_file, train_mnist_path, test_mnist_path;
     double train_rate = 0.1;
     int train_decay = -1;
@@ -62,9 +87,31 @@ int main(int argc, char** argv) {
         } else if(arg == "--train-epochs") {
             epochs = util::int_value(argv[++i]);
         } else if(arg == "--train-multi") {
-            train_multi = util::int_value(argv[++i]);
+            // no longer used, but still accepted
+            i++;
         } else if(arg == "--train-rate") {
             train_rate = util::double_value(argv[++i]);
+        } else if(arg == "--batch-size") {
+            batch_size = std::max(util::int_value(argv[++i]), 1);
+        } else if(arg == "--threads") {
+            threads = std::max(util::int_value(argv[++i]), 1);
+        } else if(arg == "--hogwild") {
+            hogwild = true;
+        } else if(arg == "--deterministic") {
+            deterministic = true;
+        } else if(arg == "--quantize") {
+            quantize = true;
+        } else if(arg == "--jobs") {
+            jobs = std::max(util::int_value(argv[++i]), 1);
+        } else if(arg == "--halving") {
+            halving = util::int_value(argv[++i]);
+        } else if(arg == "--activation") {
+            activation = argv[++i];
+            // fail here rather than in the first worker to build a network
+            ai::activation<T>::get(activation);
+        } else if(arg == "--backend") {
+            backend = argv[++i];
+            ai::backend<T>::get(backend);
         } else if(arg == "--train-decay") {
             train_decay = std::stoi(argv[++i]);
         } else if(arg == "--test-train-path") {
@@ -103,166 +150,327 @@ int main(int argc, char** argv) {
     int INODES = R*C;
 
     std::vector<uint> hidden;
-    for(int i = 0; i < hlayers; i++) {
+    for(uint i = 0; i < hlayers; i++) {
         hidden.push_back(hmin);
     }
 
-    std::vector<std::tuple<int,math::matrix<T>>> inputs = load_mnist(train_mnist_path);
-    std::uniform_int_distribution<int> idist(0, inputs.size()-1);
-    bool finished = false, first = true;
-    sys::Directory pwd("./");
-    std::multimap<double, std::vector<uint>> results;
-    
-    while(!finished) {
-        if(!first) {
-            // go backwards finding a layer to increment
-            bool found = false;
-            for(int i = hlayers - 1; i >= 0; i--) {
-                if(hidden[i] < hmax) {
-                    hidden[i] += hdiff;
-		    
-                    // now go back forwards and reset to hmin
-                    for(int j = i+1; j < hlayers; j++) {
-                        hidden[j] = hmin;
-                    }
-		    
-                    found = true;
-                    break;
+    // every run reads the same samples, and only this thread writes them
+    std::cout << "Loading mnist data from " << train_mnist_path << std::endl;
+    const samples inputs = samples::load(train_mnist_path);
+    std::unique_ptr<samples> tests;
+    if(!test_mnist_path.empty()) {
+        std::cout << "Loading mnist data from " << test_mnist_path << std::endl;
+        tests.reset(new samples(samples::load(test_mnist_path)));
+    }
+
+    if(halving > 1 && !tests) {
+        std::cerr << "WARNING: --halving needs --test-mnist-path, training every run to the end" << std::endl;
+        halving = 0;
+    }
+
+    // every point of the grid, in the order the search has always walked it
+    std::vector<std::vector<uint>> grid;
+    while(true) {
+        grid.push_back(hidden);
+
+        // go backwards finding a layer to increment
+        bool found = false;
+        for(int i = hlayers - 1; i >= 0; i--) {
+            if(hidden[i] < hmax) {
+                hidden[i] += hdiff;
+
+                // now go back forwards and reset to hmin
+                for(uint j = i+1; j < hlayers; j++) {
+                    hidden[j] = hmin;
                 }
+
+                found = true;
+                break;
             }
-	    
-            if(!found) {
-                finished = true;
-                continue;
-            }
-        } else {
-            first = false;
         }
 
+        if(!found)
+            break;
+    }
+
+    sys::Directory pwd("./");
+    std::multimap<double, std::vector<uint>> results;
+    // guards results and the console
+    std::mutex lock;
+
+    std::vector<std::unique_ptr<run>> runs;
+    for(std::size_t g = 0; g < grid.size(); g++) {
+        std::unique_ptr<run> r(new run());
+        r->hidden = grid[g];
+        r->index = g;
+        r->rate = train_rate;
+        r->epoch = 0;
+        r->loaded = false;
+        r->score = -1;
+
         std::ostringstream os;
         os << "deep-search";
-        for(auto h : hidden) {
+        for(auto h : r->hidden) {
             os << "-" << h << "h";
         }
         os << "-" << train_rate << "r";
         os << "-" << epochs << "e";
         os << ".json";
-        output_file = os.str();
-            
-        bool exists = false;
+        r->output_file = os.str();
+
         try {
-            if(pwd.is(output_file, sys::REGULAR)) {
-                exists = true;
+            if(pwd.is(r->output_file, sys::REGULAR)) {
+                r->loaded = true;
+                r->epoch = epochs;
             }
         } catch(...) {
         }
 
-        std::unique_ptr<ai::NeuralNetwork<double>> nn;
-        if(exists) {
-            std::cout << "Loading " << output_file << std::endl;
-	    
-            std::string cache;
-            std::ifstream ifs(output_file);
-            sys::read(ifs, cache);
-	    
-            json::object::ptr o = json::object::create(cache);
-	    
-            nn.reset(new ai::NeuralNetwork<double>(o));
-        } else {
-            std::cout << "Training " << output_file << std::endl;
-            nn.reset(new ai::NeuralNetwork<double>(train_rate, INODES, hidden, ONODES));
+        runs.push_back(std::move(r));
+    }
 
-            math::matrix<T> target(ONODES, 1);
-            target.foreach([](T& x) {
-                    x = 0.01;
-                });
-        
-            for(uint e = 0; e < epochs; e++) {
-                std::cout << "Training epoch " << e << ", " << inputs.size() << " inputs" << std::endl;
-                if(train_decay > 0 && ((e % train_decay) == (train_decay - 1))) {
-                    std::cout << "Decay training rate from " << train_rate << " to " << (train_rate / 10.0) << std::endl;
-                    train_rate /= 10.0;
-                    nn->set_rate(train_rate);
-                }
-            
-                std::cout << "Shuffling inputs... " << std::flush;
-                for(int i = 0; i < inputs.size(); i++) {
-                    int x = idist(generator);
-                    auto tmp = inputs[i];
-                    inputs[i] = inputs[x];
-                    inputs[x] = tmp;
-                }
-                std::cout << "done" << std::endl;
-            
-                for(auto i : inputs) {
-                    int n = std::get<0>(i);
-                    math::matrix<T> input = std::get<1>(i);
-                
-                    target(n, 0) = 0.99;
-		
-                    nn->train(input, target);
-		
-                    target(n, 0) = 0.01;
+    // every run takes the samples of an epoch in the same order, each
+    // epoch's a fresh shuffle of the last's, made by whichever run gets
+    // there first
+    std::vector<std::unique_ptr<const std::vector<std::size_t>>> orders;
+    std::mutex orders_lock;
+    std::default_random_engine shuffler;
+    auto order = [&](uint e) -> const std::vector<std::size_t>& {
+        std::unique_lock<std::mutex> l(orders_lock);
+        while(orders.size() <= e) {
+            std::vector<std::size_t>* o = new std::vector<std::size_t>();
+            if(orders.empty()) {
+                for(std::size_t i = 0; i < inputs.size(); i++) {
+                    o->push_back(i);
                 }
+            } else {
+                *o = *orders.back();
             }
 
-            json::object::ptr o = nn->json();
-            std::string str = o->str(true);
-            
-            std::cout << "Writing " << output_file << std::endl;
-            
-            std::ofstream ofs(output_file);
-            ofs << str;
+            std::uniform_int_distribution<std::size_t> idist(0, o->size() - 1);
+            for(std::size_t i = 0; i < o->size(); i++) {
+                std::swap((*o)[i], (*o)[idist(shuffler)]);
+            }
+            orders.emplace_back(o);
+        }
+        return *orders[e];
+    };
+
+    // one more epoch of r, building its network first if need be
+    auto train = [&](run& r) {
+        if(!r.nn) {
+            std::unique_lock<std::mutex> l(lock);
+            if(r.loaded) {
+                std::cout << "Loading " << r.output_file << std::endl;
+                l.unlock();
+
+                std::string cache;
+                std::ifstream ifs(r.output_file);
+                sys::read(ifs, cache);
+
+                json::object::ptr o = json::object::create(cache);
+                r.nn.reset(new ai::NeuralNetwork<T>(o));
+                r.nn->set_backend(backend);
+            } else {
+                std::cout << "Training " << r.output_file << std::endl;
+                l.unlock();
+
+                r.nn.reset(new ai::NeuralNetwork<T>(r.rate, INODES, r.hidden, ONODES));
+                r.nn->set_activation(activation);
+                r.nn->set_backend(backend);
+            }
         }
 
-        if(!test_mnist_path.empty()) {
-            std::cout << "Opening " << test_mnist_path << std::endl;
-
-            uint count = 0, correct = 0;
-  
-            std::ifstream tfs(test_mnist_path);
-            while(tfs) {
-                std::string line;
-                std::getline(tfs, line);
-                if(tfs) {
-                    std::vector<std::string> inlist = util::tokenize(line, ",");
-                    int size = inlist.size() - 1;
-  
-                    //std::cout << "Got " << size << " elements" << std::endl;
-      
-                    int label = util::int_value(inlist.front());
-                    math::matrix<double> input(size, 1);
-      
-                    for(std::size_t i = 0; i < size; i++) {
-                        input(i, 0) = ((util::int_value(inlist[i+1]) / 255.0) * 0.99) + 0.01;
-                    }
+        if(r.epoch >= epochs)
+            return;
 
-                    math::matrix<double> output = nn->query(input);
+        const uint e = r.epoch++;
+        if(train_decay > 0 && ((e % uint(train_decay)) == uint(train_decay - 1))) {
+            r.rate /= 10.0;
+            r.nn->set_rate(r.rate);
+        }
 
-                    double max = output(0, 0);
-                    uint x = 0;
-                    for(uint i = 1; i < output.M; i++) {
-                        if(output(i, 0) > max) {
-                            max = output(i, 0);
-                            x = i;
-                        }
+        const std::vector<std::size_t>& shuffled = order(e);
+
+        // shards each batch over the threads; one thread trains in place
+        ai::Trainer<T> trainer(*r.nn, threads, (hogwild ? ai::Trainer<T>::HOGWILD : ai::Trainer<T>::SYNCHRONOUS));
+        trainer.set_deterministic(deterministic);
+
+        math::matrix<T> target(ONODES, 1);
+        target.foreach([](T& x) {
+                x = 0.01;
+            });
+
+        // the samples are shared by every run, so each batch of the
+        // shuffle is gathered into the same matrix
+        math::matrix<T> input(inputs.features(), batch_size, math::UNINITIALIZED);
+        for(std::size_t b = 0; b < shuffled.size(); b += batch_size) {
+            uint width = std::min<std::size_t>(batch_size, shuffled.size() - b);
+            inputs.gather(shuffled, b, width, input);
+
+            if(width == 1 && threads == 1) {
+                int n = inputs.label(shuffled[b]);
+                target(n, 0) = 0.99;
+                r.nn->learn(input, target);
+                target(n, 0) = 0.01;
+                continue;
+            }
+
+            math::matrix<T> targets(ONODES, width);
+            targets.foreach_index([&](uint row, uint c, T& x) {
+                    x = (int(row) == inputs.label(shuffled[b + c]) ? 0.99 : 0.01);
+                });
+
+            if(threads > 1)
+                trainer.train_batch(input, targets);
+            else
+                r.nn->learn_batch(input, targets);
+        }
+
+        r.score = -1;
+    };
+
+    // the fraction of the test set query gets right
+    auto score = [&](std::function<math::matrix<T>(const math::matrix<T>&)> query) {
+        uint count = 0, correct = 0;
+        for(std::size_t b = 0; b < tests->size(); b += batch_size) {
+            uint width = std::min<std::size_t>(batch_size, tests->size() - b);
+            math::matrix<T> output = query(tests->batch(b, width));
+
+            for(uint c = 0; c < width; c++) {
+                double max = output(0, c);
+                uint x = 0;
+                for(uint i = 1; i < output.M; i++) {
+                    if(output(i, c) > max) {
+                        max = output(i, c);
+                        x = i;
                     }
-      
-                    //std::cout << "Expected " << label << " got " << x << std::endl;
-                    count++;
-                    if(label == x)
-                        correct++;
                 }
 
+                count++;
+                if(tests->label(b + c) == int(x))
+                    correct++;
             }
+        }
+
+        return correct / double(count);
+    };
+
+    auto test = [&](run& r) {
+        if(!tests || r.score >= 0)
+            return;
+
+        typedef std::chrono::steady_clock clock;
+        const clock::time_point start = clock::now();
+        r.score = score([&](const math::matrix<T>& in) { return r.nn->query_batch(in); });
+        const double seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+        if(!quantize || r.epoch < epochs)
+            return;
+
+        // the same network with int8 weights, for serving
+        ai::QuantizedNetwork<T> q(*r.nn);
+        const clock::time_point qstart = clock::now();
+        const double qscore = score([&](const math::matrix<T>& in) { return q.query_batch(in); });
+        const double qseconds = std::chrono::duration<double>(clock::now() - qstart).count();
+
+        std::size_t bytes = 0;
+        const std::vector<uint> widths = [&]() {
+            std::vector<uint> w(1, INODES);
+            w.insert(w.end(), r.hidden.begin(), r.hidden.end());
+            w.push_back(ONODES);
+            return w;
+        }();
+        for(uint i = 1; i < widths.size(); i++) {
+            bytes += std::size_t(widths[i]) * widths[i - 1] * sizeof(T);
+        }
+
+        std::unique_lock<std::mutex> l(lock);
+        std::cout << "Quantized " << r.output_file << ": " << qscore * 100 << "% against " << r.score * 100
+                  << "%, " << tests->size() / qseconds << " against " << tests->size() / seconds
+                  << " samples/s, " << q.bytes() / double(1 << 20) << " against " << bytes / double(1 << 20)
+                  << " MB of weights" << std::endl;
+    };
+
+    // record how r did and let its network go
+    auto finish = [&](run& r) {
+        std::string str;
+        if(!r.loaded && r.epoch == epochs)
+            str = r.nn->json()->str(true);
+
+        std::unique_lock<std::mutex> l(lock);
+        if(!str.empty()) {
+            std::cout << "Writing " << r.output_file << std::endl;
+            std::ofstream ofs(r.output_file);
+            ofs << str;
+        }
+
+        if(r.score >= 0) {
+            std::cout << "Got " << r.score * 100 << "% success rate for " << r.output_file;
+            if(r.epoch < epochs)
+                std::cout << ", cut after " << r.epoch << " epochs";
+            std::cout << std::endl;
+
+            results.insert(results.begin(), std::make_pair(r.score, r.hidden));
+        }
 
-            double ratio = correct / double(count);
-            std::cout << "Got " << ratio * 100 << "% success rate" << std::endl;
+        r.nn.reset();
+    };
 
-            results.insert(results.begin(), std::make_pair(ratio, hidden));
+    // the calling thread runs jobs too
+    sys::pool pool(jobs - 1);
+
+    std::vector<run*> live;
+    for(auto& r : runs) {
+        live.push_back(r.get());
+    }
+
+    if(halving > 1) {
+        // successive halving: every live run takes one more epoch, then only
+        // the best 1/halving of them go on to the next.  a run is finished,
+        // and its network let go, as soon as enough runs of its rung have
+        // beaten it, so a rung holds at most the survivors and one network
+        // per job
+        auto better = [](const run* a, const run* b) {
+            return (a->score > b->score || (a->score == b->score && a->index < b->index));
+        };
+
+        for(uint e = 0; e < epochs && live.size() > 1; e++) {
+            std::cout << "Training epoch " << e << " of " << live.size() << " runs" << std::endl;
+
+            const std::size_t keep = (e + 1 == epochs ? live.size() : (live.size() + halving - 1) / halving);
+            std::vector<run*> best;
+            std::mutex best_lock;
+
+            pool.run(live.size(), [&](std::size_t i) {
+                    run* r = live[i];
+                    train(*r);
+                    test(*r);
+
+                    {
+                        std::unique_lock<std::mutex> l(best_lock);
+                        best.insert(std::upper_bound(best.begin(), best.end(), r, better), r);
+                        if(best.size() <= keep)
+                            return;
+                        r = best.back();
+                        best.pop_back();
+                    }
+                    finish(*r);
+                });
+
+            live.swap(best);
         }
     }
 
+    pool.run(live.size(), [&](std::size_t i) {
+            run& r = *live[i];
+            do {
+                train(r);
+            } while(r.epoch < epochs);
+            test(r);
+            finish(r);
+        });
+
     std::cout << "Results" << std::endl;
 
     std::ostringstream ros;
@@ -295,35 +503,6 @@ int main(int argc, char** argv) {
     return 0;
 }
 
-std::vector<std::tuple<int,math::matrix<T>>> load_mnist(std::string path) {
-    std::cout << "Loading mnist data from " << path << std::endl;
-    std::vector<std::tuple<int,math::matrix<T>>> inputs;
-    std::ifstream ifs(path);
-    while(ifs) {
-        std::string line;
-        std::getline(ifs, line);
-        if(ifs) {
-            std::vector<std::string> inlist = util::tokenize(line, ",");
-            int size = inlist.size() - 1;
-            
-            //std::cout << "Got " << size << " elements" << std::endl;
-            
-            int label = util::int_value(inlist.front());
-            math::matrix<double> input(size, 1);
-            
-            for(std::size_t i = 0; i < size; i++) {
-                input(i, 0) = ((util::int_value(inlist[i+1]) / 255.0) * 0.99) + 0.01;
-            }
-            
-            inputs.push_back(std::make_tuple(label, input));
-        }
-    }
-
-    return inputs;
-}
-
-
-
 math::matrix<T> load(std::string path, uint r, uint c, bool greyscale) {
     using MagickCore::Quantum;
     const uint QMAX = QuantumRange;
@@ -361,10 +540,6 @@ math::matrix<T> load(std::string path, uint r, uint c, bool greyscale) {
     if(image.rows() != r || image.columns() != c) {
         //std::cout << "Scaling image from " << image.rows() << "x" << image.columns() << " to " << r << "x" <<  c << std::endl;
 	
-        uint rscale = image.rows() / r;
-        uint cscale = image.columns() / c;
-        //std::cout << "Scale down 1/" << rscale << ", 1/" << cscale << std::endl;
-	
         image.zoom(Magick::Geometry(r, c));
     }
     
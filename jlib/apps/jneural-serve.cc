@@ -0,0 +1,279 @@
+/* -*- mode: C++ c-basic-offset: 4  -*-
+ *
+ * Copyright (c) 2026 Joey Yandle <xoloki@gmail.com>
+ *
+ */
+
+#include <jlib/util/json.hh>
+#include <jlib/ai/neural.hh>
+#include <jlib/ai/quantized.hh>
+#include <jlib/ai/dataset.hh>
+#include <jlib/ai/batcher.hh>
+#include <jlib/sys/socketserver.hh>
+#include <jlib/sys/socketstream.hh>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <csignal>
+#include <cstdlib>
+
+#include <sys/socket.h>
+
+using namespace jlib;
+
+typedef double T;
+
+// answers classification requests for a trained model over a socket, one
+// request per line:
+//
+//   a line of comma separated inputs, scaled as the dataset loader scales
+//   them, so that a line of an mnist csv without its label is a request,
+//   is answered "<class>,<output>" for the largest output
+//
+//   "stats" is answered with one line of counts since the last report
+//
+// and anything it cannot read is answered "error: <why>".  requests from
+// every connection are batched together; see ai::Batcher
+
+std::string format(const ai::Batcher<T>::stats& s) {
+    std::ostringstream o;
+    o << std::fixed << std::setprecision(0)
+      << "requests " << s.requests << " batches " << s.batches
+      << " queue " << s.queued << " max " << s.max_queued
+      << " p50 " << s.p50 << "us p99 " << s.p99 << "us sizes";
+    for(std::size_t i = 0; i < s.sizes.size(); i++) {
+        if(s.sizes[i])
+            o << " " << (1u << i) << "+:" << s.sizes[i];
+    }
+    return o.str();
+}
+
+int main(int argc, char** argv) {
+    std::string model;
+    std::string host = "127.0.0.1";
+    uint port = 7070;
+    std::string path;
+    uint max_batch = 64;
+    uint max_wait = 500;
+    uint max_connections = 256;
+    uint report = 0;
+    bool quantize = false;
+    T scale = ai::dataset<T>::PIXEL_SCALE;
+    T offset = ai::dataset<T>::PIXEL_OFFSET;
+
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if(arg == "--model") {
+            model = argv[++i];
+        } else if(arg == "--host") {
+            host = argv[++i];
+        } else if(arg == "--port") {
+            port = std::atoi(argv[++i]);
+        } else if(arg == "--socket") {
+            path = argv[++i];
+        } else if(arg == "--max-batch") {
+            max_batch = std::atoi(argv[++i]);
+        } else if(arg == "--max-wait") {
+            max_wait = std::atoi(argv[++i]);
+        } else if(arg == "--max-connections") {
+            max_connections = std::max(1, std::atoi(argv[++i]));
+        } else if(arg == "--report") {
+            report = std::atoi(argv[++i]);
+        } else if(arg == "--quantize") {
+            quantize = true;
+        } else if(arg == "--scale") {
+            scale = std::atof(argv[++i]);
+        } else if(arg == "--offset") {
+            offset = std::atof(argv[++i]);
+        } else if(arg == "--threads") {
+            math::set_threads(std::atoi(argv[++i]));
+        } else {
+            std::cerr << "WARNING: unknown arg '" << arg << "'" << std::endl;
+        }
+    }
+
+    if(model.empty()) {
+        std::cerr << "usage: jneural-serve --model <file> [--host A] [--port N | --socket PATH]" << std::endl;
+        std::cerr << "                     [--max-batch N] [--max-wait US] [--max-connections N]" << std::endl;
+        std::cerr << "                     [--report S] [--quantize] [--scale X] [--offset X] [--threads N]" << std::endl;
+        return 1;
+    }
+
+    // a client going away mid answer is that connection's problem
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::unique_ptr<ai::NeuralNetwork<T>> nn;
+    std::unique_ptr<ai::QuantizedNetwork<T>> q;
+    std::unique_ptr<sys::socketserver> server;
+    try {
+        nn = ai::model::load<T>(model);
+        if(quantize)
+            q.reset(new ai::QuantizedNetwork<T>(*nn));
+
+        if(path.empty())
+            server.reset(new sys::socketserver(host, port));
+        else
+            server.reset(new sys::socketserver(path));
+    } catch(std::exception& e) {
+        std::cerr << "jneural-serve: " << e.what() << std::endl;
+        return 1;
+    }
+
+    const uint features = nn->get_inputs();
+    ai::Batcher<T> batcher(features, [&](const math::matrix<T>& in) {
+            return (q ? q->query_batch(in) : nn->query_batch(in));
+        }, max_batch, max_wait);
+
+    std::cout << "Serving " << model << (q ? " quantized" : "") << ", " << features << " inputs, on "
+              << (path.empty() ? host + ":" + std::to_string(server->port()) : path) << std::endl;
+
+    // the reporter and every connection use the batcher, so all of them are
+    // joined before main returns.  lock guards stopping and connections
+    struct connection {
+        std::thread thread;
+        int sock;
+        bool done;
+    };
+    std::mutex lock;
+    std::condition_variable changed;
+    bool stopping = false;
+    std::list<connection> connections;
+
+    std::thread reporter;
+    if(report > 0) {
+        reporter = std::thread([&]() {
+                std::unique_lock<std::mutex> l(lock);
+                while(!changed.wait_for(l, std::chrono::seconds(report), [&]() { return stopping; })) {
+                    l.unlock();
+                    std::cout << format(batcher.report()) << std::endl;
+                    l.lock();
+                }
+            });
+    }
+
+    auto answer = [&](std::iostream& s) {
+        std::string line;
+        std::vector<T> input;
+        while(std::getline(s, line)) {
+            if(!line.empty() && line.back() == '\r')
+                line.pop_back();
+            if(line.empty())
+                continue;
+
+            if(line == "stats") {
+                s << format(batcher.report(false)) << std::endl;
+                continue;
+            }
+
+            input.clear();
+            const char* p = line.c_str();
+            char* end;
+            while(true) {
+                const double v = std::strtod(p, &end);
+                if(end == p)
+                    break;
+                input.push_back(T(v) * scale + offset);
+                p = end;
+                if(*p != ',')
+                    break;
+                p++;
+            }
+
+            try {
+                if(*p != '\0')
+                    throw std::runtime_error("cannot read input " + std::to_string(input.size() + 1));
+
+                math::matrix<T> output = batcher.submit(input).get();
+                uint x = 0;
+                for(uint i = 1; i < output.M; i++) {
+                    if(output(i, 0) > output(x, 0))
+                        x = i;
+                }
+                s << x << "," << output(x, 0) << std::endl;
+            } catch(std::exception& e) {
+                s << "error: " << e.what() << std::endl;
+            }
+        }
+    };
+
+    auto serve = [&](std::list<connection>::iterator c) {
+        {
+            sys::socketstream s(c->sock);
+            answer(s);
+
+            // s closes the socket on the way out, after which main must
+            // not shut it down
+            std::lock_guard<std::mutex> l(lock);
+            c->sock = -1;
+        }
+        std::lock_guard<std::mutex> l(lock);
+        c->done = true;
+        changed.notify_all();
+    };
+
+    // join the connections that have hung up; lock is held
+    auto reap = [&]() {
+        for(auto i = connections.begin(); i != connections.end();) {
+            if(i->done) {
+                i->thread.join();
+                i = connections.erase(i);
+            } else {
+                i++;
+            }
+        }
+    };
+
+    // a thread per connection, up to max_connections of them, each with one
+    // request outstanding; batching is across connections
+    while(true) {
+        {
+            std::unique_lock<std::mutex> l(lock);
+            changed.wait(l, [&]() {
+                    reap();
+                    return connections.size() < max_connections;
+                });
+        }
+
+        int sock = server->accept();
+        if(sock < 0) {
+            std::cerr << "jneural-serve: accept: " << std::strerror(errno) << std::endl;
+            break;
+        }
+
+        std::lock_guard<std::mutex> l(lock);
+        connections.push_back(connection());
+        auto c = std::prev(connections.end());
+        c->sock = sock;
+        c->done = false;
+        c->thread = std::thread(serve, c);
+    }
+
+    // stop the reporter, hang up on every client and wait for them all
+    {
+        std::lock_guard<std::mutex> l(lock);
+        stopping = true;
+        for(connection& c : connections) {
+            if(c.sock >= 0)
+                ::shutdown(c.sock, SHUT_RDWR);
+        }
+    }
+    changed.notify_all();
+    for(connection& c : connections) {
+        c.thread.join();
+    }
+    if(reporter.joinable())
+        reporter.join();
+
+    return 1;
+}
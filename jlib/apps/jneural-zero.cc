@@ -9,6 +9,7 @@
 #include <jlib/util/json.hh>
 #include <jlib/sys/Directory.hh>
 #include <jlib/sys/sys.hh>
+#include <jlib/ai/dataset.hh>
 
 #include <functional>
 #include <random>
@@ -161,37 +162,21 @@ int main(int argc, char** argv) {
   
     std::cout << "Opening " << training_file << std::endl;
     if(ends(training_file, ".csv")) {
+        // read once, rather than again every epoch
+        const ai::dataset<double> train = ai::dataset<double>::csv(training_file);
+        math::matrix<double> target(ONODES, 1);
         for(uint e = 0; e < epochs; e++) {
             std::cout << "Training epoch " << e << std::endl;
-            std::ifstream ifs(training_file);
-            while(ifs) {
-                std::string line;
-                std::getline(ifs, line);
-                if(ifs) {
-                    std::vector<std::string> inlist = util::tokenize(line, ",");
-                    int size = inlist.size() - 1;
-		    
-                    //std::cout << "Got " << size << " elements" << std::endl;
-		    
-                    int label = util::int_value(inlist.front());
-                    math::matrix<double> input(size, 1);
-		    
-                    for(std::size_t i = 0; i < size; i++) {
-                        input(i, 0) = ((util::int_value(inlist[i+1]) / 255.0) * 0.99) + 0.01;
-                    }
-		    
-                    math::matrix<double> target(ONODES, 1);
-                    for(int i = 0; i < ONODES; i++) {
-                        if(i == label)
-                            target(i, 0) = 0.99;
-                        else
-                            target(i, 0) = 0.01;
-                    }
-		    
-                    nn.train(input, target);
+            for(std::size_t t = 0; t < train.size(); t++) {
+                for(int i = 0; i < ONODES; i++) {
+                    if(i == train.label(t))
+                        target(i, 0) = 0.99;
+                    else
+                        target(i, 0) = 0.01;
                 }
+
+                nn.train(train.sample(t), target);
             }
-            ifs.close();
         }
 
         if(argc > 4) {
@@ -218,40 +203,22 @@ int main(int argc, char** argv) {
 
     uint count = 0, correct = 0;
   
-    std::ifstream tfs(testing_file);
-    while(tfs) {
-        std::string line;
-        std::getline(tfs, line);
-        if(tfs) {
-            std::vector<std::string> inlist = util::tokenize(line, ",");
-            int size = inlist.size() - 1;
-  
-            //std::cout << "Got " << size << " elements" << std::endl;
-      
-            int label = util::int_value(inlist.front());
-            math::matrix<double> input(size, 1);
-      
-            for(std::size_t i = 0; i < size; i++) {
-                input(i, 0) = ((util::int_value(inlist[i+1]) / 255.0) * 0.99) + 0.01;
+    const ai::dataset<double> tests = ai::dataset<double>::load(testing_file);
+    for(std::size_t t = 0; t < tests.size(); t++) {
+        math::matrix<double> output = nn.query(tests.sample(t));
+
+        double max = output(0, 0);
+        uint x = 0;
+        for(uint i = 1; i < output.M; i++) {
+            if(output(i, 0) > max) {
+                max = output(i, 0);
+                x = i;
             }
-
-            math::matrix<double> output = nn.query(input);
-
-            double max = output(0, 0);
-            uint x = 0;
-            for(uint i = 1; i < output.M; i++) {
-                if(output(i, 0) > max) {
-                    max = output(i, 0);
-                    x = i;
-                }
-            }
-      
-            //std::cout << "Expected " << label << " got " << x << std::endl;
-            count++;
-            if(label == x)
-                correct++;
         }
 
+        count++;
+        if(tests.label(t) == int(x))
+            correct++;
     }
 
     sys::Directory dir("my_own_images");
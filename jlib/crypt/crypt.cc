@@ -23,14 +23,23 @@
 #include <jlib/sys/sync.hh>
 #include <jlib/sys/tfstream.hh>
 
+#include <algorithm>
+#include <cerrno>
 #include <cstdlib>
 #include <sstream>
+#include <vector>
 
 namespace jlib {
     namespace crypt {
 
         namespace gpg {
 
+            namespace {
+                // bytes moved per read or write between gpgme and a string or
+                // stream
+                const std::size_t CHUNK = 64 * 1024;
+            }
+
             ctx::ctx() {
                 gpgme_error_t err = gpgme_new(&m_ctx);
                 if(gpgme_err_code(err) != GPG_ERR_NO_ERROR) {
@@ -127,6 +136,7 @@ namespace jlib {
             void ctx::op_encrypt(key::list rcpts, data::ptr plain, data::ptr cipher) {
                 gpgme_key_t* arr = key::to_array(rcpts);
                 gpgme_error_t err = gpgme_op_encrypt(m_ctx, arr, GPGME_ENCRYPT_ALWAYS_TRUST, plain->m_data, cipher->m_data);
+                delete[] arr;
                 if(gpgme_err_code(err) != GPG_ERR_NO_ERROR) {
                     throw exception(err);
                 } 
@@ -140,6 +150,7 @@ namespace jlib {
             void ctx::op_encrypt_sign(key::list rcpts, data::ptr plain, data::ptr cipher) {
                 gpgme_key_t* arr = key::to_array(rcpts);
                 gpgme_error_t err = gpgme_op_encrypt_sign(m_ctx, arr, GPGME_ENCRYPT_ALWAYS_TRUST, plain->m_data, cipher->m_data);
+                delete[] arr;
                 if(gpgme_err_code(err) != GPG_ERR_NO_ERROR) {
                     throw exception(err);
                 } 
@@ -173,6 +184,26 @@ namespace jlib {
                 return gpgme_op_verify_result(m_ctx);
             }
 
+            void ctx::op_sign(std::istream& plain, std::ostream& sig, gpgme_sig_mode_t mode) {
+                op_sign(data::create_reader(plain), data::create_writer(sig), mode);
+                sig.flush();
+            }
+
+            void ctx::op_encrypt(key::list rcpts, std::istream& plain, std::ostream& cipher) {
+                op_encrypt(rcpts, data::create_reader(plain), data::create_writer(cipher));
+                cipher.flush();
+            }
+
+            void ctx::op_encrypt_sign(key::list rcpts, std::istream& plain, std::ostream& cipher) {
+                op_encrypt_sign(rcpts, data::create_reader(plain), data::create_writer(cipher));
+                cipher.flush();
+            }
+
+            void ctx::op_decrypt(std::istream& cipher, std::ostream& plain) {
+                op_decrypt(data::create_reader(cipher), data::create_writer(plain));
+                plain.flush();
+            }
+
 
             key::key() 
                 : m_key(0)
@@ -211,7 +242,7 @@ namespace jlib {
                 return data::ptr(new data(d, n, copy));
             }
 
-            data::ptr data::create(std::string d) {
+            data::ptr data::create(const std::string& d) {
                 return data::ptr(new data(d));
             }
 
@@ -223,33 +254,127 @@ namespace jlib {
                 return data::ptr(new data());
             }
 
-            data::data(const char* data, size_t n, bool copy) {
+            data::ptr data::create_reader(std::istream& in) {
+                return data::ptr(new data(in));
+            }
+
+            data::ptr data::create_writer(std::ostream& out) {
+                return data::ptr(new data(out));
+            }
+
+            data::ptr data::create(int fd) {
+                return data::ptr(new data(fd));
+            }
+
+            // gpgme keeps the pointer, so these live as long as the program
+            gpgme_data_cbs data::s_in = { &data::read_cb, 0, &data::seek_cb, 0 };
+            gpgme_data_cbs data::s_out = { 0, &data::write_cb, 0, 0 };
+
+            data::data(const char* data, size_t n, bool copy)
+                : m_in(0),
+                  m_out(0)
+            {
                 gpgme_error_t err = gpgme_data_new_from_mem(&m_data, data, n, static_cast<int>(copy));
                 if(gpgme_err_code(err) != GPG_ERR_NO_ERROR) {
                     throw exception(err);
                 } 
             }
 
-            data::data(std::string data) {
+            data::data(const std::string& data)
+                : m_in(0),
+                  m_out(0)
+            {
                 gpgme_error_t err = gpgme_data_new_from_mem(&m_data, data.data(), data.length(), 1);
                 if(gpgme_err_code(err) != GPG_ERR_NO_ERROR) {
                     throw exception(err);
                 } 
             }
 
-            data::data(std::string file, bool copy) {
+            data::data(std::string file, bool copy)
+                : m_in(0),
+                  m_out(0)
+            {
                 gpgme_error_t err = gpgme_data_new_from_file(&m_data, file.c_str(), static_cast<int>(copy));
                 if(gpgme_err_code(err) != GPG_ERR_NO_ERROR) {
                     throw exception(err);
                 } 
             }
 
-            data::data() {
+            data::data()
+                : m_in(0),
+                  m_out(0)
+            {
                 gpgme_error_t err = gpgme_data_new(&m_data);
                 if(gpgme_err_code(err) != GPG_ERR_NO_ERROR) {
                     throw exception(err);
                 } 
             }
+
+            data::data(std::istream& in)
+                : m_in(&in),
+                  m_out(0)
+            {
+                gpgme_error_t err = gpgme_data_new_from_cbs(&m_data, &s_in, this);
+                if(gpgme_err_code(err) != GPG_ERR_NO_ERROR) {
+                    throw exception(err);
+                } 
+            }
+
+            data::data(std::ostream& out)
+                : m_in(0),
+                  m_out(&out)
+            {
+                gpgme_error_t err = gpgme_data_new_from_cbs(&m_data, &s_out, this);
+                if(gpgme_err_code(err) != GPG_ERR_NO_ERROR) {
+                    throw exception(err);
+                } 
+            }
+
+            data::data(int fd)
+                : m_in(0),
+                  m_out(0)
+            {
+                gpgme_error_t err = gpgme_data_new_from_fd(&m_data, fd);
+                if(gpgme_err_code(err) != GPG_ERR_NO_ERROR) {
+                    throw exception(err);
+                } 
+            }
+
+            ssize_t data::read_cb(void* handle, void* buffer, size_t size) {
+                std::istream& in = *static_cast<data*>(handle)->m_in;
+                in.read(static_cast<char*>(buffer), size);
+                if(in.bad()) {
+                    errno = EIO;
+                    return -1;
+                }
+                return in.gcount();
+            }
+
+            ssize_t data::write_cb(void* handle, const void* buffer, size_t size) {
+                std::ostream& out = *static_cast<data*>(handle)->m_out;
+                out.write(static_cast<const char*>(buffer), size);
+                if(!out) {
+                    errno = EIO;
+                    return -1;
+                }
+                return size;
+            }
+
+            off_t data::seek_cb(void* handle, off_t offset, int whence) {
+                std::istream& in = *static_cast<data*>(handle)->m_in;
+                const std::ios_base::seekdir dir =
+                    (whence == SEEK_SET ? std::ios_base::beg : whence == SEEK_CUR ? std::ios_base::cur : std::ios_base::end);
+
+                in.clear();
+                in.seekg(offset, dir);
+                const std::streamoff pos = in.tellg();
+                if(!in || pos < 0) {
+                    in.clear();
+                    errno = ESPIPE;
+                    return -1;
+                }
+                return pos;
+            }
             
             data::~data() {
                 gpgme_data_release(m_data);
@@ -276,51 +401,89 @@ namespace jlib {
             }
             
             std::string data::read(int n) {
-                char buf[1024];
-                size_t n_read = 0;
-                std::string buffer;
-                bool cont = true;
-                gpgme_error_t err;
                 std::string ret;
-                ssize_t y = -1;
-                
-                do {
-                    size_t x;
-                    if(n == -1) {
-                        x = 1024;
-                    } else if((n - n_read) > 1024) {
-                        x = 1024;
-                    } else {
-                        x = (n - n_read);
+
+                // reserve what's left when the data knows its size, which
+                // streams and pipes don't
+                if(n == -1) {
+                    const off_t here = gpgme_data_seek(m_data, 0, SEEK_CUR);
+                    const off_t end = (here == -1 ? -1 : gpgme_data_seek(m_data, 0, SEEK_END));
+                    if(end != -1) {
+                        gpgme_data_seek(m_data, here, SEEK_SET);
+                        ret.reserve(end - here);
                     }
-                    
-                    y = gpgme_data_read(m_data, buf, x);
+                }
+
+                // straight into ret, with no buffer in between
+                std::size_t n_read = 0;
+                while(n == -1 || n_read < static_cast<std::size_t>(n)) {
+                    const std::size_t x = (n == -1 ? CHUNK : std::min(CHUNK, n - n_read));
+                    ret.resize(n_read + x);
 
+                    const ssize_t y = gpgme_data_read(m_data, &ret[n_read], x);
                     if(y == -1)
                         throw exception("gpgme_data_read returned -1");
+                    if(y == 0)
+                        break;
 
-                    if(y > 0) {
-                        n_read += y;
-                        ret.append(buf, y);
-                    }
-                    
-                } while((n_read != n) && y != 0);
+                    n_read += y;
+                }
+                ret.resize(n_read);
             
                 return ret;
             }
 
-            void data::write(std::string data) {
-                std::size_t n = gpgme_data_write(m_data, data.data(), data.length());
-                if(n != data.size()) {
+            void data::write(const std::string& data) {
+                const ssize_t n = gpgme_data_write(m_data, data.data(), data.length());
+                if(n == -1) {
+                    throw exception(gpg_error_from_syserror());
+                } 
+
+                if(static_cast<std::size_t>(n) != data.size()) {
                     std::ostringstream os;
-                    os << "Only wrote " << n << " of " + data.size();
+                    os << "Only wrote " << n << " of " << data.size();
                     throw std::runtime_error(os.str());
                 }
-                    
+            }
 
-                if(n == -1) {
-                    throw exception(errno);
-                } 
+            std::size_t data::read(std::ostream& out) {
+                std::vector<char> buf(CHUNK);
+                std::size_t total = 0;
+                while(true) {
+                    const ssize_t y = gpgme_data_read(m_data, buf.data(), buf.size());
+                    if(y == -1)
+                        throw exception("gpgme_data_read returned -1");
+                    if(y == 0)
+                        break;
+
+                    out.write(buf.data(), y);
+                    if(!out)
+                        throw exception("writing gpgme data to a stream failed");
+                    total += y;
+                }
+                return total;
+            }
+
+            std::size_t data::write(std::istream& in) {
+                std::vector<char> buf(CHUNK);
+                std::size_t total = 0;
+                while(in) {
+                    in.read(buf.data(), buf.size());
+                    const std::size_t got = in.gcount();
+                    for(std::size_t done = 0; done < got; ) {
+                        const ssize_t n = gpgme_data_write(m_data, buf.data() + done, got - done);
+                        if(n < 0)
+                            throw exception(gpg_error_from_syserror());
+                        // nothing written would never finish
+                        if(n == 0)
+                            throw exception("gpgme_data_write wrote nothing");
+                        done += n;
+                    }
+                    total += got;
+                }
+                if(in.bad())
+                    throw exception("reading a stream into gpgme data failed");
+                return total;
             }
 
             void init(gpgme_protocol_t proto) {
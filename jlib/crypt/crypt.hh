@@ -27,6 +27,8 @@
 
 #include <gpgme.h>
 
+#include <istream>
+#include <ostream>
 #include <string>
 #include <list>
 #include <map>
@@ -76,15 +78,27 @@ namespace jlib {
                 typedef Glib::RefPtr<data> ptr;
 
                 static ptr create(const char* data, size_t n, bool copy = true);
-                static ptr create(std::string data);
+                static ptr create(const std::string& data);
                 static ptr create(std::string file, bool copy);
                 static ptr create();
 
+                // data that gpgme reads from in, or writes to out, as an
+                // operation goes, rather than holding it all in memory.
+                // the stream must outlive the data object.  they are named
+                // apart so a std::iostream can be passed to either
+                static ptr create_reader(std::istream& in);
+                static ptr create_writer(std::ostream& out);
+                // the same for a file descriptor, which isn't closed
+                static ptr create(int fd);
+
             protected:
                 data(const char* data, size_t n, bool copy = true);
-                data(std::string data);
+                data(const std::string& data);
                 data(std::string file, bool copy);
                 data();
+                data(std::istream& in);
+                data(std::ostream& out);
+                data(int fd);
 
                 ~data();
 
@@ -93,7 +107,12 @@ namespace jlib {
                 gpgme_data_encoding_t get_encoding();
 
                 std::string read(int n = -1);
-                void write(std::string data);
+                void write(const std::string& data);
+
+                // everything from here on to out, or all of in, a chunk at
+                // a time; returns the number of bytes copied
+                std::size_t read(std::ostream& out);
+                std::size_t write(std::istream& in);
 
                 off_t seek(off_t offset, int whence);
                 void rewind();
@@ -101,7 +120,16 @@ namespace jlib {
                 friend class ctx;
 
             protected:
+                static ssize_t read_cb(void* handle, void* buffer, size_t size);
+                static ssize_t write_cb(void* handle, const void* buffer, size_t size);
+                static off_t seek_cb(void* handle, off_t offset, int whence);
+
+                static gpgme_data_cbs s_in;
+                static gpgme_data_cbs s_out;
+
                 gpgme_data_t m_data;
+                std::istream* m_in;
+                std::ostream* m_out;
             };
 
             class key : public sys::Object {
@@ -153,6 +181,14 @@ namespace jlib {
                 void op_decrypt(data::ptr cipher, data::ptr plain);
                 gpgme_verify_result_t op_decrypt_verify(data::ptr cipher, data::ptr plain);
 
+                // the same between streams: gpgme pulls the input and pushes
+                // the output through a small buffer as the engine runs, so
+                // memory use doesn't grow with the size of the payload
+                void op_sign(std::istream& plain, std::ostream& sig, gpgme_sig_mode_t mode = GPGME_SIG_MODE_NORMAL);
+                void op_encrypt(key::list rcpts, std::istream& plain, std::ostream& cipher);
+                void op_encrypt_sign(key::list rcpts, std::istream& plain, std::ostream& cipher);
+                void op_decrypt(std::istream& cipher, std::ostream& plain);
+
             protected:
                 gpgme_ctx_t m_ctx;
                 
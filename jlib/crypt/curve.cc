@@ -18,7 +18,12 @@
  * 
  */
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <ostream>
+#include <stdexcept>
+#include <string>
 
 #include <sodium.h>
 #include <sodium/crypto_core_ristretto255.h>
@@ -111,12 +116,14 @@ Scalar Scalar::operator^(int k) const {
         return result;
     }
 
+    // from the top bit of |k| down, squaring at each and multiplying in
+    // this where the bit is set
+    const unsigned int j = std::abs(k);
     curve::Scalar a_k = curve::Scalar::one();
-
-    unsigned int j = std::abs(k);
-    
-    for(unsigned int i = 0; i < j; i++) {
-        a_k *= (*this);
+    for(unsigned int bit = (j ? 1u << (31 - __builtin_clz(j)) : 0); bit; bit >>= 1) {
+        a_k *= a_k;
+        if(j & bit)
+            a_k *= (*this);
     }
 
     if(static_cast<int>(j) != k) {
@@ -125,6 +132,16 @@ Scalar Scalar::operator^(int k) const {
         return a_k;
     }
 }
+
+std::vector<Scalar> powers(const Scalar& x, std::size_t n) {
+    std::vector<Scalar> result;
+    result.reserve(n + 1);
+    result.push_back(Scalar::one());
+    for(std::size_t k = 1; k <= n; k++) {
+        result.push_back(result.back() * x);
+    }
+    return result;
+}
     
 Point Scalar::operator*(const Point& x) const {
     return (x * *this);
@@ -316,12 +333,709 @@ Commitment::Commitment(const Scalar& value)
 {
 }
 
+namespace {
+
+const FixedBase& table_g() {
+    static const FixedBase table(Commitment::G);
+    return table;
+}
+
+const FixedBase& table_h() {
+    static const FixedBase table(Commitment::H);
+    return table;
+}
+
+}
+
 Commitment::Commitment(const Scalar& value, const Scalar& blind)
     : m_value(value),
       m_blind(blind)
 {
-    Point p = value * G + blind * H;
-    static_cast<Point&>(*this) = p;
+    Element p = table_g() * value + table_h() * blind;
+    static_cast<Point&>(*this) = p.point();
+}
+
+// field arithmetic mod p = 2^255-19 for Element, in five 51 bit limbs.
+// sums and differences are carried, so every limb stays a little over 51
+// bits and products fit in 128
+namespace {
+
+typedef unsigned __int128 uint128;
+typedef std::uint64_t fe[5];
+
+const std::uint64_t MASK51 = (std::uint64_t(1) << 51) - 1;
+
+const fe FE_ZERO = { 0, 0, 0, 0, 0 };
+const fe FE_ONE = { 1, 0, 0, 0, 0 };
+// the curve constant d = -121665/121666, and 2d
+const fe FE_D = { 0x34dca135978a3, 0x1a8283b156ebd, 0x5e7a26001c029, 0x739c663a03cbb, 0x52036cee2b6ff };
+const fe FE_D2 = { 0x69b9426b2f159, 0x35050762add7a, 0x3cf44c0038052, 0x6738cc7407977, 0x2406d9dc56dff };
+// sqrt(-1), and 1/sqrt(a-d) with a = -1
+const fe FE_SQRTM1 = { 0x61b274a0ea0b0, 0xd5a5fc8f189d, 0x7ef5e9cbd0c60, 0x78595a6804c9e, 0x2b8324804fc1d };
+const fe FE_INVSQRT_A_MINUS_D = { 0xfdaa805d40ea, 0x2eb482e57d339, 0x7610274bc58, 0x6510b613dc8ff, 0x786c8905cfaff };
+
+inline void fe_copy(fe h, const fe f) {
+    std::memcpy(h, f, sizeof(fe));
+}
+
+inline void fe_carry(fe h) {
+    std::uint64_t c;
+    c = h[0] >> 51; h[0] &= MASK51; h[1] += c;
+    c = h[1] >> 51; h[1] &= MASK51; h[2] += c;
+    c = h[2] >> 51; h[2] &= MASK51; h[3] += c;
+    c = h[3] >> 51; h[3] &= MASK51; h[4] += c;
+    c = h[4] >> 51; h[4] &= MASK51; h[0] += 19 * c;
+}
+
+inline void fe_add(fe h, const fe f, const fe g) {
+    for(int i = 0; i < 5; i++) {
+        h[i] = f[i] + g[i];
+    }
+    fe_carry(h);
+}
+
+// f + 4p - g, which can't go negative for carried g
+inline void fe_sub(fe h, const fe f, const fe g) {
+    h[0] = (f[0] + 0x1fffffffffffb4) - g[0];
+    for(int i = 1; i < 5; i++) {
+        h[i] = (f[i] + 0x1ffffffffffffc) - g[i];
+    }
+    fe_carry(h);
+}
+
+inline void fe_neg(fe h, const fe f) {
+    fe_sub(h, FE_ZERO, f);
+}
+
+inline void fe_reduce(fe h, const uint128 r[5]) {
+    uint128 r1 = r[1], r2 = r[2], r3 = r[3], r4 = r[4];
+    std::uint64_t h0 = std::uint64_t(r[0]) & MASK51;
+    r1 += std::uint64_t(r[0] >> 51);
+    std::uint64_t h1 = std::uint64_t(r1) & MASK51;
+    r2 += std::uint64_t(r1 >> 51);
+    std::uint64_t h2 = std::uint64_t(r2) & MASK51;
+    r3 += std::uint64_t(r2 >> 51);
+    std::uint64_t h3 = std::uint64_t(r3) & MASK51;
+    r4 += std::uint64_t(r3 >> 51);
+    std::uint64_t h4 = std::uint64_t(r4) & MASK51;
+    h0 += 19 * std::uint64_t(r4 >> 51);
+    h1 += h0 >> 51;
+    h0 &= MASK51;
+
+    h[0] = h0; h[1] = h1; h[2] = h2; h[3] = h3; h[4] = h4;
+}
+
+inline void fe_mul(fe h, const fe f, const fe g) {
+    const std::uint64_t g1_19 = 19 * g[1], g2_19 = 19 * g[2], g3_19 = 19 * g[3], g4_19 = 19 * g[4];
+    uint128 r[5];
+
+    r[0] = uint128(f[0]) * g[0] + uint128(f[1]) * g4_19 + uint128(f[2]) * g3_19 + uint128(f[3]) * g2_19 + uint128(f[4]) * g1_19;
+    r[1] = uint128(f[0]) * g[1] + uint128(f[1]) * g[0] + uint128(f[2]) * g4_19 + uint128(f[3]) * g3_19 + uint128(f[4]) * g2_19;
+    r[2] = uint128(f[0]) * g[2] + uint128(f[1]) * g[1] + uint128(f[2]) * g[0] + uint128(f[3]) * g4_19 + uint128(f[4]) * g3_19;
+    r[3] = uint128(f[0]) * g[3] + uint128(f[1]) * g[2] + uint128(f[2]) * g[1] + uint128(f[3]) * g[0] + uint128(f[4]) * g4_19;
+    r[4] = uint128(f[0]) * g[4] + uint128(f[1]) * g[3] + uint128(f[2]) * g[2] + uint128(f[3]) * g[1] + uint128(f[4]) * g[0];
+
+    fe_reduce(h, r);
+}
+
+inline void fe_sq(fe h, const fe f) {
+    const std::uint64_t f0_2 = 2 * f[0], f1_2 = 2 * f[1];
+    const std::uint64_t f3_19 = 19 * f[3], f4_19 = 19 * f[4];
+    uint128 r[5];
+
+    r[0] = uint128(f[0]) * f[0] + uint128(f1_2) * f4_19 + uint128(2 * f[2]) * f3_19;
+    r[1] = uint128(f0_2) * f[1] + uint128(2 * f[2]) * f4_19 + uint128(f[3]) * f3_19;
+    r[2] = uint128(f0_2) * f[2] + uint128(f[1]) * f[1] + uint128(2 * f[3]) * f4_19;
+    r[3] = uint128(f0_2) * f[3] + uint128(f1_2) * f[2] + uint128(f[4]) * f4_19;
+    r[4] = uint128(f0_2) * f[4] + uint128(f1_2) * f[3] + uint128(f[2]) * f[2];
+
+    fe_reduce(h, r);
+}
+
+// h = f^(2^n)
+inline void fe_sqn(fe h, const fe f, int n) {
+    fe_sq(h, f);
+    for(int i = 1; i < n; i++) {
+        fe_sq(h, h);
+    }
+}
+
+// the unique representative in [0, p), little endian
+void fe_tobytes(unsigned char* s, const fe f) {
+    fe t;
+    fe_copy(t, f);
+    fe_carry(t);
+    fe_carry(t);
+    fe_carry(t);
+
+    // every limb is below 2^51 now, and t is at least p exactly when
+    // t + 19 carries out of bit 255
+    std::uint64_t q = (t[0] + 19) >> 51;
+    q = (t[1] + q) >> 51;
+    q = (t[2] + q) >> 51;
+    q = (t[3] + q) >> 51;
+    q = (t[4] + q) >> 51;
+
+    t[0] += 19 * q;
+    t[1] += t[0] >> 51; t[0] &= MASK51;
+    t[2] += t[1] >> 51; t[1] &= MASK51;
+    t[3] += t[2] >> 51; t[2] &= MASK51;
+    t[4] += t[3] >> 51; t[3] &= MASK51;
+    t[4] &= MASK51;
+
+    const std::uint64_t w[4] = {
+        t[0] | (t[1] << 51),
+        (t[1] >> 13) | (t[2] << 38),
+        (t[2] >> 26) | (t[3] << 25),
+        (t[3] >> 39) | (t[4] << 12)
+    };
+    for(int i = 0; i < 4; i++) {
+        for(int b = 0; b < 8; b++) {
+            s[8 * i + b] = static_cast<unsigned char>(w[i] >> (8 * b));
+        }
+    }
+}
+
+// the low 255 bits of s
+void fe_frombytes(fe h, const unsigned char* s) {
+    std::uint64_t w[4];
+    for(int i = 0; i < 4; i++) {
+        w[i] = 0;
+        for(int b = 0; b < 8; b++) {
+            w[i] |= std::uint64_t(s[8 * i + b]) << (8 * b);
+        }
+    }
+
+    h[0] = w[0] & MASK51;
+    h[1] = ((w[0] >> 51) | (w[1] << 13)) & MASK51;
+    h[2] = ((w[1] >> 38) | (w[2] << 26)) & MASK51;
+    h[3] = ((w[2] >> 25) | (w[3] << 39)) & MASK51;
+    h[4] = (w[3] >> 12) & MASK51;
+}
+
+bool fe_isnegative(const fe f) {
+    unsigned char s[32];
+    fe_tobytes(s, f);
+    return (s[0] & 1) != 0;
+}
+
+bool fe_iszero(const fe f) {
+    static const unsigned char zero[32] = { 0 };
+    unsigned char s[32];
+    fe_tobytes(s, f);
+    return std::memcmp(s, zero, 32) == 0;
+}
+
+bool fe_equal(const fe f, const fe g) {
+    unsigned char s[32], t[32];
+    fe_tobytes(s, f);
+    fe_tobytes(t, g);
+    return std::memcmp(s, t, 32) == 0;
+}
+
+// h = |f|, the one of f and -f that isn't negative
+void fe_abs(fe h, const fe f) {
+    if(fe_isnegative(f))
+        fe_neg(h, f);
+    else
+        fe_copy(h, f);
+}
+
+// h = f^((p-5)/8) = f^(2^252-3)
+void fe_pow22523(fe h, const fe f) {
+    fe t0, t1, t2;
+
+    fe_sq(t0, f);
+    fe_sqn(t1, t0, 2);
+    fe_mul(t1, f, t1);
+    fe_mul(t0, t0, t1);
+    fe_sq(t0, t0);
+    fe_mul(t0, t1, t0);         // 2^5 - 1
+    fe_sqn(t1, t0, 5);
+    fe_mul(t0, t1, t0);         // 2^10 - 1
+    fe_sqn(t1, t0, 10);
+    fe_mul(t1, t1, t0);         // 2^20 - 1
+    fe_sqn(t2, t1, 20);
+    fe_mul(t1, t2, t1);         // 2^40 - 1
+    fe_sqn(t1, t1, 10);
+    fe_mul(t0, t1, t0);         // 2^50 - 1
+    fe_sqn(t1, t0, 50);
+    fe_mul(t1, t1, t0);         // 2^100 - 1
+    fe_sqn(t2, t1, 100);
+    fe_mul(t1, t2, t1);         // 2^200 - 1
+    fe_sqn(t1, t1, 50);
+    fe_mul(t0, t1, t0);         // 2^250 - 1
+    fe_sqn(t0, t0, 2);
+    fe_mul(h, t0, f);           // 2^252 - 3
+}
+
+// h = 1/f = f^(p-2) = (f^(2^252-3))^8 * f^3
+void fe_invert(fe h, const fe f) {
+    fe t, f3;
+    fe_pow22523(t, f);
+    fe_sqn(t, t, 3);
+    fe_sq(f3, f);
+    fe_mul(f3, f3, f);
+    fe_mul(h, t, f3);
+}
+
+// r = sqrt(u/v) when that exists, and sqrt(i*u/v) otherwise, as the
+// ristretto255 SQRT_RATIO_M1; true in the first case
+bool fe_sqrt_ratio_m1(fe r, const fe u, const fe v) {
+    fe v3, v7, t, check, u_neg, u_neg_i, r_prime;
+
+    fe_sq(v3, v);
+    fe_mul(v3, v3, v);          // v^3
+    fe_sq(v7, v3);
+    fe_mul(v7, v7, v);          // v^7
+    fe_mul(t, u, v7);
+    fe_pow22523(t, t);
+    fe_mul(t, t, v3);
+    fe_mul(r, t, u);            // (u v^3) (u v^7)^((p-5)/8)
+
+    fe_sq(check, r);
+    fe_mul(check, check, v);
+
+    fe_neg(u_neg, u);
+    fe_mul(u_neg_i, u_neg, FE_SQRTM1);
+
+    const bool correct = fe_equal(check, u);
+    const bool flipped = fe_equal(check, u_neg);
+    const bool flipped_i = fe_equal(check, u_neg_i);
+
+    if(flipped || flipped_i) {
+        fe_mul(r_prime, r, FE_SQRTM1);
+        fe_copy(r, r_prime);
+    }
+    fe_abs(r, r);
+
+    return correct || flipped;
+}
+
+}
+
+Element::Element() {
+    fe_copy(m_x, FE_ZERO);
+    fe_copy(m_y, FE_ONE);
+    fe_copy(m_z, FE_ONE);
+    fe_copy(m_t, FE_ZERO);
+}
+
+Element::Element(const Point& p) {
+    const unsigned char* s = p.data();
+
+    // s must be canonical and non-negative
+    fe f;
+    unsigned char check[32];
+    fe_frombytes(f, s);
+    fe_tobytes(check, f);
+    if(std::memcmp(check, s, 32) != 0 || (s[0] & 1))
+        throw std::runtime_error("curve::Element: not a canonical point encoding");
+
+    fe ss, u1, u2, u2_sq, v, t, invsqrt, den_x, den_y;
+
+    fe_sq(ss, f);
+    fe_sub(u1, FE_ONE, ss);
+    fe_add(u2, FE_ONE, ss);
+    fe_sq(u2_sq, u2);
+
+    // v = -(d u1^2) - u2^2
+    fe_sq(t, u1);
+    fe_mul(t, FE_D, t);
+    fe_neg(t, t);
+    fe_sub(v, t, u2_sq);
+
+    fe_mul(t, v, u2_sq);
+    const bool square = fe_sqrt_ratio_m1(invsqrt, FE_ONE, t);
+
+    fe_mul(den_x, invsqrt, u2);
+    fe_mul(den_y, invsqrt, den_x);
+    fe_mul(den_y, den_y, v);
+
+    fe_add(t, f, f);
+    fe_mul(t, t, den_x);
+    fe_abs(m_x, t);
+    fe_mul(m_y, u1, den_y);
+    fe_copy(m_z, FE_ONE);
+    fe_mul(m_t, m_x, m_y);
+
+    if(!square || fe_isnegative(m_t) || fe_iszero(m_y))
+        throw std::runtime_error("curve::Element: not a canonical point encoding");
+}
+
+Point Element::point() const {
+    fe u1, u2, t, invsqrt, den1, den2, z_inv, ix, iy, den_inv, x, y;
+
+    fe_add(u1, m_z, m_y);
+    fe_sub(t, m_z, m_y);
+    fe_mul(u1, u1, t);
+    fe_mul(u2, m_x, m_y);
+
+    fe_sq(t, u2);
+    fe_mul(t, u1, t);
+    fe_sqrt_ratio_m1(invsqrt, FE_ONE, t);
+
+    fe_mul(den1, invsqrt, u1);
+    fe_mul(den2, invsqrt, u2);
+    fe_mul(z_inv, den1, den2);
+    fe_mul(z_inv, z_inv, m_t);
+
+    fe_mul(t, m_t, z_inv);
+    if(fe_isnegative(t)) {
+        fe_mul(ix, m_x, FE_SQRTM1);
+        fe_mul(iy, m_y, FE_SQRTM1);
+        fe_copy(x, iy);
+        fe_copy(y, ix);
+        fe_mul(den_inv, den1, FE_INVSQRT_A_MINUS_D);
+    } else {
+        fe_copy(x, m_x);
+        fe_copy(y, m_y);
+        fe_copy(den_inv, den2);
+    }
+
+    fe_mul(t, x, z_inv);
+    if(fe_isnegative(t))
+        fe_neg(y, y);
+
+    fe_sub(t, m_z, y);
+    fe_mul(t, den_inv, t);
+    fe_abs(t, t);
+
+    Point result;
+    fe_tobytes(result.m_data, t);
+    return result;
+}
+
+// add-2008-hwcd-3, for a = -1
+Element Element::operator+(const Element& q) const {
+    fe a, b, c, d, e, f, g, h, t;
+
+    fe_sub(a, m_y, m_x);
+    fe_sub(t, q.m_y, q.m_x);
+    fe_mul(a, a, t);
+    fe_add(b, m_y, m_x);
+    fe_add(t, q.m_y, q.m_x);
+    fe_mul(b, b, t);
+    fe_mul(c, m_t, q.m_t);
+    fe_mul(c, c, FE_D2);
+    fe_mul(d, m_z, q.m_z);
+    fe_add(d, d, d);
+
+    fe_sub(e, b, a);
+    fe_sub(f, d, c);
+    fe_add(g, d, c);
+    fe_add(h, b, a);
+
+    Element result;
+    fe_mul(result.m_x, e, f);
+    fe_mul(result.m_y, g, h);
+    fe_mul(result.m_t, e, h);
+    fe_mul(result.m_z, f, g);
+    return result;
+}
+
+Element Element::operator-() const {
+    Element result(*this);
+    fe_neg(result.m_x, m_x);
+    fe_neg(result.m_t, m_t);
+    return result;
+}
+
+Element Element::operator-(const Element& q) const {
+    return (*this + (-q));
+}
+
+Element& Element::operator+=(const Element& q) {
+    *this = (*this + q);
+    return *this;
+}
+
+Element& Element::operator-=(const Element& q) {
+    *this = (*this + (-q));
+    return *this;
+}
+
+// dbl-2008-hwcd, for a = -1
+Element Element::twice() const {
+    fe a, b, c, d, e, f, g, h, t;
+
+    fe_sq(a, m_x);
+    fe_sq(b, m_y);
+    fe_sq(c, m_z);
+    fe_add(c, c, c);
+    fe_neg(d, a);
+    fe_add(t, m_x, m_y);
+    fe_sq(e, t);
+    fe_sub(e, e, a);
+    fe_sub(e, e, b);
+    fe_add(g, d, b);
+    fe_sub(f, g, c);
+    fe_sub(h, d, b);
+
+    Element result;
+    fe_mul(result.m_x, e, f);
+    fe_mul(result.m_y, g, h);
+    fe_mul(result.m_t, e, h);
+    fe_mul(result.m_z, f, g);
+    return result;
+}
+
+// ristretto255 equality, which holds across the cofactor
+bool operator==(const Element& p, const Element& q) {
+    fe l, r;
+
+    fe_mul(l, p.m_x, q.m_y);
+    fe_mul(r, p.m_y, q.m_x);
+    if(fe_equal(l, r))
+        return true;
+
+    fe_mul(l, p.m_y, q.m_y);
+    fe_mul(r, p.m_x, q.m_x);
+    return fe_equal(l, r);
+}
+
+bool operator!=(const Element& x, const Element& y) {
+    return !(x == y);
+}
+
+namespace {
+
+// all ones when a == b, for small a and b
+std::uint64_t equal_mask(std::uint64_t a, std::uint64_t b) {
+    return -(((a ^ b) - 1) >> 63);
+}
+
+// r = a where mask is all ones, leaving r where it is zero
+void fe_select(fe r, const fe a, std::uint64_t mask) {
+    for(int i = 0; i < 5; i++) {
+        r[i] ^= (r[i] ^ a[i]) & mask;
+    }
+}
+
+}
+
+FixedBase::FixedBase(const Point& p)
+    : m_table(64 * 8)
+{
+    // row i holds 16^i * p up to 8 * 16^i * p, each with z = 1
+    Element row(p);
+    for(unsigned int i = 0; i < 64; i++) {
+        Element e = row;
+        for(unsigned int j = 0; j < 8; j++) {
+            fe z_inv, x, y;
+            fe_invert(z_inv, e.m_z);
+            fe_mul(x, e.m_x, z_inv);
+            fe_mul(y, e.m_y, z_inv);
+
+            Entry& t = m_table[i * 8 + j];
+            fe_add(t.ypx, y, x);
+            fe_sub(t.ymx, y, x);
+            fe_mul(t.xy2d, x, y);
+            fe_mul(t.xy2d, t.xy2d, FE_D2);
+
+            if(j < 7)
+                e += row;
+        }
+        row = e.twice();
+    }
+}
+
+Element FixedBase::operator*(const Scalar& x) const {
+    // nibbles recoded to digits in [-8, 8), carrying into the next; x is
+    // below 2^253, so the top digit is at most 2
+    const unsigned char* s = x.data();
+    signed char e[64];
+    for(unsigned int i = 0; i < 32; i++) {
+        e[2 * i] = s[i] & 15;
+        e[2 * i + 1] = (s[i] >> 4) & 15;
+    }
+    signed char carry = 0;
+    for(unsigned int i = 0; i < 63; i++) {
+        e[i] += carry;
+        carry = (e[i] + 8) >> 4;
+        e[i] -= carry * 16;
+    }
+    e[63] += carry;
+
+    Element result;
+    for(unsigned int i = 0; i < 64; i++) {
+        const std::uint64_t negative = -std::uint64_t(std::uint8_t(e[i]) >> 7);
+        const std::uint64_t d = (std::uint64_t(e[i]) ^ negative) - negative;
+
+        // the identity for a zero digit, which the addition handles
+        Entry q;
+        fe_copy(q.ypx, FE_ONE);
+        fe_copy(q.ymx, FE_ONE);
+        fe_copy(q.xy2d, FE_ZERO);
+        const Entry* t = &m_table[i * 8];
+        for(unsigned int j = 0; j < 8; j++) {
+            const std::uint64_t mask = equal_mask(d, j + 1);
+            fe_select(q.ypx, t[j].ypx, mask);
+            fe_select(q.ymx, t[j].ymx, mask);
+            fe_select(q.xy2d, t[j].xy2d, mask);
+        }
+
+        // -(x, y) swaps y + x and y - x and negates xy
+        fe ypx, xy2d;
+        fe_copy(ypx, q.ypx);
+        fe_select(q.ypx, q.ymx, negative);
+        fe_select(q.ymx, ypx, negative);
+        fe_neg(xy2d, q.xy2d);
+        fe_select(q.xy2d, xy2d, negative);
+
+        // add-2008-hwcd-3 with z2 = 1 and 2d t2 ready
+        fe a, b, c, dd, ee, f, g, h;
+        fe_sub(a, result.m_y, result.m_x);
+        fe_mul(a, a, q.ymx);
+        fe_add(b, result.m_y, result.m_x);
+        fe_mul(b, b, q.ypx);
+        fe_mul(c, result.m_t, q.xy2d);
+        fe_add(dd, result.m_z, result.m_z);
+
+        fe_sub(ee, b, a);
+        fe_sub(f, dd, c);
+        fe_add(g, dd, c);
+        fe_add(h, b, a);
+
+        fe_mul(result.m_x, ee, f);
+        fe_mul(result.m_y, g, h);
+        fe_mul(result.m_t, ee, h);
+        fe_mul(result.m_z, f, g);
+    }
+    return result;
+}
+
+namespace {
+
+// the c bits of a little endian 256 bit scalar starting at bit pos
+unsigned int scalar_bits(const unsigned char* s, unsigned int pos, unsigned int c) {
+    std::uint32_t w = 0;
+    for(unsigned int i = pos / 8, b = 0; b < 32 && i < Scalar::SIZE; i++, b += 8) {
+        w |= std::uint32_t(s[i]) << b;
+    }
+    return (w >> (pos % 8)) & ((1u << c) - 1);
+}
+
+// the window minimising (257/c) * (n + 2^c), the additions pippenger takes
+unsigned int window(std::size_t n) {
+    unsigned int best = 1;
+    double cost = 0;
+    for(unsigned int c = 1; c <= 16; c++) {
+        const double k = double((256 / c) + 1) * (double(n) + double(1u << c));
+        if(c == 1 || k < cost) {
+            best = c;
+            cost = k;
+        }
+    }
+    return best;
+}
+
+}
+
+Element multiexp(const std::vector<Element>& points, const std::vector<Scalar>& scalars) {
+    if(points.size() != scalars.size())
+        throw std::runtime_error("curve::multiexp: " + std::to_string(points.size()) + " points but " +
+                                 std::to_string(scalars.size()) + " scalars");
+
+    const std::size_t n = points.size();
+    if(n == 0)
+        return Element();
+
+    // digits in [-2^(c-1), 2^(c-1)], the top one taking any carry, so the
+    // buckets are for 1..2^(c-1) and a negative digit subtracts its point
+    const unsigned int c = window(n);
+    const unsigned int windows = (256 / c) + 1;
+    const int half = 1 << (c - 1);
+
+    std::vector<int> digits(n * windows);
+    for(std::size_t i = 0; i < n; i++) {
+        const unsigned char* s = scalars[i].data();
+        int carry = 0;
+        for(unsigned int w = 0; w < windows; w++) {
+            int d = int(scalar_bits(s, w * c, c)) + carry;
+            carry = 0;
+            if(d >= half && w + 1 < windows) {
+                d -= (1 << c);
+                carry = 1;
+            }
+            digits[i * windows + w] = d;
+        }
+    }
+
+    std::vector<Element> buckets(half);
+    std::vector<bool> used(half);
+
+    Element result;
+    for(unsigned int w = windows; w-- > 0; ) {
+        if(w + 1 < windows) {
+            for(unsigned int i = 0; i < c; i++) {
+                result = result.twice();
+            }
+        }
+
+        std::fill(used.begin(), used.end(), false);
+        for(std::size_t i = 0; i < n; i++) {
+            const int d = digits[i * windows + w];
+            if(d == 0)
+                continue;
+
+            const std::size_t b = std::abs(d) - 1;
+            const Element& p = points[i];
+            if(!used[b]) {
+                buckets[b] = (d > 0 ? p : -p);
+                used[b] = true;
+            } else if(d > 0) {
+                buckets[b] += p;
+            } else {
+                buckets[b] -= p;
+            }
+        }
+
+        // sum of (b+1) * buckets[b], as a running sum from the top
+        Element sum, total;
+        bool any = false;
+        for(std::size_t b = half; b-- > 0; ) {
+            if(used[b]) {
+                sum = (any ? sum + buckets[b] : buckets[b]);
+                any = true;
+            }
+            if(any)
+                total += sum;
+        }
+        result += total;
+    }
+
+    return result;
+}
+
+Point multiexp(const std::vector<Point>& points, const std::vector<Scalar>& scalars) {
+    // one term isn't worth decoding
+    if(points.size() == 1 && scalars.size() == 1)
+        return points[0] * scalars[0];
+
+    std::vector<Element> elements(points.begin(), points.end());
+    return multiexp(elements, scalars).point();
+}
+
+void Combination::add(const Point& p, const Scalar& x) {
+    const std::string key(reinterpret_cast<const char*>(p.data()), Point::SIZE);
+    auto i = m_index.find(key);
+    if(i != m_index.end()) {
+        m_scalars[i->second] += x;
+        return;
+    }
+
+    m_index[key] = m_points.size();
+    m_points.push_back(p);
+    m_scalars.push_back(x);
+}
+
+Point Combination::sum() const {
+    return multiexp(m_points, m_scalars);
+}
+
+bool Combination::zero() const {
+    return (sum() == Point::zero());
 }
 
 }
@@ -21,7 +21,12 @@
 #ifndef JLIB_CRYPT_CURVE_HH
 #define JLIB_CRYPT_CURVE_HH
 
+#include <cstdint>
 #include <ostream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <sodium.h>
 #include <sodium/crypto_core_ristretto255.h>
@@ -36,6 +41,7 @@ class BasePoint;
 class Point;
 class Scalar;
 class Commitment;
+class Element;
 
 template<int N>
 class Hash {
@@ -65,10 +71,10 @@ template<int N, typename... Args>
 Hash<N> hash(Args&&... args);
 
 template<int N, typename T, typename... Args>
-Hash<N> do_hash(Hash<N>& hasher, const T& t, Args&&... args);
+void do_hash(Hash<N>& hasher, const T& t, Args&&... args);
 
 template<int N, typename T>
-Hash<N> do_hash(Hash<N>& hasher, const T& t);
+void do_hash(Hash<N>& hasher, const T& t);
 
 class Scalar {
 public:
@@ -88,6 +94,7 @@ public:
     Scalar operator+(const Scalar& x) const;
     Scalar operator-(const Scalar& x) const;
     Scalar operator*(const Scalar& x) const;
+    // this to the k, by square and multiply; -1 is the inverse
     Scalar operator^(int k) const;
     Point operator*(const Point& x) const;
     Point operator*(const BasePoint& x) const;
@@ -114,6 +121,9 @@ public:
 protected:
     unsigned char m_data[crypto_core_ristretto255_SCALARBYTES];
 };
+
+// x^0 up to x^n, for a proof that needs every power of its challenge
+std::vector<Scalar> powers(const Scalar& x, std::size_t n);
     
 class Point {
 public:
@@ -144,11 +154,108 @@ public:
     friend class Hash;
     friend class BasePoint;
     friend class Commitment;
+    friend class Element;
     
 protected:
     unsigned char m_data[crypto_core_ristretto255_BYTES];
 };
 
+// a point decoded into extended twisted edwards coordinates (X:Y:Z:T).
+// every Point operation goes through libsodium on the 32 byte encoding,
+// which costs a square root to decode each operand and another to encode
+// the result; an Element is decoded once, and sums and multiples of them
+// stay decoded until point() encodes the answer
+class Element {
+public:
+    // the identity
+    Element();
+    // throws if p isn't the canonical encoding of a point
+    Element(const Point& p);
+
+    Point point() const;
+
+    Element operator+(const Element& x) const;
+    Element operator-(const Element& x) const;
+    Element operator-() const;
+    Element& operator+=(const Element& x);
+    Element& operator-=(const Element& x);
+
+    // 2 * this, cheaper than this + this
+    Element twice() const;
+
+    friend bool operator==(const Element& x, const Element& y);
+    friend class FixedBase;
+
+protected:
+    // each coordinate mod 2^255-19 in five limbs of 51 bits
+    std::uint64_t m_x[5];
+    std::uint64_t m_y[5];
+    std::uint64_t m_z[5];
+    std::uint64_t m_t[5];
+};
+
+bool operator==(const Element& x, const Element& y);
+bool operator!=(const Element& x, const Element& y);
+
+// multiples of a point fixed in advance: j * 16^i * p for each of the 64
+// signed radix 16 digits i of a scalar and j from 1 to 8, so that x * p is
+// 64 additions and no doublings.  each digit's row is scanned in full and
+// the entry picked by masking, so the time taken doesn't depend on x, and
+// blinding factors can go through it.  the table is 60k
+class FixedBase {
+public:
+    FixedBase(const Point& p);
+
+    Element operator*(const Scalar& x) const;
+
+protected:
+    // (y + x, y - x, 2dxy) of the affine point, which adds in 7
+    // multiplications
+    struct Entry {
+        std::uint64_t ypx[5];
+        std::uint64_t ymx[5];
+        std::uint64_t xy2d[5];
+    };
+
+    std::vector<Entry> m_table;
+};
+
+// the sum of scalars[i] * points[i], by pippenger's bucket method: each
+// scalar is cut into signed windows of c bits, and for every window each
+// point is added to the bucket for its digit, so that N terms cost about
+// (256/c) * (N + 2^c) additions instead of N full multiplications.  the
+// time taken depends on the scalars, so keep secrets out of them where
+// that matters
+Element multiexp(const std::vector<Element>& points, const std::vector<Scalar>& scalars);
+Point multiexp(const std::vector<Point>& points, const std::vector<Scalar>& scalars);
+
+// a sum of scalar multiples built up term by term, for checking many
+// verification equations at once.  terms for a point already in the sum
+// add to its scalar, so generators every proof shares are multiplied once
+class Combination {
+public:
+    void add(const Point& p, const Scalar& x);
+
+    // the sum, by multiexp; throws if a point isn't a valid encoding
+    Point sum() const;
+    // whether the sum is the identity
+    bool zero() const;
+
+    std::size_t size() const { return m_points.size(); }
+
+protected:
+    std::vector<Point> m_points;
+    std::vector<Scalar> m_scalars;
+    std::unordered_map<std::string, std::size_t> m_index;
+};
+
+// the indices in [0, n) that fail, given check(begin, end), which is true
+// when every one of [begin, end) passes.  a failing range is split in two
+// and each half checked, so k failures take about 2k log(n/k) checks.
+// check can throw, which counts as failing
+template<typename F>
+std::vector<std::size_t> bisect(std::size_t n, F check);
+
 class BasePoint : public Point {
 public:
     BasePoint();
@@ -165,6 +272,8 @@ bool operator!=(const Scalar& x, const Scalar& y);
 bool operator==(const Point& x, const Point& y);
 bool operator!=(const Point& x, const Point& y);
 
+// a pedersen commitment value * G + blind * H.  both are computed from
+// FixedBase tables for G and H, built on first use, and the sum encoded once
 class Commitment : public Point {
 public:
     Commitment();
@@ -247,16 +356,52 @@ Hash<N> hash(Args&&... args) {
 }
 
 template<int N, typename T, typename... Args>
-Hash<N> do_hash(Hash<N>& hasher, const T& t, Args&&... args) {
+void do_hash(Hash<N>& hasher, const T& t, Args&&... args) {
     hasher.update(t.data(), T::SIZE);
     do_hash(hasher, args...);
 }
 
 template<int N, typename T>
-Hash<N> do_hash(Hash<N>& hasher, const T& t) {
+void do_hash(Hash<N>& hasher, const T& t) {
     hasher.update(t.data(), T::SIZE);
 }
 
+// known_bad when the caller has already seen [begin, end) fail; true when
+// something in it did
+template<typename F>
+bool do_bisect(std::size_t begin, std::size_t end, F& check, std::vector<std::size_t>& bad, bool known_bad) {
+    if(begin == end)
+        return false;
+
+    if(!known_bad) {
+        bool ok = false;
+        try {
+            ok = check(begin, end);
+        } catch(std::exception& e) {
+        }
+        if(ok)
+            return false;
+    }
+
+    if(end - begin == 1) {
+        bad.push_back(begin);
+        return true;
+    }
+
+    // when the first half passes, the second must be what failed
+    const std::size_t mid = begin + (end - begin) / 2;
+    const bool left = do_bisect(begin, mid, check, bad, false);
+    do_bisect(mid, end, check, bad, !left);
+    return true;
+}
+
+template<typename F>
+std::vector<std::size_t> bisect(std::size_t n, F check) {
+    std::vector<std::size_t> bad;
+    do_bisect(0, n, check, bad, false);
+    return bad;
+}
+
 }
 }
 }
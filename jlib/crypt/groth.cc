@@ -26,7 +26,7 @@
 #include <sodium/crypto_core_ristretto255.h>
 
 #include <jlib/crypt/groth.hh>
-#include <jlib/math/polynomial.hh>
+#include <jlib/math/parallel.hh>
 #include <jlib/util/util.hh>
 
 namespace jlib {
@@ -64,8 +64,41 @@ bool verify(const BinaryProof& proof) {
     return (cxca == cfza && cxfcb == czzb);
 }
 
-typedef math::Polynomial<curve::Scalar, curve::Scalar::Power> Polynomial;
-    
+std::vector<std::size_t> verify_batch(const std::vector<BinaryProof>& proofs) {
+    return curve::bisect(proofs.size(), [&proofs](std::size_t begin, std::size_t end) {
+            // both equations of each proof, x*c + c_a - (f*G + z_a*H) and
+            // (x-f)*c + c_b - z_b*H, each with its own weight
+            curve::Combination sum;
+            curve::Scalar g = curve::Scalar::zero();
+            curve::Scalar h = curve::Scalar::zero();
+            for(std::size_t i = begin; i < end; i++) {
+                const BinaryProof& proof = proofs[i];
+                curve::Scalar x = curve::hash<curve::Scalar::HASHSIZE>(proof.c, proof.c_a, proof.c_b);
+                curve::Scalar v = curve::Scalar::random();
+                curve::Scalar w = curve::Scalar::random();
+
+                sum.add(proof.c, v * x + w * (x - proof.f));
+                sum.add(proof.c_a, v);
+                sum.add(proof.c_b, w);
+                g -= v * proof.f;
+                h -= v * proof.z_a + w * proof.z_b;
+            }
+            sum.add(curve::Commitment::G, g);
+            sum.add(curve::Commitment::H, h);
+            return sum.zero();
+        });
+}
+
+namespace {
+
+// commitments or polynomial columns a thread takes at a time
+const std::size_t GRAIN = 256;
+// math's parallel threshold counts multiply-adds of floats, and a scalar
+// product or point decode is a few hundred of those
+const std::size_t COST = 256;
+
+}
+
 ZeroProof prove(const std::vector<curve::Commitment>& c, std::size_t l, const curve::Scalar& r) {
     ZeroProof proof;
 
@@ -77,8 +110,6 @@ ZeroProof prove(const std::vector<curve::Commitment>& c, std::size_t l, const cu
     std::size_t n = lg_ceil;
     std::size_t size = std::pow(2, n);
 
-    std::cout << "proving one of " << c.size() << " commitments is zero, log2 of size is " << lg_ceil << "(" << lg << ")" << std::endl;
-    
     // expand c if necessary
     if(size > c.size()) {
         proof.c.resize(size, c.back());
@@ -111,40 +142,46 @@ ZeroProof prove(const std::vector<curve::Commitment>& c, std::size_t l, const cu
         proof.c_b.push_back(curve::Commitment(cbj, t.back()));
     }
 
-    // now that we have a we can expand f_j,i_j to get p_i(x)
-    // section 2.3 of groth paper, equation (1)
-    std::vector<Polynomial> p_x;
-    for(std::size_t i = 0; i < N; i++) {
-        Polynomial p_i_x;
-        std::bitset<64> i_j(i);
-        // expand the polynomial by multiplying by each f_j,i_j
-        for(int j = 0; j < n; j++) {
-            Polynomial f_j_i_j = i_j[j] ?
-                (l_j[j] ? std::vector<curve::Scalar>{ a[j], curve::Scalar::one() } : std::vector<curve::Scalar> { a[j] }) :
-                (!l_j[j] ? std::vector<curve::Scalar>{ -a[j], curve::Scalar::one() } : std::vector<curve::Scalar> { -a[j] });
-
-            p_i_x = (p_i_x * f_j_i_j);
-        }
-
-        p_x.push_back(p_i_x);
-
-        //std::cout << "p[" << i << "](x) = " << p_x[i] << std::endl;
+    // the coefficients of every p_i(x) = prod_j f_j,i_j(x), section 2.3 of
+    // groth paper, equation (1), with coefficient k of p_i at p[k*N + i].
+    // after bit j the first 2^j columns hold the products over bits below
+    // j; each is multiplied by f_j,1 = l_j x + a_j into column i + 2^j and
+    // by f_j,0 = (1 - l_j) x - a_j in place, one product per coefficient
+    std::vector<curve::Scalar> p((n + 1) * N, curve::Scalar::zero());
+    p[0] = curve::Scalar::one();
+    for(std::size_t j = 0; j < n; j++) {
+        const std::size_t half = std::size_t(1) << j;
+        math::parallel_for(half, GRAIN, [&](std::size_t begin, std::size_t end) {
+                for(std::size_t i = begin; i < end; i++) {
+                    for(std::size_t k = j + 2; k-- > 0; ) {
+                        const curve::Scalar ap = a[j] * p[k * N + i];
+                        const curve::Scalar& below = (k > 0 ? p[(k - 1) * N + i] : curve::Scalar::zero());
+                        p[k * N + i + half] = (l_j[j] ? ap + below : ap);
+                        p[k * N + i] = (l_j[j] ? -ap : below - ap);
+                    }
+                }
+            }, COST * half * (j + 2));
     }
 
-    // now that we have all p_i(x) we can finally calculate c_d
-    for(int j = 0; j < n; j++) {
-        curve::Point c_0_rho_k = curve::Commitment(0, rho[j]);
-
-        curve::Point c_d_k = curve::Point::zero(); //proof.c[0] * p_x[0][j];
-        for(std::size_t i = 0; i < N; i++) {
-            curve::Scalar p_x_i_j = p_x[i][j];
-            c_d_k += (proof.c[i] * p_x_i_j);
-        }
-
-        c_d_k += c_0_rho_k;
-
-        proof.c_d.push_back(c_d_k);
-    }
+    // now that we have all p_i(x) we can finally calculate c_d.  each c_d_k
+    // is a sum over all N commitments, so decode them once for all n sums
+    std::vector<curve::Element> c_i(N);
+    math::parallel_for(N, GRAIN, [&](std::size_t begin, std::size_t end) {
+            for(std::size_t i = begin; i < end; i++) {
+                c_i[i] = curve::Element(proof.c[i]);
+            }
+        }, COST * N);
+
+    proof.c_d.resize(n);
+    math::parallel_for(n, 1, [&](std::size_t begin, std::size_t end) {
+            for(std::size_t k = begin; k < end; k++) {
+                const std::vector<curve::Scalar> p_k(p.begin() + k * N, p.begin() + (k + 1) * N);
+                curve::Element c_d_k = curve::multiexp(c_i, p_k);
+                c_d_k += curve::Commitment(curve::Scalar::zero(), rho[k]);
+
+                proof.c_d[k] = c_d_k.point();
+            }
+        }, COST * N * n);
 
     curve::Hash<curve::Scalar::HASHSIZE> xhash;
     for(curve::Commitment i : proof.c)
@@ -161,10 +198,6 @@ ZeroProof prove(const std::vector<curve::Commitment>& c, std::size_t l, const cu
 
     //std::cout << "proof hash is " << x << std::endl;
 
-    for(int i = 0; i < N; i++) {
-        //std::cout << "p[" << i << "](" << x << ") = " << p_x[i](x) << std::endl;
-    }
-    
     for(int j = 0; j < n; j++) {
         curve::Scalar f_j = l_j[j] ?
             (x + a[j]) : a[j];
@@ -177,9 +210,10 @@ ZeroProof prove(const std::vector<curve::Commitment>& c, std::size_t l, const cu
         proof.z_b.push_back(z_b);
     }
 
-    proof.z_d = r * (x^n);
+    const std::vector<curve::Scalar> x_k = curve::powers(x, n);
+    proof.z_d = r * x_k[n];
     for(int k = 0; k < n; k++) {
-        proof.z_d -= (rho[k] * (x^k));
+        proof.z_d -= (rho[k] * x_k[k]);
     }
 
     /*
@@ -254,52 +288,38 @@ bool verify(const ZeroProof& proof) {
         }
     }
 
-    // first calculate the c_d_k^-x^k product
-    //curve::Scalar x_k_0 = curve::Scalar::one();
-    //curve::Point c_d_k_x_k_0 = proof.c_d[0] * (-x_k_0);
-    curve::Point P_c_d_k_x_k = curve::Point::zero();//c_d_k_x_k_0;
-    for(int k = 0; k < n; k++) {
-        curve::Point c_d_k_x_k = proof.c_d[k] * (-(x^k));
-        //curve::Point c_d_k_x_k = (proof.c_d[k] * ((-x)^k));
+    // the product of c_d_k^-x^k and of c_i^(prod_j f_j,i_j) is one multiexp
+    // over both sets of points
+    std::vector<curve::Point> points(proof.c.begin(), proof.c.end());
+    std::vector<curve::Scalar> scalars;
+    scalars.reserve(N + n);
 
-        P_c_d_k_x_k += c_d_k_x_k;
+    // prod_j f_j,i_j for every i, a bit at a time: the products for i below
+    // 2^(j+1) are those for i mod 2^j times f_j,i_j
+    scalars.push_back(curve::Scalar::one());
+    for(int j = 0; j < n; j++) {
+        const std::size_t half = scalars.size();
+        const curve::Scalar f_j_0 = x - proof.f[j];
+        for(std::size_t i = 0; i < half; i++) {
+            scalars.push_back(scalars[i] * proof.f[j]);
+            scalars[i] *= f_j_0;
+        }
     }
-
-    curve::Point c0zd = curve::Commitment(curve::Scalar::zero(), proof.z_d);
-    /*
-    // calculate f_j,i_j starting with i=0
-    curve::Scalar P_f_j_i_j_0 = x - proof.f[0];
-    for(int j = 1; j < n; j++) {
-        // f_j,i_j is always f_j,0 when i=0
-        curve::Scalar f_j_i_j = x - proof.f[j];
-
-        P_f_j_i_j_0 *= f_j_i_j;
+    if(scalars.size() != N) {
+        std::cerr << "groth zeroproof failed to verify because it has " << N << " commitments for " << n << " bits" << std::endl;
+        return false;
     }
-    */
-    curve::Point P_c_i_f_j_i_j = curve::Point::zero();//proof.c[0] * P_f_j_i_j_0;
-    for(int i = 0; i < N; i++) {
-        std::bitset<64> i_j(i);
-        //std::cout << "at i = " << i << ": i_j = " << i_j << std::endl;
-        curve::Scalar P_f_j_i_j = curve::Scalar::one();
-        for(int j = 0; j < n; j++) {
-            curve::Scalar f_j_i_j = i_j[j] ? proof.f[j] : (x - proof.f[j]);
-            //std::cout << "i_j[" << j << "] = " << i_j[j] << std::endl;
-            P_f_j_i_j *= f_j_i_j;
-        }
-        
-        //std::cout << "P_f_j_i_j[" << i << "] = " << P_f_j_i_j << std::endl;
 
-        P_c_i_f_j_i_j += (proof.c[i] * P_f_j_i_j);
+    const std::vector<curve::Scalar> x_k = curve::powers(x, n);
+    for(int k = 0; k < n; k++) {
+        points.push_back(proof.c_d[k]);
+        scalars.push_back(-x_k[k]);
     }
 
-    if((P_c_i_f_j_i_j + P_c_d_k_x_k) != c0zd) {
+    curve::Point c0zd = curve::Commitment(curve::Scalar::zero(), proof.z_d);
+
+    if(curve::multiexp(points, scalars) != c0zd) {
         std::cerr << "groth zeroproof failed to verify because product part failed" << std::endl;
-        /*
-        std::cerr << "P_c_i_f_j_i_j = \n" << P_c_i_f_j_i_j << std::endl;
-        std::cerr << "P_c_d_k_x_k = \n" << P_c_d_k_x_k << std::endl;
-        std::cerr << "P_c_i_f_j_i_j + P_c_d_k_x_k = \n" << (P_c_d_k_x_k + P_c_i_f_j_i_j) << std::endl;
-        std::cerr << "c0zd = \n" << c0zd << std::endl;
-        */
         return false;
     }
     
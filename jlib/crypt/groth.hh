@@ -47,6 +47,10 @@ BinaryProof prove(const curve::Scalar& m, const curve::Scalar& r);
 
 bool verify(const BinaryProof& proof);
 
+// the indices of the proofs that don't verify, empty when they all do; see
+// schnorr::verify_batch
+std::vector<std::size_t> verify_batch(const std::vector<BinaryProof>& proofs);
+
 // a ZeroProof is a proof that one of the many commitments opens to zero
 struct ZeroProof {
     std::vector<curve::Commitment> c;
@@ -60,6 +64,9 @@ struct ZeroProof {
     curve::Scalar z_d;
 };
     
+// proves that c[l] is a commitment to zero with blind r.  the polynomial
+// coefficients, decoding c and the multiexp for each c_d_k are spread over
+// math::set_threads threads
 ZeroProof prove(const std::vector<curve::Commitment>& c, std::size_t l, const curve::Scalar& r);
 
 bool verify(const ZeroProof& proof);
@@ -70,6 +70,48 @@ bool verify(const DoubleProof& proof) {
     return (u == proof.u);
 }
 
+namespace {
+
+// w * (r*g + c*y - t), which is zero for a good proof
+void add(curve::Combination& sum, const Proof& proof, const curve::Scalar& w) {
+    curve::Scalar c = curve::hash<curve::Scalar::HASHSIZE>(proof.g, proof.y, proof.t);
+
+    sum.add(proof.g, w * proof.r);
+    sum.add(proof.y, w * c);
+    sum.add(proof.t, -w);
+}
+
+// w * (c*y + s*g + t*h - u)
+void add(curve::Combination& sum, const DoubleProof& proof, const curve::Scalar& w) {
+    curve::Scalar c = curve::hash<curve::Scalar::HASHSIZE>(proof.y, proof.u);
+
+    sum.add(proof.y, w * c);
+    sum.add(proof.g, w * proof.s);
+    sum.add(proof.h, w * proof.t);
+    sum.add(proof.u, -w);
+}
+
+template<typename P>
+std::vector<std::size_t> verify_any(const std::vector<P>& proofs) {
+    return curve::bisect(proofs.size(), [&proofs](std::size_t begin, std::size_t end) {
+            curve::Combination sum;
+            for(std::size_t i = begin; i < end; i++) {
+                add(sum, proofs[i], curve::Scalar::random());
+            }
+            return sum.zero();
+        });
+}
+
+}
+
+std::vector<std::size_t> verify_batch(const std::vector<Proof>& proofs) {
+    return verify_any(proofs);
+}
+
+std::vector<std::size_t> verify_batch(const std::vector<DoubleProof>& proofs) {
+    return verify_any(proofs);
+}
+
 }
 }
 }
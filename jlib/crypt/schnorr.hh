@@ -23,6 +23,7 @@
 
 #include <ostream>
 #include <iterator>
+#include <vector>
 
 #include <sodium.h>
 #include <sodium/crypto_core_ristretto255.h>
@@ -65,6 +66,12 @@ DoubleProof prove(const curve::Point& y, const curve::Scalar& s, const curve::Sc
 
 bool verify(const DoubleProof& proof);
 
+// the indices of the proofs that don't verify, empty when they all do.
+// every proof's equation is weighted by a random scalar and the lot is
+// checked as one multiexp; a batch that fails is bisected to find which
+std::vector<std::size_t> verify_batch(const std::vector<Proof>& proofs);
+std::vector<std::size_t> verify_batch(const std::vector<DoubleProof>& proofs);
+
 template<int N>
 struct GeneralProof {
     curve::Point g;
@@ -5,10 +5,13 @@
  */
 
 #include <jlib/cuda/cuda.hh>
+#include <jlib/cuda/gemm.hh>
 
 #include <stdexcept>
+#include <string>
 
 #include <cuda_runtime.h>
+#include <cublas_v2.h>
 
 namespace jlib {
 namespace cuda {
@@ -25,6 +28,112 @@ void* malloc(std::size_t n) {
 void free(void* p) {
     cudaFree(p);
 }
+
+namespace {
+
+void check(cudaError_t err, const char* what) {
+    if(err != cudaSuccess)
+        throw std::runtime_error(std::string(what) + ": " + cudaGetErrorString(err));
+}
+
+void check(cublasStatus_t status, const char* what) {
+    if(status != CUBLAS_STATUS_SUCCESS)
+        throw std::runtime_error(std::string(what) + " failed with cublas status " + std::to_string(int(status)));
+}
+
+cublasStatus_t gemm(cublasHandle_t h, cublasOperation_t ta, cublasOperation_t tb, int m, int n, int k,
+                    const float* alpha, const float* a, int lda, const float* b, int ldb,
+                    const float* beta, float* c, int ldc) {
+    return cublasSgemm(h, ta, tb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+}
+
+cublasStatus_t gemm(cublasHandle_t h, cublasOperation_t ta, cublasOperation_t tb, int m, int n, int k,
+                    const double* alpha, const double* a, int lda, const double* b, int ldb,
+                    const double* beta, double* c, int ldc) {
+    return cublasDgemm(h, ta, tb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+}
+
+cublasStatus_t axpy(cublasHandle_t h, int n, const float* alpha, const float* x, float* y) {
+    return cublasSaxpy(h, n, alpha, x, 1, y, 1);
+}
+
+cublasStatus_t axpy(cublasHandle_t h, int n, const double* alpha, const double* x, double* y) {
+    return cublasDaxpy(h, n, alpha, x, 1, y, 1);
+}
+
+// copy n values of host memory to a device buffer grown to fit them
+template<typename T>
+T* upload(device_buffer<T>& d, const T* p, std::size_t n) {
+    T* ret = d.reserve(n);
+    check(cudaMemcpy(ret, p, n * sizeof(T), cudaMemcpyHostToDevice), "cudaMemcpy to device");
+    return ret;
+}
+
+}
+
+template<typename T>
+backend<T>::backend() {
+    cublasHandle_t h;
+    check(cublasCreate(&h), "cublasCreate");
+    m_handle = h;
+}
+
+template<typename T>
+backend<T>::~backend() {
+    cublasDestroy(m_handle);
+}
+
+template<typename T>
+void backend<T>::gemm(bool ta, bool tb, unsigned int m, unsigned int n, unsigned int k,
+                      T alpha, const T* a, unsigned int lda, const T* b, unsigned int ldb,
+                      T beta, T* c, unsigned int ldc) {
+    if(m == 0 || n == 0)
+        return;
+
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    // each operand is a whole number of columns of its leading dimension
+    const std::size_t asize = std::size_t(lda) * (ta ? m : k);
+    const std::size_t bsize = std::size_t(ldb) * (tb ? k : n);
+    const std::size_t csize = std::size_t(ldc) * n;
+
+    const T* da = upload(m_a, a, asize);
+    const T* db = upload(m_b, b, bsize);
+    // c is never read when beta is zero, and may be garbage
+    T* dc = (beta == T(0) ? m_c.reserve(csize) : upload(m_c, c, csize));
+
+    check(cuda::gemm(m_handle, (ta ? CUBLAS_OP_T : CUBLAS_OP_N), (tb ? CUBLAS_OP_T : CUBLAS_OP_N), m, n, k,
+                     &alpha, da, lda, db, ldb, &beta, dc, ldc), "cublas gemm");
+    check(cudaMemcpy(c, dc, csize * sizeof(T), cudaMemcpyDeviceToHost), "cudaMemcpy from device");
+}
+
+template<typename T>
+void backend<T>::axpy(std::size_t n, T alpha, const T* x, T* y) {
+    if(n == 0)
+        return;
+
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    const T* dx = upload(m_a, x, n);
+    T* dy = upload(m_c, y, n);
+    check(cuda::axpy(m_handle, n, &alpha, dx, dy), "cublas axpy");
+    check(cudaMemcpy(y, dy, n * sizeof(T), cudaMemcpyDeviceToHost), "cudaMemcpy from device");
+}
+
+template class backend<float>;
+template class backend<double>;
+
+namespace {
+
+// "cuda" is there for any network once libjcuda is linked
+struct registrar {
+    registrar() {
+        ai::backend<float>::add("cuda", []() { return ai::backend<float>::ptr(new backend<float>()); });
+        ai::backend<double>::add("cuda", []() { return ai::backend<double>::ptr(new backend<double>()); });
+    }
+} registered;
+
+}
     
 }
 }
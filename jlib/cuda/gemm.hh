@@ -4,92 +4,74 @@
  * 
  */
 
-#include <jlib/math/matrix.hh>
+#ifndef JLIB_CUDA_GEMM_HH
+#define JLIB_CUDA_GEMM_HH
 
 #include <jlib/cuda/cuda.hh>
+#include <jlib/ai/backend.hh>
 
-#include <cuda_runtime.h>
-#include <cublas_v2.h>
+#include <mutex>
+#include <string>
 
+struct cublasContext;
 
 namespace jlib {
-namespace cublas {
+namespace cuda {
 
+// device memory that only ever grows, so a network's products stop
+// allocating once they have seen the widest batch
 template<typename T>
-struct gemm_base {
-    //gemm_base(cublasHandle_t handle) : m_handle(handle) {}
-    //cublasHandle_t m_handle;
-    static void get_matrix(const T* cd, math::matrix<T> c);
-    static T* set_matrix(math::matrix<T> m);
-    static void set_matrix(math::matrix<T> m, T* ret);
-};
-    
-template<typename T>
-struct gemm : public gemm_base<T> {
+struct device_buffer {
+    T* data = nullptr;
+    std::size_t capacity = 0;
 
-    void operator()(cublasHandle_t handle, cublasOperation_t tra, cublasOperation_t trb, T alpha, math::matrix<T> a, const T* da, math::matrix<T> b, const T* db, T beta, math::matrix<T> c, T* dc) {}
+    ~device_buffer() { cuda::free(data); }
 
-};
-
-template<>
-struct gemm<float> : public gemm_base<float> {
-    void operator()(cublasHandle_t handle, cublasOperation_t tra, cublasOperation_t trb, float alpha, math::matrix<float> a, const float* ad, math::matrix<float> b, const float* bd, float beta, math::matrix<float> c, float* cd) {
-        cublasStatus_t stat;
-        uint k = (tra == CUBLAS_OP_N ? a.N : a.M);
-        
-        stat = cublasSgemm (handle, tra, trb, c.M, c.N, k, &alpha, ad, a.M, bd, b.M, &beta, cd, c.M);
-        if (stat != CUBLAS_STATUS_SUCCESS) {
-            throw std::runtime_error ("CUBLAS multiplication failed\n");
+    T* reserve(std::size_t n) {
+        if(n > capacity) {
+            cuda::free(data);
+            data = nullptr;
+            data = static_cast<T*>(cuda::malloc(n * sizeof(T)));
+            capacity = n;
         }
-        
-        this->get_matrix(cd, c);
+        return data;
     }
 };
 
-template<>
-struct gemm<double> : public gemm_base<double> {
-    void operator()(cublasHandle_t handle, cublasOperation_t tra, cublasOperation_t trb, double alpha, math::matrix<double> a, const double* ad, math::matrix<double> b, const double* bd, double beta, math::matrix<double> c, double* cd) {
-        cublasStatus_t stat;
-        uint k = (tra == CUBLAS_OP_N ? a.N : a.M);
-        
-        stat = cublasDgemm (handle, tra, trb, c.M, c.N, k, &alpha, ad, a.M, bd, b.M, &beta, cd, c.M);
-        if (stat != CUBLAS_STATUS_SUCCESS) {
-            throw std::runtime_error ("CUBLAS multiplication failed\n");
-        }
-        
-        this->get_matrix(cd, c);
-    }
-};
+// the "cuda" compute backend: products through cublas on one handle, with
+// operands copied through device buffers kept for the life of the backend.
+// calls are serialized, since the buffers are shared.  float and double,
+// registered with ai::backend by libjcuda
+template<typename T>
+class backend : public ai::backend<T> {
+public:
+    backend();
+    ~backend();
 
+    std::string name() const { return "cuda"; }
 
-template<typename T>
-void gemm_base<T>::get_matrix(const T* cd, math::matrix<T> c) {
-    math::buffer<T> cb = c;
-    cublasStatus_t stat = cublasGetMatrix (c.M, c.N, sizeof(float), cd, c.M, cb.data(), c.M);
-    if (stat != CUBLAS_STATUS_SUCCESS) {
-        std::ostringstream os;
-        os << "data upload failed: " << (int)stat;
-        throw std::runtime_error(os.str());
-    }
-}
+    void gemm(bool ta, bool tb, unsigned int m, unsigned int n, unsigned int k,
+              T alpha, const T* a, unsigned int lda, const T* b, unsigned int ldb,
+              T beta, T* c, unsigned int ldc);
+    void axpy(std::size_t n, T alpha, const T* x, T* y);
 
-template<typename T>    
-T* gemm_base<T>::set_matrix(math::matrix<T> m) {
-    T* ret = (T*)cuda::malloc(m.M * m.N * sizeof(T));
-    set_matrix(m, ret);
-    return ret;
-}
+    using ai::backend<T>::gemm;
+    using ai::backend<T>::axpy;
+
+protected:
+    backend(const backend&);
+
+    std::mutex m_lock;
+    cublasContext* m_handle;
+    device_buffer<T> m_a;
+    device_buffer<T> m_b;
+    device_buffer<T> m_c;
+};
+
+extern template class backend<float>;
+extern template class backend<double>;
 
-template<typename T>
-void gemm_base<T>::set_matrix(math::matrix<T> m, T* ret) {
-    math::buffer<T> buffer = m;
-    
-    cublasStatus_t stat = cublasSetMatrix (m.M, m.N, sizeof(T), buffer.data(), m.M, ret, m.M);
-    
-    if (stat != CUBLAS_STATUS_SUCCESS) {
-        throw std::runtime_error ("data download failed");
-    }
-}
-    
 }
 }
+
+#endif //JLIB_CUDA_GEMM_HH
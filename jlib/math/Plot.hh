@@ -22,7 +22,10 @@
 #define JLIB_MATH_PLOT_HH
 
 #include <jlib/math/math.hh>
+#include <jlib/math/fixed.hh>
 
+#include <map>
+#include <type_traits>
 #include <vector>
 #include <stack>
 
@@ -30,7 +33,39 @@
 namespace jlib {
 namespace math {
 
-        
+// plots of up to this many dimensions are drawn with fixed_matrix, so the
+// per vertex work stays on the stack.  bigger ones fall back to matrix
+const uint FIXED_DIMENSIONS = 10;
+
+// the projections transform applies after the first, from d down to 3, as
+// fixed matrices built once per frame
+template<typename T, uint d, bool = (d > 2)>
+struct projection_chain {
+    projection_chain(const std::vector< std::pair<T,T> >&) {}
+
+    template<uint N>
+    void apply(fixed_vertex<T,N>&) const {}
+};
+
+template<typename T, uint d>
+struct projection_chain<T, d, true> {
+    projection_chain(const std::vector< std::pair<T,T> >& clip)
+        : p(matrix<T>::project(d, clip)),
+          next(clip)
+    {}
+
+    template<uint N>
+    void apply(fixed_vertex<T,N>& ret) const {
+        fixed_vertex<T,d> v = ret.template change<d>();
+        ret = p * v();
+        ret.normalize();
+        next.apply(ret);
+    }
+
+    fixed_matrix<T,d+1,d+1> p;
+    projection_chain<T,d-1> next;
+};
+
 template<typename T>
 class Plot {
 public:
@@ -45,6 +80,8 @@ public:
     virtual void draw();
 
     std::pair<uint,uint> map(const math::vertex<T>& v);
+    template<uint N>
+    std::pair<uint,uint> map(const math::fixed_vertex<T,N>& v);
 
     void set(STACK s);
     void push();
@@ -63,15 +100,36 @@ public:
 
 protected:
     bool visible(math::vertex<T> vertex) const;
+    // the per vertex work of draw().  with fixed_transform set, plots of up
+    // to FIXED_DIMENSIONS do the same work with fixed_matrix instead
     virtual math::vertex<T> transform(const math::vertex<T>& v) const;
 
+    // draw() for a D known at compile time, picked by dispatch()
+    template<uint N>
+    void draw_fixed();
+    template<uint N>
+    void dispatch(std::integral_constant<uint,N>);
+    void dispatch(std::integral_constant<uint,0>);
+
+    std::pair<uint,uint> map(T x, T y) const;
+
     std::vector< std::pair<T,T> > clip;
     std::list< object<T> > objects;
+    // for each object, the index of every vertex adjacent to each vertex
+    std::list< std::vector< std::vector<uint> > > edges;
+    // screen position of each vertex of the object being drawn
+    std::vector< std::pair<uint,uint> > points;
     std::stack< matrix<T> > modelview;
     std::stack< matrix<T> > projection;
     STACK current;
     uint width;
     uint height;
+
+    // set by a plot whose transform is Plot's own, to let draw() take the
+    // fixed_matrix path.  off by default, so an overridden transform is
+    // always called; a subclass of a plot that sets it and overrides
+    // transform has to clear it again
+    bool fixed_transform;
 };
 
 
@@ -81,7 +139,8 @@ Plot<T>::Plot(uint n, std::vector< std::pair<T,T> > c, uint w, uint h)
     : D(n),
       clip(c),
       width(w),
-      height(h)
+      height(h),
+      fixed_transform(false)
 {    
     if(c.size())
        change(n);
@@ -91,45 +150,108 @@ Plot<T>::Plot(uint n, std::vector< std::pair<T,T> > c, uint w, uint h)
 template<typename T>
 inline
 typename Plot<T>::objref Plot<T>::add(const object<T>& o) {
-    return objects.insert(objects.end(), o);
+    // adjacency is stored by value, so look the neighbours up once here
+    // rather than every frame
+    std::map<vertex<T>, uint> index;
+    for(uint j = 0; j < o.size(); j++) {
+        index.insert(std::make_pair(o[j], j));
+    }
+
+    object<T>& added = *objects.insert(objects.end(), o);
+    std::vector< std::vector<uint> > adj(added.size());
+    for(uint j = 0; j < added.size(); j++) {
+        std::list< vertex<T> > adjacent = added.adjacent(j);
+        typename std::list< vertex<T> >::iterator k;
+        for(k = adjacent.begin(); k != adjacent.end(); k++) {
+            adj[j].push_back(index.find(*k)->second);
+        }
+    }
+    edges.push_back(adj);
+
+    return --objects.end();
 }
 
 
 template<typename T>
 inline
 void Plot<T>::draw() {
+    if(fixed_transform)
+        dispatch(std::integral_constant<uint,FIXED_DIMENSIONS>());
+    else
+        dispatch(std::integral_constant<uint,0>());
+}
+
+
+template<typename T>
+template<uint N>
+inline
+void Plot<T>::dispatch(std::integral_constant<uint,N>) {
+    if(D == N)
+        draw_fixed<N>();
+    else
+        dispatch(std::integral_constant<uint,N-1>());
+}
+
+
+template<typename T>
+inline
+void Plot<T>::dispatch(std::integral_constant<uint,0>) {
     typename std::list< object<T> >::iterator i = objects.begin();
-    for(; i != objects.end(); i++) {
-        std::map<vertex<T>, std::pair<uint,uint> > mapped;
+    typename std::list< std::vector< std::vector<uint> > >::iterator e = edges.begin();
+    for(; i != objects.end(); i++, e++) {
         object<T>& object = *i;
 
+        points.resize(object.size());
         for(uint j = 0; j < object.size(); j++) {
-            vertex<T>& v1 = object[j];
-            vertex<T> tv1 = transform(v1);
-            std::pair<uint,uint> p1 = map(tv1);
-
-            mapped.insert(std::make_pair(v1, p1));
+            points[j] = map(transform(object[j]));
         }
 
         for(uint j = 0; j < object.size(); j++) {
-            math::vertex<T>& v1 = object[j];
-            //math::vertex<T>& tv1 = transformed.find(v1)->second;
-            std::pair<uint,uint>& p1 = mapped.find(v1)->second;
-
             /* if(!visible(tv1)) continue; */
 
-            draw_point(p1);
-            
-            std::list< math::vertex<T> > adjacent = object.adjacent(j);
-            typename std::list< math::vertex<T> >::iterator k;
-            for(k = adjacent.begin(); k != adjacent.end(); k++) {
-                math::vertex<T>& v2 = *k;
-                //math::vertex<T>& tv2 = transformed.find(v2)->second;
-                std::pair<uint,uint>& p2 = mapped.find(v2)->second;
+            draw_point(points[j]);
+
+            const std::vector<uint>& adjacent = (*e)[j];
+            for(uint k = 0; k < adjacent.size(); k++) {
+                draw_line(points[j], points[adjacent[k]]);
+            }
+        }
+    }
+}
 
-                /* if(!visible(tv2)) continue; */
 
-                draw_line(p1, p2);
+template<typename T>
+template<uint N>
+inline
+void Plot<T>::draw_fixed() {
+    // projection * modelview once per frame, then each vertex is one
+    // unrolled product and the chain of projections down to two dimensions
+    const fixed_matrix<T,N+1,N+1> view =
+        fixed_matrix<T,N+1,N+1>(projection.top()) * fixed_matrix<T,N+1,N+1>(modelview.top());
+    const projection_chain<T,N-1> chain(clip);
+
+    typename std::list< object<T> >::iterator i = objects.begin();
+    typename std::list< std::vector< std::vector<uint> > >::iterator e = edges.begin();
+    for(; i != objects.end(); i++, e++) {
+        object<T>& object = *i;
+
+        points.resize(object.size());
+        for(uint j = 0; j < object.size(); j++) {
+            fixed_vertex<T,N> v(object[j]);
+            fixed_vertex<T,N> ret;
+            ret = view * v();
+            ret.normalize();
+            chain.apply(ret);
+
+            points[j] = map(ret);
+        }
+
+        for(uint j = 0; j < object.size(); j++) {
+            draw_point(points[j]);
+
+            const std::vector<uint>& adjacent = (*e)[j];
+            for(uint k = 0; k < adjacent.size(); k++) {
+                draw_line(points[j], points[adjacent[k]]);
             }
         }
     }
@@ -139,6 +261,21 @@ void Plot<T>::draw() {
 template<typename T>
 inline
 std::pair<uint,uint> Plot<T>::map(const math::vertex<T>& v) {
+    return map(v[0], v[1]);
+}
+
+
+template<typename T>
+template<uint N>
+inline
+std::pair<uint,uint> Plot<T>::map(const math::fixed_vertex<T,N>& v) {
+    return map(v[0], v[1]);
+}
+
+
+template<typename T>
+inline
+std::pair<uint,uint> Plot<T>::map(T x, T y) const {
     std::pair<uint,uint> ret;
     T cw = clip[0].second - clip[0].first;
     T ch = clip[1].second - clip[1].first;
@@ -148,8 +285,8 @@ std::pair<uint,uint> Plot<T>::map(const math::vertex<T>& v) {
     int cx = width / 2;
     int cy = height / 2;
 
-    ret.first  = static_cast<uint>(cx + (mw * v[0]));
-    ret.second = static_cast<uint>(cy + (mh * v[1]));
+    ret.first  = static_cast<uint>(cx + (mw * x));
+    ret.second = static_cast<uint>(cy + (mh * y));
 
     return ret;
 }
@@ -173,15 +310,21 @@ inline
 math::vertex<T> Plot<T>::transform(const math::vertex<T>& vertex) const {
     math::vertex<T> ret(D);
 
-    ret = (projection.top() * modelview.top() * vertex());
+    // two matrix-vector products instead of projection * modelview per vertex.
+    // view is local, like ret, so transform leaves the plot alone
+    math::matrix<T> view(D + 1, 1);
+    math::gemm(T(1), modelview.top(), math::NOTRANS, vertex(), math::NOTRANS, T(0), view);
+    math::gemm(T(1), projection.top(), math::NOTRANS, view, math::NOTRANS, T(0), ret());
     ret.normalize();
 
     // keep projecting until we get to two dimensions
     for(int d = (D - 1); d > 2; d--) {
         math::matrix<T> p = math::matrix<T>::project(d, clip);
         math::vertex<T> v(d);
+        math::vertex<T> pv(d);
         v = ret;
-        ret = p * v();
+        math::gemm(T(1), p, math::NOTRANS, v(), math::NOTRANS, T(0), pv());
+        ret = pv();
         ret.normalize();
     }
 
@@ -271,6 +414,7 @@ void Plot<T>::change(uint n) {
     set(MODELVIEW);
 
     objects.clear();
+    edges.clear();
 }
 
 }
@@ -0,0 +1,584 @@
+/* -*- mode: C++ c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2026 Joey Yandle <xoloki@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+#ifndef JLIB_MATH_ACTIVATION_HH
+#define JLIB_MATH_ACTIVATION_HH
+
+#include <jlib/math/gemm.hh>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// elementwise kernels for the activation functions of a neural network,
+// over n contiguous values.  y may be x, and d may be e or y.  the
+// exponentials are a range reduction to [-ln2/2, ln2/2] and a polynomial,
+// good to a couple of ulps, with the widest vectors the cpu has.  they
+// flush to 0 below -708 and go to inf above 709 (-87 and 88 for float),
+// a little before the library's exp would, and pass NaNs through.  tanh
+// is a taylor series near 0 and within a few ulps everywhere
+namespace jlib {
+namespace math {
+namespace kernel {
+
+enum transcendental_op { EXP, SIGMOID, TANH };
+
+// exp, and the two activations built on it, for one T/isa pair.  the
+// scalar one is the library's own exp
+template<typename T, isa I>
+struct transcendental {
+    static void exp(std::size_t n, const T* x, T* y);
+    // 1 / (1 + exp(-x))
+    static void sigmoid(std::size_t n, const T* x, T* y);
+    // 2 * sigmoid(2x) - 1
+    static void tanh(std::size_t n, const T* x, T* y);
+};
+
+// the same, on whatever get_isa() allows, plus the kernels simple enough
+// that the compiler vectorizes them itself.  the backward kernels take the
+// errors e at the outputs y = f(x) and write e * f'(x), worked out from y
+template<typename T>
+struct activations {
+    static void exp(std::size_t n, const T* x, T* y);
+    static void sigmoid(std::size_t n, const T* x, T* y);
+    static void tanh(std::size_t n, const T* x, T* y);
+    static void relu(std::size_t n, const T* x, T* y);
+    static void leaky_relu(std::size_t n, T alpha, const T* x, T* y);
+
+    static void sigmoid_backward(std::size_t n, const T* e, const T* y, T* d);
+    static void tanh_backward(std::size_t n, const T* e, const T* y, T* d);
+    static void relu_backward(std::size_t n, const T* e, const T* y, T* d);
+    static void leaky_relu_backward(std::size_t n, T alpha, const T* e, const T* y, T* d);
+
+    // each of cols columns of rows values, column-major and packed
+    static void softmax(std::size_t rows, std::size_t cols, const T* x, T* y);
+    static void softmax_backward(std::size_t rows, std::size_t cols, const T* e, const T* y, T* d);
+};
+
+
+#ifdef JLIB_MATH_GEMM_X86
+
+template<>
+struct transcendental<double, AVX2> {
+    __attribute__((target("avx2,fma")))
+    static inline __m256d vexp(__m256d x) {
+        // x = k ln2 + r; adding 1.5 * 2^52 rounds x / ln2 to the integer k
+        // and leaves it in the low bits of the mantissa
+        const __m256d magic = _mm256_set1_pd(6755399441055744.0);
+        const __m256d zero = _mm256_cmp_pd(x, _mm256_set1_pd(-708.0), _CMP_LT_OQ);
+        const __m256d huge = _mm256_cmp_pd(x, _mm256_set1_pd(709.0), _CMP_GT_OQ);
+        // the clamp's x is the second operand, which min and max return
+        // when either is a NaN, so NaNs come out the far end
+        x = _mm256_min_pd(_mm256_set1_pd(709.0), _mm256_max_pd(_mm256_set1_pd(-708.0), x));
+
+        __m256d k = _mm256_fmadd_pd(x, _mm256_set1_pd(1.4426950408889634), magic);
+        __m256i bits = _mm256_castpd_si256(k);
+        k = _mm256_sub_pd(k, magic);
+
+        // ln2 in two parts, so k ln2 is exact
+        __m256d r = _mm256_fnmadd_pd(k, _mm256_set1_pd(6.93147180369123816490e-01), x);
+        r = _mm256_fnmadd_pd(k, _mm256_set1_pd(1.90821492927058770002e-10), r);
+
+        // taylor to r^12, which is below half an ulp on [-ln2/2, ln2/2]
+        __m256d p = _mm256_set1_pd(1.0 / 479001600.0);
+        p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0 / 39916800.0));
+        p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0 / 3628800.0));
+        p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0 / 362880.0));
+        p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0 / 40320.0));
+        p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0 / 5040.0));
+        p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0 / 720.0));
+        p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0 / 120.0));
+        p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0 / 24.0));
+        p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0 / 6.0));
+        p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(0.5));
+        p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0));
+        p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0));
+
+        // 2^k, with the magic number's own bits shifted out the top
+        __m256i e = _mm256_slli_epi64(_mm256_add_epi64(bits, _mm256_set1_epi64x(1023)), 52);
+        p = _mm256_andnot_pd(zero, _mm256_mul_pd(p, _mm256_castsi256_pd(e)));
+        return _mm256_blendv_pd(p, _mm256_set1_pd(HUGE_VAL), huge);
+    }
+
+    // tanh's taylor series to x^21, for |x| < 1/4, where 2 / (1 + exp(-2x)) - 1
+    // would lose the low bits to cancellation
+    __attribute__((target("avx2,fma")))
+    static inline __m256d vtanh0(__m256d x) {
+        const __m256d x2 = _mm256_mul_pd(x, x);
+        __m256d p = _mm256_set1_pd(9.691537956929451e-05);
+        p = _mm256_fmadd_pd(p, x2, _mm256_set1_pd(-2.3912911424355248e-04));
+        p = _mm256_fmadd_pd(p, x2, _mm256_set1_pd(5.90027440945586e-04));
+        p = _mm256_fmadd_pd(p, x2, _mm256_set1_pd(-1.4558343870513183e-03));
+        p = _mm256_fmadd_pd(p, x2, _mm256_set1_pd(3.592128036572481e-03));
+        p = _mm256_fmadd_pd(p, x2, _mm256_set1_pd(-8.863235529902197e-03));
+        p = _mm256_fmadd_pd(p, x2, _mm256_set1_pd(2.1869488536155203e-02));
+        p = _mm256_fmadd_pd(p, x2, _mm256_set1_pd(-5.396825396825397e-02));
+        p = _mm256_fmadd_pd(p, x2, _mm256_set1_pd(1.3333333333333333e-01));
+        p = _mm256_fmadd_pd(p, x2, _mm256_set1_pd(-3.3333333333333333e-01));
+        return _mm256_fmadd_pd(_mm256_mul_pd(p, x2), x, x);
+    }
+
+    template<transcendental_op F>
+    __attribute__((target("avx2,fma")))
+    static inline __m256d f(__m256d x) {
+        const __m256d one = _mm256_set1_pd(1.0);
+        if(F == SIGMOID)
+            return _mm256_div_pd(one, _mm256_add_pd(one, vexp(_mm256_xor_pd(x, _mm256_set1_pd(-0.0)))));
+        if(F == TANH) {
+            __m256d e = vexp(_mm256_mul_pd(x, _mm256_set1_pd(-2.0)));
+            __m256d t = _mm256_sub_pd(_mm256_div_pd(_mm256_set1_pd(2.0), _mm256_add_pd(one, e)), one);
+            const __m256d small = _mm256_cmp_pd(_mm256_andnot_pd(_mm256_set1_pd(-0.0), x), _mm256_set1_pd(0.25), _CMP_LT_OQ);
+            return _mm256_blendv_pd(t, vtanh0(x), small);
+        }
+        return vexp(x);
+    }
+
+    // the last few values go through one padded vector
+    template<transcendental_op F>
+    __attribute__((target("avx2,fma")))
+    static void apply(std::size_t n, const double* x, double* y) {
+        std::size_t i = 0;
+        for(; i + 4 <= n; i += 4) {
+            _mm256_storeu_pd(y + i, f<F>(_mm256_loadu_pd(x + i)));
+        }
+        if(i < n) {
+            double in[4] = { 0, 0, 0, 0 };
+            double out[4];
+            std::copy(x + i, x + n, in);
+            _mm256_storeu_pd(out, f<F>(_mm256_loadu_pd(in)));
+            std::copy(out, out + (n - i), y + i);
+        }
+    }
+
+    static void exp(std::size_t n, const double* x, double* y) { apply<EXP>(n, x, y); }
+    static void sigmoid(std::size_t n, const double* x, double* y) { apply<SIGMOID>(n, x, y); }
+    static void tanh(std::size_t n, const double* x, double* y) { apply<TANH>(n, x, y); }
+};
+
+template<>
+struct transcendental<float, AVX2> {
+    __attribute__((target("avx2,fma")))
+    static inline __m256 vexp(__m256 x) {
+        const __m256 zero = _mm256_cmp_ps(x, _mm256_set1_ps(-87.0f), _CMP_LT_OQ);
+        const __m256 huge = _mm256_cmp_ps(x, _mm256_set1_ps(88.0f), _CMP_GT_OQ);
+        x = _mm256_min_ps(_mm256_set1_ps(88.0f), _mm256_max_ps(_mm256_set1_ps(-87.0f), x));
+
+        __m256 k = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(1.44269504f)),
+                                   _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m256 r = _mm256_fnmadd_ps(k, _mm256_set1_ps(0.693359375f), x);
+        r = _mm256_fnmadd_ps(k, _mm256_set1_ps(-2.12194440e-4f), r);
+
+        // taylor to r^7
+        __m256 p = _mm256_set1_ps(1.0f / 5040.0f);
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.0f / 720.0f));
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.0f / 120.0f));
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.0f / 24.0f));
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.0f / 6.0f));
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(0.5f));
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.0f));
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.0f));
+
+        __m256i e = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(k), _mm256_set1_epi32(127)), 23);
+        p = _mm256_andnot_ps(zero, _mm256_mul_ps(p, _mm256_castsi256_ps(e)));
+        return _mm256_blendv_ps(p, _mm256_set1_ps(HUGE_VALF), huge);
+    }
+
+    // tanh's taylor series to x^11, for |x| < 1/4
+    __attribute__((target("avx2,fma")))
+    static inline __m256 vtanh0(__m256 x) {
+        const __m256 x2 = _mm256_mul_ps(x, x);
+        __m256 p = _mm256_set1_ps(-8.863235e-03f);
+        p = _mm256_fmadd_ps(p, x2, _mm256_set1_ps(2.1869489e-02f));
+        p = _mm256_fmadd_ps(p, x2, _mm256_set1_ps(-5.3968254e-02f));
+        p = _mm256_fmadd_ps(p, x2, _mm256_set1_ps(1.3333334e-01f));
+        p = _mm256_fmadd_ps(p, x2, _mm256_set1_ps(-3.3333334e-01f));
+        return _mm256_fmadd_ps(_mm256_mul_ps(p, x2), x, x);
+    }
+
+    template<transcendental_op F>
+    __attribute__((target("avx2,fma")))
+    static inline __m256 f(__m256 x) {
+        const __m256 one = _mm256_set1_ps(1.0f);
+        if(F == SIGMOID)
+            return _mm256_div_ps(one, _mm256_add_ps(one, vexp(_mm256_xor_ps(x, _mm256_set1_ps(-0.0f)))));
+        if(F == TANH) {
+            __m256 e = vexp(_mm256_mul_ps(x, _mm256_set1_ps(-2.0f)));
+            __m256 t = _mm256_sub_ps(_mm256_div_ps(_mm256_set1_ps(2.0f), _mm256_add_ps(one, e)), one);
+            const __m256 small = _mm256_cmp_ps(_mm256_andnot_ps(_mm256_set1_ps(-0.0f), x), _mm256_set1_ps(0.25f), _CMP_LT_OQ);
+            return _mm256_blendv_ps(t, vtanh0(x), small);
+        }
+        return vexp(x);
+    }
+
+    template<transcendental_op F>
+    __attribute__((target("avx2,fma")))
+    static void apply(std::size_t n, const float* x, float* y) {
+        std::size_t i = 0;
+        for(; i + 8 <= n; i += 8) {
+            _mm256_storeu_ps(y + i, f<F>(_mm256_loadu_ps(x + i)));
+        }
+        if(i < n) {
+            float in[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+            float out[8];
+            std::copy(x + i, x + n, in);
+            _mm256_storeu_ps(out, f<F>(_mm256_loadu_ps(in)));
+            std::copy(out, out + (n - i), y + i);
+        }
+    }
+
+    static void exp(std::size_t n, const float* x, float* y) { apply<EXP>(n, x, y); }
+    static void sigmoid(std::size_t n, const float* x, float* y) { apply<SIGMOID>(n, x, y); }
+    static void tanh(std::size_t n, const float* x, float* y) { apply<TANH>(n, x, y); }
+};
+
+template<>
+struct transcendental<double, AVX512> {
+    __attribute__((target("avx512f")))
+    static inline __m512d vexp(__m512d x) {
+        // the unmasked min, max and shifts merge into an undefined register
+        // that gcc 12 warns about at -O2, so they go through zero masking
+        const __mmask8 all = 0xff;
+        const __m512d magic = _mm512_set1_pd(6755399441055744.0);
+        const __mmask8 keep = _mm512_cmp_pd_mask(x, _mm512_set1_pd(-708.0), _CMP_NLT_UQ);
+        const __mmask8 huge = _mm512_cmp_pd_mask(x, _mm512_set1_pd(709.0), _CMP_GT_OQ);
+        x = _mm512_maskz_min_pd(all, _mm512_set1_pd(709.0), _mm512_maskz_max_pd(all, _mm512_set1_pd(-708.0), x));
+
+        __m512d k = _mm512_fmadd_pd(x, _mm512_set1_pd(1.4426950408889634), magic);
+        __m512i bits = _mm512_castpd_si512(k);
+        k = _mm512_sub_pd(k, magic);
+
+        __m512d r = _mm512_fnmadd_pd(k, _mm512_set1_pd(6.93147180369123816490e-01), x);
+        r = _mm512_fnmadd_pd(k, _mm512_set1_pd(1.90821492927058770002e-10), r);
+
+        __m512d p = _mm512_set1_pd(1.0 / 479001600.0);
+        p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(1.0 / 39916800.0));
+        p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(1.0 / 3628800.0));
+        p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(1.0 / 362880.0));
+        p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(1.0 / 40320.0));
+        p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(1.0 / 5040.0));
+        p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(1.0 / 720.0));
+        p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(1.0 / 120.0));
+        p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(1.0 / 24.0));
+        p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(1.0 / 6.0));
+        p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(0.5));
+        p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(1.0));
+        p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(1.0));
+
+        __m512i e = _mm512_maskz_slli_epi64(all, _mm512_add_epi64(bits, _mm512_set1_epi64(1023)), 52);
+        p = _mm512_maskz_mul_pd(keep, p, _mm512_castsi512_pd(e));
+        return _mm512_mask_blend_pd(huge, p, _mm512_set1_pd(HUGE_VAL));
+    }
+
+    __attribute__((target("avx512f")))
+    static inline __m512d vtanh0(__m512d x) {
+        const __m512d x2 = _mm512_mul_pd(x, x);
+        __m512d p = _mm512_set1_pd(9.691537956929451e-05);
+        p = _mm512_fmadd_pd(p, x2, _mm512_set1_pd(-2.3912911424355248e-04));
+        p = _mm512_fmadd_pd(p, x2, _mm512_set1_pd(5.90027440945586e-04));
+        p = _mm512_fmadd_pd(p, x2, _mm512_set1_pd(-1.4558343870513183e-03));
+        p = _mm512_fmadd_pd(p, x2, _mm512_set1_pd(3.592128036572481e-03));
+        p = _mm512_fmadd_pd(p, x2, _mm512_set1_pd(-8.863235529902197e-03));
+        p = _mm512_fmadd_pd(p, x2, _mm512_set1_pd(2.1869488536155203e-02));
+        p = _mm512_fmadd_pd(p, x2, _mm512_set1_pd(-5.396825396825397e-02));
+        p = _mm512_fmadd_pd(p, x2, _mm512_set1_pd(1.3333333333333333e-01));
+        p = _mm512_fmadd_pd(p, x2, _mm512_set1_pd(-3.3333333333333333e-01));
+        return _mm512_fmadd_pd(_mm512_mul_pd(p, x2), x, x);
+    }
+
+    template<transcendental_op F>
+    __attribute__((target("avx512f")))
+    static inline __m512d f(__m512d x) {
+        const __m512d one = _mm512_set1_pd(1.0);
+        if(F == SIGMOID)
+            return _mm512_div_pd(one, _mm512_add_pd(one, vexp(_mm512_mul_pd(x, _mm512_set1_pd(-1.0)))));
+        if(F == TANH) {
+            __m512d e = vexp(_mm512_mul_pd(x, _mm512_set1_pd(-2.0)));
+            __m512d t = _mm512_sub_pd(_mm512_div_pd(_mm512_set1_pd(2.0), _mm512_add_pd(one, e)), one);
+            const __mmask8 small = _mm512_cmp_pd_mask(_mm512_abs_pd(x), _mm512_set1_pd(0.25), _CMP_LT_OQ);
+            return _mm512_mask_blend_pd(small, t, vtanh0(x));
+        }
+        return vexp(x);
+    }
+
+    // masked loads and stores take care of the tail
+    template<transcendental_op F>
+    __attribute__((target("avx512f")))
+    static void apply(std::size_t n, const double* x, double* y) {
+        std::size_t i = 0;
+        for(; i + 8 <= n; i += 8) {
+            _mm512_storeu_pd(y + i, f<F>(_mm512_loadu_pd(x + i)));
+        }
+        if(i < n) {
+            const __mmask8 m = __mmask8((1u << (n - i)) - 1);
+            _mm512_mask_storeu_pd(y + i, m, f<F>(_mm512_maskz_loadu_pd(m, x + i)));
+        }
+    }
+
+    static void exp(std::size_t n, const double* x, double* y) { apply<EXP>(n, x, y); }
+    static void sigmoid(std::size_t n, const double* x, double* y) { apply<SIGMOID>(n, x, y); }
+    static void tanh(std::size_t n, const double* x, double* y) { apply<TANH>(n, x, y); }
+};
+
+template<>
+struct transcendental<float, AVX512> {
+    __attribute__((target("avx512f")))
+    static inline __m512 vexp(__m512 x) {
+        const __mmask16 all = 0xffff;
+        const __mmask16 keep = _mm512_cmp_ps_mask(x, _mm512_set1_ps(-87.0f), _CMP_NLT_UQ);
+        const __mmask16 huge = _mm512_cmp_ps_mask(x, _mm512_set1_ps(88.0f), _CMP_GT_OQ);
+        x = _mm512_maskz_min_ps(all, _mm512_set1_ps(88.0f), _mm512_maskz_max_ps(all, _mm512_set1_ps(-87.0f), x));
+
+        __m512 k = _mm512_maskz_roundscale_ps(all, _mm512_mul_ps(x, _mm512_set1_ps(1.44269504f)),
+                                              _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m512 r = _mm512_fnmadd_ps(k, _mm512_set1_ps(0.693359375f), x);
+        r = _mm512_fnmadd_ps(k, _mm512_set1_ps(-2.12194440e-4f), r);
+
+        __m512 p = _mm512_set1_ps(1.0f / 5040.0f);
+        p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(1.0f / 720.0f));
+        p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(1.0f / 120.0f));
+        p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(1.0f / 24.0f));
+        p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(1.0f / 6.0f));
+        p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(0.5f));
+        p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(1.0f));
+        p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(1.0f));
+
+        __m512i e = _mm512_maskz_slli_epi32(all, _mm512_add_epi32(_mm512_maskz_cvtps_epi32(all, k), _mm512_set1_epi32(127)), 23);
+        p = _mm512_maskz_mul_ps(keep, p, _mm512_castsi512_ps(e));
+        return _mm512_mask_blend_ps(huge, p, _mm512_set1_ps(HUGE_VALF));
+    }
+
+    __attribute__((target("avx512f")))
+    static inline __m512 vtanh0(__m512 x) {
+        const __m512 x2 = _mm512_mul_ps(x, x);
+        __m512 p = _mm512_set1_ps(-8.863235e-03f);
+        p = _mm512_fmadd_ps(p, x2, _mm512_set1_ps(2.1869489e-02f));
+        p = _mm512_fmadd_ps(p, x2, _mm512_set1_ps(-5.3968254e-02f));
+        p = _mm512_fmadd_ps(p, x2, _mm512_set1_ps(1.3333334e-01f));
+        p = _mm512_fmadd_ps(p, x2, _mm512_set1_ps(-3.3333334e-01f));
+        return _mm512_fmadd_ps(_mm512_mul_ps(p, x2), x, x);
+    }
+
+    template<transcendental_op F>
+    __attribute__((target("avx512f")))
+    static inline __m512 f(__m512 x) {
+        const __m512 one = _mm512_set1_ps(1.0f);
+        if(F == SIGMOID)
+            return _mm512_div_ps(one, _mm512_add_ps(one, vexp(_mm512_mul_ps(x, _mm512_set1_ps(-1.0f)))));
+        if(F == TANH) {
+            __m512 e = vexp(_mm512_mul_ps(x, _mm512_set1_ps(-2.0f)));
+            __m512 t = _mm512_sub_ps(_mm512_div_ps(_mm512_set1_ps(2.0f), _mm512_add_ps(one, e)), one);
+            const __mmask16 small = _mm512_cmp_ps_mask(_mm512_abs_ps(x), _mm512_set1_ps(0.25f), _CMP_LT_OQ);
+            return _mm512_mask_blend_ps(small, t, vtanh0(x));
+        }
+        return vexp(x);
+    }
+
+    template<transcendental_op F>
+    __attribute__((target("avx512f")))
+    static void apply(std::size_t n, const float* x, float* y) {
+        std::size_t i = 0;
+        for(; i + 16 <= n; i += 16) {
+            _mm512_storeu_ps(y + i, f<F>(_mm512_loadu_ps(x + i)));
+        }
+        if(i < n) {
+            const __mmask16 m = __mmask16((1u << (n - i)) - 1);
+            _mm512_mask_storeu_ps(y + i, m, f<F>(_mm512_maskz_loadu_ps(m, x + i)));
+        }
+    }
+
+    static void exp(std::size_t n, const float* x, float* y) { apply<EXP>(n, x, y); }
+    static void sigmoid(std::size_t n, const float* x, float* y) { apply<SIGMOID>(n, x, y); }
+    static void tanh(std::size_t n, const float* x, float* y) { apply<TANH>(n, x, y); }
+};
+
+#endif //JLIB_MATH_GEMM_X86
+
+
+template<typename T, isa I>
+inline
+void transcendental<T,I>::exp(std::size_t n, const T* x, T* y) {
+    for(std::size_t i = 0; i < n; i++) {
+        y[i] = std::exp(x[i]);
+    }
+}
+
+template<typename T, isa I>
+inline
+void transcendental<T,I>::sigmoid(std::size_t n, const T* x, T* y) {
+    for(std::size_t i = 0; i < n; i++) {
+        y[i] = T(1) / (T(1) + std::exp(-x[i]));
+    }
+}
+
+template<typename T, isa I>
+inline
+void transcendental<T,I>::tanh(std::size_t n, const T* x, T* y) {
+    for(std::size_t i = 0; i < n; i++) {
+        y[i] = std::tanh(x[i]);
+    }
+}
+
+// only float and double have vector kernels
+template<typename T>
+struct vectorized {
+    static const bool value = false;
+};
+
+template<>
+struct vectorized<float> {
+    static const bool value = true;
+};
+
+template<>
+struct vectorized<double> {
+    static const bool value = true;
+};
+
+#ifdef JLIB_MATH_GEMM_X86
+#define JLIB_MATH_ACTIVATION_DISPATCH(f, n, x, y)                 \
+    if(vectorized<T>::value && get_isa() == AVX512)               \
+        transcendental<T, AVX512>::f(n, x, y);                    \
+    else if(vectorized<T>::value && get_isa() == AVX2)            \
+        transcendental<T, AVX2>::f(n, x, y);                      \
+    else                                                          \
+        transcendental<T, SCALAR>::f(n, x, y);
+#else
+#define JLIB_MATH_ACTIVATION_DISPATCH(f, n, x, y)                 \
+    transcendental<T, SCALAR>::f(n, x, y);
+#endif
+
+template<typename T>
+inline
+void activations<T>::exp(std::size_t n, const T* x, T* y) {
+    JLIB_MATH_ACTIVATION_DISPATCH(exp, n, x, y)
+}
+
+template<typename T>
+inline
+void activations<T>::sigmoid(std::size_t n, const T* x, T* y) {
+    JLIB_MATH_ACTIVATION_DISPATCH(sigmoid, n, x, y)
+}
+
+template<typename T>
+inline
+void activations<T>::tanh(std::size_t n, const T* x, T* y) {
+    JLIB_MATH_ACTIVATION_DISPATCH(tanh, n, x, y)
+}
+
+#undef JLIB_MATH_ACTIVATION_DISPATCH
+
+template<typename T>
+inline
+void activations<T>::relu(std::size_t n, const T* x, T* y) {
+    for(std::size_t i = 0; i < n; i++) {
+        y[i] = std::max(x[i], T(0));
+    }
+}
+
+template<typename T>
+inline
+void activations<T>::leaky_relu(std::size_t n, T alpha, const T* x, T* y) {
+    for(std::size_t i = 0; i < n; i++) {
+        y[i] = (x[i] > T(0) ? x[i] : alpha * x[i]);
+    }
+}
+
+template<typename T>
+inline
+void activations<T>::sigmoid_backward(std::size_t n, const T* e, const T* y, T* d) {
+    for(std::size_t i = 0; i < n; i++) {
+        d[i] = e[i] * y[i] * (T(1) - y[i]);
+    }
+}
+
+template<typename T>
+inline
+void activations<T>::tanh_backward(std::size_t n, const T* e, const T* y, T* d) {
+    for(std::size_t i = 0; i < n; i++) {
+        d[i] = e[i] * (T(1) - y[i] * y[i]);
+    }
+}
+
+template<typename T>
+inline
+void activations<T>::relu_backward(std::size_t n, const T* e, const T* y, T* d) {
+    for(std::size_t i = 0; i < n; i++) {
+        d[i] = (y[i] > T(0) ? e[i] : T(0));
+    }
+}
+
+template<typename T>
+inline
+void activations<T>::leaky_relu_backward(std::size_t n, T alpha, const T* e, const T* y, T* d) {
+    for(std::size_t i = 0; i < n; i++) {
+        d[i] = (y[i] > T(0) ? e[i] : alpha * e[i]);
+    }
+}
+
+template<typename T>
+inline
+void activations<T>::softmax(std::size_t rows, std::size_t cols, const T* x, T* y) {
+    for(std::size_t j = 0; j < cols; j++) {
+        const T* xj = x + j * rows;
+        T* yj = y + j * rows;
+
+        // shifted by the largest value so nothing overflows
+        const T top = (rows ? *std::max_element(xj, xj + rows) : T(0));
+        for(std::size_t i = 0; i < rows; i++) {
+            yj[i] = xj[i] - top;
+        }
+        exp(rows, yj, yj);
+
+        T sum = T(0);
+        for(std::size_t i = 0; i < rows; i++) {
+            sum += yj[i];
+        }
+        const T scale = T(1) / sum;
+        for(std::size_t i = 0; i < rows; i++) {
+            yj[i] *= scale;
+        }
+    }
+}
+
+template<typename T>
+inline
+void activations<T>::softmax_backward(std::size_t rows, std::size_t cols, const T* e, const T* y, T* d) {
+    // the jacobian diag(y) - y y^T times e, without forming it
+    for(std::size_t j = 0; j < cols; j++) {
+        const T* ej = e + j * rows;
+        const T* yj = y + j * rows;
+        T* dj = d + j * rows;
+
+        T dot = T(0);
+        for(std::size_t i = 0; i < rows; i++) {
+            dot += ej[i] * yj[i];
+        }
+        for(std::size_t i = 0; i < rows; i++) {
+            dj[i] = yj[i] * (ej[i] - dot);
+        }
+    }
+}
+
+}
+}
+}
+
+#endif //JLIB_MATH_ACTIVATION_HH
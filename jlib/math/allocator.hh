@@ -0,0 +1,301 @@
+/* -*- mode: C++ c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2026 Joey Yandle <xoloki@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+#ifndef JLIB_MATH_ALLOCATOR_HH
+#define JLIB_MATH_ALLOCATOR_HH
+
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include <cstddef>
+#include <cstdlib>
+
+namespace jlib {
+namespace math {
+
+// size-class pool behind math::array.  blocks are 64 byte aligned and come
+// in four sizes per power of two, so rounding wastes at most a quarter.
+// each thread keeps a few freed blocks of every class to hand straight back,
+// spilling to a shared list under a lock and only then to the system.
+// blocks may be freed on a different thread than the one that got them.
+//
+// only blocks up to a megabyte are pooled, and the bigger classes keep
+// fewer of them, so what the pool holds stays bounded however large the
+// matrices a process has once had
+class allocator {
+public:
+    static const std::size_t ALIGN = 64;
+    // anything bigger goes straight to the system, and back to it
+    static const std::size_t LARGEST = std::size_t(1) << 20;
+    static const unsigned int CLASSES = 1 + (20 - 6) * 4;
+    // blocks of one class each thread holds on to, and at most how many
+    // bytes of them
+    static const unsigned int CACHED = 8;
+    static const std::size_t CACHED_BYTES = std::size_t(1) << 20;
+    // blocks of one class the shared list holds on to, and at most how
+    // many bytes of them
+    static const unsigned int SHARED = 64;
+    static const std::size_t SHARED_BYTES = std::size_t(4) << 20;
+
+    static void* allocate(std::size_t bytes);
+    static void release(void* p, std::size_t bytes);
+
+    // how many blocks have come from the system rather than the pool
+    static std::size_t system_allocations();
+
+    // with pooling off every request goes to the system and every release
+    // back to it, which is what array did before the pool
+    static void set_pooling(bool on);
+    static bool get_pooling();
+
+    // which class a request falls in, and the bytes that class holds
+    static unsigned int size_class(std::size_t bytes);
+    static std::size_t class_size(unsigned int c);
+
+    // how many blocks of class c to keep, given a count and a byte limit.
+    // always at least one
+    static unsigned int keep(unsigned int c, unsigned int count, std::size_t bytes);
+
+protected:
+    struct shared_list {
+        std::mutex lock;
+        std::vector<void*> blocks;
+    };
+
+    struct cache {
+        void* blocks[CLASSES][CACHED];
+        unsigned int count[CLASSES];
+    };
+
+    // deliberately leaked, so matrices destroyed during static teardown
+    // still have somewhere to go
+    static shared_list* shared();
+    static std::atomic<std::size_t>& misses();
+    static std::atomic<bool>& pooling();
+
+    // null once this thread's cache has been torn down
+    static cache* local();
+
+    static void* system(std::size_t bytes);
+    static void flush(cache* c);
+};
+
+// std allocator over the pool, for the shared_ptr control blocks of arrays
+template<typename T>
+struct pool_allocator {
+    typedef T value_type;
+
+    pool_allocator() {}
+    template<typename U>
+    pool_allocator(const pool_allocator<U>&) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(allocator::allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) {
+        allocator::release(p, n * sizeof(T));
+    }
+
+    template<typename U>
+    bool operator==(const pool_allocator<U>&) const { return true; }
+    template<typename U>
+    bool operator!=(const pool_allocator<U>&) const { return false; }
+};
+
+
+inline
+unsigned int allocator::size_class(std::size_t bytes) {
+    if(bytes <= 64)
+        return 0;
+
+    // 2^k < bytes <= 2^(k+1), split into quarters of 2^k
+    const unsigned int k = 63 - __builtin_clzll((unsigned long long)(bytes - 1));
+    const std::size_t step = std::size_t(1) << (k - 2);
+    const std::size_t quarter = (bytes - (std::size_t(1) << k) + step - 1) / step;
+    return 1 + (k - 6) * 4 + (quarter - 1);
+}
+
+inline
+std::size_t allocator::class_size(unsigned int c) {
+    if(c == 0)
+        return 64;
+
+    const unsigned int k = 6 + (c - 1) / 4;
+    const std::size_t quarter = 1 + (c - 1) % 4;
+    return (std::size_t(1) << k) + quarter * (std::size_t(1) << (k - 2));
+}
+
+inline
+unsigned int allocator::keep(unsigned int c, unsigned int count, std::size_t bytes) {
+    const std::size_t fit = bytes / class_size(c);
+    return (fit < 1 ? 1 : (fit < count ? fit : count));
+}
+
+inline
+allocator::shared_list* allocator::shared() {
+    static shared_list* lists = new shared_list[CLASSES];
+    return lists;
+}
+
+inline
+std::atomic<std::size_t>& allocator::misses() {
+    static std::atomic<std::size_t> count(0);
+    return count;
+}
+
+inline
+std::atomic<bool>& allocator::pooling() {
+    static std::atomic<bool> on(true);
+    return on;
+}
+
+inline
+allocator::cache* allocator::local() {
+    // the cache lives behind plain thread_local pointers so nothing reaches
+    // it after the reaper has flushed it at thread exit
+    static thread_local cache* c = nullptr;
+    static thread_local bool dead = false;
+
+    struct reaper {
+        cache*& c;
+        bool& dead;
+        reaper(cache*& c, bool& dead) : c(c), dead(dead) {}
+        ~reaper() {
+            if(c) {
+                flush(c);
+                delete c;
+            }
+            c = nullptr;
+            dead = true;
+        }
+    };
+
+    if(!c && !dead) {
+        static thread_local reaper r(c, dead);
+        c = new cache();
+    }
+    return c;
+}
+
+inline
+void* allocator::system(std::size_t bytes) {
+    misses()++;
+
+    void* p = nullptr;
+    if(posix_memalign(&p, ALIGN, bytes) != 0)
+        throw std::bad_alloc();
+    return p;
+}
+
+inline
+void allocator::flush(cache* c) {
+    for(unsigned int i = 0; i < CLASSES; i++) {
+        for(unsigned int j = 0; j < c->count[i]; j++) {
+            shared_list& s = shared()[i];
+            std::unique_lock<std::mutex> lock(s.lock);
+            if(s.blocks.size() < keep(i, SHARED, SHARED_BYTES))
+                s.blocks.push_back(c->blocks[i][j]);
+            else
+                std::free(c->blocks[i][j]);
+        }
+        c->count[i] = 0;
+    }
+}
+
+inline
+void* allocator::allocate(std::size_t bytes) {
+    if(bytes > LARGEST)
+        return system(bytes);
+
+    // always the full class size, so a block got with pooling off can still
+    // be cached if pooling is back on by the time it is released
+    const unsigned int i = size_class(bytes);
+    if(!pooling())
+        return system(class_size(i));
+
+    cache* c = local();
+    if(c && c->count[i])
+        return c->blocks[i][--c->count[i]];
+
+    {
+        shared_list& s = shared()[i];
+        std::unique_lock<std::mutex> lock(s.lock);
+        if(!s.blocks.empty()) {
+            void* p = s.blocks.back();
+            s.blocks.pop_back();
+            return p;
+        }
+    }
+
+    return system(class_size(i));
+}
+
+inline
+void allocator::release(void* p, std::size_t bytes) {
+    if(!p)
+        return;
+
+    if(bytes > LARGEST || !pooling()) {
+        std::free(p);
+        return;
+    }
+
+    const unsigned int i = size_class(bytes);
+
+    cache* c = local();
+    if(c && c->count[i] < keep(i, CACHED, CACHED_BYTES)) {
+        c->blocks[i][c->count[i]++] = p;
+        return;
+    }
+
+    shared_list& s = shared()[i];
+    std::unique_lock<std::mutex> lock(s.lock);
+    if(s.blocks.size() < keep(i, SHARED, SHARED_BYTES)) {
+        if(s.blocks.capacity() < SHARED)
+            s.blocks.reserve(SHARED);
+        s.blocks.push_back(p);
+    } else {
+        lock.unlock();
+        std::free(p);
+    }
+}
+
+inline
+std::size_t allocator::system_allocations() {
+    return misses();
+}
+
+inline
+void allocator::set_pooling(bool on) {
+    pooling() = on;
+}
+
+inline
+bool allocator::get_pooling() {
+    return pooling();
+}
+
+}
+}
+
+#endif //JLIB_MATH_ALLOCATOR_HH
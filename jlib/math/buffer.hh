@@ -23,6 +23,7 @@
 
 
 #include <jlib/sys/object.hh>
+#include <jlib/math/allocator.hh>
 
 #include <memory>
 
@@ -32,13 +33,20 @@
 namespace jlib {
 namespace math {
 
+// whether new storage starts out zeroed, or is left for a caller that is
+// about to overwrite every element anyway
+enum init { ZEROED, UNINITIALIZED };
+
 
 template<typename T>
 class array {
 public:
     typedef std::shared_ptr<array> ptr;
 
-    array(unsigned int size);
+    // storage comes from math::allocator, 64 byte aligned
+    array(unsigned int size, init i = ZEROED);
+    // storage someone else owns, such as a mapped file, kept alive by owner
+    array(T* data, unsigned int size, std::shared_ptr<void> owner);
     virtual ~array();
 
     unsigned int size() const;
@@ -54,6 +62,7 @@ private:
 
     T* mdata;
     unsigned int msize;
+    std::shared_ptr<void> mowner;
 };
 
 
@@ -61,8 +70,10 @@ template<typename T>
 class buffer {
 public:
     buffer();
-    explicit buffer(unsigned int s);
+    explicit buffer(unsigned int s, init i = ZEROED);
     buffer(buffer<T> b, unsigned int o, unsigned int s);
+    // s elements at data, which owner keeps alive
+    buffer(T* data, unsigned int s, std::shared_ptr<void> owner);
     
     unsigned int size() const;
 
@@ -86,18 +97,29 @@ private:
 
 template<typename T>
 inline
-array<T>::array(unsigned int size) 
+array<T>::array(unsigned int size, init i) 
     : mdata(0),
       msize(size)
 {
-    mdata = new T[msize];
-    std::memset(mdata, 0, size * sizeof(T));
+    mdata = static_cast<T*>(allocator::allocate(std::size_t(msize) * sizeof(T)));
+    if(i == ZEROED)
+        std::memset(mdata, 0, std::size_t(msize) * sizeof(T));
+}
+
+template<typename T>
+inline
+array<T>::array(T* data, unsigned int size, std::shared_ptr<void> owner)
+    : mdata(data),
+      msize(size),
+      mowner(owner)
+{
 }
     
 template<typename T>
 inline
 array<T>::~array() {
-    delete [] mdata;
+    if(!mowner)
+        allocator::release(mdata, std::size_t(msize) * sizeof(T));
 }
 
 template<typename T>
@@ -141,8 +163,8 @@ buffer<T>::buffer()
 
 template<typename T>
 inline
-buffer<T>::buffer(unsigned int s) 
-    : mbuf(new array<T>(s)),
+buffer<T>::buffer(unsigned int s, init i) 
+    : mbuf(std::allocate_shared<array<T> >(pool_allocator<array<T> >(), s, i)),
       moff(0),
       msize(s)
 {
@@ -152,7 +174,16 @@ template<typename T>
 inline
 buffer<T>::buffer(buffer<T> b, unsigned int o, unsigned int s)
     : mbuf(b.mbuf),
-      moff(o),
+      moff(b.moff + o),
+      msize(s)
+{
+}
+
+template<typename T>
+inline
+buffer<T>::buffer(T* data, unsigned int s, std::shared_ptr<void> owner)
+    : mbuf(std::allocate_shared<array<T> >(pool_allocator<array<T> >(), data, s, owner)),
+      moff(0),
       msize(s)
 {
 }
@@ -168,7 +199,7 @@ inline
 T buffer<T>::sum() const {
     T s = 0;
     for(unsigned int i = 0; i < size(); i++) {
-        s += *this[i];
+        s += (*this)[i];
     }
     return s;
 }
@@ -178,7 +209,7 @@ inline
 T buffer<T>::product() const {
     T p = 1;
     for(unsigned int i = 0; i < size(); i++) {
-        p *= *this[i];
+        p *= (*this)[i];
     }
     return p;
 }
@@ -188,7 +219,7 @@ template<typename T>
 inline
 void buffer<T>::resize(unsigned int s) {
     if(!mbuf || moff || size() < s) {
-        mbuf = typename array<T>::ptr(new array<T>(s));
+        mbuf = std::allocate_shared<array<T> >(pool_allocator<array<T> >(), s);
         moff = 0;
     } 
     msize = s;
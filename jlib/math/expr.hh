@@ -0,0 +1,436 @@
+/* -*- mode: C++ c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2026 Joey Yandle <xoloki@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+#ifndef JLIB_MATH_EXPR_HH
+#define JLIB_MATH_EXPR_HH
+
+#include <jlib/math/parallel.hh>
+#include <jlib/math/gemm.hh>
+
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+
+#include <cstddef>
+
+// lazy elementwise arithmetic for matrix.  a ^ b, a + 1.0 and friends build
+// a small tree of nodes instead of a matrix; nothing is computed until the
+// tree is assigned to a matrix or accumulated into one with += or -=, and
+// then the whole chain is a single pass with a single allocation.
+//
+// a product with an unevaluated side becomes a gemm_expr, which folds a
+// scalar factor into gemm's alpha and += / -= into its beta, so
+//
+//     w += rate * ((e ^ o ^ (1.0 - o)) * h.transpose());
+//
+// costs one fused loop to build the left operand and one gemm straight into w.
+// a product nested inside a larger expression is evaluated into a temporary
+// first, as are transpose() and == on a node.
+//
+// nodes share the storage of the matrices they read, the way matrix copies
+// do, so auto x = a + b stays valid; but x is computed when it is assigned,
+// from whatever a and b hold then
+
+namespace jlib {
+namespace math {
+
+template<typename T>
+class matrix;
+
+// elements per task when elementwise work is split across threads
+const std::size_t ELEMENTWISE_GRAIN = 1 << 14;
+
+// base of every node, so operators can tell nodes from other types
+template<typename T, typename E>
+class expression {
+public:
+    typedef T value_type;
+
+    const E& self() const { return static_cast<const E&>(*this); }
+
+    // evaluated first, as the node has no layout of its own to swap
+    matrix<T> transpose() const;
+};
+
+// a matrix as it appears inside an expression
+template<typename T>
+class leaf : public expression<T, leaf<T> > {
+public:
+    explicit leaf(const matrix<T>& m) : M(m.M), N(m.N), m(m), p(this->m.data()) {}
+
+    // element i of the storage, only valid when flat() agreed on the layout
+    T at(std::size_t i) const { return p[i]; }
+    T operator()(uint r, uint c) const { return m(r, c); }
+
+    bool flat(bool transposed) const { return m.is_transposed() == transposed; }
+
+    uint M;
+    uint N;
+
+protected:
+    matrix<T> m;
+    const T* p;
+};
+
+// a scalar broadcast to every element
+template<typename T>
+class constant : public expression<T, constant<T> > {
+public:
+    explicit constant(const T& x) : x(x) {}
+
+    T at(std::size_t) const { return x; }
+    T operator()(uint, uint) const { return x; }
+
+    bool flat(bool) const { return true; }
+
+protected:
+    T x;
+};
+
+struct op_add { template<typename T> static T apply(const T& x, const T& y) { return x + y; } };
+struct op_sub { template<typename T> static T apply(const T& x, const T& y) { return x - y; } };
+struct op_mul { template<typename T> static T apply(const T& x, const T& y) { return x * y; } };
+
+template<typename T, typename L, typename R, typename Op>
+class binary : public expression<T, binary<T,L,R,Op> > {
+public:
+    binary(const L& l, const R& r, uint m, uint n) : M(m), N(n), l(l), r(r) {}
+
+    T at(std::size_t i) const { return Op::apply(l.at(i), r.at(i)); }
+    T operator()(uint i, uint j) const { return Op::apply(l(i, j), r(i, j)); }
+
+    bool flat(bool transposed) const { return l.flat(transposed) && r.flat(transposed); }
+
+    uint M;
+    uint N;
+
+protected:
+    L l;
+    R r;
+};
+
+// alpha * a * b, waiting to find out whether it lands in a fresh matrix or
+// is accumulated into an existing one.  the operands are already evaluated
+template<typename T>
+class gemm_expr : public expression<T, gemm_expr<T> > {
+public:
+    gemm_expr(const matrix<T>& a, const matrix<T>& b, T alpha = T(1));
+
+    // c = alpha * a * b + beta * c.  when c shares storage with a or b,
+    // as in a += a * b, the product goes through a temporary first
+    void run(matrix<T>& c, T beta) const;
+
+    uint M;
+    uint N;
+
+    matrix<T> a;
+    matrix<T> b;
+    T alpha;
+};
+
+template<typename X>
+struct is_product : std::false_type {};
+
+template<typename T>
+struct is_product<gemm_expr<T> > : std::true_type {};
+
+// what a matrix or node turns into inside a larger expression
+template<typename X, typename = void>
+struct operand {
+    static const bool value = false;
+};
+
+template<typename T>
+struct operand<matrix<T> > {
+    static const bool value = true;
+    typedef T value_type;
+    typedef leaf<T> type;
+
+    static type wrap(const matrix<T>& m) { return type(m); }
+};
+
+template<typename E>
+struct operand<E, typename std::enable_if<std::is_base_of<expression<typename E::value_type, E>, E>::value &&
+                                          !is_product<E>::value>::type> {
+    static const bool value = true;
+    typedef typename E::value_type value_type;
+    typedef E type;
+
+    static const E& wrap(const E& e) { return e; }
+};
+
+// a product inside a larger expression is computed once, up front
+template<typename T>
+struct operand<gemm_expr<T> > {
+    static const bool value = true;
+    typedef T value_type;
+    typedef leaf<T> type;
+
+    static type wrap(const gemm_expr<T>& g) { return type(matrix<T>(g)); }
+};
+
+template<typename X>
+using value_of = typename operand<X>::value_type;
+
+template<typename L, typename R, typename Op>
+using binary_of = binary<value_of<L>, typename operand<L>::type, typename operand<R>::type, Op>;
+
+template<typename L, typename R, typename Op>
+using scalar_right = binary<value_of<L>, typename operand<L>::type, constant<value_of<L> >, Op>;
+
+template<typename L, typename R, typename Op>
+using scalar_left = binary<value_of<R>, constant<value_of<R> >, typename operand<R>::type, Op>;
+
+// both sides are operands of the same element type
+template<typename L, typename R, typename Ret>
+using if_operands = typename std::enable_if<operand<L>::value && operand<R>::value &&
+                                            std::is_same<value_of<L>, value_of<R> >::value, Ret>::type;
+
+// as above, but at least one side is a node rather than a plain matrix
+template<typename L, typename R, typename Ret>
+using if_lazy_product = typename std::enable_if<operand<L>::value && operand<R>::value &&
+                                                std::is_same<value_of<L>, value_of<R> >::value &&
+                                                !(std::is_same<L, matrix<value_of<L> > >::value &&
+                                                  std::is_same<R, matrix<value_of<R> > >::value), Ret>::type;
+
+// walk e once, storing f(ret element, e element) into every element of ret
+template<typename T, typename E, typename F>
+void evaluate(matrix<T>& ret, const expression<T,E>& e, F f);
+
+template<typename T, typename E>
+void assign(matrix<T>& ret, const expression<T,E>& e);
+
+
+template<typename L, typename R>
+inline
+if_operands<L, R, binary_of<L, R, op_mul> > operator^(const L& a, const R& b) {
+    if(a.M != b.M || a.N != b.N)
+        throw typename matrix<value_of<L> >::mismatched(a.M, a.N, b.M, b.N);
+
+    return binary_of<L, R, op_mul>(operand<L>::wrap(a), operand<R>::wrap(b), a.M, a.N);
+}
+
+template<typename L, typename R>
+inline
+if_operands<L, R, binary_of<L, R, op_add> > operator+(const L& a, const R& b) {
+    if(a.M != b.M || a.N != b.N)
+        throw typename matrix<value_of<L> >::mismatch();
+
+    return binary_of<L, R, op_add>(operand<L>::wrap(a), operand<R>::wrap(b), a.M, a.N);
+}
+
+template<typename L, typename R>
+inline
+if_operands<L, R, binary_of<L, R, op_sub> > operator-(const L& a, const R& b) {
+    if(a.M != b.M || a.N != b.N)
+        throw typename matrix<value_of<L> >::mismatch();
+
+    return binary_of<L, R, op_sub>(operand<L>::wrap(a), operand<R>::wrap(b), a.M, a.N);
+}
+
+// scalars take the element type of the matrix, so 1.0 - m works for float m too
+// a scalar times a product folds into alpha instead, below
+template<typename L>
+inline
+typename std::enable_if<!is_product<L>::value, scalar_right<L, void, op_mul> >::type
+operator*(const L& a, const value_of<L>& b) {
+    return scalar_right<L, void, op_mul>(operand<L>::wrap(a), constant<value_of<L> >(b), a.M, a.N);
+}
+
+template<typename R>
+inline
+typename std::enable_if<!is_product<R>::value, scalar_left<void, R, op_mul> >::type
+operator*(const value_of<R>& a, const R& b) {
+    return scalar_left<void, R, op_mul>(constant<value_of<R> >(a), operand<R>::wrap(b), b.M, b.N);
+}
+
+template<typename L>
+inline
+scalar_right<L, void, op_add> operator+(const L& a, const value_of<L>& b) {
+    return scalar_right<L, void, op_add>(operand<L>::wrap(a), constant<value_of<L> >(b), a.M, a.N);
+}
+
+template<typename R>
+inline
+scalar_left<void, R, op_add> operator+(const value_of<R>& a, const R& b) {
+    return scalar_left<void, R, op_add>(constant<value_of<R> >(a), operand<R>::wrap(b), b.M, b.N);
+}
+
+template<typename L>
+inline
+scalar_right<L, void, op_sub> operator-(const L& a, const value_of<L>& b) {
+    return scalar_right<L, void, op_sub>(operand<L>::wrap(a), constant<value_of<L> >(b), a.M, a.N);
+}
+
+template<typename R>
+inline
+scalar_left<void, R, op_sub> operator-(const value_of<R>& a, const R& b) {
+    return scalar_left<void, R, op_sub>(constant<value_of<R> >(a), operand<R>::wrap(b), b.M, b.N);
+}
+
+// a product of two plain matrices stays eager (see matrix.hh); once either
+// side is a node it is evaluated and the product itself is deferred
+template<typename L, typename R>
+inline
+if_lazy_product<L, R, gemm_expr<value_of<L> > > operator*(const L& a, const R& b) {
+    typedef value_of<L> T;
+    return gemm_expr<T>(matrix<T>(a), matrix<T>(b));
+}
+
+template<typename T>
+inline
+gemm_expr<T> operator*(const typename std::common_type<T>::type& s, const gemm_expr<T>& g) {
+    return gemm_expr<T>(g.a, g.b, s * g.alpha);
+}
+
+template<typename T>
+inline
+gemm_expr<T> operator*(const gemm_expr<T>& g, const typename std::common_type<T>::type& s) {
+    return gemm_expr<T>(g.a, g.b, g.alpha * s);
+}
+
+
+template<typename T>
+inline
+gemm_expr<T>::gemm_expr(const matrix<T>& a, const matrix<T>& b, T alpha)
+    : M(a.M),
+      N(b.N),
+      a(a),
+      b(b),
+      alpha(alpha)
+{
+    if(a.N != b.M)
+        throw typename matrix<T>::mismatched(a.M, a.N, b.M, b.N);
+}
+
+// whether the storage of x and y overlap, views included
+template<typename T>
+inline
+bool overlaps(const matrix<T>& x, const matrix<T>& y) {
+    const std::less<const T*> less;
+    const T* xb = x.data();
+    const T* yb = y.data();
+    return less(xb, yb + std::size_t(y.M) * y.N) && less(yb, xb + std::size_t(x.M) * x.N);
+}
+
+template<typename T>
+inline
+void gemm_expr<T>::run(matrix<T>& c, T beta) const {
+    if(overlaps(c, a) || overlaps(c, b)) {
+        const matrix<T> product(*this);
+        if(beta == T(0))
+            assign(c, leaf<T>(product));
+        else
+            evaluate(c, leaf<T>(product), [beta](T& r, const T& x) { r = beta * r + x; });
+        return;
+    }
+
+    const uint lda = a.is_transposed() ? a.N : a.M;
+    const uint ldb = b.is_transposed() ? b.N : b.M;
+
+    if(!c.is_transposed()) {
+        kernel::gemm(a.is_transposed(), b.is_transposed(), a.M, b.N, a.N,
+                     alpha, a.data(), lda, b.data(), ldb, beta, c.data(), c.M);
+    } else {
+        // c is stored as its transpose, so accumulate b^T * a^T into that
+        kernel::gemm(!b.is_transposed(), !a.is_transposed(), b.N, a.M, a.N,
+                     alpha, b.data(), ldb, a.data(), lda, beta, c.data(), c.N);
+    }
+}
+
+template<typename T, typename E, typename F>
+inline
+void evaluate(matrix<T>& ret, const expression<T,E>& expr, F f) {
+    const E& e = expr.self();
+    const std::size_t size = std::size_t(ret.M) * ret.N;
+
+    if(e.flat(ret.is_transposed())) {
+        // every operand shares ret's layout, so walk the storage directly
+        T* r = ret.data();
+        parallel_for(size, ELEMENTWISE_GRAIN, [&](std::size_t begin, std::size_t end) {
+                for(std::size_t i = begin; i < end; i++) {
+                    f(r[i], e.at(i));
+                }
+            }, size);
+    } else {
+        const std::size_t cols = std::max<std::size_t>(1, ELEMENTWISE_GRAIN / std::max(ret.M, 1u));
+        parallel_for(ret.N, cols, [&](std::size_t begin, std::size_t end) {
+                for(uint j = begin; j < end; j++) {
+                    for(uint i = 0; i < ret.M; i++) {
+                        f(ret(i, j), e(i, j));
+                    }
+                }
+            }, size);
+    }
+}
+
+template<typename T, typename E>
+inline
+void assign(matrix<T>& ret, const expression<T,E>& e) {
+    evaluate(ret, e, [](T& r, const T& x) { r = x; });
+}
+
+template<typename T, typename E>
+inline
+matrix<T> expression<T,E>::transpose() const {
+    return matrix<T>(self()).transpose();
+}
+
+// comparisons evaluate the node first, then compare as matrices
+template<typename T, typename E>
+inline
+bool operator==(const expression<T,E>& a, const matrix<T>& b) {
+    return matrix<T>(a.self()) == b;
+}
+
+template<typename T, typename E>
+inline
+bool operator==(const matrix<T>& a, const expression<T,E>& b) {
+    return a == matrix<T>(b.self());
+}
+
+template<typename T, typename E, typename F>
+inline
+bool operator==(const expression<T,E>& a, const expression<T,F>& b) {
+    return matrix<T>(a.self()) == matrix<T>(b.self());
+}
+
+template<typename T, typename E>
+inline
+bool operator!=(const expression<T,E>& a, const matrix<T>& b) {
+    return !(a == b);
+}
+
+template<typename T, typename E>
+inline
+bool operator!=(const matrix<T>& a, const expression<T,E>& b) {
+    return !(a == b);
+}
+
+template<typename T, typename E, typename F>
+inline
+bool operator!=(const expression<T,E>& a, const expression<T,F>& b) {
+    return !(a == b);
+}
+
+}
+}
+
+#endif //JLIB_MATH_EXPR_HH
@@ -0,0 +1,263 @@
+/* -*- mode: C++ c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2026 Joey Yandle <xoloki@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+#ifndef JLIB_MATH_FIXED_HH
+#define JLIB_MATH_FIXED_HH
+
+#include <jlib/math/matrix.hh>
+
+#include <algorithm>
+
+// matrices and vertices whose shape is part of the type, for the 4x4 and
+// 5x5 work of the geometry code.  storage is a plain column-major array, so
+// they live on the stack, and products are unrolled at compile time.  both
+// convert to and from their heap allocated counterparts in matrix.hh
+
+namespace jlib {
+namespace math {
+
+template<typename T, uint R, uint C>
+class fixed_matrix {
+public:
+    static_assert(R > 0 && C > 0, "fixed_matrix needs at least one row and column");
+
+    static constexpr uint M = R;
+    static constexpr uint N = C;
+
+    constexpr fixed_matrix() : rep() {}
+
+    // throws mismatched unless m is R x C
+    explicit fixed_matrix(const matrix<T>& m);
+
+    constexpr T& operator()(uint r, uint c) { return rep[c * R + r]; }
+    constexpr const T& operator()(uint r, uint c) const { return rep[c * R + r]; }
+
+    operator matrix<T>() const;
+
+    constexpr fixed_matrix<T,C,R> transpose() const;
+
+    T* data() { return rep; }
+    const T* data() const { return rep; }
+
+    static constexpr fixed_matrix<T,R,C> identity();
+
+    T rep[R * C];
+};
+
+template<typename T, uint R, uint C>
+constexpr uint fixed_matrix<T,R,C>::M;
+
+template<typename T, uint R, uint C>
+constexpr uint fixed_matrix<T,R,C>::N;
+
+template<typename T, uint R, uint K, uint C>
+constexpr fixed_matrix<T,R,C> operator*(const fixed_matrix<T,R,K>& a, const fixed_matrix<T,K,C>& b);
+
+
+// a point in N dimensions with a homogeneous coordinate, like vertex<T>
+template<typename T, uint N>
+class fixed_vertex {
+public:
+    static constexpr uint D = N;
+
+    constexpr fixed_vertex() : col() { col(N, 0) = 1; }
+
+    // the first min(N, v.D) coordinates of v, and its homogeneous
+    // coordinate when the dimensions agree
+    explicit fixed_vertex(const vertex<T>& v);
+
+    constexpr T& operator[](uint i) { return col(i, 0); }
+    constexpr const T& operator[](uint i) const { return col(i, 0); }
+
+    constexpr fixed_matrix<T,N+1,1>& operator()() { return col; }
+    constexpr const fixed_matrix<T,N+1,1>& operator()() const { return col; }
+
+    operator vertex<T>() const;
+
+    // the K entries of a column into the first K coordinates, as
+    // vertex<T>::operator=(matrix).  a column of N+1 entries sets the
+    // homogeneous coordinate too
+    template<uint K>
+    constexpr fixed_vertex<T,N>& operator=(const fixed_matrix<T,K,1>& m);
+
+    constexpr void normalize();
+
+    // the same point in K dimensions, as vertex<T>::change
+    template<uint K>
+    constexpr fixed_vertex<T,K> change() const;
+
+    T* data() { return col.data(); }
+    const T* data() const { return col.data(); }
+
+protected:
+    fixed_matrix<T,N+1,1> col;
+};
+
+template<typename T, uint N>
+constexpr uint fixed_vertex<T,N>::D;
+
+
+namespace kernel {
+
+// a(i,:) . b(:,j) over the first K terms, summed in order
+template<uint K>
+struct unrolled_dot {
+    template<typename T, uint R, uint L, uint C>
+    static constexpr T run(const fixed_matrix<T,R,L>& a, const fixed_matrix<T,L,C>& b, uint i, uint j) {
+        return unrolled_dot<K-1>::run(a, b, i, j) + a(i, K-1) * b(K-1, j);
+    }
+};
+
+template<>
+struct unrolled_dot<1> {
+    template<typename T, uint R, uint L, uint C>
+    static constexpr T run(const fixed_matrix<T,R,L>& a, const fixed_matrix<T,L,C>& b, uint i, uint j) {
+        return a(i, 0) * b(0, j);
+    }
+};
+
+// the first E elements of c = a * b, in storage order
+template<uint E>
+struct unrolled_product {
+    template<typename T, uint R, uint K, uint C>
+    static constexpr void run(const fixed_matrix<T,R,K>& a, const fixed_matrix<T,K,C>& b, fixed_matrix<T,R,C>& c) {
+        unrolled_product<E-1>::run(a, b, c);
+        c.rep[E-1] = unrolled_dot<K>::run(a, b, (E-1) % R, (E-1) / R);
+    }
+};
+
+template<>
+struct unrolled_product<0> {
+    template<typename T, uint R, uint K, uint C>
+    static constexpr void run(const fixed_matrix<T,R,K>&, const fixed_matrix<T,K,C>&, fixed_matrix<T,R,C>&) {}
+};
+
+}
+
+
+template<typename T, uint R, uint C>
+inline
+fixed_matrix<T,R,C>::fixed_matrix(const matrix<T>& m)
+    : rep()
+{
+    if(m.M != R || m.N != C)
+        throw typename matrix<T>::mismatched(m.M, m.N, R, C);
+
+    for(uint j = 0; j < C; j++) {
+        for(uint i = 0; i < R; i++) {
+            (*this)(i, j) = m(i, j);
+        }
+    }
+}
+
+template<typename T, uint R, uint C>
+inline
+fixed_matrix<T,R,C>::operator matrix<T>() const {
+    matrix<T> ret(R, C, UNINITIALIZED);
+    std::copy(rep, rep + R * C, ret.data());
+    return ret;
+}
+
+template<typename T, uint R, uint C>
+inline
+constexpr fixed_matrix<T,C,R> fixed_matrix<T,R,C>::transpose() const {
+    fixed_matrix<T,C,R> ret;
+    for(uint j = 0; j < C; j++) {
+        for(uint i = 0; i < R; i++) {
+            ret(j, i) = (*this)(i, j);
+        }
+    }
+    return ret;
+}
+
+template<typename T, uint R, uint C>
+inline
+constexpr fixed_matrix<T,R,C> fixed_matrix<T,R,C>::identity() {
+    fixed_matrix<T,R,C> ret;
+    for(uint i = 0; i < std::min(R, C); i++) {
+        ret(i, i) = 1;
+    }
+    return ret;
+}
+
+template<typename T, uint R, uint K, uint C>
+inline
+constexpr fixed_matrix<T,R,C> operator*(const fixed_matrix<T,R,K>& a, const fixed_matrix<T,K,C>& b) {
+    fixed_matrix<T,R,C> ret;
+    kernel::unrolled_product<R * C>::run(a, b, ret);
+    return ret;
+}
+
+template<typename T, uint N>
+inline
+fixed_vertex<T,N>::fixed_vertex(const vertex<T>& v)
+    : col()
+{
+    for(uint i = 0; i < std::min(N, v.D); i++) {
+        (*this)[i] = v[i];
+    }
+    (*this)[N] = (v.D == N ? v[N] : 1);
+}
+
+template<typename T, uint N>
+inline
+fixed_vertex<T,N>::operator vertex<T>() const {
+    vertex<T> ret(N);
+    for(uint i = 0; i <= N; i++) {
+        ret[i] = (*this)[i];
+    }
+    return ret;
+}
+
+template<typename T, uint N>
+template<uint K>
+inline
+constexpr fixed_vertex<T,N>& fixed_vertex<T,N>::operator=(const fixed_matrix<T,K,1>& m) {
+    static_assert(K <= N + 1, "column is longer than the vertex");
+
+    for(uint i = 0; i < K; i++) {
+        (*this)[i] = m(i, 0);
+    }
+    return *this;
+}
+
+template<typename T, uint N>
+inline
+constexpr void fixed_vertex<T,N>::normalize() {
+    for(uint i = 0; i < (N+1); i++) {
+        (*this)[i] /= (*this)[N];
+    }
+}
+
+template<typename T, uint N>
+template<uint K>
+inline
+constexpr fixed_vertex<T,K> fixed_vertex<T,N>::change() const {
+    fixed_vertex<T,K> ret;
+    for(uint i = 0; i < std::min(N, K); i++) {
+        ret[i] = (*this)[i];
+    }
+    return ret;
+}
+
+}
+}
+
+#endif //JLIB_MATH_FIXED_HH
@@ -0,0 +1,840 @@
+/* -*- mode: C++ c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2026 Joey Yandle <xoloki@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+#ifndef JLIB_MATH_GEMM_HH
+#define JLIB_MATH_GEMM_HH
+
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+#include <jlib/math/parallel.hh>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define JLIB_MATH_GEMM_X86 1
+#include <immintrin.h>
+#endif
+
+namespace jlib {
+namespace math {
+namespace kernel {
+
+// instruction sets the blocked kernel knows how to use, in increasing order
+enum isa { SCALAR, AVX2, AVX512 };
+
+isa detect();
+isa get_isa();
+void set_isa(isa i);
+const char* name(isa i);
+
+// C = alpha * op(A) * op(B) + beta * C, all column-major with leading
+// dimensions lda/ldb/ldc.  op(X) is X^T when the matching flag is set.
+// when beta is zero C is never read, so it may hold garbage
+template<typename T>
+void gemm(bool ta, bool tb, unsigned int m, unsigned int n, unsigned int k,
+          T alpha, const T* a, unsigned int lda, const T* b, unsigned int ldb,
+          T beta, T* c, unsigned int ldc);
+
+// the unpacked triple loop, used for tiny products where packing costs more than it saves
+template<typename T>
+void gemm_reference(bool ta, bool tb, unsigned int m, unsigned int n, unsigned int k,
+                    T alpha, const T* a, unsigned int lda, const T* b, unsigned int ldb,
+                    T beta, T* c, unsigned int ldc);
+
+// products with fewer multiply-adds than this skip packing entirely
+const std::size_t SMALL_GEMM = 32 * 32 * 32;
+
+// register tile and cache block sizes plus the MRxNR micro kernel for one T/isa pair.
+// a is an MR wide packed panel of A, b an NR wide packed panel of B, both kc deep
+template<typename T, isa I>
+struct micro {
+    static const unsigned int MR = 4;
+    static const unsigned int NR = 4;
+    static const unsigned int MC = 128;
+    static const unsigned int KC = 256;
+    static const unsigned int NC = 2048;
+
+    static void run(unsigned int kc, const T* a, const T* b, T* c, unsigned int ldc, T alpha, T beta);
+};
+
+#ifdef JLIB_MATH_GEMM_X86
+
+template<>
+struct micro<double, AVX2> {
+    static const unsigned int MR = 8;
+    static const unsigned int NR = 6;
+    static const unsigned int MC = 96;
+    static const unsigned int KC = 256;
+    static const unsigned int NC = 4080;
+
+    __attribute__((target("avx2,fma")))
+    static void run(unsigned int kc, const double* a, const double* b, double* c, unsigned int ldc, double alpha, double beta) {
+        __m256d acc[2][NR];
+        #pragma GCC unroll 6
+        for(unsigned int j = 0; j < NR; j++) {
+            acc[0][j] = _mm256_setzero_pd();
+            acc[1][j] = _mm256_setzero_pd();
+        }
+
+        for(unsigned int p = 0; p < kc; p++) {
+            __m256d a0 = _mm256_loadu_pd(a);
+            __m256d a1 = _mm256_loadu_pd(a + 4);
+            #pragma GCC unroll 6
+            for(unsigned int j = 0; j < NR; j++) {
+                __m256d bj = _mm256_broadcast_sd(b + j);
+                acc[0][j] = _mm256_fmadd_pd(a0, bj, acc[0][j]);
+                acc[1][j] = _mm256_fmadd_pd(a1, bj, acc[1][j]);
+            }
+            a += MR;
+            b += NR;
+        }
+
+        __m256d va = _mm256_set1_pd(alpha);
+        __m256d vb = _mm256_set1_pd(beta);
+        #pragma GCC unroll 6
+        for(unsigned int j = 0; j < NR; j++) {
+            double* cj = c + j * ldc;
+            if(beta == 0) {
+                _mm256_storeu_pd(cj, _mm256_mul_pd(va, acc[0][j]));
+                _mm256_storeu_pd(cj + 4, _mm256_mul_pd(va, acc[1][j]));
+            } else {
+                _mm256_storeu_pd(cj, _mm256_fmadd_pd(va, acc[0][j], _mm256_mul_pd(vb, _mm256_loadu_pd(cj))));
+                _mm256_storeu_pd(cj + 4, _mm256_fmadd_pd(va, acc[1][j], _mm256_mul_pd(vb, _mm256_loadu_pd(cj + 4))));
+            }
+        }
+    }
+};
+
+template<>
+struct micro<float, AVX2> {
+    static const unsigned int MR = 16;
+    static const unsigned int NR = 6;
+    static const unsigned int MC = 144;
+    static const unsigned int KC = 256;
+    static const unsigned int NC = 4080;
+
+    __attribute__((target("avx2,fma")))
+    static void run(unsigned int kc, const float* a, const float* b, float* c, unsigned int ldc, float alpha, float beta) {
+        __m256 acc[2][NR];
+        #pragma GCC unroll 6
+        for(unsigned int j = 0; j < NR; j++) {
+            acc[0][j] = _mm256_setzero_ps();
+            acc[1][j] = _mm256_setzero_ps();
+        }
+
+        for(unsigned int p = 0; p < kc; p++) {
+            __m256 a0 = _mm256_loadu_ps(a);
+            __m256 a1 = _mm256_loadu_ps(a + 8);
+            #pragma GCC unroll 6
+            for(unsigned int j = 0; j < NR; j++) {
+                __m256 bj = _mm256_broadcast_ss(b + j);
+                acc[0][j] = _mm256_fmadd_ps(a0, bj, acc[0][j]);
+                acc[1][j] = _mm256_fmadd_ps(a1, bj, acc[1][j]);
+            }
+            a += MR;
+            b += NR;
+        }
+
+        __m256 va = _mm256_set1_ps(alpha);
+        __m256 vb = _mm256_set1_ps(beta);
+        #pragma GCC unroll 6
+        for(unsigned int j = 0; j < NR; j++) {
+            float* cj = c + j * ldc;
+            if(beta == 0) {
+                _mm256_storeu_ps(cj, _mm256_mul_ps(va, acc[0][j]));
+                _mm256_storeu_ps(cj + 8, _mm256_mul_ps(va, acc[1][j]));
+            } else {
+                _mm256_storeu_ps(cj, _mm256_fmadd_ps(va, acc[0][j], _mm256_mul_ps(vb, _mm256_loadu_ps(cj))));
+                _mm256_storeu_ps(cj + 8, _mm256_fmadd_ps(va, acc[1][j], _mm256_mul_ps(vb, _mm256_loadu_ps(cj + 8))));
+            }
+        }
+    }
+};
+
+template<>
+struct micro<double, AVX512> {
+    static const unsigned int MR = 16;
+    static const unsigned int NR = 8;
+    static const unsigned int MC = 192;
+    static const unsigned int KC = 256;
+    static const unsigned int NC = 4096;
+
+    __attribute__((target("avx512f")))
+    static void run(unsigned int kc, const double* a, const double* b, double* c, unsigned int ldc, double alpha, double beta) {
+        __m512d acc[2][NR];
+        #pragma GCC unroll 8
+        for(unsigned int j = 0; j < NR; j++) {
+            acc[0][j] = _mm512_setzero_pd();
+            acc[1][j] = _mm512_setzero_pd();
+        }
+
+        for(unsigned int p = 0; p < kc; p++) {
+            __m512d a0 = _mm512_loadu_pd(a);
+            __m512d a1 = _mm512_loadu_pd(a + 8);
+            #pragma GCC unroll 8
+            for(unsigned int j = 0; j < NR; j++) {
+                __m512d bj = _mm512_set1_pd(b[j]);
+                acc[0][j] = _mm512_fmadd_pd(a0, bj, acc[0][j]);
+                acc[1][j] = _mm512_fmadd_pd(a1, bj, acc[1][j]);
+            }
+            a += MR;
+            b += NR;
+        }
+
+        __m512d va = _mm512_set1_pd(alpha);
+        __m512d vb = _mm512_set1_pd(beta);
+        #pragma GCC unroll 8
+        for(unsigned int j = 0; j < NR; j++) {
+            double* cj = c + j * ldc;
+            if(beta == 0) {
+                _mm512_storeu_pd(cj, _mm512_mul_pd(va, acc[0][j]));
+                _mm512_storeu_pd(cj + 8, _mm512_mul_pd(va, acc[1][j]));
+            } else {
+                _mm512_storeu_pd(cj, _mm512_fmadd_pd(va, acc[0][j], _mm512_mul_pd(vb, _mm512_loadu_pd(cj))));
+                _mm512_storeu_pd(cj + 8, _mm512_fmadd_pd(va, acc[1][j], _mm512_mul_pd(vb, _mm512_loadu_pd(cj + 8))));
+            }
+        }
+    }
+};
+
+template<>
+struct micro<float, AVX512> {
+    static const unsigned int MR = 32;
+    static const unsigned int NR = 8;
+    static const unsigned int MC = 256;
+    static const unsigned int KC = 256;
+    static const unsigned int NC = 4096;
+
+    __attribute__((target("avx512f")))
+    static void run(unsigned int kc, const float* a, const float* b, float* c, unsigned int ldc, float alpha, float beta) {
+        __m512 acc[2][NR];
+        #pragma GCC unroll 8
+        for(unsigned int j = 0; j < NR; j++) {
+            acc[0][j] = _mm512_setzero_ps();
+            acc[1][j] = _mm512_setzero_ps();
+        }
+
+        for(unsigned int p = 0; p < kc; p++) {
+            __m512 a0 = _mm512_loadu_ps(a);
+            __m512 a1 = _mm512_loadu_ps(a + 16);
+            #pragma GCC unroll 8
+            for(unsigned int j = 0; j < NR; j++) {
+                __m512 bj = _mm512_set1_ps(b[j]);
+                acc[0][j] = _mm512_fmadd_ps(a0, bj, acc[0][j]);
+                acc[1][j] = _mm512_fmadd_ps(a1, bj, acc[1][j]);
+            }
+            a += MR;
+            b += NR;
+        }
+
+        __m512 va = _mm512_set1_ps(alpha);
+        __m512 vb = _mm512_set1_ps(beta);
+        #pragma GCC unroll 8
+        for(unsigned int j = 0; j < NR; j++) {
+            float* cj = c + j * ldc;
+            if(beta == 0) {
+                _mm512_storeu_ps(cj, _mm512_mul_ps(va, acc[0][j]));
+                _mm512_storeu_ps(cj + 16, _mm512_mul_ps(va, acc[1][j]));
+            } else {
+                _mm512_storeu_ps(cj, _mm512_fmadd_ps(va, acc[0][j], _mm512_mul_ps(vb, _mm512_loadu_ps(cj))));
+                _mm512_storeu_ps(cj + 16, _mm512_fmadd_ps(va, acc[1][j], _mm512_mul_ps(vb, _mm512_loadu_ps(cj + 16))));
+            }
+        }
+    }
+};
+
+#endif //JLIB_MATH_GEMM_X86
+
+
+// level 1 helpers for the matrix-vector case, which packing can't help
+template<typename T, isa I>
+struct vec {
+    // y += alpha * x
+    static void axpy(unsigned int n, T alpha, const T* x, T* y);
+    static T dot(unsigned int n, const T* x, const T* y);
+};
+
+#ifdef JLIB_MATH_GEMM_X86
+
+template<>
+struct vec<double, AVX2> {
+    __attribute__((target("avx2,fma")))
+    static void axpy(unsigned int n, double alpha, const double* x, double* y) {
+        __m256d va = _mm256_set1_pd(alpha);
+        unsigned int i = 0;
+        for(; i + 8 <= n; i += 8) {
+            _mm256_storeu_pd(y + i, _mm256_fmadd_pd(va, _mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+            _mm256_storeu_pd(y + i + 4, _mm256_fmadd_pd(va, _mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4)));
+        }
+        for(; i < n; i++) {
+            y[i] += alpha * x[i];
+        }
+    }
+
+    __attribute__((target("avx2,fma")))
+    static double dot(unsigned int n, const double* x, const double* y) {
+        __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+        unsigned int i = 0;
+        for(; i + 8 <= n; i += 8) {
+            s0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), s0);
+            s1 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4), s1);
+        }
+        double lanes[4];
+        _mm256_storeu_pd(lanes, _mm256_add_pd(s0, s1));
+        double sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        for(; i < n; i++) {
+            sum += x[i] * y[i];
+        }
+        return sum;
+    }
+};
+
+template<>
+struct vec<float, AVX2> {
+    __attribute__((target("avx2,fma")))
+    static void axpy(unsigned int n, float alpha, const float* x, float* y) {
+        __m256 va = _mm256_set1_ps(alpha);
+        unsigned int i = 0;
+        for(; i + 16 <= n; i += 16) {
+            _mm256_storeu_ps(y + i, _mm256_fmadd_ps(va, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+            _mm256_storeu_ps(y + i + 8, _mm256_fmadd_ps(va, _mm256_loadu_ps(x + i + 8), _mm256_loadu_ps(y + i + 8)));
+        }
+        for(; i < n; i++) {
+            y[i] += alpha * x[i];
+        }
+    }
+
+    __attribute__((target("avx2,fma")))
+    static float dot(unsigned int n, const float* x, const float* y) {
+        __m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps();
+        unsigned int i = 0;
+        for(; i + 16 <= n; i += 16) {
+            s0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), s0);
+            s1 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i + 8), _mm256_loadu_ps(y + i + 8), s1);
+        }
+        float lanes[8];
+        _mm256_storeu_ps(lanes, _mm256_add_ps(s0, s1));
+        float sum = ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+        for(; i < n; i++) {
+            sum += x[i] * y[i];
+        }
+        return sum;
+    }
+};
+
+template<>
+struct vec<double, AVX512> {
+    __attribute__((target("avx512f")))
+    static void axpy(unsigned int n, double alpha, const double* x, double* y) {
+        __m512d va = _mm512_set1_pd(alpha);
+        unsigned int i = 0;
+        for(; i + 16 <= n; i += 16) {
+            _mm512_storeu_pd(y + i, _mm512_fmadd_pd(va, _mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i)));
+            _mm512_storeu_pd(y + i + 8, _mm512_fmadd_pd(va, _mm512_loadu_pd(x + i + 8), _mm512_loadu_pd(y + i + 8)));
+        }
+        for(; i < n; i++) {
+            y[i] += alpha * x[i];
+        }
+    }
+
+    __attribute__((target("avx512f")))
+    static double dot(unsigned int n, const double* x, const double* y) {
+        __m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+        unsigned int i = 0;
+        for(; i + 16 <= n; i += 16) {
+            s0 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i), s0);
+            s1 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i + 8), _mm512_loadu_pd(y + i + 8), s1);
+        }
+        double lanes[8];
+        _mm512_storeu_pd(lanes, _mm512_add_pd(s0, s1));
+        double sum = ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+        for(; i < n; i++) {
+            sum += x[i] * y[i];
+        }
+        return sum;
+    }
+};
+
+template<>
+struct vec<float, AVX512> {
+    __attribute__((target("avx512f")))
+    static void axpy(unsigned int n, float alpha, const float* x, float* y) {
+        __m512 va = _mm512_set1_ps(alpha);
+        unsigned int i = 0;
+        for(; i + 32 <= n; i += 32) {
+            _mm512_storeu_ps(y + i, _mm512_fmadd_ps(va, _mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i)));
+            _mm512_storeu_ps(y + i + 16, _mm512_fmadd_ps(va, _mm512_loadu_ps(x + i + 16), _mm512_loadu_ps(y + i + 16)));
+        }
+        for(; i < n; i++) {
+            y[i] += alpha * x[i];
+        }
+    }
+
+    __attribute__((target("avx512f")))
+    static float dot(unsigned int n, const float* x, const float* y) {
+        __m512 s0 = _mm512_setzero_ps(), s1 = _mm512_setzero_ps();
+        unsigned int i = 0;
+        for(; i + 32 <= n; i += 32) {
+            s0 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i), s0);
+            s1 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i + 16), _mm512_loadu_ps(y + i + 16), s1);
+        }
+        float lanes[16];
+        _mm512_storeu_ps(lanes, _mm512_add_ps(s0, s1));
+        float sum = 0;
+        for(unsigned int l = 0; l < 16; l++) {
+            sum += lanes[l];
+        }
+        for(; i < n; i++) {
+            sum += x[i] * y[i];
+        }
+        return sum;
+    }
+};
+
+#endif //JLIB_MATH_GEMM_X86
+
+// y = alpha * op(A) * x + beta * y for an m x k op(A), x and y strided by incx/incy
+template<typename T, isa I>
+void gemv(bool ta, unsigned int m, unsigned int k, T alpha, const T* a, unsigned int lda,
+          const T* x, unsigned int incx, T beta, T* y, unsigned int incy);
+
+// copy an mc x kc block of op(A) into MR row panels, zero padding the last one
+template<typename T, unsigned int MR>
+void pack_a(bool ta, unsigned int mc, unsigned int kc, const T* a, unsigned int lda, T* pa);
+
+// copy a kc x nc block of op(B) into NR column panels, zero padding the last one
+template<typename T, unsigned int NR>
+void pack_b(bool tb, unsigned int kc, unsigned int nc, const T* b, unsigned int ldb, T* pb);
+
+template<typename T, isa I>
+void blocked(bool ta, bool tb, unsigned int m, unsigned int n, unsigned int k,
+             T alpha, const T* a, unsigned int lda, const T* b, unsigned int ldb,
+             T beta, T* c, unsigned int ldc);
+
+// a single row or column of output goes through gemv, anything wider is
+// blocked.  big products are cut into panels that line up with the kernel's
+// own blocking and spread over the math thread pool, so every element is
+// computed the same way whatever the thread count
+template<typename T, isa I>
+void product(bool ta, bool tb, unsigned int m, unsigned int n, unsigned int k,
+             T alpha, const T* a, unsigned int lda, const T* b, unsigned int ldb,
+             T beta, T* c, unsigned int ldc);
+
+// picks the widest kernel the cpu (and set_isa) allows for T
+template<typename T>
+struct dispatch {
+    static void run(bool ta, bool tb, unsigned int m, unsigned int n, unsigned int k,
+                    T alpha, const T* a, unsigned int lda, const T* b, unsigned int ldb,
+                    T beta, T* c, unsigned int ldc) {
+        product<T, SCALAR>(ta, tb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+    }
+};
+
+#ifdef JLIB_MATH_GEMM_X86
+
+template<>
+struct dispatch<double> {
+    static void run(bool ta, bool tb, unsigned int m, unsigned int n, unsigned int k,
+                    double alpha, const double* a, unsigned int lda, const double* b, unsigned int ldb,
+                    double beta, double* c, unsigned int ldc) {
+        switch(get_isa()) {
+        case AVX512:
+            product<double, AVX512>(ta, tb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+            break;
+        case AVX2:
+            product<double, AVX2>(ta, tb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+            break;
+        default:
+            product<double, SCALAR>(ta, tb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+            break;
+        }
+    }
+};
+
+template<>
+struct dispatch<float> {
+    static void run(bool ta, bool tb, unsigned int m, unsigned int n, unsigned int k,
+                    float alpha, const float* a, unsigned int lda, const float* b, unsigned int ldb,
+                    float beta, float* c, unsigned int ldc) {
+        switch(get_isa()) {
+        case AVX512:
+            product<float, AVX512>(ta, tb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+            break;
+        case AVX2:
+            product<float, AVX2>(ta, tb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+            break;
+        default:
+            product<float, SCALAR>(ta, tb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+            break;
+        }
+    }
+};
+
+#endif //JLIB_MATH_GEMM_X86
+
+
+inline
+isa& current_isa() {
+    static isa current = detect();
+    return current;
+}
+
+inline
+isa detect() {
+#ifdef JLIB_MATH_GEMM_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f"))
+        return AVX512;
+    if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return AVX2;
+#endif
+    return SCALAR;
+}
+
+inline
+isa get_isa() {
+    return current_isa();
+}
+
+// asking for more than the cpu supports quietly falls back to what it does
+inline
+void set_isa(isa i) {
+    current_isa() = std::min(i, detect());
+}
+
+inline
+const char* name(isa i) {
+    switch(i) {
+    case AVX512:
+        return "avx512";
+    case AVX2:
+        return "avx2";
+    default:
+        return "scalar";
+    }
+}
+
+template<typename T, isa I>
+inline
+void micro<T,I>::run(unsigned int kc, const T* a, const T* b, T* c, unsigned int ldc, T alpha, T beta) {
+    T acc[MR * NR];
+    for(unsigned int x = 0; x < MR * NR; x++) {
+        acc[x] = T(0);
+    }
+
+    for(unsigned int p = 0; p < kc; p++) {
+        for(unsigned int j = 0; j < NR; j++) {
+            const T bj = b[j];
+            for(unsigned int i = 0; i < MR; i++) {
+                acc[j * MR + i] += a[i] * bj;
+            }
+        }
+        a += MR;
+        b += NR;
+    }
+
+    for(unsigned int j = 0; j < NR; j++) {
+        for(unsigned int i = 0; i < MR; i++) {
+            T& cij = c[j * ldc + i];
+            if(beta == T(0))
+                cij = alpha * acc[j * MR + i];
+            else
+                cij = alpha * acc[j * MR + i] + beta * cij;
+        }
+    }
+}
+
+// packing scratch is per thread so concurrent products never share it
+template<typename T>
+inline
+std::vector<T>& pack_buffer(unsigned int which) {
+    static thread_local std::vector<T> buffers[3];
+    return buffers[which];
+}
+
+template<typename T, isa I>
+inline
+void vec<T,I>::axpy(unsigned int n, T alpha, const T* x, T* y) {
+    for(unsigned int i = 0; i < n; i++) {
+        y[i] += alpha * x[i];
+    }
+}
+
+template<typename T, isa I>
+inline
+T vec<T,I>::dot(unsigned int n, const T* x, const T* y) {
+    T sum = T(0);
+    for(unsigned int i = 0; i < n; i++) {
+        sum += x[i] * y[i];
+    }
+    return sum;
+}
+
+template<typename T, isa I>
+inline
+void gemv(bool ta, unsigned int m, unsigned int k, T alpha, const T* a, unsigned int lda,
+          const T* x, unsigned int incx, T beta, T* y, unsigned int incy) {
+    std::vector<T>& scratch = pack_buffer<T>(2);
+    if(scratch.size() < std::size_t(m) + k)
+        scratch.resize(std::size_t(m) + k);
+
+    // the vector kernels want unit stride, so gather strided operands first
+    if(incx != 1) {
+        T* xs = scratch.data() + m;
+        for(unsigned int p = 0; p < k; p++) {
+            xs[p] = x[std::size_t(p) * incx];
+        }
+        x = xs;
+    }
+    T* yp = (incy == 1 ? y : scratch.data());
+
+    if(!ta) {
+        // column-major A: walk the columns and accumulate into y
+        for(unsigned int i = 0; i < m; i++) {
+            if(beta == T(0))
+                yp[i] = T(0);
+            else
+                yp[i] = beta * y[std::size_t(i) * incy];
+        }
+        for(unsigned int p = 0; p < k; p++) {
+            vec<T,I>::axpy(m, alpha * x[p], a + std::size_t(p) * lda, yp);
+        }
+    } else {
+        // rows of op(A) are contiguous columns of A, so each output is a dot product
+        for(unsigned int i = 0; i < m; i++) {
+            T sum = vec<T,I>::dot(k, a + std::size_t(i) * lda, x);
+            if(beta == T(0))
+                yp[i] = alpha * sum;
+            else
+                yp[i] = alpha * sum + beta * y[std::size_t(i) * incy];
+        }
+    }
+
+    if(yp != y) {
+        for(unsigned int i = 0; i < m; i++) {
+            y[std::size_t(i) * incy] = yp[i];
+        }
+    }
+}
+
+template<typename T, unsigned int MR>
+inline
+void pack_a(bool ta, unsigned int mc, unsigned int kc, const T* a, unsigned int lda, T* pa) {
+    for(unsigned int ir = 0; ir < mc; ir += MR) {
+        const unsigned int mr = std::min(MR, mc - ir);
+        for(unsigned int p = 0; p < kc; p++) {
+            unsigned int i = 0;
+            if(!ta) {
+                const T* ap = a + std::size_t(p) * lda + ir;
+                for(; i < mr; i++) {
+                    pa[i] = ap[i];
+                }
+            } else {
+                const T* ap = a + std::size_t(ir) * lda + p;
+                for(; i < mr; i++) {
+                    pa[i] = ap[std::size_t(i) * lda];
+                }
+            }
+            for(; i < MR; i++) {
+                pa[i] = T(0);
+            }
+            pa += MR;
+        }
+    }
+}
+
+template<typename T, unsigned int NR>
+inline
+void pack_b(bool tb, unsigned int kc, unsigned int nc, const T* b, unsigned int ldb, T* pb) {
+    for(unsigned int jr = 0; jr < nc; jr += NR) {
+        const unsigned int nr = std::min(NR, nc - jr);
+        for(unsigned int p = 0; p < kc; p++) {
+            unsigned int j = 0;
+            if(!tb) {
+                const T* bp = b + std::size_t(jr) * ldb + p;
+                for(; j < nr; j++) {
+                    pb[j] = bp[std::size_t(j) * ldb];
+                }
+            } else {
+                const T* bp = b + std::size_t(p) * ldb + jr;
+                for(; j < nr; j++) {
+                    pb[j] = bp[j];
+                }
+            }
+            for(; j < NR; j++) {
+                pb[j] = T(0);
+            }
+            pb += NR;
+        }
+    }
+}
+
+template<typename T, isa I>
+inline
+void blocked(bool ta, bool tb, unsigned int m, unsigned int n, unsigned int k,
+             T alpha, const T* a, unsigned int lda, const T* b, unsigned int ldb,
+             T beta, T* c, unsigned int ldc) {
+    typedef micro<T,I> K;
+    const unsigned int MR = K::MR, NR = K::NR, MC = K::MC, KC = K::KC, NC = K::NC;
+
+    std::vector<T>& pa = pack_buffer<T>(0);
+    std::vector<T>& pb = pack_buffer<T>(1);
+    if(pa.size() < std::size_t(MC) * KC)
+        pa.resize(std::size_t(MC) * KC);
+    if(pb.size() < std::size_t(KC) * NC)
+        pb.resize(std::size_t(KC) * NC);
+
+    T tile[K::MR * K::NR];
+
+    for(unsigned int jc = 0; jc < n; jc += NC) {
+        const unsigned int nc = std::min(NC, n - jc);
+
+        for(unsigned int pc = 0; pc < k; pc += KC) {
+            const unsigned int kc = std::min(KC, k - pc);
+            // only the first slice of k scales the existing C, later ones accumulate
+            const T bet = (pc == 0 ? beta : T(1));
+
+            const T* bblock = tb ? (b + std::size_t(pc) * ldb + jc) : (b + std::size_t(jc) * ldb + pc);
+            pack_b<T, K::NR>(tb, kc, nc, bblock, ldb, pb.data());
+
+            for(unsigned int ic = 0; ic < m; ic += MC) {
+                const unsigned int mc = std::min(MC, m - ic);
+
+                const T* ablock = ta ? (a + std::size_t(ic) * lda + pc) : (a + std::size_t(pc) * lda + ic);
+                pack_a<T, K::MR>(ta, mc, kc, ablock, lda, pa.data());
+
+                for(unsigned int jr = 0; jr < nc; jr += NR) {
+                    const unsigned int nr = std::min(NR, nc - jr);
+                    const T* bp = pb.data() + std::size_t(jr) * kc;
+
+                    for(unsigned int ir = 0; ir < mc; ir += MR) {
+                        const unsigned int mr = std::min(MR, mc - ir);
+                        const T* ap = pa.data() + std::size_t(ir) * kc;
+                        T* cp = c + std::size_t(jc + jr) * ldc + (ic + ir);
+
+                        if(mr == MR && nr == NR) {
+                            K::run(kc, ap, bp, cp, ldc, alpha, bet);
+                        } else {
+                            // ragged edge: run the full tile into scratch and copy out what fits
+                            K::run(kc, ap, bp, tile, MR, alpha, T(0));
+                            for(unsigned int j = 0; j < nr; j++) {
+                                for(unsigned int i = 0; i < mr; i++) {
+                                    T& cij = cp[std::size_t(j) * ldc + i];
+                                    if(bet == T(0))
+                                        cij = tile[j * MR + i];
+                                    else
+                                        cij = tile[j * MR + i] + bet * cij;
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+template<typename T, isa I>
+inline
+void product(bool ta, bool tb, unsigned int m, unsigned int n, unsigned int k,
+             T alpha, const T* a, unsigned int lda, const T* b, unsigned int ldb,
+             T beta, T* c, unsigned int ldc) {
+    typedef micro<T,I> K;
+    const std::size_t work = std::size_t(m) * n * k;
+    // multiples of every vector width, so lanes and tails fall in the same place
+    const unsigned int GEMV_ROWS = 512;
+
+    if(n == 1) {
+        // C = op(A) * b where b is column 0 of op(B)
+        parallel_for(m, GEMV_ROWS, [&](std::size_t i0, std::size_t i1) {
+                const T* ai = a + (ta ? i0 * lda : i0);
+                gemv<T,I>(ta, i1 - i0, k, alpha, ai, lda, b, (tb ? ldb : 1), beta, c + i0, 1);
+            }, work);
+    } else if(m == 1) {
+        // C^T = op(B)^T * a^T where a is row 0 of op(A)
+        parallel_for(n, GEMV_ROWS, [&](std::size_t j0, std::size_t j1) {
+                const T* bj = b + (tb ? j0 : j0 * ldb);
+                gemv<T,I>(!tb, j1 - j0, k, alpha, bj, ldb, a, (ta ? 1 : lda), beta, c + j0 * ldc, ldc);
+            }, work);
+    } else if(parallel(work)) {
+        // MC rows by a run of NR columns, so the register tiles inside each
+        // panel sit exactly where they would in one big call
+        const unsigned int MP = K::MC, NP = K::NR * 32;
+        const std::size_t rows = (m + MP - 1) / MP, cols = (n + NP - 1) / NP;
+
+        parallel_for(rows * cols, 1, [&](std::size_t t0, std::size_t t1) {
+                for(std::size_t t = t0; t < t1; t++) {
+                    const std::size_t i0 = (t % rows) * MP, j0 = (t / rows) * NP;
+                    const unsigned int mp = std::min<std::size_t>(MP, m - i0);
+                    const unsigned int np = std::min<std::size_t>(NP, n - j0);
+
+                    const T* ai = a + (ta ? i0 * lda : i0);
+                    const T* bj = b + (tb ? j0 : j0 * ldb);
+                    blocked<T,I>(ta, tb, mp, np, k, alpha, ai, lda, bj, ldb, beta, c + j0 * ldc + i0, ldc);
+                }
+            }, work);
+    } else {
+        blocked<T,I>(ta, tb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+    }
+}
+
+template<typename T>
+inline
+void gemm_reference(bool ta, bool tb, unsigned int m, unsigned int n, unsigned int k,
+                    T alpha, const T* a, unsigned int lda, const T* b, unsigned int ldb,
+                    T beta, T* c, unsigned int ldc) {
+    for(unsigned int j = 0; j < n; j++) {
+        for(unsigned int i = 0; i < m; i++) {
+            T sum = T(0);
+            for(unsigned int p = 0; p < k; p++) {
+                const T aip = ta ? a[std::size_t(i) * lda + p] : a[std::size_t(p) * lda + i];
+                const T bpj = tb ? b[std::size_t(p) * ldb + j] : b[std::size_t(j) * ldb + p];
+                sum += aip * bpj;
+            }
+
+            T& cij = c[std::size_t(j) * ldc + i];
+            if(beta == T(0))
+                cij = alpha * sum;
+            else
+                cij = alpha * sum + beta * cij;
+        }
+    }
+}
+
+template<typename T>
+inline
+void gemm(bool ta, bool tb, unsigned int m, unsigned int n, unsigned int k,
+          T alpha, const T* a, unsigned int lda, const T* b, unsigned int ldb,
+          T beta, T* c, unsigned int ldc) {
+    if(!m || !n)
+        return;
+
+    if(!k || std::size_t(m) * n * k <= SMALL_GEMM) {
+        gemm_reference(ta, tb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+    } else {
+        dispatch<T>::run(ta, tb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+    }
+}
+
+}
+}
+}
+
+#endif //JLIB_MATH_GEMM_HH
@@ -0,0 +1,359 @@
+/* -*- mode: C++ c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2026 Joey Yandle <xoloki@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+#ifndef JLIB_MATH_INT8_HH
+#define JLIB_MATH_INT8_HH
+
+#include <jlib/math/gemm.hh>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// integer products for quantized inference.  weights are signed 8 bit,
+// activations unsigned 8 bit, so that a zero point of 128 lets them carry
+// a sign, and the sums are 32 bit and never saturate
+namespace jlib {
+namespace math {
+namespace kernel {
+
+// k is padded to a multiple of this, with zero weights past the end
+const unsigned int INT8_PAD = 64;
+
+// c[j*ldc + i] = sum over p < k of a[i*lda + p] * b[j*ldb + p]: a is m rows
+// of weights, b is n columns of activations, both with their k values
+// contiguous.  k must be a multiple of INT8_PAD
+template<isa I>
+struct int8 {
+    static void dot(unsigned int m, unsigned int n, unsigned int k,
+                    const int8_t* a, unsigned int lda, const uint8_t* b, unsigned int ldb,
+                    int32_t* c, unsigned int ldc);
+};
+
+// the activations of one sample: q = x / scale + 128, rounded to nearest,
+// where scale is the largest |x| over 127, or 1 if x is all zeros.  returns
+// the scale
+template<typename T, isa I>
+struct quantize {
+    static T run(std::size_t n, const T* x, uint8_t* q);
+};
+
+// whether the cpu has the avx512 8 bit dot product instructions
+bool vnni();
+
+// the widest of the above the cpu and get_isa() allow.  avx512 without
+// vnni uses the avx2 kernel
+void int8_dot(unsigned int m, unsigned int n, unsigned int k,
+              const int8_t* a, unsigned int lda, const uint8_t* b, unsigned int ldb,
+              int32_t* c, unsigned int ldc);
+
+template<typename T>
+T int8_quantize(std::size_t n, const T* x, uint8_t* q);
+
+
+template<isa I>
+inline
+void int8<I>::dot(unsigned int m, unsigned int n, unsigned int k,
+                  const int8_t* a, unsigned int lda, const uint8_t* b, unsigned int ldb,
+                  int32_t* c, unsigned int ldc) {
+    for(unsigned int j = 0; j < n; j++) {
+        for(unsigned int i = 0; i < m; i++) {
+            int32_t sum = 0;
+            for(unsigned int p = 0; p < k; p++) {
+                sum += int32_t(a[i * lda + p]) * int32_t(b[j * ldb + p]);
+            }
+            c[j * ldc + i] = sum;
+        }
+    }
+}
+
+template<typename T, isa I>
+inline
+T quantize<T,I>::run(std::size_t n, const T* x, uint8_t* q) {
+    T top = T(0);
+    for(std::size_t i = 0; i < n; i++) {
+        top = std::max(top, T(std::fabs(x[i])));
+    }
+    const T scale = (top > T(0) ? top / T(127) : T(1));
+
+    // x / scale is within [-127, 127], so adding 128.5 and truncating rounds
+    // it to the nearest and moves it to the zero point at once
+    const T inverse = T(1) / scale;
+    for(std::size_t i = 0; i < n; i++) {
+        q[i] = uint8_t(int32_t(x[i] * inverse + T(128.5)));
+    }
+    return scale;
+}
+
+#ifdef JLIB_MATH_GEMM_X86
+
+// m x n in blocks of R x C, then R x 1 and 1 x 1 at the edges
+template<typename K, unsigned int R, unsigned int C>
+inline
+void tile(unsigned int m, unsigned int n, unsigned int k,
+          const int8_t* a, unsigned int lda, const uint8_t* b, unsigned int ldb,
+          int32_t* c, unsigned int ldc) {
+    unsigned int j = 0;
+    for(; j + C <= n; j += C) {
+        unsigned int i = 0;
+        for(; i + R <= m; i += R)
+            K::template block<R, C>(k, a + std::size_t(i) * lda, lda, b + std::size_t(j) * ldb, ldb, c + std::size_t(j) * ldc + i, ldc);
+        for(; i < m; i++)
+            K::template block<1, C>(k, a + std::size_t(i) * lda, lda, b + std::size_t(j) * ldb, ldb, c + std::size_t(j) * ldc + i, ldc);
+    }
+    for(; j < n; j++) {
+        unsigned int i = 0;
+        for(; i + R <= m; i += R)
+            K::template block<R, 1>(k, a + std::size_t(i) * lda, lda, b + std::size_t(j) * ldb, ldb, c + std::size_t(j) * ldc + i, ldc);
+        for(; i < m; i++)
+            K::template block<1, 1>(k, a + std::size_t(i) * lda, lda, b + std::size_t(j) * ldb, ldb, c + std::size_t(j) * ldc + i, ldc);
+    }
+}
+
+// unsigned times signed fits in 16 bits, and madd sums pairs of those into
+// 32, so widening first keeps every product exact; maddubs would saturate.
+// blocks of R rows by C columns share each load
+template<>
+struct int8<AVX2> {
+    __attribute__((target("avx2,fma")))
+    static inline int32_t sum(__m256i v) {
+        __m128i s = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+        s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4e));
+        s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xb1));
+        return _mm_cvtsi128_si32(s);
+    }
+
+    template<unsigned int R, unsigned int C>
+    __attribute__((target("avx2,fma")))
+    static inline void block(unsigned int k, const int8_t* a, unsigned int lda, const uint8_t* b, unsigned int ldb,
+                             int32_t* c, unsigned int ldc) {
+        __m256i acc[R][C];
+        #pragma GCC unroll 4
+        for(unsigned int i = 0; i < R; i++)
+            #pragma GCC unroll 4
+            for(unsigned int j = 0; j < C; j++)
+                acc[i][j] = _mm256_setzero_si256();
+
+        for(unsigned int p = 0; p < k; p += 16) {
+            __m256i x[C];
+            #pragma GCC unroll 4
+            for(unsigned int j = 0; j < C; j++)
+                x[j] = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + j * ldb + p)));
+            #pragma GCC unroll 4
+            for(unsigned int i = 0; i < R; i++) {
+                const __m256i w = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i * lda + p)));
+                #pragma GCC unroll 4
+                for(unsigned int j = 0; j < C; j++)
+                    acc[i][j] = _mm256_add_epi32(acc[i][j], _mm256_madd_epi16(w, x[j]));
+            }
+        }
+
+        #pragma GCC unroll 4
+        for(unsigned int j = 0; j < C; j++)
+            #pragma GCC unroll 4
+            for(unsigned int i = 0; i < R; i++)
+                c[j * ldc + i] = sum(acc[i][j]);
+    }
+
+    __attribute__((target("avx2,fma")))
+    static void dot(unsigned int m, unsigned int n, unsigned int k,
+                    const int8_t* a, unsigned int lda, const uint8_t* b, unsigned int ldb,
+                    int32_t* c, unsigned int ldc) {
+        tile<int8<AVX2>, 4, 2>(m, n, k, a, lda, b, ldb, c, ldc);
+    }
+};
+
+// vpdpbusd multiplies unsigned by signed bytes and adds each group of four
+// straight into 32 bits
+template<>
+struct int8<AVX512> {
+    // the sum of the 16 lanes.  _mm512_reduce_add_epi32 and the 512 to 256
+    // casts extract into undefined registers, which gcc 12 flags as used
+    // uninitialized at -O2; the zero masked extracts start from zero
+    __attribute__((target("avx512f,avx512bw,avx512vnni")))
+    static inline int32_t sum(__m512i v) {
+        const __m256i h = _mm256_add_epi32(_mm512_maskz_extracti64x4_epi64(0xf, v, 0),
+                                           _mm512_maskz_extracti64x4_epi64(0xf, v, 1));
+        __m128i q = _mm_add_epi32(_mm256_castsi256_si128(h), _mm256_extracti128_si256(h, 1));
+        q = _mm_add_epi32(q, _mm_shuffle_epi32(q, 0x4e));
+        q = _mm_add_epi32(q, _mm_shuffle_epi32(q, 0xb1));
+        return _mm_cvtsi128_si32(q);
+    }
+
+    template<unsigned int R, unsigned int C>
+    __attribute__((target("avx512f,avx512bw,avx512vnni")))
+    static inline void block(unsigned int k, const int8_t* a, unsigned int lda, const uint8_t* b, unsigned int ldb,
+                             int32_t* c, unsigned int ldc) {
+        __m512i acc[R][C];
+        #pragma GCC unroll 4
+        for(unsigned int i = 0; i < R; i++)
+            #pragma GCC unroll 4
+            for(unsigned int j = 0; j < C; j++)
+                acc[i][j] = _mm512_setzero_si512();
+
+        for(unsigned int p = 0; p < k; p += 64) {
+            __m512i x[C];
+            #pragma GCC unroll 4
+            for(unsigned int j = 0; j < C; j++)
+                x[j] = _mm512_loadu_si512(b + j * ldb + p);
+            #pragma GCC unroll 4
+            for(unsigned int i = 0; i < R; i++) {
+                const __m512i w = _mm512_loadu_si512(a + i * lda + p);
+                #pragma GCC unroll 4
+                for(unsigned int j = 0; j < C; j++)
+                    acc[i][j] = _mm512_dpbusd_epi32(acc[i][j], x[j], w);
+            }
+        }
+
+        #pragma GCC unroll 4
+        for(unsigned int j = 0; j < C; j++)
+            #pragma GCC unroll 4
+            for(unsigned int i = 0; i < R; i++)
+                c[j * ldc + i] = sum(acc[i][j]);
+    }
+
+    __attribute__((target("avx512f,avx512bw,avx512vnni")))
+    static void dot(unsigned int m, unsigned int n, unsigned int k,
+                    const int8_t* a, unsigned int lda, const uint8_t* b, unsigned int ldb,
+                    int32_t* c, unsigned int ldc) {
+        tile<int8<AVX512>, 4, 4>(m, n, k, a, lda, b, ldb, c, ldc);
+    }
+};
+
+template<>
+struct quantize<double, AVX2> {
+    __attribute__((target("avx2,fma")))
+    static double run(std::size_t n, const double* x, uint8_t* q) {
+        const __m256d sign = _mm256_set1_pd(-0.0);
+        __m256d top0 = _mm256_setzero_pd(), top1 = top0, top2 = top0, top3 = top0;
+        std::size_t i = 0;
+        for(; i + 16 <= n; i += 16) {
+            top0 = _mm256_max_pd(top0, _mm256_andnot_pd(sign, _mm256_loadu_pd(x + i)));
+            top1 = _mm256_max_pd(top1, _mm256_andnot_pd(sign, _mm256_loadu_pd(x + i + 4)));
+            top2 = _mm256_max_pd(top2, _mm256_andnot_pd(sign, _mm256_loadu_pd(x + i + 8)));
+            top3 = _mm256_max_pd(top3, _mm256_andnot_pd(sign, _mm256_loadu_pd(x + i + 12)));
+        }
+        double lanes[4];
+        _mm256_storeu_pd(lanes, _mm256_max_pd(_mm256_max_pd(top0, top1), _mm256_max_pd(top2, top3)));
+        double top = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+        for(std::size_t j = i; j < n; j++) {
+            top = std::max(top, std::fabs(x[j]));
+        }
+
+        const double scale = (top > 0 ? top / 127 : 1);
+        const __m256d inverse = _mm256_set1_pd(1 / scale);
+        const __m256d half = _mm256_set1_pd(128.5);
+        for(i = 0; i + 16 <= n; i += 16) {
+            const __m128i a = _mm256_cvttpd_epi32(_mm256_fmadd_pd(_mm256_loadu_pd(x + i), inverse, half));
+            const __m128i b = _mm256_cvttpd_epi32(_mm256_fmadd_pd(_mm256_loadu_pd(x + i + 4), inverse, half));
+            const __m128i c = _mm256_cvttpd_epi32(_mm256_fmadd_pd(_mm256_loadu_pd(x + i + 8), inverse, half));
+            const __m128i d = _mm256_cvttpd_epi32(_mm256_fmadd_pd(_mm256_loadu_pd(x + i + 12), inverse, half));
+            const __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(q + i), bytes);
+        }
+        for(; i < n; i++) {
+            q[i] = uint8_t(int32_t(x[i] * (1 / scale) + 128.5));
+        }
+        return scale;
+    }
+};
+
+template<>
+struct quantize<float, AVX2> {
+    __attribute__((target("avx2,fma")))
+    static float run(std::size_t n, const float* x, uint8_t* q) {
+        const __m256 sign = _mm256_set1_ps(-0.0f);
+        __m256 top0 = _mm256_setzero_ps(), top1 = top0;
+        std::size_t i = 0;
+        for(; i + 16 <= n; i += 16) {
+            top0 = _mm256_max_ps(top0, _mm256_andnot_ps(sign, _mm256_loadu_ps(x + i)));
+            top1 = _mm256_max_ps(top1, _mm256_andnot_ps(sign, _mm256_loadu_ps(x + i + 8)));
+        }
+        float lanes[8];
+        _mm256_storeu_ps(lanes, _mm256_max_ps(top0, top1));
+        float top = *std::max_element(lanes, lanes + 8);
+        for(std::size_t j = i; j < n; j++) {
+            top = std::max(top, std::fabs(x[j]));
+        }
+
+        const float scale = (top > 0 ? top / 127 : 1);
+        const __m256 inverse = _mm256_set1_ps(1 / scale);
+        const __m256 half = _mm256_set1_ps(128.5f);
+        for(i = 0; i + 16 <= n; i += 16) {
+            const __m256i a = _mm256_cvttps_epi32(_mm256_fmadd_ps(_mm256_loadu_ps(x + i), inverse, half));
+            const __m256i b = _mm256_cvttps_epi32(_mm256_fmadd_ps(_mm256_loadu_ps(x + i + 8), inverse, half));
+            const __m128i lo = _mm_packs_epi32(_mm256_castsi256_si128(a), _mm256_extracti128_si256(a, 1));
+            const __m128i hi = _mm_packs_epi32(_mm256_castsi256_si128(b), _mm256_extracti128_si256(b, 1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(q + i), _mm_packus_epi16(lo, hi));
+        }
+        for(; i < n; i++) {
+            q[i] = uint8_t(int32_t(x[i] * (1 / scale) + 128.5f));
+        }
+        return scale;
+    }
+};
+
+#endif //JLIB_MATH_GEMM_X86
+
+inline
+bool vnni() {
+#ifdef JLIB_MATH_GEMM_X86
+    __builtin_cpu_init();
+    static const bool has = __builtin_cpu_supports("avx512vnni") && __builtin_cpu_supports("avx512bw");
+    return has;
+#else
+    return false;
+#endif
+}
+
+inline
+void int8_dot(unsigned int m, unsigned int n, unsigned int k,
+              const int8_t* a, unsigned int lda, const uint8_t* b, unsigned int ldb,
+              int32_t* c, unsigned int ldc) {
+#ifdef JLIB_MATH_GEMM_X86
+    const isa i = get_isa();
+    if(i == AVX512 && vnni())
+        int8<AVX512>::dot(m, n, k, a, lda, b, ldb, c, ldc);
+    else if(i >= AVX2)
+        int8<AVX2>::dot(m, n, k, a, lda, b, ldb, c, ldc);
+    else
+        int8<SCALAR>::dot(m, n, k, a, lda, b, ldb, c, ldc);
+#else
+    int8<SCALAR>::dot(m, n, k, a, lda, b, ldb, c, ldc);
+#endif
+}
+
+
+template<typename T>
+inline
+T int8_quantize(std::size_t n, const T* x, uint8_t* q) {
+#ifdef JLIB_MATH_GEMM_X86
+    if(get_isa() >= AVX2)
+        return quantize<T, AVX2>::run(n, x, q);
+#endif
+    return quantize<T, SCALAR>::run(n, x, q);
+}
+
+}
+}
+}
+
+#endif //JLIB_MATH_INT8_HH
@@ -22,6 +22,10 @@
 #define JLIB_MATH_MATRIX_HH
 
 #include <jlib/math/buffer.hh>
+#include <jlib/math/gemm.hh>
+#include <jlib/math/parallel.hh>
+#include <jlib/math/strassen.hh>
+#include <jlib/math/expr.hh>
 
 #include <iostream>
 #include <iomanip>
@@ -70,8 +74,18 @@ public:
 	}
     };
 
-    matrix(uint rows, uint cols);
+    template<typename U>
+    friend matrix<U> operator*(const matrix<U>& a, const matrix<U>& b);
+
+    matrix(uint rows, uint cols, init i = ZEROED);
     matrix(uint rows, uint cols, const matrix<T>& m, uint roff, uint coff);
+    // a column-major view of existing storage, which is shared rather than copied
+    matrix(uint rows, uint cols, const buffer<T>& storage);
+
+    // evaluate a lazy expression (see expr.hh) into a fresh matrix
+    template<typename E>
+    matrix(const expression<T,E>& e);
+    matrix(const gemm_expr<T>& g);
 
     T& operator()(uint r, uint c);
     const T& operator()(uint r, uint c) const;
@@ -79,14 +93,29 @@ public:
     matrix<T>& operator*=(const matrix<T>& m);
     matrix<T>& operator+=(const matrix<T>& m);
     matrix<T>& operator-=(const matrix<T>& m);
+
+    // accumulate in place, a product straight through gemm's beta
+    template<typename E>
+    matrix<T>& operator+=(const expression<T,E>& e);
+    template<typename E>
+    matrix<T>& operator-=(const expression<T,E>& e);
+    matrix<T>& operator+=(const gemm_expr<T>& g);
+    matrix<T>& operator-=(const gemm_expr<T>& g);
     
     operator buffer<T>();
     operator const buffer<T>() const;
 
     matrix<T> transpose() const;
 
-    void foreach(std::function<void (T&)> handler);
-    void foreach_index(std::function<void (uint r, uint c, T&)> handler);
+    // handlers run in row order on the calling thread unless PARALLEL is
+    // passed, in which case they may run concurrently and in any order
+    void foreach(std::function<void (T&)> handler, policy p = SEQUENTIAL);
+    void foreach_index(std::function<void (uint r, uint c, T&)> handler, policy p = SEQUENTIAL);
+
+    // raw storage: column-major M x N, or row-major if is_transposed()
+    T* data() { return rep.data(); }
+    const T* data() const { return rep.data(); }
+    bool is_transposed() const { return transposed; }
     
     //matrix<T> row(uint i) const;
     //matrix<T> col(uint i) const;
@@ -125,35 +154,41 @@ protected:
 template<typename T>    
 matrix<T> operator*(const matrix<T>& a, const matrix<T>& b);
 
-template<typename T>    
-matrix<T> operator^(const matrix<T>& a, const matrix<T>& b);
+// the elementwise and scalar operators (^, +, -, scalar *) live in expr.hh
+// and evaluate lazily
 
+// same result as a * b up to rounding, with fewer multiplies once every
+// dimension is past kernel::get_strassen_cutoff()
 template<typename T>    
 matrix<T> strassen(const matrix<T>& a, const matrix<T>& b);
 
-template<typename T>    
-matrix<T> operator*(const matrix<T>& a, const T& b);
-
-template<typename T>    
-matrix<T> operator*(const T& b, const matrix<T>& a);
-
-template<typename T>    
-matrix<T> operator+(const matrix<T>& a, const T& b);
+// in-place forms, BLAS style.  these write into storage the caller already
+// owns and never reallocate it, so a loop built from them allocates nothing
+// once its matrices exist.  they throw mismatched if the shapes disagree.
+// the output must not share storage with an input unless noted
+enum trans { NOTRANS, TRANS };
 
-template<typename T>    
-matrix<T> operator+(const T& b, const matrix<T>& a);
+// c = alpha * op(a) * op(b) + beta * c
+template<typename T>
+void gemm(T alpha, const matrix<T>& a, trans opa, const matrix<T>& b, trans opb, T beta, matrix<T>& c);
 
-template<typename T>    
-matrix<T> operator-(const matrix<T>& a, const T& b);
+// checks the shapes of the gemm above and calls f with the arguments of a
+// column-major BLAS gemm over the storage as it lies, (ta, tb, m, n, k,
+// alpha, a, lda, b, ldb, beta, c, ldc), so every gemm lays out the same way
+template<typename T, typename F>
+void gemm_layout(T alpha, const matrix<T>& a, trans opa, const matrix<T>& b, trans opb, T beta, matrix<T>& c, F f);
 
-template<typename T>    
-matrix<T> operator-(const T& b, const matrix<T>& a);
+// y += alpha * x
+template<typename T>
+void axpy(T alpha, const matrix<T>& x, matrix<T>& y);
 
-template<typename T>    
-matrix<T> operator+(const matrix<T>& a, const matrix<T>& b);
+// c = a ^ b; c may be a or b
+template<typename T>
+void hadamard_into(const matrix<T>& a, const matrix<T>& b, matrix<T>& c);
 
-template<typename T>    
-matrix<T> operator-(const matrix<T>& a, const matrix<T>& b);
+// x *= alpha
+template<typename T>
+void scale_inplace(matrix<T>& x, T alpha);
 
 template<typename T>    
 bool operator==(const matrix<T>& a, const matrix<T>& b);
@@ -264,35 +299,14 @@ matrix<T> operator*(const matrix<T>& a, const matrix<T>& b) {
     if(a.N != b.M)
         throw typename matrix<T>::mismatched(a.M, a.N, b.M, b.N);
     
-    matrix<T> ret(a.M, b.N);
-    
-    for(uint j = 0; j < b.N; j++) {
-        for(uint i = 0; i < a.M; i++) {
-            //ret(i,j) = matrix<T>::dot(a.row(i), col);
-            T sum = 0;
-            for(uint k = 0; k < a.N; k++) {
-                sum += a(i,k) * b(k,j); 
-            }
-            ret(i,j) = sum;
-        }
-    }
+    matrix<T> ret(a.M, b.N, UNINITIALIZED);
 
-    return ret;
-}
-
-template<typename T>    
-inline
-matrix<T> operator^(const matrix<T>& a, const matrix<T>& b) {
-    if(a.M != b.M || a.N != b.N)
-        throw typename matrix<T>::mismatched(a.M, a.N, b.M, b.N);
-    
-    matrix<T> ret(a.M, b.N);
-    
-    for(uint j = 0; j < b.N; j++) {
-        for(uint i = 0; i < a.M; i++) {
-            ret(i,j) = a(i, j) * b(i, j);
-        }
-    }
+    // a transposed matrix shares its rep in row-major order, which is just
+    // the column-major layout of the original, so hand the flag to the kernel
+    kernel::gemm(a.transposed, b.transposed, a.M, b.N, a.N,
+                 T(1), a.rep.data(), (a.transposed ? a.N : a.M),
+                 b.rep.data(), (b.transposed ? b.N : b.M),
+                 T(0), ret.rep.data(), ret.M);
 
     return ret;
 }
@@ -300,119 +314,78 @@ matrix<T> operator^(const matrix<T>& a, const matrix<T>& b) {
 template<typename T>    
 inline
 matrix<T> strassen(const matrix<T>& a, const matrix<T>& b) {
-    
-}
+    if(a.N != b.M)
+        throw typename matrix<T>::mismatched(a.M, a.N, b.M, b.N);
 
+    matrix<T> ret(a.M, b.N, UNINITIALIZED);
+    if(!a.M || !b.N)
+        return ret;
 
-template<typename T>    
-inline
-matrix<T> operator*(const matrix<T>& a, const T& b) {
-    matrix<T> ret(a.M, a.N);
-    for(uint i = 0; i < a.M; i++) {
-        for(uint j = 0; j < a.N; j++) {
-            ret(i,j) = a(i, j) * b;
-        }
-    }
+    kernel::strassen(a.is_transposed(), b.is_transposed(), a.M, b.N, a.N,
+                     a.data(), (a.is_transposed() ? a.N : a.M),
+                     b.data(), (b.is_transposed() ? b.N : b.M),
+                     ret.data(), ret.M);
     return ret;
 }
 
-template<typename T>    
+template<typename T, typename F>
 inline
-matrix<T> operator*(const T& b, const matrix<T>& a) {
-    matrix<T> ret(a.M, a.N);
-    for(uint i = 0; i < a.M; i++) {
-        for(uint j = 0; j < a.N; j++) {
-            ret(i,j) = a(i, j) * b;
-        }
-    }
-    return ret;
-}
+void gemm_layout(T alpha, const matrix<T>& a, trans opa, const matrix<T>& b, trans opb, T beta, matrix<T>& c, F f) {
+    // a transpose requested here cancels one already on the matrix
+    const bool ta = a.is_transposed() != (opa == TRANS);
+    const bool tb = b.is_transposed() != (opb == TRANS);
+    const uint m = (opa == TRANS ? a.N : a.M), k = (opa == TRANS ? a.M : a.N);
+    const uint kb = (opb == TRANS ? b.N : b.M), n = (opb == TRANS ? b.M : b.N);
 
+    if(k != kb)
+        throw typename matrix<T>::mismatched(m, k, kb, n);
+    if(c.M != m || c.N != n)
+        throw typename matrix<T>::mismatched(c.M, c.N, m, n);
 
-template<typename T>    
-inline
-matrix<T> operator+(const matrix<T>& a, const T& b) {
-    matrix<T> ret(a.M, a.N);
-    for(uint i = 0; i < a.M; i++) {
-        for(uint j = 0; j < a.N; j++) {
-            ret(i,j) = a(i, j) + b;
-        }
-    }
-    return ret;
-}
+    const uint lda = a.is_transposed() ? a.N : a.M;
+    const uint ldb = b.is_transposed() ? b.N : b.M;
 
-template<typename T>    
-inline
-matrix<T> operator+(const T& b, const matrix<T>& a) {
-    matrix<T> ret(a.M, a.N);
-    for(uint i = 0; i < a.M; i++) {
-        for(uint j = 0; j < a.N; j++) {
-            ret(i,j) = a(i, j) + b;
-        }
+    if(!c.is_transposed()) {
+        f(ta, tb, m, n, k, alpha, a.data(), lda, b.data(), ldb, beta, c.data(), c.M);
+    } else {
+        // c is stored as its transpose, so compute op(b)^T * op(a)^T into that
+        f(!tb, !ta, n, m, k, alpha, b.data(), ldb, a.data(), lda, beta, c.data(), c.N);
     }
-    return ret;
 }
 
-
-template<typename T>    
+template<typename T>
 inline
-matrix<T> operator-(const matrix<T>& a, const T& b) {
-    matrix<T> ret(a.M, a.N);
-    for(uint i = 0; i < a.M; i++) {
-        for(uint j = 0; j < a.N; j++) {
-            ret(i,j) = a(i, j) - b;
-        }
-    }
-    return ret;
+void gemm(T alpha, const matrix<T>& a, trans opa, const matrix<T>& b, trans opb, T beta, matrix<T>& c) {
+    gemm_layout(alpha, a, opa, b, opb, beta, c, kernel::gemm<T>);
 }
 
-template<typename T>    
+template<typename T>
 inline
-matrix<T> operator-(const T& b, const matrix<T>& a) {
-    matrix<T> ret(a.M, a.N);
-    for(uint i = 0; i < a.M; i++) {
-        for(uint j = 0; j < a.N; j++) {
-            ret(i,j) = b - a(i, j);
-        }
-    }
-    return ret;
-}
+void axpy(T alpha, const matrix<T>& x, matrix<T>& y) {
+    if(x.M != y.M || x.N != y.N)
+        throw typename matrix<T>::mismatched(x.M, x.N, y.M, y.N);
 
+    evaluate(y, leaf<T>(x), [alpha](T& r, const T& v) { r += alpha * v; });
+}
 
-template<typename T>    
+template<typename T>
 inline
-matrix<T> operator+(const matrix<T>& a, const matrix<T>& b) {
+void hadamard_into(const matrix<T>& a, const matrix<T>& b, matrix<T>& c) {
     if(a.M != b.M || a.N != b.N)
-        throw matrix<T>::mismatch();
+        throw typename matrix<T>::mismatched(a.M, a.N, b.M, b.N);
+    if(c.M != a.M || c.N != a.N)
+        throw typename matrix<T>::mismatched(c.M, c.N, a.M, a.N);
 
-    matrix<T> ret(a.M, a.N);
-    for(uint i = 0; i < a.M; i++) {
-        for(uint j = 0; j < a.N; j++) {
-            ret(i,j) = a(i, j) + b(i, j);
-        }
-    }
-    return ret;    
+    assign(c, leaf<T>(a) ^ leaf<T>(b));
 }
 
-
-template<typename T>    
+template<typename T>
 inline
-matrix<T> operator-(const matrix<T>& a, const matrix<T>& b) {
-    if(a.M != b.M || a.N != b.N)
-        throw typename matrix<T>::mismatch();
-
-    matrix<T> ret = a;
-    for(uint i = 0; i < a.M; i++) {
-        for(uint j = 0; j < a.N; j++) {
-	    ret(i,j) = a(i, j) - b(i, j);
-        }
-    }
-    return ret;    
+void scale_inplace(matrix<T>& x, T alpha) {
+    evaluate(x, constant<T>(alpha), [](T& r, const T& v) { r *= v; });
 }
 
 
-
-
 template<typename T>    
 inline
 bool operator!=(const matrix<T>& a, const matrix<T>& b) {
@@ -497,13 +470,43 @@ std::ostream& operator<<(std::ostream& s, const matrix<T>& m) {
 
 template<typename T>
 inline
-matrix<T>::matrix(uint rows, uint cols) 
+matrix<T>::matrix(uint rows, uint cols, init i) 
+    : M(rows),
+      N(cols),
+      rep(rows*cols, i)
+{
+}
+
+template<typename T>
+inline
+matrix<T>::matrix(uint rows, uint cols, const buffer<T>& storage) 
     : M(rows),
       N(cols),
-      rep(rows*cols)
+      rep(storage)
 {
 }
 
+template<typename T>
+template<typename E>
+inline
+matrix<T>::matrix(const expression<T,E>& e)
+    : M(e.self().M),
+      N(e.self().N),
+      rep(M*N, UNINITIALIZED)
+{
+    assign(*this, e);
+}
+
+template<typename T>
+inline
+matrix<T>::matrix(const gemm_expr<T>& g)
+    : M(g.a.M),
+      N(g.b.N),
+      rep(M*N, UNINITIALIZED)
+{
+    g.run(*this, T(0));
+}
+
 template<typename T>
 inline
 matrix<T>::matrix(uint rows, uint cols, const matrix<T>& m, uint roff, uint coff)
@@ -514,17 +517,25 @@ matrix<T>::matrix(uint rows, uint cols, const matrix<T>& m, uint roff, uint coff
 
 template<typename T>
 inline
-void matrix<T>::foreach(std::function<void (T&)> handler) {
-    for(uint i = 0; i < this->M; i++) {
-        for(uint j = 0; j < this->N; j++) {
-            handler((*this)(i,j));
-        }
-    }
+void matrix<T>::foreach(std::function<void (T&)> handler, policy p) {
+    foreach_index([&handler](uint, uint, T& x) { handler(x); }, p);
 }
     
 template<typename T>
 inline
-void matrix<T>::foreach_index(std::function<void (uint,uint,T&)> handler) {
+void matrix<T>::foreach_index(std::function<void (uint,uint,T&)> handler, policy p) {
+    if(p == PARALLEL) {
+        const std::size_t cols = std::max<std::size_t>(1, ELEMENTWISE_GRAIN / std::max(M, 1u));
+        parallel_for(N, cols, [&](std::size_t begin, std::size_t end) {
+                for(uint j = begin; j < end; j++) {
+                    for(uint i = 0; i < M; i++) {
+                        handler(i, j, (*this)(i,j));
+                    }
+                }
+            }, std::size_t(M) * N);
+        return;
+    }
+
     for(uint i = 0; i < this->M; i++) {
         for(uint j = 0; j < this->N; j++) {
             handler(i, j, (*this)(i,j));
@@ -562,33 +573,52 @@ matrix<T>& matrix<T>::operator*=(const matrix<T>& m) {
 template<typename T>    
 inline
 matrix<T>& matrix<T>::operator+=(const matrix<T>& b) {
-    if(this->M != b.M || this->N != b.N)
-        throw typename matrix<T>::mismatch();
-
-    matrix<T>& ret = *this;
-    for(uint i = 0; i < this->M; i++) {
-        for(uint j = 0; j < this->N; j++) {
-            ret(i,j) += b(i, j);
-        }
-    }
-    
-    return ret;    
+    return *this += leaf<T>(b);
 }
 
 
 template<typename T>    
 inline
 matrix<T>& matrix<T>::operator-=(const matrix<T>& b) {
-    if(this->M != b.M || this->N != b.N)
+    return *this -= leaf<T>(b);
+}
+
+template<typename T>
+template<typename E>
+inline
+matrix<T>& matrix<T>::operator+=(const expression<T,E>& e) {
+    if(this->M != e.self().M || this->N != e.self().N)
         throw typename matrix<T>::mismatch();
 
-    matrix<T>& ret = *this;
-    for(uint i = 0; i < this->M; i++) {
-        for(uint j = 0; j < this->N; j++) {
-	    ret(i,j) -= b(i, j);
-        }
-    }
-    return ret;    
+    evaluate(*this, e, [](T& r, const T& x) { r += x; });
+    return *this;
+}
+
+template<typename T>
+template<typename E>
+inline
+matrix<T>& matrix<T>::operator-=(const expression<T,E>& e) {
+    if(this->M != e.self().M || this->N != e.self().N)
+        throw typename matrix<T>::mismatch();
+
+    evaluate(*this, e, [](T& r, const T& x) { r -= x; });
+    return *this;
+}
+
+template<typename T>
+inline
+matrix<T>& matrix<T>::operator+=(const gemm_expr<T>& g) {
+    if(this->M != g.a.M || this->N != g.b.N)
+        throw typename matrix<T>::mismatch();
+
+    g.run(*this, T(1));
+    return *this;
+}
+
+template<typename T>
+inline
+matrix<T>& matrix<T>::operator-=(const gemm_expr<T>& g) {
+    return *this += gemm_expr<T>(g.a, g.b, -g.alpha);
 }
 
 template<typename T>
@@ -607,9 +637,7 @@ matrix<T>::operator const buffer<T>() const {
 template<typename T>
 inline
 matrix<T> matrix<T>::transpose() const {
-    matrix<T> ret(N, M);
-
-    ret.rep = rep;
+    matrix<T> ret(N, M, rep);
     ret.transposed = !transposed;
 
     return ret;
@@ -0,0 +1,140 @@
+/* -*- mode: C++ c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2026 Joey Yandle <xoloki@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+#ifndef JLIB_MATH_PARALLEL_HH
+#define JLIB_MATH_PARALLEL_HH
+
+#include <jlib/sys/sync.hh>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include <cstddef>
+
+namespace jlib {
+namespace math {
+
+// whether a foreach handler may be called from several threads at once
+enum policy { SEQUENTIAL, PARALLEL };
+
+// number of threads matrix operations may use, counting the caller.
+// the default of 1 keeps everything on the calling thread.  don't change
+// it while other threads are in the middle of matrix operations
+void set_threads(unsigned int n);
+unsigned int get_threads();
+
+// operations smaller than this many scalar operations (elements, or
+// multiply-adds for products) stay on the calling thread
+void set_parallel_threshold(std::size_t n);
+std::size_t get_parallel_threshold();
+
+// true when an operation of the given size would be split across threads
+bool parallel(std::size_t work);
+
+// split [0, n) into chunks of grain and call f(begin, end) for each one,
+// spread over the pool when parallel(work).  chunk boundaries depend only
+// on n and grain, never on the thread count
+template<typename F>
+void parallel_for(std::size_t n, std::size_t grain, F f, std::size_t work);
+
+
+struct parallel_state {
+    std::atomic<unsigned int> threads;
+    std::atomic<std::size_t> threshold;
+    std::shared_ptr<sys::pool> pool;
+    std::mutex lock;
+
+    parallel_state() : threads(1), threshold(1 << 16) {}
+
+    static parallel_state& get() {
+        static parallel_state state;
+        return state;
+    }
+};
+
+inline
+void set_threads(unsigned int n) {
+    parallel_state& s = parallel_state::get();
+    std::unique_lock<std::mutex> lock(s.lock);
+
+    n = std::max(n, 1u);
+    if(n == s.threads && (n == 1 || s.pool))
+        return;
+
+    // the calling thread always helps, so the pool only needs n-1 workers
+    s.pool.reset();
+    if(n > 1)
+        s.pool = std::make_shared<sys::pool>(n - 1);
+    s.threads = n;
+}
+
+inline
+unsigned int get_threads() {
+    return parallel_state::get().threads;
+}
+
+inline
+void set_parallel_threshold(std::size_t n) {
+    parallel_state::get().threshold = n;
+}
+
+inline
+std::size_t get_parallel_threshold() {
+    return parallel_state::get().threshold;
+}
+
+inline
+bool parallel(std::size_t work) {
+    const parallel_state& s = parallel_state::get();
+    return s.threads > 1 && work >= s.threshold;
+}
+
+template<typename F>
+inline
+void parallel_for(std::size_t n, std::size_t grain, F f, std::size_t work) {
+    grain = std::max<std::size_t>(grain, 1);
+    const std::size_t chunks = (n + grain - 1) / grain;
+
+    std::shared_ptr<sys::pool> pool;
+    if(chunks > 1 && parallel(work)) {
+        parallel_state& s = parallel_state::get();
+        std::unique_lock<std::mutex> lock(s.lock);
+        pool = s.pool;
+    }
+
+    if(!pool) {
+        for(std::size_t c = 0; c < chunks; c++) {
+            f(c * grain, std::min(n, (c + 1) * grain));
+        }
+        return;
+    }
+
+    pool->run(chunks, [&](std::size_t c) {
+            f(c * grain, std::min(n, (c + 1) * grain));
+        });
+}
+
+}
+}
+
+#endif //JLIB_MATH_PARALLEL_HH
@@ -0,0 +1,330 @@
+/* -*- mode: C++ c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2026 Joey Yandle <xoloki@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+#ifndef JLIB_MATH_STRASSEN_HH
+#define JLIB_MATH_STRASSEN_HH
+
+#include <jlib/math/gemm.hh>
+
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+namespace jlib {
+namespace math {
+namespace kernel {
+
+// strassen keeps halving while every dimension is above this, then hands
+// the pieces to gemm.  see jmatrix strassen for where it pays off
+std::size_t get_strassen_cutoff();
+void set_strassen_cutoff(std::size_t n);
+
+// C = op(A) * op(B) using the Strassen-Winograd recursion (7 products and
+// 15 additions per level).  shapes that don't halve evenly are zero padded
+// once at the top, and all scratch comes from a per thread arena
+template<typename T>
+void strassen(bool ta, bool tb, unsigned int m, unsigned int n, unsigned int k,
+              const T* a, unsigned int lda, const T* b, unsigned int ldb,
+              T* c, unsigned int ldc);
+
+// bump allocator over one buffer.  the recursion takes what it needs for a
+// level and gives it back before its sibling runs, so the high water mark
+// is a single path down the tree rather than the whole tree
+template<typename T>
+class arena {
+public:
+    arena() : m_top(0) {}
+
+    void reserve(std::size_t n) {
+        if(m_buf.size() < n)
+            m_buf.resize(n);
+        m_top = 0;
+    }
+
+    T* take(std::size_t n) {
+        T* p = m_buf.data() + m_top;
+        m_top += n;
+        return p;
+    }
+
+    std::size_t mark() const {
+        return m_top;
+    }
+
+    void release(std::size_t mark) {
+        m_top = mark;
+    }
+
+protected:
+    std::vector<T> m_buf;
+    std::size_t m_top;
+};
+
+template<typename T>
+arena<T>& strassen_arena();
+
+// how many halvings the cutoff allows for these dimensions
+unsigned int strassen_levels(unsigned int m, unsigned int n, unsigned int k);
+
+// scratch one level of the recursion and everything below it needs
+std::size_t strassen_scratch(unsigned int m, unsigned int n, unsigned int k, unsigned int levels);
+
+// c = x + y and c = x - y for m x n column-major blocks
+template<typename T>
+void add(unsigned int m, unsigned int n, const T* x, unsigned int ldx,
+         const T* y, unsigned int ldy, T* c, unsigned int ldc);
+
+template<typename T>
+void sub(unsigned int m, unsigned int n, const T* x, unsigned int ldx,
+         const T* y, unsigned int ldy, T* c, unsigned int ldc);
+
+// the recursion proper, on untransposed operands whose dimensions divide by 2^levels
+template<typename T>
+void winograd(unsigned int m, unsigned int n, unsigned int k, unsigned int levels,
+              const T* a, unsigned int lda, const T* b, unsigned int ldb,
+              T* c, unsigned int ldc, arena<T>& mem);
+
+
+inline
+std::size_t& current_strassen_cutoff() {
+    static std::size_t cutoff = 1024;
+    return cutoff;
+}
+
+inline
+std::size_t get_strassen_cutoff() {
+    return current_strassen_cutoff();
+}
+
+inline
+void set_strassen_cutoff(std::size_t n) {
+    current_strassen_cutoff() = std::max<std::size_t>(n, 1);
+}
+
+template<typename T>
+inline
+arena<T>& strassen_arena() {
+    static thread_local arena<T> mem;
+    return mem;
+}
+
+inline
+unsigned int strassen_levels(unsigned int m, unsigned int n, unsigned int k) {
+    const std::size_t cutoff = get_strassen_cutoff();
+    unsigned int levels = 0;
+
+    while(std::min(m, std::min(n, k)) > cutoff) {
+        m = (m + 1) / 2;
+        n = (n + 1) / 2;
+        k = (k + 1) / 2;
+        levels++;
+    }
+
+    return levels;
+}
+
+inline
+std::size_t strassen_scratch(unsigned int m, unsigned int n, unsigned int k, unsigned int levels) {
+    std::size_t total = 0;
+
+    while(levels--) {
+        m /= 2;
+        n /= 2;
+        k /= 2;
+        // four sums of A blocks, four of B blocks, one product
+        total += 4 * std::size_t(m) * k + 4 * std::size_t(k) * n + std::size_t(m) * n;
+    }
+
+    return total;
+}
+
+template<typename T>
+inline
+void add(unsigned int m, unsigned int n, const T* x, unsigned int ldx,
+         const T* y, unsigned int ldy, T* c, unsigned int ldc) {
+    for(unsigned int j = 0; j < n; j++) {
+        const T* xj = x + std::size_t(j) * ldx;
+        const T* yj = y + std::size_t(j) * ldy;
+        T* cj = c + std::size_t(j) * ldc;
+        for(unsigned int i = 0; i < m; i++) {
+            cj[i] = xj[i] + yj[i];
+        }
+    }
+}
+
+template<typename T>
+inline
+void sub(unsigned int m, unsigned int n, const T* x, unsigned int ldx,
+         const T* y, unsigned int ldy, T* c, unsigned int ldc) {
+    for(unsigned int j = 0; j < n; j++) {
+        const T* xj = x + std::size_t(j) * ldx;
+        const T* yj = y + std::size_t(j) * ldy;
+        T* cj = c + std::size_t(j) * ldc;
+        for(unsigned int i = 0; i < m; i++) {
+            cj[i] = xj[i] - yj[i];
+        }
+    }
+}
+
+template<typename T>
+inline
+void winograd(unsigned int m, unsigned int n, unsigned int k, unsigned int levels,
+              const T* a, unsigned int lda, const T* b, unsigned int ldb,
+              T* c, unsigned int ldc, arena<T>& mem) {
+    if(levels == 0) {
+        gemm(false, false, m, n, k, T(1), a, lda, b, ldb, T(0), c, ldc);
+        return;
+    }
+
+    const unsigned int m2 = m / 2, n2 = n / 2, k2 = k / 2;
+
+    const T* a11 = a;
+    const T* a21 = a + m2;
+    const T* a12 = a + std::size_t(k2) * lda;
+    const T* a22 = a12 + m2;
+
+    const T* b11 = b;
+    const T* b21 = b + k2;
+    const T* b12 = b + std::size_t(n2) * ldb;
+    const T* b22 = b12 + k2;
+
+    T* c11 = c;
+    T* c21 = c + m2;
+    T* c12 = c + std::size_t(n2) * ldc;
+    T* c22 = c12 + m2;
+
+    const std::size_t top = mem.mark();
+    T* s1 = mem.take(std::size_t(m2) * k2);
+    T* s2 = mem.take(std::size_t(m2) * k2);
+    T* s3 = mem.take(std::size_t(m2) * k2);
+    T* s4 = mem.take(std::size_t(m2) * k2);
+    T* t1 = mem.take(std::size_t(k2) * n2);
+    T* t2 = mem.take(std::size_t(k2) * n2);
+    T* t3 = mem.take(std::size_t(k2) * n2);
+    T* t4 = mem.take(std::size_t(k2) * n2);
+    T* x = mem.take(std::size_t(m2) * n2);
+
+    add(m2, k2, a21, lda, a22, lda, s1, m2);
+    sub(m2, k2, s1, m2, a11, lda, s2, m2);
+    sub(m2, k2, a11, lda, a21, lda, s3, m2);
+    sub(m2, k2, a12, lda, s2, m2, s4, m2);
+
+    sub(k2, n2, b12, ldb, b11, ldb, t1, k2);
+    sub(k2, n2, b22, ldb, t1, k2, t2, k2);
+    sub(k2, n2, b22, ldb, b12, ldb, t3, k2);
+    sub(k2, n2, t2, k2, b21, ldb, t4, k2);
+
+    // the products land in C's quadrants as soon as they can, so one
+    // temporary is enough for the whole level
+    winograd(m2, n2, k2, levels - 1, a11, lda, b11, ldb, x, m2, mem);     // p1
+    winograd(m2, n2, k2, levels - 1, a12, lda, b21, ldb, c11, ldc, mem);  // p2
+    add(m2, n2, c11, ldc, x, m2, c11, ldc);                                // c11 = p1 + p2
+
+    winograd(m2, n2, k2, levels - 1, s2, m2, t2, k2, c12, ldc, mem);      // p6
+    add(m2, n2, c12, ldc, x, m2, c12, ldc);                                // u2 = p1 + p6
+    winograd(m2, n2, k2, levels - 1, s3, m2, t3, k2, c21, ldc, mem);      // p7
+    add(m2, n2, c21, ldc, c12, ldc, c21, ldc);                             // u3 = u2 + p7
+
+    winograd(m2, n2, k2, levels - 1, s1, m2, t1, k2, x, m2, mem);         // p5
+    add(m2, n2, c12, ldc, x, m2, c12, ldc);                                // u4 = u2 + p5
+    add(m2, n2, c21, ldc, x, m2, c22, ldc);                                // c22 = u3 + p5
+
+    winograd(m2, n2, k2, levels - 1, s4, m2, b22, ldb, x, m2, mem);       // p3
+    add(m2, n2, c12, ldc, x, m2, c12, ldc);                                // c12 = u4 + p3
+
+    winograd(m2, n2, k2, levels - 1, a22, lda, t4, k2, x, m2, mem);       // p4
+    sub(m2, n2, c21, ldc, x, m2, c21, ldc);                                // c21 = u3 - p4
+
+    mem.release(top);
+}
+
+template<typename T>
+inline
+void strassen(bool ta, bool tb, unsigned int m, unsigned int n, unsigned int k,
+              const T* a, unsigned int lda, const T* b, unsigned int ldb,
+              T* c, unsigned int ldc) {
+    const unsigned int levels = strassen_levels(m, n, k);
+    if(levels == 0) {
+        gemm(ta, tb, m, n, k, T(1), a, lda, b, ldb, T(0), c, ldc);
+        return;
+    }
+
+    // round every dimension up so it halves cleanly all the way down
+    const unsigned int step = 1u << levels;
+    const unsigned int pm = (m + step - 1) / step * step;
+    const unsigned int pn = (n + step - 1) / step * step;
+    const unsigned int pk = (k + step - 1) / step * step;
+
+    // transposed or padded operands get one column-major copy up front
+    const bool copy_a = ta || pm != m || pk != k;
+    const bool copy_b = tb || pk != k || pn != n;
+    const bool copy_c = pm != m || pn != n;
+
+    arena<T>& mem = strassen_arena<T>();
+    mem.reserve((copy_a ? std::size_t(pm) * pk : 0) +
+                (copy_b ? std::size_t(pk) * pn : 0) +
+                (copy_c ? std::size_t(pm) * pn : 0) +
+                strassen_scratch(pm, pn, pk, levels));
+
+    if(copy_a) {
+        T* pa = mem.take(std::size_t(pm) * pk);
+        for(unsigned int p = 0; p < pk; p++) {
+            T* col = pa + std::size_t(p) * pm;
+            for(unsigned int i = 0; i < pm; i++) {
+                if(i < m && p < k)
+                    col[i] = ta ? a[std::size_t(i) * lda + p] : a[std::size_t(p) * lda + i];
+                else
+                    col[i] = T(0);
+            }
+        }
+        a = pa;
+        lda = pm;
+    }
+
+    if(copy_b) {
+        T* pb = mem.take(std::size_t(pk) * pn);
+        for(unsigned int j = 0; j < pn; j++) {
+            T* col = pb + std::size_t(j) * pk;
+            for(unsigned int p = 0; p < pk; p++) {
+                if(p < k && j < n)
+                    col[p] = tb ? b[std::size_t(p) * ldb + j] : b[std::size_t(j) * ldb + p];
+                else
+                    col[p] = T(0);
+            }
+        }
+        b = pb;
+        ldb = pk;
+    }
+
+    T* pc = copy_c ? mem.take(std::size_t(pm) * pn) : c;
+    winograd(pm, pn, pk, levels, a, lda, b, ldb, pc, (copy_c ? pm : ldc), mem);
+
+    if(copy_c) {
+        for(unsigned int j = 0; j < n; j++) {
+            std::copy(pc + std::size_t(j) * pm, pc + std::size_t(j) * pm + m, c + std::size_t(j) * ldc);
+        }
+    }
+}
+
+}
+}
+}
+
+#endif //JLIB_MATH_STRASSEN_HH
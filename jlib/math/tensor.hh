@@ -1,21 +1,21 @@
 /* -*- mode: C++ c-basic-offset: 4 -*-
- * 
+ *
  * Copyright (c) 1999 Joe Yandle <joey@divisionbyzero.com>
- * 
+ *
  * This program is free software; you can redistribute it and/or
  * modify it under the terms of the GNU General Public License
  * as published by the Free Software Foundation; either version 2
  * of the License, or (at your option) any later version.
- * 
+ *
  * This program is distributed in the hope that it will be useful,
  * but WITHOUT ANY WARRANTY; without even the implied warranty of
  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
  * GNU General Public License for more details.
- * 
+ *
  * You should have received a copy of the GNU General Public License
  * along with this program; if not, write to the Free Software
  * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
- * 
+ *
  */
 
 #ifndef JLIB_MATH_TENSOR_HH
@@ -23,183 +23,510 @@
 
 
 #include <jlib/math/buffer.hh>
+#include <jlib/math/matrix.hh>
+#include <jlib/math/gemm.hh>
+#include <jlib/math/parallel.hh>
+
+#include <algorithm>
+#include <atomic>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
 #include <cstdarg>
+#include <cstddef>
 
 
 namespace jlib {
 namespace math {
 
 
-template<typename T>
-class tensor;
-
-// tensor product
-template<typename T> 
-tensor<T> operator*(const tensor<T>& a, const tensor<T>& b);
-
-// tensor inner (dot) product
-template<typename T>    
-tensor<T> operator^(const tensor<T>& a, const tensor<T>& b);
-
-template<typename T>    
-bool operator==(const tensor<T>& a, const tensor<T>& b);
-
-template<typename T>    
-bool operator!=(const tensor<T>& a, const T& b);
-
+// a view of a buffer as an array of any rank up to MAX_RANK.  each axis has
+// a size and a stride in elements, so slicing, transposing and broadcasting
+// only rewrite the view; the elements stay where they are and are shared,
+// as a matrix shares its buffer with its copies.  new tensors are laid out
+// row-major, last axis fastest
 template<typename T>
 class tensor {
 public:
     class mismatch : public std::exception {};
-    class not_implemented : public std::exception {};
-    
-    template<typename U>
-    friend tensor<U> operator*(const tensor<U>& a, const tensor<U>& b);
+    // nothing throws this any more: every product is implemented.  kept so
+    // code that catches it still builds
+    class [[deprecated("tensor products no longer throw not_implemented")]]
+    not_implemented : public std::exception {};
 
-    template<typename U>
-    friend tensor<U> operator^(const tensor<U>& a, const tensor<U>& b);
+    static const unsigned int MAX_RANK = 8;
 
+    // rank, then the size of each axis
     explicit tensor(unsigned int r, ...);
+    explicit tensor(const std::vector<unsigned int>& shape, init i = ZEROED);
+    explicit tensor(std::initializer_list<unsigned int> shape, init i = ZEROED);
     tensor(buffer<unsigned int> m);
     tensor(buffer<unsigned int> m, buffer<T> d);
 
-    tensor<T> operator[](unsigned int i);
+    // a rows by columns view of m's storage
+    explicit tensor(const matrix<T>& m);
+
+    // element access, one index per axis
+    template<typename... I>
+    T& at(I... i);
+    template<typename... I>
+    const T& at(I... i) const;
+
+    // take ith slice along the first axis.  in a rank 2 tensor, a slice is a row
+    tensor<T> operator[](unsigned int i) const;
+    tensor<T> operator()(unsigned int i) const;
+
+    // views: drop an axis at index i, keep [begin, end) of an axis,
+    // reorder or reverse the axes, give size 1 axes a stride of zero
+    tensor<T> slice(unsigned int axis, unsigned int i) const;
+    tensor<T> range(unsigned int axis, unsigned int begin, unsigned int end) const;
+    tensor<T> transpose() const;
+    tensor<T> transpose(const std::vector<unsigned int>& axes) const;
+    tensor<T> broadcast(const std::vector<unsigned int>& shape) const;
+
+    // a view when the elements are contiguous, otherwise a copy
+    tensor<T> reshape(const std::vector<unsigned int>& shape) const;
+
+    // the same elements in fresh row-major storage
+    tensor<T> copy() const;
 
-    // take ith slice.  in a rank 2 tensor, a slice is a column vector
-    tensor<T> operator()(unsigned int i);
+    // a rank 2 tensor as a matrix, sharing storage when the layout allows
+    matrix<T> to_matrix() const;
 
     operator T&();
     operator const T&() const;
 
     unsigned int rank() const;
     unsigned int size(unsigned int i) const;
+    std::ptrdiff_t stride(unsigned int i) const;
+    std::vector<unsigned int> shape() const;
+    std::size_t elements() const;
+
+    // laid out row-major with no gaps
+    bool contiguous() const;
 
     tensor<T>& operator=(const T& t);
-    
-private:
-    unsigned int mmult(unsigned int o);
+    void fill(const T& t);
+
+    // the first element
+    T* data();
+    const T* data() const;
+
+    // strides gemm can read the view with once axes [0, split) are
+    // flattened into rows and the rest into columns.  false when they
+    // can't be; otherwise the view is an ld-strided column-major matrix,
+    // of the rows x columns product or, when rowmajor, of its transpose
+    bool gemm_layout(unsigned int split, bool& rowmajor, unsigned int& ld) const;
 
-    buffer<unsigned int> meta;
-    buffer<T> data;
+private:
+    void dense(const unsigned int* shape, unsigned int r, init i);
+    std::size_t offset(const unsigned int* index) const;
+
+    // stride of axes [begin, end) flattened into one, zero if they are
+    // all size 1, false if they can't be flattened
+    bool flatten(unsigned int begin, unsigned int end, std::ptrdiff_t& stride) const;
+
+    unsigned int m_rank;
+    unsigned int m_shape[MAX_RANK];
+    std::ptrdiff_t m_stride[MAX_RANK];
+    std::size_t m_offset;
+    buffer<T> m_data;
 };
 
-    
+// c = f(a, b) elementwise, all three the same shape
+template<typename T, typename F>
+void zip(tensor<T>& c, const tensor<T>& a, const tensor<T>& b, F f);
+
+// the shape a and b both broadcast to
+template<typename T>
+std::vector<unsigned int> broadcast_shape(const tensor<T>& a, const tensor<T>& b);
+
+// sum over each pair of axes (axis of a, axis of b).  the result has the
+// remaining axes of a followed by the remaining axes of b, and is computed
+// by one gemm; views gemm can't stride through are copied first
+template<typename T>
+tensor<T> contract(const tensor<T>& a, const tensor<T>& b,
+                   const std::vector<std::pair<unsigned int, unsigned int> >& axes);
+
+// tensor product
+template<typename T>
+tensor<T> operator*(const tensor<T>& a, const tensor<T>& b);
+
+// tensor inner (dot) product, over the last axis of a and the first of b
+template<typename T>
+tensor<T> operator^(const tensor<T>& a, const tensor<T>& b);
+
+// elementwise, broadcasting
+template<typename T>
+tensor<T> operator+(const tensor<T>& a, const tensor<T>& b);
+template<typename T>
+tensor<T> operator-(const tensor<T>& a, const tensor<T>& b);
+template<typename T>
+tensor<T> hadamard(const tensor<T>& a, const tensor<T>& b);
+template<typename T>
+tensor<T> operator*(const tensor<T>& a, const T& s);
+template<typename T>
+tensor<T> operator*(const T& s, const tensor<T>& a);
+
+template<typename T>
+bool operator==(const tensor<T>& a, const tensor<T>& b);
+
+template<typename T>
+bool operator!=(const tensor<T>& a, const tensor<T>& b);
+
+
 template<typename T>
 inline
 tensor<T>::tensor(unsigned int r, ...)
-    : meta(r)
+    : m_rank(0),
+      m_offset(0)
 {
-    va_list v;
-    va_start(v, r);
+    if(r > MAX_RANK)
+        throw mismatch();
 
-    unsigned int size = 1;
+    unsigned int shape[MAX_RANK];
 
-    for(unsigned int i = 0; i < meta.size(); i++) {
-        unsigned int val = va_arg(v, unsigned int);
-        meta[i] = val;
-        size *= val;
+    va_list v;
+    va_start(v, r);
+    for(unsigned int i = 0; i < r; i++) {
+        shape[i] = va_arg(v, unsigned int);
     }
-
     va_end(v);
 
-    data.resize(size);
+    dense(shape, r, ZEROED);
 }
 
 template<typename T>
 inline
-tensor<T>::tensor(buffer<unsigned int> m) 
-    : meta(m)
+tensor<T>::tensor(const std::vector<unsigned int>& shape, init i)
+    : m_rank(0),
+      m_offset(0)
 {
-    data.resize(meta.product());
+    if(shape.size() > MAX_RANK)
+        throw mismatch();
+
+    dense(shape.data(), shape.size(), i);
 }
 
 template<typename T>
 inline
-tensor<T>::tensor(buffer<unsigned int> m, buffer<T> d) 
-    : meta(m),
-      data(d)
+tensor<T>::tensor(std::initializer_list<unsigned int> shape, init i)
+    : tensor(std::vector<unsigned int>(shape), i)
 {
 }
 
 template<typename T>
 inline
-tensor<T>::operator T&() {
-    if(meta.size())
+tensor<T>::tensor(buffer<unsigned int> m)
+    : m_rank(0),
+      m_offset(0)
+{
+    if(m.size() > MAX_RANK)
         throw mismatch();
 
-    return data[0];
+    unsigned int shape[MAX_RANK];
+    for(unsigned int i = 0; i < m.size(); i++) {
+        shape[i] = m[i];
+    }
+    dense(shape, m.size(), ZEROED);
 }
 
 template<typename T>
 inline
-tensor<T>::operator const T&() const {
-    if(meta.size())
+tensor<T>::tensor(buffer<unsigned int> m, buffer<T> d)
+    : m_rank(0),
+      m_offset(0)
+{
+    if(m.size() > MAX_RANK || m.product() != d.size())
         throw mismatch();
 
-    return data[0];
+    m_rank = m.size();
+    std::ptrdiff_t n = 1;
+    for(int i = int(m_rank) - 1; i >= 0; i--) {
+        m_shape[i] = m[i];
+        m_stride[i] = n;
+        n *= m[i];
+    }
+    m_data = d;
 }
 
+template<typename T>
+inline
+tensor<T>::tensor(const matrix<T>& m)
+    : m_rank(2),
+      m_offset(0),
+      m_data(static_cast<const buffer<T> >(m))
+{
+    m_shape[0] = m.M;
+    m_shape[1] = m.N;
+    m_stride[0] = (m.is_transposed() ? m.N : 1);
+    m_stride[1] = (m.is_transposed() ? 1 : m.M);
+}
 
 template<typename T>
 inline
-tensor<T> tensor<T>::operator[](unsigned int i) {
-    if(!meta.size()) {
-        if(i)
+void tensor<T>::dense(const unsigned int* shape, unsigned int r, init i) {
+    m_rank = r;
+
+    std::size_t n = 1;
+    for(int d = int(r) - 1; d >= 0; d--) {
+        m_shape[d] = shape[d];
+        m_stride[d] = n;
+        n *= shape[d];
+    }
+
+    m_offset = 0;
+    m_data = buffer<T>(std::max<std::size_t>(n, 1), i);
+}
+
+template<typename T>
+inline
+std::size_t tensor<T>::offset(const unsigned int* index) const {
+    std::ptrdiff_t o = m_offset;
+    for(unsigned int d = 0; d < m_rank; d++) {
+        if(index[d] >= m_shape[d])
             throw mismatch();
-        else
-            return *this;
+        o += index[d] * m_stride[d];
     }
+    return o;
+}
 
-    buffer<unsigned int> submeta(meta, 1, meta.size() - 1);
+template<typename T>
+template<typename... I>
+inline
+T& tensor<T>::at(I... i) {
+    const unsigned int index[] = { 0u, static_cast<unsigned int>(i)... };
+    if(sizeof...(I) != m_rank)
+        throw mismatch();
 
-    unsigned int p = submeta.product();
+    return m_data[offset(index + 1)];
+}
 
-    buffer<T> subdata(data, i * p, p);
+template<typename T>
+template<typename... I>
+inline
+const T& tensor<T>::at(I... i) const {
+    const unsigned int index[] = { 0u, static_cast<unsigned int>(i)... };
+    if(sizeof...(I) != m_rank)
+        throw mismatch();
+
+    return m_data[offset(index + 1)];
+}
 
-    return tensor<T>(submeta, subdata);
+template<typename T>
+inline
+tensor<T> tensor<T>::operator[](unsigned int i) const {
+    return slice(0, i);
 }
 
 template<typename T>
 inline
-tensor<T> tensor<T>::operator()(unsigned int i) {
-    if(!meta.size()) {
-        if(i)
+tensor<T> tensor<T>::operator()(unsigned int i) const {
+    return slice(0, i);
+}
+
+template<typename T>
+inline
+tensor<T> tensor<T>::slice(unsigned int axis, unsigned int i) const {
+    if(axis >= m_rank || i >= m_shape[axis])
+        throw mismatch();
+
+    tensor<T> ret(*this);
+    ret.m_offset += i * m_stride[axis];
+    ret.m_rank--;
+    for(unsigned int d = axis; d < ret.m_rank; d++) {
+        ret.m_shape[d] = m_shape[d + 1];
+        ret.m_stride[d] = m_stride[d + 1];
+    }
+
+    return ret;
+}
+
+template<typename T>
+inline
+tensor<T> tensor<T>::range(unsigned int axis, unsigned int begin, unsigned int end) const {
+    if(axis >= m_rank || begin > end || end > m_shape[axis])
+        throw mismatch();
+
+    tensor<T> ret(*this);
+    ret.m_offset += begin * m_stride[axis];
+    ret.m_shape[axis] = end - begin;
+
+    return ret;
+}
+
+template<typename T>
+inline
+tensor<T> tensor<T>::transpose() const {
+    std::vector<unsigned int> axes(m_rank);
+    for(unsigned int d = 0; d < m_rank; d++) {
+        axes[d] = m_rank - 1 - d;
+    }
+    return transpose(axes);
+}
+
+template<typename T>
+inline
+tensor<T> tensor<T>::transpose(const std::vector<unsigned int>& axes) const {
+    if(axes.size() != m_rank)
+        throw mismatch();
+
+    tensor<T> ret(*this);
+    bool seen[MAX_RANK] = { false };
+    for(unsigned int d = 0; d < m_rank; d++) {
+        if(axes[d] >= m_rank || seen[axes[d]])
+            throw mismatch();
+        seen[axes[d]] = true;
+
+        ret.m_shape[d] = m_shape[axes[d]];
+        ret.m_stride[d] = m_stride[axes[d]];
+    }
+
+    return ret;
+}
+
+template<typename T>
+inline
+tensor<T> tensor<T>::broadcast(const std::vector<unsigned int>& shape) const {
+    if(shape.size() < m_rank || shape.size() > MAX_RANK)
+        throw mismatch();
+
+    // axes line up from the right, missing ones on the left are added
+    tensor<T> ret(*this);
+    ret.m_rank = shape.size();
+    const unsigned int lead = shape.size() - m_rank;
+    for(unsigned int d = 0; d < ret.m_rank; d++) {
+        ret.m_shape[d] = shape[d];
+        if(d < lead) {
+            ret.m_stride[d] = 0;
+        } else if(m_shape[d - lead] == shape[d]) {
+            ret.m_stride[d] = m_stride[d - lead];
+        } else if(m_shape[d - lead] == 1) {
+            ret.m_stride[d] = 0;
+        } else {
             throw mismatch();
-        else
-            return *this;
+        }
     }
 
-    buffer<unsigned int> submeta(meta, 1, meta.size() - 1);
+    return ret;
+}
+
+template<typename T>
+inline
+tensor<T> tensor<T>::reshape(const std::vector<unsigned int>& shape) const {
+    std::size_t n = 1;
+    for(unsigned int s : shape) {
+        n *= s;
+    }
+    if(n != elements() || shape.size() > MAX_RANK)
+        throw mismatch();
 
-    unsigned int p = submeta.product();
+    if(!contiguous())
+        return copy().reshape(shape);
 
-    buffer<T> subdata(data, i * p, p);
+    tensor<T> ret(*this);
+    ret.m_rank = shape.size();
+    n = 1;
+    for(int d = int(ret.m_rank) - 1; d >= 0; d--) {
+        ret.m_shape[d] = shape[d];
+        ret.m_stride[d] = n;
+        n *= shape[d];
+    }
 
-    return tensor<T>(submeta, subdata);
+    return ret;
+}
+
+template<typename T>
+inline
+tensor<T> tensor<T>::copy() const {
+    tensor<T> ret(shape(), UNINITIALIZED);
+    zip(ret, *this, *this, [](T& c, const T& a, const T&) { c = a; });
+    return ret;
+}
+
+template<typename T>
+inline
+matrix<T> tensor<T>::to_matrix() const {
+    if(m_rank != 2)
+        throw mismatch();
+
+    const unsigned int rows = m_shape[0];
+    const unsigned int cols = m_shape[1];
+    const std::size_t n = std::size_t(rows) * cols;
+    buffer<T> storage(m_data, m_offset, n);
+
+    // matrix only knows column-major and its transpose, both without gaps
+    if((m_stride[0] == 1 || rows == 1) && (m_stride[1] == rows || cols == 1))
+        return matrix<T>(rows, cols, storage);
+    if((m_stride[1] == 1 || cols == 1) && (m_stride[0] == cols || rows == 1))
+        return matrix<T>(cols, rows, storage).transpose();
+
+    return copy().to_matrix();
+}
+
+template<typename T>
+inline
+tensor<T>::operator T&() {
+    if(m_rank)
+        throw mismatch();
+
+    return m_data[m_offset];
+}
+
+template<typename T>
+inline
+tensor<T>::operator const T&() const {
+    if(m_rank)
+        throw mismatch();
+
+    return m_data[m_offset];
 }
 
 template<typename T>
 inline
 unsigned int tensor<T>::rank() const {
-    return meta.size();
+    return m_rank;
 }
 
 template<typename T>
 inline
 unsigned int tensor<T>::size(unsigned int i) const {
-    return meta[i];
+    return m_shape[i];
+}
+
+template<typename T>
+inline
+std::ptrdiff_t tensor<T>::stride(unsigned int i) const {
+    return m_stride[i];
 }
 
 template<typename T>
 inline
-unsigned int tensor<T>::mmult(unsigned int o) {
-    unsigned int m = 1;
+std::vector<unsigned int> tensor<T>::shape() const {
+    return std::vector<unsigned int>(m_shape, m_shape + m_rank);
+}
 
-    for(unsigned int i = o; i < meta.size(); i++) {
-        m *= meta[i];
+template<typename T>
+inline
+std::size_t tensor<T>::elements() const {
+    std::size_t n = 1;
+    for(unsigned int d = 0; d < m_rank; d++) {
+        n *= m_shape[d];
     }
+    return n;
+}
 
-    return m;
+template<typename T>
+inline
+bool tensor<T>::contiguous() const {
+    std::ptrdiff_t n = 1;
+    for(int d = int(m_rank) - 1; d >= 0; d--) {
+        if(m_shape[d] != 1 && m_stride[d] != n)
+            return false;
+        n *= m_shape[d];
+    }
+    return true;
 }
 
 template<typename T>
@@ -208,80 +535,280 @@ tensor<T>& tensor<T>::operator=(const T& t) {
     if(rank())
         throw mismatch();
 
-    data[0] = t;
+    m_data[m_offset] = t;
 
     return *this;
 }
 
+template<typename T>
+inline
+void tensor<T>::fill(const T& t) {
+    zip(*this, *this, *this, [&](T& c, const T&, const T&) { c = t; });
+}
 
-template<typename T>    
+template<typename T>
 inline
-tensor<T> operator^(const tensor<T>& a, const tensor<T>& b) {
-    if(a.rank() == 2 && b.rank() == 2) {
-        if(a.size(1) != b.size(0))
-            throw typename tensor<T>::mismatch();
+T* tensor<T>::data() {
+    return m_data.data() + m_offset;
+}
 
-        // inner product of two matricies is a matrix with as many rows as the first and columns as the second
-        tensor<T> ret(2, a.size(0), b.size(1));
+template<typename T>
+inline
+const T* tensor<T>::data() const {
+    return m_data.data() + m_offset;
+}
 
-        for(unsigned int j = 0; j < b.size(1); j++) {
-            for(unsigned int i = 0; i < a.size(0); i++) {
-                ret[i][j] = 0;
-                for(unsigned int k = 0; k < a.size(1); k++) {
-                    ret[i][j] += (a[i][k] * b[k][j]);
-                }
-            }
+template<typename T>
+inline
+bool tensor<T>::flatten(unsigned int begin, unsigned int end, std::ptrdiff_t& stride) const {
+    stride = 0;
+    std::ptrdiff_t next = 0;
+    for(int d = int(end) - 1; d >= int(begin); d--) {
+        if(m_shape[d] == 1)
+            continue;
+        if(!stride) {
+            stride = m_stride[d];
+            if(stride <= 0)
+                return false;
+        } else if(m_stride[d] != next) {
+            return false;
         }
+        next = m_stride[d] * m_shape[d];
+    }
+    return true;
+}
+
+template<typename T>
+inline
+bool tensor<T>::gemm_layout(unsigned int split, bool& rowmajor, unsigned int& ld) const {
+    std::size_t rows = 1, cols = 1;
+    for(unsigned int d = 0; d < m_rank; d++) {
+        (d < split ? rows : cols) *= m_shape[d];
+    }
 
-        return ret;
-    } else {
-        throw typename tensor<T>::not_implemented();
+    std::ptrdiff_t rs, cs;
+    if(!flatten(0, split, rs) || !flatten(split, m_rank, cs))
+        return false;
 
-        // inner product is a tensor with rank equal to sum of args' ranks - 2
-        buffer<unsigned int> meta(a.rank() + b.rank() - 2);
-        buffer<T> data();
-        tensor<T> ret(meta, data);
-    
-        return ret;
+    if(cols == 1 || cs == 1) {
+        rowmajor = true;
+        ld = (rows == 1 ? cols : rs);
+        return rows == 1 || std::size_t(rs) >= cols;
+    }
+    if(rows == 1 || rs == 1) {
+        rowmajor = false;
+        ld = (cols == 1 ? rows : cs);
+        return cols == 1 || std::size_t(cs) >= rows;
     }
+    return false;
 }
 
 
-template<typename T>    
+template<typename T, typename F>
 inline
-tensor<T> operator*(const tensor<T>& a, const tensor<T>& b) {
-    // outer product is a tensor with rank equal to sum of args' ranks
-    buffer<unsigned int> meta(a.rank() + b.rank());
-    buffer<T> data(a.meta.product() * b.meta.product());
-    tensor<T> ret(meta, data);
-
-    if(a.rank() == 1 && b.rank() == 1) {
-        meta[0] = a.size(0);
-        meta[1] = b.size(0);
-
-        for(unsigned int i = 0; i < a.size(); i++) {
-            for(unsigned int j = 0; j < b.size(); j++) {
-                ret[i][j] = (a[i] * b[j]);
+void zip(tensor<T>& c, const tensor<T>& a, const tensor<T>& b, F f) {
+    const unsigned int r = c.rank();
+    if(a.shape() != c.shape() || b.shape() != c.shape())
+        throw typename tensor<T>::mismatch();
+
+    T* pc = c.data();
+    const T* pa = a.data();
+    const T* pb = b.data();
+    if(r == 0) {
+        f(*pc, *pa, *pb);
+        return;
+    }
+
+    // odometer over every axis but the last, a strided loop along it
+    const unsigned int n = c.size(r - 1);
+    const std::size_t total = c.elements();
+    const std::size_t outer = (n ? total / n : 0);
+    const std::ptrdiff_t sc = c.stride(r - 1), sa = a.stride(r - 1), sb = b.stride(r - 1);
+    const std::size_t grain = std::max<std::size_t>(1, ELEMENTWISE_GRAIN / std::max(n, 1u));
+
+    parallel_for(outer, grain, [&](std::size_t begin, std::size_t end) {
+            unsigned int index[tensor<T>::MAX_RANK];
+            std::size_t x = begin;
+            for(int d = int(r) - 2; d >= 0; d--) {
+                index[d] = x % c.size(d);
+                x /= c.size(d);
+            }
+
+            for(std::size_t o = begin; o < end; o++) {
+                std::ptrdiff_t oc = 0, oa = 0, ob = 0;
+                for(unsigned int d = 0; d + 1 < r; d++) {
+                    oc += index[d] * c.stride(d);
+                    oa += index[d] * a.stride(d);
+                    ob += index[d] * b.stride(d);
+                }
+
+                for(unsigned int j = 0; j < n; j++) {
+                    f(pc[oc + j * sc], pa[oa + j * sa], pb[ob + j * sb]);
+                }
+
+                for(int d = int(r) - 2; d >= 0; d--) {
+                    if(++index[d] < c.size(d))
+                        break;
+                    index[d] = 0;
+                }
             }
+        }, total);
+}
+
+template<typename T>
+inline
+std::vector<unsigned int> broadcast_shape(const tensor<T>& a, const tensor<T>& b) {
+    const unsigned int r = std::max(a.rank(), b.rank());
+    std::vector<unsigned int> ret(r);
+    for(unsigned int d = 0; d < r; d++) {
+        const unsigned int x = (d + a.rank() >= r ? a.size(d + a.rank() - r) : 1);
+        const unsigned int y = (d + b.rank() >= r ? b.size(d + b.rank() - r) : 1);
+        if(x != y && x != 1 && y != 1)
+            throw typename tensor<T>::mismatch();
+        ret[d] = (x == 1 ? y : x);
+    }
+    return ret;
+}
+
+template<typename T>
+inline
+tensor<T> contract(const tensor<T>& a, const tensor<T>& b,
+                   const std::vector<std::pair<unsigned int, unsigned int> >& axes) {
+    const unsigned int c = axes.size();
+    if(c > a.rank() || c > b.rank() || a.rank() + b.rank() - 2 * c > tensor<T>::MAX_RANK)
+        throw typename tensor<T>::mismatch();
+
+    // a becomes (free..., contracted...) and b (contracted..., free...)
+    bool used_a[tensor<T>::MAX_RANK] = { false };
+    bool used_b[tensor<T>::MAX_RANK] = { false };
+    std::vector<unsigned int> pa, pb, shape;
+    std::size_t k = 1;
+    for(auto& x : axes) {
+        if(x.first >= a.rank() || x.second >= b.rank() || used_a[x.first] || used_b[x.second] ||
+           a.size(x.first) != b.size(x.second))
+            throw typename tensor<T>::mismatch();
+        used_a[x.first] = used_b[x.second] = true;
+        k *= a.size(x.first);
+    }
+
+    std::size_t m = 1, n = 1;
+    for(unsigned int d = 0; d < a.rank(); d++) {
+        if(!used_a[d]) {
+            pa.push_back(d);
+            shape.push_back(a.size(d));
+            m *= a.size(d);
+        }
+    }
+    for(auto& x : axes) {
+        pa.push_back(x.first);
+        pb.push_back(x.second);
+    }
+    for(unsigned int d = 0; d < b.rank(); d++) {
+        if(!used_b[d]) {
+            pb.push_back(d);
+            shape.push_back(b.size(d));
+            n *= b.size(d);
         }
+    }
+
+    tensor<T> va = a.transpose(pa);
+    tensor<T> vb = b.transpose(pb);
+    tensor<T> ret(shape, UNINITIALIZED);
 
-    } else {
-        throw typename tensor<T>::not_implemented();
+    bool ra, rb;
+    unsigned int lda, ldb;
+    if(!va.gemm_layout(a.rank() - c, ra, lda)) {
+        va = va.copy();
+        va.gemm_layout(a.rank() - c, ra, lda);
     }
-    
+    if(!vb.gemm_layout(c, rb, ldb)) {
+        vb = vb.copy();
+        vb.gemm_layout(c, rb, ldb);
+    }
+
+    // ret is row-major m x n, which gemm sees as the column-major n x m
+    // transpose, so compute that as op(b)^T * op(a)^T
+    kernel::gemm(!rb, !ra, n, m, k, T(1), vb.data(), ldb, va.data(), lda, T(0), ret.data(), n);
+
     return ret;
 }
 
-template<typename T>    
+template<typename T>
+inline
+tensor<T> operator^(const tensor<T>& a, const tensor<T>& b) {
+    if(!a.rank() || !b.rank())
+        throw typename tensor<T>::mismatch();
+
+    return contract(a, b, { std::make_pair(a.rank() - 1, 0u) });
+}
+
+template<typename T>
+inline
+tensor<T> operator*(const tensor<T>& a, const tensor<T>& b) {
+    return contract(a, b, {});
+}
+
+template<typename T, typename F>
+inline
+tensor<T> elementwise(const tensor<T>& a, const tensor<T>& b, F f) {
+    std::vector<unsigned int> shape = broadcast_shape(a, b);
+    tensor<T> ret(shape, UNINITIALIZED);
+    zip(ret, a.broadcast(shape), b.broadcast(shape), f);
+    return ret;
+}
+
+template<typename T>
+inline
+tensor<T> operator+(const tensor<T>& a, const tensor<T>& b) {
+    return elementwise(a, b, [](T& c, const T& x, const T& y) { c = x + y; });
+}
+
+template<typename T>
+inline
+tensor<T> operator-(const tensor<T>& a, const tensor<T>& b) {
+    return elementwise(a, b, [](T& c, const T& x, const T& y) { c = x - y; });
+}
+
+template<typename T>
+inline
+tensor<T> hadamard(const tensor<T>& a, const tensor<T>& b) {
+    return elementwise(a, b, [](T& c, const T& x, const T& y) { c = x * y; });
+}
+
+template<typename T>
+inline
+tensor<T> operator*(const tensor<T>& a, const T& s) {
+    return elementwise(a, a, [&](T& c, const T& x, const T&) { c = x * s; });
+}
+
+template<typename T>
+inline
+tensor<T> operator*(const T& s, const tensor<T>& a) {
+    return a * s;
+}
+
+template<typename T>
+inline
 bool operator==(const tensor<T>& a, const tensor<T>& b) {
-    return (a.rank() == b.rank());
+    if(a.shape() != b.shape())
+        return false;
+
+    // a stands in for the output, which is never written
+    std::atomic<bool> equal(true);
+    tensor<T> view(a);
+    zip(view, a, b, [&](T&, const T& x, const T& y) {
+            if(x != y)
+                equal.store(false, std::memory_order_relaxed);
+        });
+    return equal;
 }
 
 template<typename T>
-bool operator!=(const tensor<T>& a, const T& b) {
+inline
+bool operator!=(const tensor<T>& a, const tensor<T>& b) {
     return !(a == b);
 }
-    
+
 
 }
 }
@@ -34,14 +34,18 @@ namespace jlib {
     namespace net {
 
         Email::Email() 
-            : m_is_loaded(false),
+            : m_sort_time(0),
+              m_data_size(0),
+              m_is_loaded(false),
               m_indx(-1)
         { 
             m_sort = "DATE"; 
         }
 
         Email::Email(std::string is) 
-            : m_is_loaded(false),
+            : m_sort_time(0),
+              m_data_size(0),
+              m_is_loaded(false),
               m_indx(-1)
         {
             create(is);
@@ -102,6 +106,8 @@ namespace jlib {
                 set("CONTENT-TYPE","text/plain");
             }
 
+            update_sort_key();
+
             std::string type = find("CONTENT-TYPE");
 
             if(getenv("JLIB_NET_EMAIL_DEBUG")) {
@@ -211,24 +217,33 @@ namespace jlib {
         }
         
         bool operator<(const Email& j1, const Email& j2) {
-            std::string s1 = j1[j1.m_sort];
-            std::string s2 = j2[j2.m_sort];
-            
             if(j1.m_sort == "DATE" && j2.m_sort == "DATE") {
-                jlib::util::Date d1; d1.set(s1);
-                jlib::util::Date d2; d2.set(s2);
-                //cout << d1.time() << " -- " << d2.time() << endl;
-                return d1.time() < d2.time();
+                return j1.m_sort_time < j2.m_sort_time;
             }
             else if(j1.m_sort == "SIZE" && j2.m_sort == "SIZE") {
                 return (j1.get_data_size() < j2.get_data_size());
             }
-            //cout << "Testing operator< on '" << s1.c_str() << "' and '" << s2.c_str() << "'\n";
-            return (s1 < s2);
+            return (j1.m_sort_key < j2.m_sort_key);
         }
         
         void Email::sort(std::string field) {
             m_sort = field;
+            update_sort_key();
+        }
+
+        void Email::update_sort_key() {
+            m_sort_key = m_headers[m_sort];
+            m_sort_time = 0;
+
+            if(m_sort == "DATE" && m_sort_key != "") {
+                try {
+                    jlib::util::Date d;
+                    d.set(m_sort_key);
+                    m_sort_time = d.time();
+                } catch(std::exception& e) {
+                    // unparseable dates sort first
+                }
+            }
         }
         
         std::vector<Email>& Email::attach() {
@@ -256,10 +271,14 @@ namespace jlib {
         void Email::set(std::string key,std::string val) {
             //std::multimap<std::string,std::string>::const_iterator i = m_headers.lower_bound(key);
             m_headers.set(key,val);
+            if(jlib::util::upper(key) == jlib::util::upper(m_sort))
+                update_sort_key();
         }
 
         void Email::add(std::string key,std::string val) {
             m_headers.add(key,val);
+            if(jlib::util::upper(key) == jlib::util::upper(m_sort))
+                update_sort_key();
         }
 
         void Email::set_flag(flag_type flag) {
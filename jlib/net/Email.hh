@@ -28,6 +28,8 @@
 #include <string>
 #include <set>
 
+#include <ctime>
+
 #include <jlib/util/Headers.hh>
 
 namespace jlib {
@@ -84,6 +86,11 @@ namespace jlib {
             
             void create(std::string is);
 
+            Email(const Email&) = default;
+            Email(Email&&) = default;
+            Email& operator=(const Email&) = default;
+            Email& operator=(Email&&) = default;
+
             /**
              * Destructor.
              */
@@ -136,6 +143,24 @@ namespace jlib {
              *
              */
             void sort(std::string field);
+
+            /**
+             * Get the DATE header as seconds since the epoch, parsed once
+             * when the headers were, or 0 if it couldn't be.  Used in place
+             * of the header when sorting by DATE.
+             *
+             * @return sort time
+             */
+            time_t sort_time() const { return m_sort_time; }
+
+            /**
+             * Get the text of the header being sorted by, kept up to date
+             * by create(), set(), add() and sort().  Changes made through
+             * headers() aren't seen; call sort() again after them.
+             *
+             * @return sort key
+             */
+            const std::string& sort_key() const { return m_sort_key; }
             
             /**
              * Get the headers for this email.
@@ -218,8 +243,11 @@ namespace jlib {
         protected:
             std::string get_text(bool html, bool render, bool globbed, bool recurse) const;
             bool check(std::string buf);
+            void update_sort_key();
             
             std::string m_sort;
+            std::string m_sort_key;
+            time_t m_sort_time;
             std::string m_raw;
             
             std::vector<std::string> m_bounds;
@@ -21,6 +21,7 @@
 #include <jlib/net/MailFolder.hh>
 
 #include <algorithm>
+#include <utility>
 
 namespace jlib {
     namespace net {
@@ -111,7 +112,25 @@ namespace jlib {
         }
         
         void MailFolder::sort() {
-            std::sort(begin(),end());
+            // order positions by the emails' cached sort keys, then move
+            // each email into place once, rather than swapping whole
+            // emails about for every comparison
+            std::vector<size_type> order(size());
+            for(size_type i = 0; i < order.size(); i++) {
+                order[i] = i;
+            }
+
+            iterator mails = begin();
+            std::sort(order.begin(), order.end(), [mails](size_type a, size_type b) {
+                    return mails[a] < mails[b];
+                });
+
+            rep_type sorted;
+            sorted.reserve(order.size());
+            for(size_type i = 0; i < order.size(); i++) {
+                sorted.push_back(std::move(mails[order[i]]));
+            }
+            std::move(sorted.begin(), sorted.end(), mails);
         }
         
         void MailFolder::filter() {
@@ -0,0 +1,113 @@
+/* -*- mode: C++ c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2026 Joey Yandle <xoloki@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+#ifndef JLIB_SYS_MAPPING_HH
+#define JLIB_SYS_MAPPING_HH
+
+#include <exception>
+#include <memory>
+#include <string>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace jlib {
+namespace sys {
+
+class mapping_exception : public std::exception {
+public:
+    mapping_exception(std::string msg = "") {
+        m_msg = "mapping exception: "+msg;
+    }
+    virtual ~mapping_exception() throw() {}
+    virtual const char* what() const throw() { return m_msg.c_str(); }
+protected:
+    std::string m_msg;
+};
+
+// a whole file mapped into memory.  the mapping is private, so writes
+// through data() copy the page they touch and never reach the file, and
+// the pages nobody writes are shared with every other process mapping it
+class mapping {
+public:
+    typedef std::shared_ptr<mapping> ptr;
+
+    static ptr open(const std::string& path);
+
+    ~mapping();
+
+    char* data() { return m_data; }
+    const char* data() const { return m_data; }
+    std::size_t size() const { return m_size; }
+
+protected:
+    mapping(char* data, std::size_t size) : m_data(data), m_size(size) {}
+    mapping(const mapping&);
+
+    char* m_data;
+    std::size_t m_size;
+};
+
+
+inline
+mapping::ptr mapping::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+        throw mapping_exception(path + ": " + std::strerror(errno));
+
+    struct stat st;
+    if(fstat(fd, &st) != 0) {
+        const int err = errno;
+        ::close(fd);
+        throw mapping_exception(path + ": " + std::strerror(err));
+    }
+
+    const std::size_t size = st.st_size;
+    void* data = nullptr;
+    if(size > 0) {
+        data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if(data == MAP_FAILED) {
+            const int err = errno;
+            ::close(fd);
+            throw mapping_exception(path + ": " + std::strerror(err));
+        }
+    }
+
+    // the mapping holds its own reference to the file
+    ::close(fd);
+    return ptr(new mapping(static_cast<char*>(data), size));
+}
+
+inline
+mapping::~mapping() {
+    if(m_data)
+        munmap(m_data, m_size);
+}
+
+}
+}
+
+#endif //JLIB_SYS_MAPPING_HH
@@ -0,0 +1,177 @@
+/* -*- mode: C++ c-basic-offset: 4  -*-
+ *
+ * Copyright (c) 2026 Joey Yandle <xoloki@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+#ifndef JLIB_SYS_SOCKETSERVER_HH
+#define JLIB_SYS_SOCKETSERVER_HH
+
+#include <exception>
+#include <string>
+
+#include <cstring>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+
+namespace jlib {
+    namespace sys {
+
+        // the listening end of a stream socket, on a tcp port or a unix
+        // domain path.  accept gives descriptors for socketstream(int)
+        class socketserver {
+        public:
+            class exception : public std::exception {
+            public:
+                exception(std::string msg = "") {
+                    m_msg = "socketserver exception: "+msg;
+                }
+                virtual ~exception() throw() {}
+                virtual const char* what() const throw() { return m_msg.c_str(); }
+            protected:
+                std::string m_msg;
+            };
+
+            static const int BACKLOG = 128;
+
+            // host is an address to bind to, or "" for all of them; port 0
+            // picks a free one, which port() then gives
+            socketserver(std::string host, unsigned int port) {
+                m_sock = -1;
+                open_socket(host, port);
+            }
+
+            // a unix domain socket, replacing anything already at path
+            explicit socketserver(std::string path) {
+                m_sock = -1;
+                open_local(path);
+            }
+
+            ~socketserver() {
+                close();
+            }
+
+            // the next connection, or -1 once the server is closed.  tcp
+            // connections have nagle turned off, since requests are small
+            int accept() {
+                while(true) {
+                    int sock = ::accept(m_sock, NULL, NULL);
+                    if(sock >= 0) {
+                        if(m_path.empty()) {
+                            int one = 1;
+                            setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                        }
+                        fcntl(sock, F_SETFD, 1);
+                        return sock;
+                    }
+                    if(errno != EINTR && errno != ECONNABORTED)
+                        return -1;
+                }
+            }
+
+            // wake any accept and stop listening
+            void close() {
+                if(m_sock != -1) {
+                    shutdown(m_sock, SHUT_RDWR);
+                    ::close(m_sock);
+                    m_sock = -1;
+                    if(!m_path.empty())
+                        unlink(m_path.c_str());
+                }
+            }
+
+            unsigned int port() const { return m_port; }
+
+            int get_socket() { return m_sock; }
+
+        protected:
+            socketserver(const socketserver&);
+
+            void open_socket(std::string host, unsigned int port) {
+                struct sockaddr_in sa;
+                std::memset(&sa,0,sizeof(sa));
+                sa.sin_family = AF_INET;
+                sa.sin_port = htons((u_short)port);
+                if(host.empty()) {
+                    sa.sin_addr.s_addr = htonl(INADDR_ANY);
+                } else if(inet_pton(AF_INET, host.c_str(), &sa.sin_addr) != 1) {
+                    throw exception("not an address: "+host);
+                }
+
+                if( (m_sock=socket(AF_INET,SOCK_STREAM,0)) < 0 ) {
+                    throw exception("error in socket()");
+                }
+
+                int one = 1;
+                setsockopt(m_sock, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+                listen_on(reinterpret_cast<struct sockaddr*>(&sa), sizeof(sa), host+":"+std::to_string(port));
+
+                socklen_t len = sizeof(sa);
+                getsockname(m_sock, reinterpret_cast<struct sockaddr*>(&sa), &len);
+                m_port = ntohs(sa.sin_port);
+            }
+
+            void open_local(std::string path) {
+                struct sockaddr_un sa;
+                std::memset(&sa,0,sizeof(sa));
+                if(path.size() >= sizeof(sa.sun_path)) {
+                    throw exception("socket path too long: "+path);
+                }
+                sa.sun_family = AF_UNIX;
+                std::strcpy(sa.sun_path, path.c_str());
+
+                if( (m_sock=socket(AF_UNIX,SOCK_STREAM,0)) < 0 ) {
+                    throw exception("error in socket()");
+                }
+
+                unlink(path.c_str());
+                listen_on(reinterpret_cast<struct sockaddr*>(&sa), sizeof(sa), path);
+                m_path = path;
+                m_port = 0;
+            }
+
+            void listen_on(struct sockaddr* sa, socklen_t len, std::string where) {
+                if(bind(m_sock, sa, len) < 0 || listen(m_sock, BACKLOG) < 0) {
+                    std::string err = std::strerror(errno);
+                    ::close(m_sock);
+                    m_sock = -1;
+                    throw exception("cannot listen on " + where + ": " + err);
+                }
+
+                if(fcntl(m_sock, F_SETFD, 1) == -1) {
+                    throw exception("error calling fcntl(sock, F_SETFD, 1)");
+                }
+            }
+
+            std::string m_path;
+            unsigned int m_port;
+            int m_sock;
+        };
+
+    }
+}
+
+
+#endif // JLIB_SYS_SOCKETSERVER_HH
@@ -34,6 +34,7 @@
 #include <netinet/in.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/un.h>
 #include <netdb.h>
 #include <unistd.h>
 #include <fcntl.h>
@@ -65,13 +66,7 @@ namespace jlib {
             static const unsigned int BUF_SIZE = 1024;
 
             basic_socketbuf(std::string host, unsigned int port) {
-                char_type* tmp;
-                
-                tmp = new char_type[BUF_SIZE];
-                this->setg(tmp,tmp,tmp);
-                
-                tmp = new char_type[BUF_SIZE];
-                this->setp(tmp,tmp+BUF_SIZE);
+                init_buffers();
                 
                 //_M_mode = (std::ios_base::in | std::ios_base::out);
                 
@@ -79,6 +74,22 @@ namespace jlib {
                 open_socket(host,port);
             }
 
+            // a unix domain socket at path
+            explicit basic_socketbuf(std::string path) {
+                init_buffers();
+                m_eintr = false;
+                open_local(path);
+            }
+
+            // a socket that is already connected, such as one from accept(2);
+            // it is closed with the buffer
+            explicit basic_socketbuf(int sock) {
+                init_buffers();
+                m_eintr = false;
+                m_port = 0;
+                m_sock = sock;
+            }
+
             virtual ~basic_socketbuf() {
                 if(std::getenv("JLIB_SYS_SOCKET_DEBUG"))
                     std::cerr << "basic_socketbuf::~basic_socketbuf()"<<std::endl;
@@ -175,6 +186,47 @@ namespace jlib {
             int get_socket() { return m_sock; }
             
         protected:
+            void init_buffers() {
+                char_type* tmp;
+                
+                tmp = new char_type[BUF_SIZE];
+                this->setg(tmp,tmp,tmp);
+                
+                tmp = new char_type[BUF_SIZE];
+                this->setp(tmp,tmp+BUF_SIZE);
+            }
+
+            void open_local(std::string path) {
+                m_host = path;
+                m_port = 0;
+
+                struct sockaddr_un sa;
+                std::memset(&sa,0,sizeof(sa));
+                if(path.size() >= sizeof(sa.sun_path)) {
+                    m_sock = -1;
+                    throw exception("socket path too long: "+path);
+                }
+                sa.sun_family = AF_UNIX;
+                std::strcpy(sa.sun_path, path.c_str());
+
+                if( (m_sock=socket(AF_UNIX,SOCK_STREAM,0)) < 0 ) {
+                    throw exception("error in socket()");
+                }
+
+                if(connect(m_sock,reinterpret_cast<struct sockaddr*>(&sa),sizeof(sa)) < 0) {
+                    if(errno == EINTR) {
+                        m_eintr = true;
+                    }
+                    ::close(m_sock);
+                    m_sock = -1;
+                    throw exception("error connecting to " + path);
+                }
+
+                if(fcntl(m_sock, F_SETFD, 1) == -1) {
+                    throw exception("error calling fcntl(sock, F_SETFD, 1)");
+                }
+            }
+
             void open_socket(std::string host, unsigned int port) {
                 m_host = host;
                 m_port = port;
@@ -254,6 +306,20 @@ namespace jlib {
                     delete m_buf;
             }
             
+            explicit basic_socketstream(std::string path)
+                : std::basic_iostream<charT,traitT>(NULL)
+            {
+                m_buf=new basic_socketbuf<charT,traitT>(path);
+                this->init(m_buf);
+            }
+
+            explicit basic_socketstream(int sock)
+                : std::basic_iostream<charT,traitT>(NULL)
+            {
+                m_buf=new basic_socketbuf<charT,traitT>(sock);
+                this->init(m_buf);
+            }
+
             void open(std::string host, unsigned int port) {
                 if(m_buf != 0)
                     delete m_buf;
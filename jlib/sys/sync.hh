@@ -28,6 +28,9 @@
 #include <exception>
 #include <string>
 #include <queue>
+#include <deque>
+#include <vector>
+#include <memory>
 #include <atomic>
 #include <functional>
 
@@ -168,6 +171,178 @@ protected:
     std::vector<std::thread> m_pool;
     std::atomic<bool> m_exit;
 };
+
+// a fixed set of workers, each with its own deque of tasks.  a worker pops
+// from the back of its own deque and steals from the front of the others
+// when it runs dry.  run() blocks until a whole batch is done, and the
+// calling thread steals work too rather than sitting idle.
+class pool {
+public:
+    pool(unsigned int size = std::thread::hardware_concurrency()) {
+        m_exit = false;
+        m_pending = 0;
+
+        for(unsigned int i = 0; i < size; i++) {
+            m_queues.push_back(std::unique_ptr<worker_queue>(new worker_queue()));
+        }
+        for(unsigned int i = 0; i < size; i++) {
+            m_pool.push_back(std::thread([this, i](){ start(i); }));
+        }
+    }
+
+    ~pool() {
+        {
+            std::unique_lock<std::mutex> lock(m_sleep);
+            m_exit = true;
+        }
+        m_wake.notify_all();
+
+        for(auto& thread : m_pool) {
+            thread.join();
+        }
+    }
+
+    unsigned int size() const {
+        return m_pool.size();
+    }
+
+    // call job(i) for every i in [0, n) and wait for all of them.  the first
+    // exception thrown by a job is rethrown here once the batch has drained.
+    // calls made from inside a job run inline so nested use can't deadlock
+    void run(std::size_t n, std::function<void(std::size_t)> job) {
+        if(n == 0)
+            return;
+
+        if(m_pool.empty() || n == 1 || current() == this) {
+            for(std::size_t i = 0; i < n; i++) {
+                job(i);
+            }
+            return;
+        }
+
+        batch b(job, n);
+
+        // count the tasks before they become visible so pending never underflows
+        {
+            std::unique_lock<std::mutex> lock(m_sleep);
+            m_pending += n;
+        }
+
+        for(std::size_t i = 0; i < n; i++) {
+            worker_queue& q = *m_queues[i % m_queues.size()];
+            std::unique_lock<std::mutex> lock(q.lock);
+            q.tasks.push_back(task{&b, i});
+        }
+        m_wake.notify_all();
+
+        task t;
+        while(steal(0, t)) {
+            execute(t);
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(b.lock);
+            b.done.wait(lock, [&b](){ return b.left == 0; });
+        }
+
+        if(b.error)
+            std::rethrow_exception(b.error);
+    }
+
+protected:
+    struct batch {
+        batch(std::function<void(std::size_t)>& j, std::size_t n) : job(j), left(n) {}
+
+        std::function<void(std::size_t)>& job;
+        std::size_t left;
+        std::exception_ptr error;
+        std::mutex lock;
+        std::condition_variable done;
+    };
+
+    struct task {
+        batch* b;
+        std::size_t i;
+    };
+
+    struct worker_queue {
+        std::mutex lock;
+        std::deque<task> tasks;
+    };
+
+    static pool*& current() {
+        static thread_local pool* p = nullptr;
+        return p;
+    }
+
+    bool pop(unsigned int i, task& t) {
+        worker_queue& q = *m_queues[i];
+        std::unique_lock<std::mutex> lock(q.lock);
+        if(q.tasks.empty())
+            return false;
+
+        t = q.tasks.back();
+        q.tasks.pop_back();
+        m_pending--;
+        return true;
+    }
+
+    // look through every deque starting after the given one
+    bool steal(unsigned int from, task& t) {
+        for(unsigned int j = 0; j < m_queues.size(); j++) {
+            worker_queue& q = *m_queues[(from + j) % m_queues.size()];
+            std::unique_lock<std::mutex> lock(q.lock);
+            if(!q.tasks.empty()) {
+                t = q.tasks.front();
+                q.tasks.pop_front();
+                m_pending--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void execute(const task& t) {
+        batch& b = *t.b;
+        try {
+            b.job(t.i);
+        } catch(...) {
+            std::unique_lock<std::mutex> lock(b.lock);
+            if(!b.error)
+                b.error = std::current_exception();
+        }
+
+        // notify under the lock: the batch lives on the caller's stack and
+        // may be gone the moment it can see left reach zero
+        std::unique_lock<std::mutex> lock(b.lock);
+        if(--b.left == 0)
+            b.done.notify_all();
+    }
+
+    void start(unsigned int i) {
+        current() = this;
+
+        while(true) {
+            task t;
+            if(pop(i, t) || steal(i + 1, t)) {
+                execute(t);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_sleep);
+            m_wake.wait(lock, [this](){ return m_exit || m_pending > 0; });
+            if(m_exit)
+                return;
+        }
+    }
+
+    std::vector<std::unique_ptr<worker_queue>> m_queues;
+    std::vector<std::thread> m_pool;
+    std::mutex m_sleep;
+    std::condition_variable m_wake;
+    std::atomic<std::size_t> m_pending;
+    bool m_exit;
+};
     
 }
 }
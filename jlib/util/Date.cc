@@ -24,6 +24,7 @@
 #include <iostream>
 #include <iomanip>
 #include <vector>
+#include <algorithm>
 
 #include <cctype>
 #include <cstring>
@@ -41,12 +42,163 @@ const char* long_weekdays[] = { "Sunday", "Monday", "Tuesday", "Wednesday", "Thu
 const int MONTH_MAX=12;
 const int WEEK_MAX=8;
 
+namespace {
+    // minutes east of UTC, sorted by name for the binary search in
+    // find_zone.  the RFC 2822 zones and the ones mail commonly carries
+    struct tz_entry {
+        const char* name;
+        int offset;
+    };
+
+    const tz_entry tz_table[] = {
+        { "ADT", -180 }, { "AKDT", -480 }, { "AKST", -540 }, { "AST", -240 },
+        { "BST", 60 }, { "CDT", -300 }, { "CEST", 120 }, { "CET", 60 },
+        { "CST", -360 }, { "EDT", -240 }, { "EEST", 180 }, { "EET", 120 },
+        { "EST", -300 }, { "GMT", 0 }, { "HST", -600 }, { "JST", 540 },
+        { "KST", 540 }, { "MDT", -360 }, { "MEST", 120 }, { "MET", 60 },
+        { "MSK", 180 }, { "MST", -420 }, { "NZDT", 780 }, { "NZST", 720 },
+        { "PDT", -420 }, { "PST", -480 }, { "UT", 0 }, { "UTC", 0 },
+        { "WEST", 60 }, { "WET", 0 }, { "Z", 0 }
+    };
+
+    const int TZ_MAX = sizeof(tz_table) / sizeof(tz_table[0]);
+
+    // writes a zone offset as +hhmm or -hhmm
+    void put_zone(std::ostream& os, int offset) {
+        os << (offset < 0 ? '-' : '+') << std::setfill('0')
+           << std::setw(2) << std::abs(offset) / 60
+           << std::setw(2) << std::abs(offset) % 60;
+    }
+
+    // the n chars at p, which Date::parse reads without copying
+    struct text {
+        const char* p;
+        std::size_t n;
+
+        std::size_t size() const { return n; }
+        char operator[](std::size_t i) const { return p[i]; }
+    };
+
+    // the pieces of the fast path in Date::parse.  each takes the position
+    // i in s, and moves it past what it reads
+    bool is_space(char c) {
+        return (c == ' ' || c == '\t' || c == '\r' || c == '\n');
+    }
+
+    bool is_num(char c) {
+        return (c >= '0' && c <= '9');
+    }
+
+    bool is_letter(char c) {
+        return ((c|0x20) >= 'a' && (c|0x20) <= 'z');
+    }
+
+    // true if there was any whitespace to skip
+    bool skip_space(text s, std::size_t& i) {
+        const std::size_t j = i;
+        while(i < s.size() && is_space(s[i]))
+            i++;
+        return (i > j);
+    }
+
+    text letters(text s, std::size_t& i) {
+        const std::size_t j = i;
+        while(i < s.size() && is_letter(s[i]))
+            i++;
+        text w = { s.p + j, i - j };
+        return w;
+    }
+
+    // between one and max digits; returns how many were read
+    int read_number(text s, std::size_t& i, int max, int& v) {
+        int n = 0;
+        v = 0;
+        while(n < max && i < s.size() && is_num(s[i])) {
+            v = v * 10 + (s[i++] - '0');
+            n++;
+        }
+        return n;
+    }
+
+    // the index of w in names, matching three letters without case
+    int lookup(text w, const char** names, int max) {
+        if(w.size() != 3)
+            return -1;
+        for(int k = 0; k < max; k++) {
+            if(std::tolower(w[0]) == std::tolower(names[k][0]) &&
+               std::tolower(w[1]) == std::tolower(names[k][1]) &&
+               std::tolower(w[2]) == std::tolower(names[k][2]))
+                return k;
+        }
+        return -1;
+    }
+
+    // two or four digits, as %y and %Y
+    bool read_year(text s, std::size_t& i, struct tm* t) {
+        int v;
+        switch(read_number(s, i, 4, v)) {
+        case 4:
+            t->tm_year = v - 1900;
+            return true;
+        case 2:
+            t->tm_year = (v < 70 ? 100 + v : v);
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // hh:mm or hh:mm:ss
+    bool read_clock(text s, std::size_t& i, struct tm* t) {
+        if(read_number(s, i, 2, t->tm_hour) == 0 || i >= s.size() || s[i] != ':')
+            return false;
+        i++;
+        if(read_number(s, i, 2, t->tm_min) != 2)
+            return false;
+        if(i < s.size() && s[i] == ':') {
+            i++;
+            if(read_number(s, i, 2, t->tm_sec) != 2)
+                return false;
+        }
+        return (t->tm_hour < 24 && t->tm_min < 60 && t->tm_sec <= 60);
+    }
+
+    // +hhmm, -hhmm or a name from tz_table
+    bool read_zone(text s, std::size_t& i, int& offset) {
+        if(i < s.size() && (s[i] == '+' || s[i] == '-')) {
+            const bool west = (s[i++] == '-');
+            int v;
+            if(read_number(s, i, 4, v) != 4 || v % 100 >= 60)
+                return false;
+            offset = (v / 100) * 60 + v % 100;
+            if(west)
+                offset = -offset;
+            return true;
+        }
+        const text w = letters(s, i);
+        return jlib::util::Date::find_zone(w.p, w.n, &offset);
+    }
+
+    // a parenthesized comment, which may nest
+    bool skip_comment(text s, std::size_t& i) {
+        int depth = 0;
+        do {
+            if(i >= s.size())
+                return false;
+            if(s[i] == '(')
+                depth++;
+            else if(s[i] == ')')
+                depth--;
+            i++;
+        } while(depth > 0);
+        return true;
+    }
+}
+
 namespace jlib {
     namespace util {
         Date::Date() {
             m_time = new struct tm;
-            m_tz_name = create_tz_names();
-            m_tz_val = create_tz_vals();
             set();
         }
         
@@ -213,9 +365,12 @@ namespace jlib {
             case 'X':
                 os << build_date("%H:%M:%S");
                 break;
-            case 'z':
-                os << static_cast< std::map<std::string,std::string> >(m_tz_name)[tzname[0]] ;
+            case 'z': {
+                int offset;
+                if(find_zone(tzname[0], std::strlen(tzname[0]), &offset))
+                    put_zone(os, offset);
                 break;
+            }
             case 'Z':
                 os << tzname[0] ;
                 break;
@@ -508,14 +663,102 @@ namespace jlib {
             build_date(is2,fmt);
         }
         
+        bool Date::parse(const char* p, std::size_t n, struct tm* t, int* offset) {
+            const text s = { p, n };
+            std::memset(t, 0, sizeof(struct tm));
+            int tz = 0;
+            std::size_t i = 0;
+
+            skip_space(s, i);
+            text w = letters(s, i);
+
+            // the weekday is left for mktime to work out
+            if(lookup(w, short_weekdays, WEEK_MAX) >= 0) {
+                if(i < s.size() && s[i] == ',')
+                    i++;
+                skip_space(s, i);
+                w = letters(s, i);
+            }
+
+            if(w.size()) {
+                // From_ line: Mon DD HH:MM:SS [zone] YYYY [zone]
+                if((t->tm_mon = lookup(w, short_months, MONTH_MAX)) < 0 ||
+                   !skip_space(s, i) || read_number(s, i, 2, t->tm_mday) == 0 ||
+                   !skip_space(s, i) || !read_clock(s, i, t) || !skip_space(s, i))
+                    return false;
+                if(i < s.size() && !is_num(s[i])) {
+                    if(!read_zone(s, i, tz) || !skip_space(s, i) || !read_year(s, i, t))
+                        return false;
+                }
+                else {
+                    if(!read_year(s, i, t))
+                        return false;
+                    if(skip_space(s, i) && i < s.size() && s[i] != '(' && !read_zone(s, i, tz))
+                        return false;
+                }
+            }
+            else {
+                // RFC 2822: DD Mon YYYY HH:MM[:SS] [zone]
+                if(read_number(s, i, 2, t->tm_mday) == 0 || !skip_space(s, i) ||
+                   (t->tm_mon = lookup(letters(s, i), short_months, MONTH_MAX)) < 0 ||
+                   !skip_space(s, i) || !read_year(s, i, t) ||
+                   !skip_space(s, i) || !read_clock(s, i, t))
+                    return false;
+                if(skip_space(s, i) && i < s.size() && s[i] != '(' && !read_zone(s, i, tz))
+                    return false;
+            }
+
+            skip_space(s, i);
+            if(i < s.size() && s[i] == '(' && !skip_comment(s, i))
+                return false;
+            skip_space(s, i);
+
+            if(i != s.size() || t->tm_mday < 1 || t->tm_mday > 31)
+                return false;
+            if(offset)
+                *offset = tz;
+            return true;
+        }
+        
+        bool Date::parse(const std::string& s, struct tm* t, int* offset) {
+            return parse(s.data(), s.size(), t, offset);
+        }
+        
+        bool Date::find_zone(const char* name, std::size_t n, int* offset) {
+            char buf[8];
+            if(n == 0 || n >= sizeof(buf))
+                return false;
+            for(std::size_t k = 0; k < n; k++) {
+                buf[k] = std::toupper(name[k]);
+            }
+            buf[n] = 0;
+
+            const tz_entry* end = tz_table + TZ_MAX;
+            const tz_entry* e = std::lower_bound(tz_table, end, buf, [](const tz_entry& a, const char* b) {
+                    return (std::strcmp(a.name, b) < 0);
+                });
+            if(e == end || std::strcmp(e->name, buf) != 0)
+                return false;
+            *offset = e->offset;
+            return true;
+        }
+        
+        bool Date::find_zone(const std::string& name, int* offset) {
+            return find_zone(name.data(), name.size(), offset);
+        }
+        
         std::string Date::get(std::string fmt) const {
             return build_date(fmt);
         }
         
         void Date::set(std::string s, std::string fmt) {
             //std::cout << "setting "<<s<<" to format "<<fmt<<std::endl;
-            std::memset(m_time, 0, sizeof(struct tm));
             m_current_tz = "";
+            if(fmt == "%O" && parse(s, m_time)) {
+                reinit();
+                return;
+            }
+            std::memset(m_time, 0, sizeof(struct tm));
             std::istringstream is(s);
             build_date(is,fmt);
             reinit();
@@ -631,30 +874,20 @@ namespace jlib {
         
         std::map<std::string,std::string> Date::create_tz_names() {
             std::map<std::string,std::string> ret;
-            ret["GMT"] = "+0000";
-            ret["EDT"] = "-0400";
-            ret["EST"] = "-0500";
-            ret["CDT"] = "-0500";
-            ret["CST"] = "-0600";
-            ret["MDT"] = "-0600";
-            ret["MST"] = "-0700";
-            ret["PDT"] = "-0700";
-            ret["PST"] = "-0800";
+            for(int i=0; i<TZ_MAX; i++) {
+                std::ostringstream os;
+                put_zone(os, tz_table[i].offset);
+                ret[tz_table[i].name] = os.str();
+            }
             
             return ret;
         }
         
         std::map<std::string,int> Date::create_tz_vals() {
             std::map<std::string,int> ret;
-            ret["GMT"] = 0;
-            ret["EDT"] = -4;
-            ret["EST"] = -5;
-            ret["CDT"] = -5;
-            ret["CST"] = -6;
-            ret["MDT"] = -6;
-            ret["MST"] = -7;
-            ret["PDT"] = -7;
-            ret["PST"] = -8;
+            for(int i=0; i<TZ_MAX; i++) {
+                ret[tz_table[i].name] = tz_table[i].offset / 60;
+            }
             
             return ret;
         }
@@ -22,6 +22,7 @@
 #define JLIB_UTIL_DATE_HH
 
 #include <ctime>
+#include <cstddef>
 
 #include <string>
 #include <exception>
@@ -149,6 +150,12 @@ namespace jlib {
             virtual void set(struct tm* t);
             
             virtual std::string get(std::string fmt="%a, %d %b %Y %H:%M:%S %z") const;
+
+            /**
+             * set from the string s in format fmt.  the default, %O, tries
+             * parse() first and only falls back to auto_parse for the
+             * formats it doesn't know
+             */
             virtual void set(std::string s, std::string fmt="%O");
             
             /**
@@ -194,6 +201,25 @@ namespace jlib {
              */
             void auto_parse(std::istream& is);
             
+            /**
+             * parse an RFC 2822 date ("Mon, 5 Jan 2004 12:00:00 -0500") or
+             * the date of an mbox From_ line ("Mon Jan  5 12:00:00 2004")
+             * into t, in one pass, without allocating or throwing.  the
+             * weekday, seconds and zone are optional, and a trailing
+             * comment is skipped.  offset gets the zone in minutes east of
+             * UTC, 0 if there is none.  returns false for anything else.
+             * s is n chars long, and need not be null terminated
+             */
+            static bool parse(const char* s, std::size_t n, struct tm* t, int* offset = 0);
+            static bool parse(const std::string& s, struct tm* t, int* offset = 0);
+            
+            /**
+             * look up a timezone abbreviation, i.e. "EDT" => -240 minutes,
+             * in the static zone table
+             */
+            static bool find_zone(const char* name, std::size_t n, int* offset);
+            static bool find_zone(const std::string& name, int* offset);
+            
             /**
              * reinitialize m_time by calling mktime() and localtime(), 
              * successively
@@ -256,8 +282,6 @@ namespace jlib {
             
         private:
             struct tm* m_time;
-            std::map<std::string,std::string> m_tz_name;
-            std::map<std::string,int> m_tz_val;
             
             std::string m_current_tz;
         };
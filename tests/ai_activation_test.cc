@@ -0,0 +1,236 @@
+/* -*- mode: C++ c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2026 Joey Yandle <xoloki@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+#include <jlib/ai/neural.hh>
+
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <cstdio>
+#include <unistd.h>
+
+using namespace jlib;
+
+// the vector kernels against the library's functions, at every instruction
+// set this cpu has, including the odd lengths that end in a partial vector
+template<typename T>
+bool check_kernels(double tolerance) {
+    typedef math::kernel::activations<T> k;
+    bool ok = true;
+
+    for(int i = math::kernel::SCALAR; i <= math::kernel::detect(); i++) {
+        math::kernel::set_isa(math::kernel::isa(i));
+        for(std::size_t n : { 1, 7, 33, 1001 }) {
+            std::vector<T> x(n), y(n);
+            for(std::size_t j = 0; j < n; j++) {
+                x[j] = T(-40.0 + 80.0 * j / n);
+            }
+
+            double worst[3] = { 0, 0, 0 };
+            k::exp(n, x.data(), y.data());
+            for(std::size_t j = 0; j < n; j++) {
+                const double want = std::exp(double(x[j]));
+                worst[0] = std::max(worst[0], std::fabs(y[j] - want) / want);
+            }
+            k::sigmoid(n, x.data(), y.data());
+            for(std::size_t j = 0; j < n; j++) {
+                worst[1] = std::max(worst[1], std::fabs(y[j] - 1 / (1 + std::exp(-double(x[j])))));
+            }
+            // in place, as the network uses it
+            y = x;
+            k::tanh(n, y.data(), y.data());
+            for(std::size_t j = 0; j < n; j++) {
+                worst[2] = std::max(worst[2], std::fabs(y[j] - std::tanh(double(x[j]))));
+            }
+
+            for(int f = 0; f < 3; f++) {
+                if(worst[f] > tolerance) {
+                    std::cerr << "ai_activation_test: " << math::kernel::name(math::kernel::get_isa())
+                              << " " << sizeof(T) << " byte " << (f == 0 ? "exp" : f == 1 ? "sigmoid" : "tanh")
+                              << " of " << n << " is off by " << worst[f] << std::endl;
+                    ok = false;
+                }
+            }
+        }
+    }
+
+    // near 0, tanh keeps its relative precision rather than cancelling
+    // away, and NaNs go through every kernel
+    for(int i = math::kernel::SCALAR; i <= math::kernel::detect(); i++) {
+        math::kernel::set_isa(math::kernel::isa(i));
+        const T small[7] = { T(1e-30), T(-1e-8), T(1e-4), T(-0.1), T(0.2), T(-0.26), T(0.4) };
+        T y[7];
+        k::tanh(7, small, y);
+        for(int j = 0; j < 7; j++) {
+            const double want = std::tanh(double(small[j]));
+            if(std::fabs(y[j] - want) / std::fabs(want) > tolerance) {
+                std::cerr << "ai_activation_test: " << math::kernel::name(math::kernel::get_isa())
+                          << " tanh(" << small[j] << ") = " << y[j] << std::endl;
+                ok = false;
+            }
+        }
+
+        const T nan = std::numeric_limits<T>::quiet_NaN();
+        T z[3];
+        k::exp(1, &nan, z);
+        k::sigmoid(1, &nan, z + 1);
+        k::tanh(1, &nan, z + 2);
+        if(!std::isnan(z[0]) || !std::isnan(z[1]) || !std::isnan(z[2])) {
+            std::cerr << "ai_activation_test: " << math::kernel::name(math::kernel::get_isa())
+                      << " of NaN = " << z[0] << ", " << z[1] << ", " << z[2] << std::endl;
+            ok = false;
+        }
+    }
+
+    // far out of range saturates rather than wrapping
+    T far[2] = { T(-1000), T(1000) };
+    k::sigmoid(2, far, far);
+    if(far[0] != T(0) || far[1] != T(1)) {
+        std::cerr << "ai_activation_test: sigmoid(-1000, 1000) = " << far[0] << ", " << far[1] << std::endl;
+        ok = false;
+    }
+
+    math::kernel::set_isa(math::kernel::detect());
+    return ok;
+}
+
+// backward against a central difference of sum(e ^ f(x)), which also
+// covers softmax, where each output depends on the whole column
+bool check_derivatives() {
+    std::default_random_engine generator(13);
+    std::uniform_real_distribution<double> dist(-2.0, 2.0);
+    bool ok = true;
+
+    for(const std::string& name : ai::activation<double>::names()) {
+        const ai::activation<double>& f = ai::activation<double>::get(name);
+
+        math::matrix<double> x(5, 3), e(5, 3);
+        x.foreach([&](double& v) {
+                // away from the kink in relu
+                v = dist(generator);
+                if(std::fabs(v) < 0.1)
+                    v += 0.2;
+            });
+        e.foreach([&](double& v) { v = dist(generator); });
+
+        math::matrix<double> y(5, 3), d(5, 3);
+        f.forward(x, y);
+        f.backward(e, y, d);
+
+        auto loss = [&](const math::matrix<double>& at) {
+            math::matrix<double> out(5, 3);
+            f.forward(at, out);
+            double sum = 0;
+            for(uint c = 0; c < 3; c++)
+                for(uint r = 0; r < 5; r++)
+                    sum += e(r, c) * out(r, c);
+            return sum;
+        };
+
+        const double h = 1e-6;
+        for(uint c = 0; c < 3; c++) {
+            for(uint r = 0; r < 5; r++) {
+                math::matrix<double> up{math::leaf<double>(x)};
+                math::matrix<double> down{math::leaf<double>(x)};
+                up(r, c) += h;
+                down(r, c) -= h;
+                const double want = (loss(up) - loss(down)) / (2 * h);
+                if(std::fabs(d(r, c) - want) > 1e-6) {
+                    std::cerr << "ai_activation_test: " << name << " derivative at (" << r << "," << c << ") is "
+                              << d(r, c) << " expected " << want << std::endl;
+                    ok = false;
+                }
+            }
+        }
+    }
+
+    try {
+        ai::activation<double>::get("no such function");
+        std::cerr << "ai_activation_test: looked up an unknown activation" << std::endl;
+        ok = false;
+    } catch(std::runtime_error&) {
+    }
+
+    return ok;
+}
+
+// each layer's activation survives the binary format
+bool check_model() {
+    ai::NeuralNetwork<double> nn(0.1, 6, 4, 5, 5);
+    nn.set_activation("relu");
+    nn.set_activation(1, "tanh");
+    nn.set_activation(2, "softmax");
+
+    const std::string path = "/tmp/ai_activation_test-" + std::to_string(getpid());
+    nn.save(path);
+    ai::NeuralNetwork<double> loaded(path);
+    std::remove(path.c_str());
+
+    bool ok = true;
+    for(uint i = 0; i < 3; i++) {
+        if(loaded.get_activation(i) != nn.get_activation(i)) {
+            std::cerr << "ai_activation_test: layer " << i << " loaded as " << loaded.get_activation(i)
+                      << " not " << nn.get_activation(i) << std::endl;
+            ok = false;
+        }
+    }
+
+    math::matrix<double> in(6, 2);
+    in.foreach([](double& v) { v = 0.5; });
+    math::matrix<double> a = nn.query_batch(in);
+    math::matrix<double> b = loaded.query_batch(in);
+    for(uint c = 0; c < 2; c++) {
+        double sum = 0;
+        for(uint r = 0; r < 4; r++) {
+            sum += a(r, c);
+            if(a(r, c) != b(r, c)) {
+                std::cerr << "ai_activation_test: loaded model answers " << b(r, c)
+                          << " not " << a(r, c) << std::endl;
+                ok = false;
+            }
+        }
+        if(std::fabs(sum - 1) > 1e-12) {
+            std::cerr << "ai_activation_test: softmax column sums to " << sum << std::endl;
+            ok = false;
+        }
+    }
+
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    if(!check_kernels<double>(1e-15))
+        return 1;
+
+    if(!check_kernels<float>(1e-6))
+        return 1;
+
+    if(!check_derivatives())
+        return 1;
+
+    if(!check_model())
+        return 1;
+
+    return 0;
+}
@@ -0,0 +1,195 @@
+/* -*- mode: C++ c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2026 Joey Yandle <xoloki@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+#include <jlib/ai/neural.hh>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+using namespace jlib;
+
+// the unblocked triple loop, counting what the network asks of it, as a
+// stand in for a backend that is not the cpu one
+class reference : public ai::backend<double> {
+public:
+    std::string name() const { return "reference"; }
+
+    void gemm(bool ta, bool tb, unsigned int m, unsigned int n, unsigned int k,
+              double alpha, const double* a, unsigned int lda, const double* b, unsigned int ldb,
+              double beta, double* c, unsigned int ldc) {
+        products++;
+        math::kernel::gemm_reference(ta, tb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+    }
+
+    void axpy(std::size_t n, double alpha, const double* x, double* y) {
+        sums++;
+        for(std::size_t i = 0; i < n; i++) {
+            y[i] += alpha * x[i];
+        }
+    }
+
+    using ai::backend<double>::gemm;
+    using ai::backend<double>::axpy;
+
+    static uint products;
+    static uint sums;
+};
+
+uint reference::products = 0;
+uint reference::sums = 0;
+
+class network : public ai::NeuralNetwork<double> {
+public:
+    template<typename... Args>
+    network(Args&&... args)
+        : ai::NeuralNetwork<double>(std::forward<Args>(args)...)
+    {}
+
+    double distance(network& o) {
+        double worst = 0;
+        for(uint l = 0; l < this->layers(); l++) {
+            const math::matrix<double>& a = this->weights(l);
+            const math::matrix<double>& b = o.weights(l);
+            for(uint i = 0; i < a.M; i++) {
+                for(uint j = 0; j < a.N; j++) {
+                    worst = std::max(worst, std::fabs(a(i, j) - b(i, j)));
+                }
+            }
+        }
+        return worst;
+    }
+};
+
+math::matrix<double> random(uint m, uint n, std::default_random_engine& generator) {
+    std::uniform_real_distribution<double> dist(0.0, 1.0);
+    math::matrix<double> ret(m, n);
+    ret.foreach([&](double& x) { x = dist(generator); });
+    return ret;
+}
+
+// the same network trained and queried on the cpu backend and on the
+// reference one ends up with the same weights and answers, and every
+// product went through the backend it was given
+bool check_parity() {
+    ai::backend<double>::add("reference", []() { return ai::backend<double>::ptr(new reference()); });
+
+    // the generator is seeded the same, so these start out equal
+    network cpu(0.2, 30, std::vector<uint>({ 20, 15 }), 5);
+    network ref(0.2, 30, std::vector<uint>({ 20, 15 }), 5);
+    ref.set_backend("reference");
+    if(cpu.distance(ref) != 0) {
+        std::cerr << "ai_backend_test: networks start out different" << std::endl;
+        return false;
+    }
+    if(cpu.get_backend()->name() != "cpu" || ref.get_backend()->name() != "reference") {
+        std::cerr << "ai_backend_test: backends are " << cpu.get_backend()->name() << " and "
+                  << ref.get_backend()->name() << std::endl;
+        return false;
+    }
+
+    std::default_random_engine generator(11);
+    for(uint i = 0; i < 10; i++) {
+        math::matrix<double> in = random(30, 8, generator);
+        math::matrix<double> target = random(5, 8, generator);
+        cpu.train_batch(in, target);
+        ref.train_batch(in, target);
+    }
+    math::matrix<double> one = random(30, 1, generator);
+    math::matrix<double> one_target = random(5, 1, generator);
+    cpu.train(one, one_target);
+    ref.train(one, one_target);
+
+    std::vector<math::matrix<double>> grads;
+    ai::NeuralNetwork<double>::workspace scratch;
+    math::matrix<double> in = random(30, 4, generator);
+    math::matrix<double> target = random(5, 4, generator);
+    cpu.gradient(in, target, grads, scratch);
+    cpu.apply(grads, 0.1);
+    ref.gradient(in, target, grads, scratch);
+    ref.apply(grads, 0.1);
+
+    if(cpu.distance(ref) > 1e-12) {
+        std::cerr << "ai_backend_test: weights differ by " << cpu.distance(ref) << std::endl;
+        return false;
+    }
+
+    // a transposed input goes through the layout wrapper
+    math::matrix<double> rows = random(6, 30, generator);
+    math::matrix<double> a = cpu.query_batch(rows.transpose());
+    math::matrix<double> b = ref.query_batch(rows.transpose());
+    for(uint r = 0; r < a.M; r++) {
+        for(uint c = 0; c < a.N; c++) {
+            if(std::fabs(a(r, c) - b(r, c)) > 1e-12) {
+                std::cerr << "ai_backend_test: query (" << r << "," << c << ") is " << b(r, c)
+                          << " expected " << a(r, c) << std::endl;
+                return false;
+            }
+        }
+    }
+
+    // three layers: a step forwards, updates each and propagates two; a
+    // gradient is as many, and a query three
+    const uint steps = 10 + 1;
+    const uint want = steps * 8 + 8 + 3;
+    if(reference::products != want || reference::sums != 3) {
+        std::cerr << "ai_backend_test: reference ran " << reference::products << " products and "
+                  << reference::sums << " sums, expected " << want << " and 3" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool check_registry() {
+    std::vector<std::string> names = ai::backend<double>::names();
+    if(std::find(names.begin(), names.end(), "cpu") == names.end()) {
+        std::cerr << "ai_backend_test: no cpu backend" << std::endl;
+        return false;
+    }
+
+    network nn(0.1, 4, std::vector<uint>({ 3 }), 2);
+    try {
+        nn.set_backend("abacus");
+        std::cerr << "ai_backend_test: set an unknown backend" << std::endl;
+        return false;
+    } catch(std::runtime_error&) {
+    }
+
+    // each network gets its own
+    network other(0.1, 4, std::vector<uint>({ 3 }), 2);
+    if(nn.get_backend() == other.get_backend()) {
+        std::cerr << "ai_backend_test: networks share a backend" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if(!check_parity())
+        return 1;
+
+    if(!check_registry())
+        return 1;
+
+    return 0;
+}
@@ -0,0 +1,134 @@
+/* -*- mode: C++ c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2026 Joey Yandle <xoloki@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+#include <jlib/ai/batcher.hh>
+
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace jlib;
+
+// two outputs per sample, its sum and its first value, so an answer given
+// to the wrong caller shows
+math::matrix<double> query(const math::matrix<double>& in) {
+    math::matrix<double> out(2, in.N);
+    for(uint c = 0; c < in.N; c++) {
+        for(uint r = 0; r < in.M; r++) {
+            out(0, c) += in(r, c);
+        }
+        out(1, c) = in(0, c);
+    }
+    return out;
+}
+
+// many callers at once are answered in shared batches, each with its own
+// column, and every request is counted
+bool check_batching() {
+    const uint threads = 8, each = 200, max_batch = 16;
+    ai::Batcher<double> b(3, query, max_batch, 2000);
+
+    std::atomic<uint> wrong(0);
+    std::vector<std::thread> callers;
+    for(uint t = 0; t < threads; t++) {
+        callers.push_back(std::thread([&, t]() {
+                    for(uint i = 0; i < each; i++) {
+                        const double x = t * 1000 + i;
+                        math::matrix<double> y = b.submit({ x, 1, 2 }).get();
+                        if(y.M != 2 || y.N != 1 || y(0, 0) != x + 3 || y(1, 0) != x)
+                            wrong++;
+                    }
+                }));
+    }
+    for(auto& c : callers) {
+        c.join();
+    }
+
+    if(wrong) {
+        std::cerr << "ai_batcher_test: " << wrong << " wrong answers" << std::endl;
+        return false;
+    }
+
+    ai::Batcher<double>::stats s = b.report();
+    std::size_t batches = 0;
+    for(std::size_t n : s.sizes) {
+        batches += n;
+    }
+    if(s.requests != threads * each || batches != s.batches || s.sizes.size() > 5 || s.queued != 0) {
+        std::cerr << "ai_batcher_test: " << s.requests << " requests in " << s.batches << " batches, "
+                  << s.sizes.size() << " size buckets, " << s.queued << " queued" << std::endl;
+        return false;
+    }
+    if(s.batches == s.requests) {
+        std::cerr << "ai_batcher_test: no two requests shared a batch" << std::endl;
+        return false;
+    }
+    if(s.p50 <= 0 || s.p99 < s.p50) {
+        std::cerr << "ai_batcher_test: latencies p50 " << s.p50 << " p99 " << s.p99 << std::endl;
+        return false;
+    }
+
+    if(b.report().requests != 0) {
+        std::cerr << "ai_batcher_test: report did not reset" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+// a lone request is answered once its wait is up, and a failing query
+// reaches the caller
+bool check_errors() {
+    ai::Batcher<double> b(3, query, 64, 1000);
+    if(b.submit({ 1, 2, 3 }).get()(0, 0) != 6) {
+        std::cerr << "ai_batcher_test: lone request answered wrong" << std::endl;
+        return false;
+    }
+
+    try {
+        b.submit({ 1, 2 });
+        std::cerr << "ai_batcher_test: took a short input" << std::endl;
+        return false;
+    } catch(std::runtime_error&) {
+    }
+
+    ai::Batcher<double> bad(1, [](const math::matrix<double>& in) -> math::matrix<double> {
+            throw std::runtime_error("no model");
+        }, 4, 100);
+    try {
+        bad.submit({ 1 }).get();
+        std::cerr << "ai_batcher_test: failed query gave an answer" << std::endl;
+        return false;
+    } catch(std::runtime_error&) {
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if(!check_batching())
+        return 1;
+
+    if(!check_errors())
+        return 1;
+
+    return 0;
+}
@@ -0,0 +1,170 @@
+/* -*- mode: C++ c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2026 Joey Yandle <xoloki@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+#include <jlib/ai/dataset.hh>
+
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include <cstdio>
+#include <unistd.h>
+
+using namespace jlib;
+
+std::string temp(const std::string& name) {
+    return "/tmp/ai_dataset_test-" + std::to_string(getpid()) + "-" + name;
+}
+
+void write(const std::string& path, const std::string& contents) {
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    ofs.write(contents.data(), contents.size());
+}
+
+std::string big32(uint32_t v) {
+    const char b[] = { char(v >> 24), char(v >> 16), char(v >> 8), char(v) };
+    return std::string(b, 4);
+}
+
+// the values land column by column with their labels, whatever the line
+// endings or signs, and a batch is a window on the same storage
+bool check_csv() {
+    const std::string path = temp("train.csv");
+    write(path, "7,0,255,10\r\n\n-3,1,-2,3\n9,100,0,-200");
+
+    ai::dataset<double> d = ai::dataset<double>::csv(path, 1.0, 0.0);
+    std::remove(path.c_str());
+
+    const double want[3][3] = { { 0, 255, 10 }, { 1, -2, 3 }, { 100, 0, -200 } };
+    const int labels[3] = { 7, -3, 9 };
+    if(d.size() != 3 || d.features() != 3) {
+        std::cerr << "ai_dataset_test: read " << d.size() << " samples of " << d.features() << std::endl;
+        return false;
+    }
+    for(uint c = 0; c < 3; c++) {
+        if(d.label(c) != labels[c]) {
+            std::cerr << "ai_dataset_test: sample " << c << " has label " << d.label(c) << std::endl;
+            return false;
+        }
+        for(uint r = 0; r < 3; r++) {
+            if(d.samples()(r, c) != want[c][r]) {
+                std::cerr << "ai_dataset_test: sample " << c << " value " << r << " is "
+                          << d.samples()(r, c) << " expected " << want[c][r] << std::endl;
+                return false;
+            }
+        }
+    }
+
+    math::matrix<double> b = d.batch(1, 2);
+    if(b.M != 3 || b.N != 2 || b.data() != d.samples().data() + 3) {
+        std::cerr << "ai_dataset_test: batch is not a view of the samples" << std::endl;
+        return false;
+    }
+
+    std::vector<std::size_t> order = { 2, 0 };
+    math::matrix<double> g(3, 1);
+    d.gather(order, 0, 2, g);
+    if(g(0, 0) != 100 || g(2, 1) != 10) {
+        std::cerr << "ai_dataset_test: gather took the wrong samples" << std::endl;
+        return false;
+    }
+
+    // shuffled, every label still goes with its own values
+    std::default_random_engine generator(3);
+    d.shuffle(generator);
+    for(uint c = 0; c < 3; c++) {
+        const uint i = (d.label(c) == 7 ? 0 : d.label(c) == -3 ? 1 : 2);
+        if(d.samples()(0, c) != want[i][0] || d.samples()(2, c) != want[i][2]) {
+            std::cerr << "ai_dataset_test: shuffle separated sample " << c << " from its label" << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// two 2x2 images, found from the image file's name, with the default scaling
+bool check_idx() {
+    const std::string images = temp("t10k-images-idx3-ubyte");
+    const std::string labels = temp("t10k-labels-idx1-ubyte");
+    write(images, big32(0x803) + big32(2) + big32(2) + big32(2) + std::string("\x00\x01\x02\xff\x10\x20\x30\x40", 8));
+    write(labels, big32(0x801) + big32(2) + std::string("\x05\x08", 2));
+
+    ai::dataset<float> d = ai::dataset<float>::load(images);
+    std::remove(images.c_str());
+    std::remove(labels.c_str());
+
+    if(d.size() != 2 || d.features() != 4 || d.label(0) != 5 || d.label(1) != 8) {
+        std::cerr << "ai_dataset_test: idx read " << d.size() << " samples of " << d.features() << std::endl;
+        return false;
+    }
+    if(d.samples()(0, 0) != 0.01f || d.samples()(3, 0) != float(255 * (0.99 / 255.0)) + 0.01f ||
+       d.sample(1)(1, 0) != float(0x20 * (0.99 / 255.0)) + 0.01f) {
+        std::cerr << "ai_dataset_test: idx values are scaled wrong" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+// a missing value, a stray character or sign, or a ragged line names the line
+bool check_errors() {
+    const std::string path = temp("bad.csv");
+    const std::string bad[] = { "1,2,3\n4,5,\n", "1,2,3\n4,5,x\n", "1,2,3\n4,5,-\n", "1,2,3\n4,-,6\n",
+                                "1,2,3\n4,5,--6\n", "1,2,3\n4,5\n", "1,2,3\n4,5,6,7\n", "" };
+
+    for(const std::string& contents : bad) {
+        write(path, contents);
+        try {
+            ai::dataset<double>::csv(path);
+            std::cerr << "ai_dataset_test: read a bad csv" << std::endl;
+            return false;
+        } catch(std::runtime_error& e) {
+            if(!contents.empty() && std::string(e.what()).find("line 2") == std::string::npos) {
+                std::cerr << "ai_dataset_test: error does not name the line: " << e.what() << std::endl;
+                return false;
+            }
+        }
+    }
+    std::remove(path.c_str());
+
+    try {
+        ai::dataset<double>::csv(temp("missing.csv"));
+        std::cerr << "ai_dataset_test: read a missing file" << std::endl;
+        return false;
+    } catch(std::exception&) {
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if(!check_csv())
+        return 1;
+
+    if(!check_idx())
+        return 1;
+
+    if(!check_errors())
+        return 1;
+
+    return 0;
+}
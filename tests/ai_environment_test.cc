@@ -0,0 +1,219 @@
+/* -*- mode: C++ c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2026 Joey Yandle <xoloki@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+#include <jlib/ai/vacuum.hh>
+#include <jlib/ai/runner.hh>
+
+#include <iostream>
+#include <stdexcept>
+
+using namespace jlib;
+using namespace jlib::ai;
+
+const unsigned int STEPS = 100;
+
+// cleans a dirty square, and otherwise goes to the other one
+class Reflex : public vacuum::Agent {
+public:
+    Action::ptr agent(const Percept::map percepts) {
+        return choose(percepts);
+    }
+
+    Action::ptr choose(const Percept::map& percepts) {
+        vacuum::Location::ptr l = vacuum::Location::ptr::cast_dynamic(percepts.at(vacuum::Environment::LOCATION));
+        vacuum::Cleanliness::ptr c = vacuum::Cleanliness::ptr::cast_dynamic(percepts.at(vacuum::Environment::CLEANLINESS));
+        if(!c->clean)
+            return clean();
+        return move(vacuum::location(1, 1 - l->loc[0]));
+    }
+
+    ptr clone() const { return ptr(new Reflex()); }
+};
+
+// does anything at all
+class Random : public vacuum::Agent {
+public:
+    Action::ptr agent(const Percept::map percepts) {
+        return choose(percepts);
+    }
+
+    Action::ptr choose(const Percept::map&) {
+        std::uniform_int_distribution<int> choice(0, 2);
+        const int c = choice(rng());
+        if(c == 2)
+            return clean();
+        return move(vacuum::location(1, c));
+    }
+
+    ptr clone() const { return ptr(new Random()); }
+};
+
+// a random agent that can't be copied
+class Stuck : public Random {
+public:
+    ptr clone() const { return ptr(); }
+};
+
+// only answers agent(), as agents did before choose()
+class Counting : public vacuum::Agent {
+public:
+    Counting() : steps(0) {}
+
+    Action::ptr agent(const Percept::map) {
+        steps++;
+        return clean();
+    }
+
+    unsigned int steps;
+};
+
+// a world that can't be copied, to be run where it is
+class Fixed : public vacuum::Environment {
+public:
+    Fixed() : vacuum::Environment(std::vector<vacuum::location>{ vacuum::location(1, 0), vacuum::location(1, 1) }, STEPS) {}
+
+    std::unique_ptr<ai::Environment> clone() const { return std::unique_ptr<ai::Environment>(); }
+};
+
+// the reflex agent has both squares clean within three steps and keeps
+// them that way
+bool check_reflex() {
+    vacuum::Environment env(std::vector<vacuum::location>{ vacuum::location(1, 0), vacuum::location(1, 1) }, STEPS);
+    env.add(Agent::ptr(new Reflex()));
+
+    for(int i = 0; i < 20; i++) {
+        env.episode(i);
+        const Environment::score s = env.run();
+        if(s < 2 * STEPS - 3 || s > 2 * STEPS) {
+            std::cerr << "episode " << i << ": reflex agent scored " << s << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// every thread count gives the serial average, episode for episode, and
+// the seed changes it
+bool check_runner() {
+    vacuum::Environment env(std::vector<vacuum::location>{ vacuum::location(1, 0), vacuum::location(1, 1) }, STEPS);
+    env.add(Agent::ptr(new Random()));
+    env.seed(7);
+
+    const int episodes = 200;
+    const Environment::score serial = env.run(episodes);
+
+    Runner one(1);
+    const Environment::score single = one.run(env, episodes);
+    const std::vector<Environment::score> scores = one.scores();
+
+    bool varied = false;
+    for(int i = 1; i < episodes; i++) {
+        varied |= (scores[i] != scores[0]);
+    }
+    if(!varied) {
+        std::cerr << "every episode scored " << scores[0] << std::endl;
+        return false;
+    }
+
+    for(unsigned int threads : { 2, 4, 7 }) {
+        Runner r(threads);
+        const Environment::score s = r.run(env, episodes);
+        if(s != serial || s != single || r.scores() != scores) {
+            std::cerr << threads << " threads: " << s << ", serial " << serial << std::endl;
+            return false;
+        }
+    }
+
+    env.seed(8);
+    if(Runner(4).run(env, episodes) == serial) {
+        std::cerr << "seed 8 scored the same as seed 7" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// an environment that can't be cloned is run on the calling thread, to the
+// same result; one whose agents can't be is a mistake
+bool check_fallbacks() {
+    Fixed fixed;
+    fixed.add(Agent::ptr(new Random()));
+    fixed.seed(7);
+    const Environment::score serial = fixed.run(50);
+    if(Runner(4).run(fixed, 50) != serial) {
+        std::cerr << "uncloned environment scored differently" << std::endl;
+        return false;
+    }
+
+    vacuum::Environment env;
+    env.add(Agent::ptr(new Stuck()));
+    try {
+        Runner(4).run(env, 10);
+        std::cerr << "cloned an agent without clone" << std::endl;
+        return false;
+    } catch(std::logic_error&) {
+    }
+    return true;
+}
+
+// an environment nobody seeded runs its episodes on from where the last
+// left off, a copy shares its agents, and an agent with only agent() is
+// asked every step
+bool check_compatibility() {
+    vacuum::Environment env(std::vector<vacuum::location>{ vacuum::location(1, 0), vacuum::location(1, 1) }, STEPS);
+    env.add(Agent::ptr(new Random()));
+    if(env.run(20) == env.run(20)) {
+        std::cerr << "unseeded runs were reseeded" << std::endl;
+        return false;
+    }
+    env.seed(7);
+    if(env.run(20) != env.run(20)) {
+        std::cerr << "seeded runs differ" << std::endl;
+        return false;
+    }
+
+    vacuum::Environment copy(env);
+    if(copy.agents() != env.agents()) {
+        std::cerr << "a copy has its own agents" << std::endl;
+        return false;
+    }
+
+    Counting* counting = new Counting();
+    vacuum::Environment old(std::vector<vacuum::location>{ vacuum::location(1, 0), vacuum::location(1, 1) }, STEPS);
+    old.add(Agent::ptr(counting));
+    old.run(3);
+    if(counting->steps != 3 * STEPS) {
+        std::cerr << "agent() was asked " << counting->steps << " times" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if(!check_reflex())
+        return 1;
+    if(!check_runner())
+        return 1;
+    if(!check_fallbacks())
+        return 1;
+    if(!check_compatibility())
+        return 1;
+
+    return 0;
+}
@@ -0,0 +1,194 @@
+/* -*- mode: C++ c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2026 Joey Yandle <xoloki@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+#include <jlib/ai/neural.hh>
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+
+#include <cstdio>
+#include <unistd.h>
+
+using namespace jlib;
+
+template<typename T>
+class network : public ai::NeuralNetwork<T> {
+public:
+    template<typename... Args>
+    network(Args&&... args)
+        : ai::NeuralNetwork<T>(std::forward<Args>(args)...)
+    {}
+
+    math::matrix<T>& layer(uint i) {
+        return this->weights(i);
+    }
+
+    uint count() const {
+        return this->layers();
+    }
+};
+
+std::string temp(const std::string& name) {
+    return "/tmp/ai_model_test-" + std::to_string(getpid()) + "-" + name;
+}
+
+// the file mapped at p, from /proc/self/maps
+std::string mapped_from(const void* p) {
+    const unsigned long address = reinterpret_cast<unsigned long>(p);
+    std::ifstream maps("/proc/self/maps");
+    std::string line;
+    while(std::getline(maps, line)) {
+        unsigned long begin, end;
+        char path[4096] = "";
+        if(std::sscanf(line.c_str(), "%lx-%lx %*s %*s %*s %*s %4095s", &begin, &end, path) >= 2 &&
+           begin <= address && address < end)
+            return path;
+    }
+    return "";
+}
+
+template<typename A, typename B>
+bool same(network<A>& a, network<B>& b, const std::string& what) {
+    if(a.count() != b.count() || a.get_rate() != b.get_rate()) {
+        std::cerr << "ai_model_test: " << what << " has a different shape or rate" << std::endl;
+        return false;
+    }
+
+    for(uint l = 0; l < a.count(); l++) {
+        const math::matrix<A>& x = a.layer(l);
+        const math::matrix<B>& y = b.layer(l);
+        if(x.M != y.M || x.N != y.N) {
+            std::cerr << "ai_model_test: " << what << " layer " << l << " is " << y.M << "x" << y.N
+                      << " expected " << x.M << "x" << x.N << std::endl;
+            return false;
+        }
+
+        for(uint i = 0; i < x.M; i++) {
+            for(uint j = 0; j < x.N; j++) {
+                if(B(x(i,j)) != y(i,j)) {
+                    std::cerr << "ai_model_test: " << what << " layer " << l << " weight (" << i << "," << j
+                              << ") is " << y(i,j) << " expected " << x(i,j) << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+bool check_roundtrip() {
+    const std::string path = temp("double.nn");
+    network<double> nn(0.25, 50, std::vector<uint>({ 17, 9, 30 }), 10);
+    nn.save(path);
+
+    // the weights are read in place, so they live in the file's mapping
+    network<double> loaded(path);
+    for(uint l = 0; l < loaded.count(); l++) {
+        if(mapped_from(loaded.layer(l).data()) != path) {
+            std::cerr << "ai_model_test: layer " << l << " is not in " << path << std::endl;
+            return false;
+        }
+    }
+
+    if(!same(nn, loaded, "loaded model"))
+        return false;
+
+    // training the loaded copy must not reach the file
+    math::matrix<double> input(50, 1);
+    math::matrix<double> target(10, 1);
+    input.foreach([](double& x) { x = 0.5; });
+    target.foreach([](double& x) { x = 0.01; });
+    loaded.train(input, target);
+
+    network<double> again(path);
+    if(!same(nn, again, "model reloaded after training"))
+        return false;
+
+    // weights kept as float load as double without loss
+    const std::string fpath = temp("float.nn");
+    network<float> small(0.5, 20, std::vector<uint>({ 8 }), 3);
+    small.save(fpath);
+    network<double> widened(fpath);
+    if(!same(small, widened, "float model loaded as double"))
+        return false;
+
+    std::remove(path.c_str());
+    std::remove(fpath.c_str());
+    return true;
+}
+
+bool check_errors() {
+    const std::string path = temp("bad.nn");
+    network<double> nn(0.1, 30, std::vector<uint>({ 12 }), 4);
+    nn.save(path);
+
+    std::string contents;
+    {
+        std::ifstream ifs(path, std::ios::binary);
+        contents.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+    }
+
+    // cut short anywhere, or with the wrong magic, loading has to throw
+    const std::size_t cuts[] = { 0, 10, 40, 100, contents.size() - 1 };
+    for(std::size_t cut : cuts) {
+        {
+            std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+            ofs.write(contents.data(), cut);
+        }
+
+        try {
+            network<double> bad(path);
+            std::cerr << "ai_model_test: loaded a model cut to " << cut << " bytes" << std::endl;
+            return false;
+        } catch(std::runtime_error&) {
+        }
+    }
+
+    {
+        std::string wrong = contents;
+        wrong[0] = 'J';
+        std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+        ofs.write(wrong.data(), wrong.size());
+    }
+
+    try {
+        network<double> bad(path);
+        std::cerr << "ai_model_test: loaded a model with the wrong magic" << std::endl;
+        return false;
+    } catch(std::runtime_error&) {
+    }
+
+    std::remove(path.c_str());
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if(!check_roundtrip())
+        return 1;
+
+    if(!check_errors())
+        return 1;
+
+    return 0;
+}
@@ -0,0 +1,176 @@
+/* -*- mode: C++ c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2026 Joey Yandle <xoloki@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+#include <jlib/ai/neural.hh>
+
+#include "allocations.hh"
+
+#include <iostream>
+#include <random>
+
+#include <cmath>
+#include <cstdlib>
+
+using namespace jlib;
+
+// the training step as it was written before the in-place api, one
+// temporary per operator, to check the new one still learns the same thing
+template<typename T>
+class reference : public ai::NeuralNetwork<T> {
+public:
+    reference(double lrate, uint ninput, const std::vector<uint>& hidden, uint noutput)
+        : ai::NeuralNetwork<T>(lrate, ninput, hidden, noutput)
+    {}
+
+    void train_eager(const math::matrix<T>& inputs, const math::matrix<T>& targets) {
+        std::vector<math::matrix<T>> outputs;
+        math::matrix<T> in = inputs;
+        for(uint i = 0; i < this->layers(); i++) {
+            math::matrix<T> out = this->weights(i) * in;
+            out.foreach([](T& x) { x = 1.0 / (1.0 + exp(-x)); });
+            outputs.push_back(out);
+            in = out;
+        }
+
+        math::matrix<T> errors = targets - outputs.back();
+        for(int i = this->layers() - 1; i >= 0; i--) {
+            const math::matrix<T>& prev = (i == 0 ? inputs : outputs[i - 1]);
+            math::matrix<T> delta = errors ^ outputs[i] ^ (1.0 - outputs[i]);
+            math::matrix<T> step = delta * prev.transpose();
+            this->weights(i) += T(this->m_lrate) * step;
+            errors = this->weights(i).transpose() * errors;
+        }
+    }
+
+    const math::matrix<T>& layer(uint i) {
+        return this->weights(i);
+    }
+};
+
+int main(int argc, char** argv) {
+    const std::vector<uint> hidden = { 100, 50 };
+    reference<double> nn(0.1, 784, hidden, 10);
+    reference<double> eager(0.1, 784, hidden, 10);
+
+    std::default_random_engine generator;
+    std::uniform_real_distribution<double> dist(0.01, 1.0);
+
+    math::matrix<double> input(784, 1);
+    math::matrix<double> target(10, 1);
+    input.foreach([&](double& x) { x = dist(generator); });
+    target.foreach([&](double& x) { x = 0.01; });
+    target(3, 0) = 0.99;
+
+    // the first step sizes the scratch space and the gemm packing buffers
+    nn.train(input, target);
+    eager.train_eager(input, target);
+
+    nn.query(input);
+
+    // matrix storage comes from math::allocator rather than operator new.
+    // with pooling off every block it hands out is a system allocation, so
+    // training in place must not ask it for any
+    math::allocator::set_pooling(false);
+    std::size_t before = allocations();
+    std::size_t system = math::allocator::system_allocations();
+    for(int i = 0; i < 10; i++) {
+        nn.learn(input, target);
+    }
+    std::size_t steady = allocations() - before;
+    std::size_t blocks = math::allocator::system_allocations() - system;
+    math::allocator::set_pooling(true);
+
+    if(steady != 0 || blocks != 0) {
+        std::cerr << "ai_neural_test: " << steady << " allocations and " << blocks
+                  << " system blocks in 10 training steps" << std::endl;
+        return 1;
+    }
+
+    // queries take their layer buffers from the pool, which has them from
+    // the first query on
+    system = math::allocator::system_allocations();
+    for(int i = 0; i < 10; i++) {
+        nn.query(input);
+    }
+    blocks = math::allocator::system_allocations() - system;
+
+    if(blocks != 0) {
+        std::cerr << "ai_neural_test: " << blocks << " system blocks in 10 queries" << std::endl;
+        return 1;
+    }
+
+    for(int i = 0; i < 10; i++) {
+        eager.train_eager(input, target);
+    }
+
+    for(uint l = 0; l < 4; l++) {
+        const math::matrix<double>& a = nn.layer(l);
+        const math::matrix<double>& b = eager.layer(l);
+        for(uint i = 0; i < a.M; i++) {
+            for(uint j = 0; j < a.N; j++) {
+                if(std::abs(a(i,j) - b(i,j)) > 1e-12) {
+                    std::cerr << "ai_neural_test: layer " << l << " weight (" << i << "," << j << ") is "
+                              << a(i,j) << " expected " << b(i,j) << std::endl;
+                    return 1;
+                }
+            }
+        }
+    }
+
+    // train hands back errors of its own, which the next step leaves alone
+    math::matrix<double> first = nn.train(input, target);
+    math::matrix<double> kept = first * 1.0;
+    math::matrix<double> second = nn.train(input, target);
+    if(first != kept || first.data() == second.data()) {
+        std::cerr << "ai_neural_test: the next train overwrote the errors train returned" << std::endl;
+        return 1;
+    }
+
+    // the gradient of a batch is averaged, so a batch of copies of one
+    // sample moves the weights exactly as much as that sample alone
+    reference<double> single(0.1, 784, hidden, 10);
+    reference<double> batched(0.1, 784, hidden, 10);
+
+    math::matrix<double> inputs(784, 8);
+    math::matrix<double> targets(10, 8);
+    for(uint j = 0; j < 8; j++) {
+        for(uint i = 0; i < 784; i++) inputs(i, j) = input(i, 0);
+        for(uint i = 0; i < 10; i++) targets(i, j) = target(i, 0);
+    }
+
+    for(int i = 0; i < 5; i++) {
+        single.train(input, target);
+        batched.train_batch(inputs, targets);
+    }
+
+    math::matrix<double> one = single.query(input);
+    math::matrix<double> all = batched.query_batch(inputs);
+    for(uint j = 0; j < 8; j++) {
+        for(uint i = 0; i < 10; i++) {
+            if(std::abs(all(i,j) - one(i,0)) > 1e-9) {
+                std::cerr << "ai_neural_test: batch output (" << i << "," << j << ") is "
+                          << all(i,j) << " expected " << one(i,0) << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,133 @@
+/* -*- mode: C++ c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2026 Joey Yandle <xoloki@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+#include <jlib/ai/quantized.hh>
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace jlib;
+
+// every kernel the cpu has gives exactly the scalar sums, including the
+// extremes of both ranges and row counts that are not a multiple of four
+bool check_kernels() {
+    std::default_random_engine generator(5);
+    std::uniform_int_distribution<int> weight(-127, 127);
+    std::uniform_int_distribution<int> activation(0, 255);
+
+    const unsigned int m = 13, n = 3, k = 2 * math::kernel::INT8_PAD;
+    std::vector<int8_t> a(m * k);
+    std::vector<uint8_t> b(n * k);
+    for(auto& x : a) x = int8_t(weight(generator));
+    for(auto& x : b) x = uint8_t(activation(generator));
+    a[0] = -127;
+    b[0] = 255;
+
+    std::vector<int32_t> want(m * n), got(m * n);
+    math::kernel::int8<math::kernel::SCALAR>::dot(m, n, k, a.data(), k, b.data(), k, want.data(), m);
+
+    bool ok = true;
+    for(int i = math::kernel::AVX2; i <= math::kernel::detect(); i++) {
+        math::kernel::set_isa(math::kernel::isa(i));
+        math::kernel::int8_dot(m, n, k, a.data(), k, b.data(), k, got.data(), m);
+        if(got != want) {
+            std::cerr << "ai_quantized_test: " << math::kernel::name(math::kernel::isa(i))
+                      << (math::kernel::vnni() ? " vnni" : "") << " sums differ from scalar" << std::endl;
+            ok = false;
+        }
+
+        // fma may round the odd value the other way, but never further
+        std::vector<double> x(37);
+        std::uniform_real_distribution<double> dist(-3.0, 3.0);
+        for(auto& v : x) v = dist(generator);
+        std::vector<uint8_t> q(x.size()), qs(x.size());
+        const double scale = math::kernel::int8_quantize(x.size(), x.data(), q.data());
+        math::kernel::quantize<double, math::kernel::SCALAR>::run(x.size(), x.data(), qs.data());
+        for(std::size_t j = 0; j < x.size(); j++) {
+            if(std::abs(int(q[j]) - int(qs[j])) > 1 || std::fabs((int(q[j]) - 128) * scale - x[j]) > scale) {
+                std::cerr << "ai_quantized_test: " << x[j] << " quantized to " << int(q[j]) << std::endl;
+                ok = false;
+            }
+        }
+    }
+    math::kernel::set_isa(math::kernel::detect());
+
+    return ok;
+}
+
+// the int8 network answers close to the double one, and picks the same
+// class nearly every time
+bool check_network() {
+    ai::NeuralNetwork<double> nn(0.1, 100, 10, 70, 30);
+    ai::QuantizedNetwork<double> q(nn);
+
+    std::default_random_engine generator(9);
+    std::uniform_real_distribution<double> dist(0.0, 1.0);
+    math::matrix<double> in(100, 200);
+    in.foreach([&](double& x) { x = dist(generator); });
+
+    math::matrix<double> want = nn.query_batch(in);
+    math::matrix<double> got = q.query_batch(in);
+
+    double worst = 0;
+    uint agree = 0;
+    for(uint c = 0; c < in.N; c++) {
+        uint a = 0, b = 0;
+        for(uint r = 0; r < want.M; r++) {
+            worst = std::max(worst, std::fabs(want(r, c) - got(r, c)));
+            if(want(r, c) > want(a, c)) a = r;
+            if(got(r, c) > got(b, c)) b = r;
+        }
+        if(a == b)
+            agree++;
+    }
+
+    bool ok = true;
+    if(worst > 0.01) {
+        std::cerr << "ai_quantized_test: outputs differ by up to " << worst << std::endl;
+        ok = false;
+    }
+    if(agree < 0.95 * in.N) {
+        std::cerr << "ai_quantized_test: only " << agree << " of " << in.N << " samples agree" << std::endl;
+        ok = false;
+    }
+
+    // a single column through query, as NeuralNetwork takes it
+    math::matrix<double> one(100, 1);
+    one.foreach([&](double& x) { x = dist(generator); });
+    if(q.query(one).M != 10) {
+        std::cerr << "ai_quantized_test: query gave the wrong shape" << std::endl;
+        ok = false;
+    }
+
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    if(!check_kernels())
+        return 1;
+
+    if(!check_network())
+        return 1;
+
+    return 0;
+}
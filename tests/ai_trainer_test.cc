@@ -0,0 +1,182 @@
+/* -*- mode: C++ c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2026 Joey Yandle <xoloki@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+#include <jlib/ai/trainer.hh>
+
+#include <iostream>
+#include <random>
+
+#include <cmath>
+
+using namespace jlib;
+
+template<typename T>
+class network : public ai::NeuralNetwork<T> {
+public:
+    network(double lrate, uint ninput, const std::vector<uint>& hidden, uint noutput)
+        : ai::NeuralNetwork<T>(lrate, ninput, hidden, noutput)
+    {}
+
+    math::matrix<T>& layer(uint i) {
+        return this->weights(i);
+    }
+
+    // half the squared error over every column
+    T loss(const math::matrix<T>& inputs, const math::matrix<T>& targets) {
+        math::matrix<T> out = this->query_batch(inputs);
+        T ret = 0;
+        for(uint i = 0; i < out.M; i++) {
+            for(uint j = 0; j < out.N; j++) {
+                ret += 0.5 * (targets(i,j) - out(i,j)) * (targets(i,j) - out(i,j));
+            }
+        }
+        return ret;
+    }
+};
+
+std::default_random_engine generator;
+
+math::matrix<double> random_matrix(uint m, uint n) {
+    std::uniform_real_distribution<double> dist(0.01, 1.0);
+    math::matrix<double> ret(m, n);
+    ret.foreach([&](double& x) { x = dist(generator); });
+    return ret;
+}
+
+// for the output layer gradient() is minus the derivative of the loss.  the
+// layers behind it get the errors passed back through the weights, without
+// the derivative of the activation, so they follow their own rule
+bool check_gradient() {
+    network<double> nn(0.1, 12, { 7, 5 }, 4);
+    math::matrix<double> inputs = random_matrix(12, 6);
+    math::matrix<double> targets = random_matrix(4, 6);
+
+    std::vector<math::matrix<double>> grads;
+    ai::NeuralNetwork<double>::workspace scratch;
+    nn.gradient(inputs, targets, grads, scratch);
+
+    const double h = 1e-6;
+    const uint l = 2;
+    {
+        math::matrix<double>& w = nn.layer(l);
+        for(uint i = 0; i < w.M; i++) {
+            for(uint j = 0; j < w.N; j++) {
+                const double x = w(i,j);
+                w(i,j) = x + h;
+                const double up = nn.loss(inputs, targets);
+                w(i,j) = x - h;
+                const double down = nn.loss(inputs, targets);
+                w(i,j) = x;
+
+                const double expected = -(up - down) / (2 * h);
+                if(std::abs(grads[l](i,j) - expected) > 1e-6) {
+                    std::cerr << "ai_trainer_test: layer " << l << " gradient (" << i << "," << j << ") is "
+                              << grads[l](i,j) << " expected " << expected << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+// an epoch on the given number of threads, returning the final weights
+std::vector<math::matrix<double>> epoch(unsigned int threads, ai::Trainer<double>::MODE mode, bool deterministic,
+                                        const math::matrix<double>& inputs, const math::matrix<double>& targets) {
+    network<double> nn(0.5, inputs.M, { 30 }, targets.M);
+    ai::Trainer<double> trainer(nn, threads, mode);
+    trainer.set_deterministic(deterministic);
+    trainer.train_epoch(inputs, targets, 100);
+
+    std::vector<math::matrix<double>> ret;
+    for(uint l = 0; l < 2; l++) {
+        ret.push_back(nn.layer(l));
+    }
+    return ret;
+}
+
+double difference(const std::vector<math::matrix<double>>& a, const std::vector<math::matrix<double>>& b) {
+    double ret = 0;
+    for(uint l = 0; l < a.size(); l++) {
+        for(uint i = 0; i < a[l].M; i++) {
+            for(uint j = 0; j < a[l].N; j++) {
+                ret = std::max(ret, std::abs(a[l](i,j) - b[l](i,j)));
+            }
+        }
+    }
+    return ret;
+}
+
+bool check_trainer() {
+    math::matrix<double> inputs = random_matrix(40, 1000);
+    math::matrix<double> targets = random_matrix(5, 1000);
+
+    // deterministic shards give the same bits on any number of threads
+    const std::vector<math::matrix<double>> one = epoch(1, ai::Trainer<double>::SYNCHRONOUS, true, inputs, targets);
+    for(unsigned int t : { 2, 3, 8 }) {
+        const double d = difference(one, epoch(t, ai::Trainer<double>::SYNCHRONOUS, true, inputs, targets));
+        if(d != 0) {
+            std::cerr << "ai_trainer_test: deterministic on " << t << " threads is off by " << d << std::endl;
+            return false;
+        }
+    }
+
+    // otherwise only the order of the sums changes
+    for(unsigned int t : { 2, 3, 8 }) {
+        const double d = difference(one, epoch(t, ai::Trainer<double>::SYNCHRONOUS, false, inputs, targets));
+        if(d > 1e-10) {
+            std::cerr << "ai_trainer_test: synchronous on " << t << " threads is off by " << d << std::endl;
+            return false;
+        }
+    }
+
+    // hogwild steps more often on stale weights, but it still has to learn
+    // about as well as taking one step per batch
+    network<double> hog(0.5, inputs.M, { 30 }, targets.M);
+    network<double> sync(0.5, inputs.M, { 30 }, targets.M);
+    const double before = hog.loss(inputs, targets);
+    ai::Trainer<double> hogwild(hog, 4, ai::Trainer<double>::HOGWILD);
+    ai::Trainer<double> synchronous(sync, 4, ai::Trainer<double>::SYNCHRONOUS);
+    for(int e = 0; e < 5; e++) {
+        hogwild.train_epoch(inputs, targets, 100);
+        synchronous.train_epoch(inputs, targets, 100);
+    }
+
+    const double after = hog.loss(inputs, targets);
+    const double expected = sync.loss(inputs, targets);
+    if(!(after < before) || after > 1.1 * expected) {
+        std::cerr << "ai_trainer_test: hogwild took the loss from " << before << " to " << after
+                  << ", synchronous to " << expected << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if(!check_gradient())
+        return 1;
+
+    if(!check_trainer())
+        return 1;
+
+    return 0;
+}
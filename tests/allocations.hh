@@ -0,0 +1,31 @@
+/* -*- mode: C++ c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2026 Joey Yandle <xoloki@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+#ifndef JLIB_TESTS_ALLOCATIONS_HH
+#define JLIB_TESTS_ALLOCATIONS_HH
+
+#include <cstddef>
+
+// the number of heap allocations the process has made so far.  linking
+// allocations.cc into a test replaces the global operator new and delete
+// with ones that count, for tests that check a loop doesn't allocate
+std::size_t allocations();
+
+#endif //JLIB_TESTS_ALLOCATIONS_HH
@@ -303,5 +303,73 @@ int main(int argc, char** argv) {
         }
     }
 
+    // decoded elements against the encoded point operations
+    {
+        Point p = Point::random(), q = Point::random();
+        Element a(p), b(q);
+
+        if(a.point() != p || (a + b).point() != (p + q) || (a - b).point() != (p - q) || a.twice().point() != (p + p)) {
+            std::cerr << "Element arithmetic doesn't match Point arithmetic" << std::endl;
+            return -1;
+        }
+
+        if(Element().point() != Point::zero() || !(a + b - b == a)) {
+            std::cerr << "Element identity or equality is wrong" << std::endl;
+            return -1;
+        }
+
+        Point negative = Point::random();
+        negative.data()[0] |= 1;
+        try {
+            Element e(negative);
+            std::cerr << "Element accepted a non-canonical encoding" << std::endl;
+            return -1;
+        } catch(std::exception& e) {
+        }
+    }
+    // multiexp against a sum of products, with zero, small and negative
+    // scalars among the random ones
+    for(std::size_t n : { 0, 1, 2, 7, 100, 600 }) {
+        std::vector<Point> points;
+        std::vector<Scalar> scalars;
+        Point sum = Point::zero();
+        for(std::size_t i = 0; i < n; i++) {
+            Scalar x = (i % 7 == 3 ? Scalar::zero() : i % 5 == 1 ? Scalar(i) : i % 11 == 2 ? -Scalar::one() : Scalar::random());
+            points.push_back(Point::random());
+            scalars.push_back(x);
+            sum += points.back() * x;
+        }
+
+        if(multiexp(points, scalars) != sum) {
+            std::cerr << "multiexp of " << n << " terms doesn't match the sum of products" << std::endl;
+            return -1;
+        }
+    }
+
+    // square and multiply and the power ladder against repeated products
+    {
+        Scalar x = Scalar::random();
+        std::vector<Scalar> x_k = powers(x, 40);
+        Scalar p = Scalar::one();
+        for(int k = 0; k <= 40; k++) {
+            if(x_k[k] != p || (x^k) != p || (x^(-k)) != (p^(-1))) {
+                std::cerr << "x^" << k << " doesn't match " << k << " multiplications" << std::endl;
+                return -1;
+            }
+            p *= x;
+        }
+    }
+    // fixed base tables against the variable base product
+    {
+        Point p = Point::random();
+        FixedBase table(p);
+        for(Scalar x : { Scalar::zero(), Scalar::one(), Scalar(8), Scalar(0x88888888), -Scalar::one(), Scalar::random() }) {
+            if((table * x).point() != p * x) {
+                std::cerr << "FixedBase gives a different product for " << x << std::endl;
+                return -1;
+            }
+        }
+    }
+
     return 0;
 }
@@ -0,0 +1,69 @@
+/* -*- mode: C++ c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2026 Joey Yandle <xoloki@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+#include <jlib/crypt/crypt.hh>
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace jlib::crypt;
+
+int main(int argc, char** argv) {
+    // the data layer only needs gpgme itself, not an engine
+    gpgme_check_version(0);
+
+    // a few chunks and then some, with every byte value in it
+    std::string text;
+    for(std::size_t i = 0; i < 300000; i++) {
+        text.push_back(char(i * 7 + i / 256));
+    }
+
+    // stringstream into memory data and back out to another
+    std::stringstream in(text);
+    gpg::data::ptr mem = gpg::data::create();
+    if(mem->write(in) != text.size()) {
+        std::cerr << "crypt_gpg_data_test: write(std::istream&) came up short" << std::endl;
+        return 1;
+    }
+    mem->rewind();
+    std::stringstream out;
+    if(mem->read(out) != text.size() || out.str() != text) {
+        std::cerr << "crypt_gpg_data_test: memory data didn't round trip a stringstream" << std::endl;
+        return 1;
+    }
+
+    // data over streams: gpgme reads from one and writes to the other
+    std::stringstream source(text);
+    std::stringstream sink;
+    gpg::data::ptr reader = gpg::data::create_reader(source);
+    gpg::data::ptr writer = gpg::data::create_writer(sink);
+    std::stringstream through;
+    if(reader->read(through) != text.size() || through.str() != text) {
+        std::cerr << "crypt_gpg_data_test: reading a stream through data is wrong" << std::endl;
+        return 1;
+    }
+    if(writer->write(through) != text.size() || sink.str() != text) {
+        std::cerr << "crypt_gpg_data_test: writing a stream through data is wrong" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
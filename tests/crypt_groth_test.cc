@@ -19,6 +19,7 @@
  */
 
 #include <jlib/crypt/groth.hh>
+#include <jlib/math/parallel.hh>
 
 #include <chrono>
 
@@ -47,6 +48,21 @@ int main(int argc, char** argv) {
             std::cerr << "groth BinaryProof with m=1 should verify" << std::endl;
             return -1;
         }
+
+        std::vector<BinaryProof> proofs;
+        for(int i = 0; i < 16; i++) {
+            proofs.push_back(prove(i % 2 ? m1 : m0, Scalar::random()));
+        }
+        if(!verify_batch(proofs).empty()) {
+            std::cerr << "groth BinaryProof batch should verify" << std::endl;
+            return -1;
+        }
+
+        proofs[9] = proof;
+        if(verify_batch(proofs) != std::vector<std::size_t>{ 9 }) {
+            std::cerr << "groth BinaryProof batch should fail at 9" << std::endl;
+            return -1;
+        }
     }
     {
         std::vector<Commitment> cs;
@@ -117,6 +133,28 @@ int main(int argc, char** argv) {
         }
     }
 
+    // the same proof made on several threads
+    {
+        std::vector<Commitment> cs;
+        Scalar r = Scalar::random();
+        for(int i = 0; i < 700; i++) {
+            cs.push_back(i == 613 ? Commitment(Scalar::zero(), r) : Commitment(Scalar::random()));
+        }
+
+        const unsigned int threads = jlib::math::get_threads();
+        const std::size_t threshold = jlib::math::get_parallel_threshold();
+        jlib::math::set_threads(4);
+        jlib::math::set_parallel_threshold(0);
+        ZeroProof proof = prove(cs, 613, r);
+        jlib::math::set_threads(threads);
+        jlib::math::set_parallel_threshold(threshold);
+
+        if(!verify(proof)) {
+            std::cerr << "groth ZeroProof made on 4 threads didn't verify" << std::endl;
+            return -1;
+        }
+    }
+
     
     return 0;
 }
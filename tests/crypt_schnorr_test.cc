@@ -69,6 +69,31 @@ int main(int argc, char** argv) {
         std::cerr << "schnorr proof<3> didn't verify" << std::endl;
         return -1;
     } 
+
+    std::vector<Proof> proofs;
+    std::vector<DoubleProof> dps;
+    for(int i = 0; i < 20; i++) {
+        x = Scalar::random();
+        proofs.push_back(prove(G, x * G, x));
+
+        s = Scalar::random();
+        t = Scalar::random();
+        dps.push_back(prove(dp.g * s + dp.h * t, s, t));
+    }
+
+    if(!verify_batch(proofs).empty() || !verify_batch(dps).empty()) {
+        std::cerr << "schnorr batch didn't verify" << std::endl;
+        return -1;
+    }
+
+    proofs[4].r = Scalar::random();
+    proofs[11].y = proofs[12].y;
+    dps[19].u = dps[0].u;
+    if(verify_batch(proofs) != std::vector<std::size_t>{ 4, 11 } ||
+       verify_batch(dps) != std::vector<std::size_t>{ 19 }) {
+        std::cerr << "schnorr batch didn't find the bad proofs" << std::endl;
+        return -1;
+    }
     
     return 0;
 }
@@ -0,0 +1,257 @@
+/* -*- mode: C++ c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2026 Joey Yandle <xoloki@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+#include <jlib/math/fixed.hh>
+#include <jlib/math/Plot.hh>
+
+#include "allocations.hh"
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <cmath>
+#include <cstdlib>
+
+using namespace jlib::math;
+
+std::default_random_engine generator;
+
+template<typename T>
+matrix<T> random_matrix(uint m, uint n) {
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    matrix<T> ret(m, n);
+    ret.foreach([&](T& x) {
+            x = dist(generator);
+        });
+    return ret;
+}
+
+// records what it would have drawn, and can draw through matrix instead
+class recorder : public Plot<double> {
+public:
+    recorder(uint n)
+        : Plot<double>(n, clip(n), 400, 400)
+    {
+        fixed_transform = true;
+        cuboid<double> object(n);
+        add(object);
+    }
+
+    static std::vector< std::pair<double,double> > clip(uint n) {
+        std::vector< std::pair<double,double> > ret(2, std::make_pair(-3.0, 3.0));
+        for(uint i = 2; i < n; i++) {
+            ret.push_back(std::make_pair(1.5, 4.5));
+        }
+        return ret;
+    }
+
+    void draw_matrix() {
+        dispatch(std::integral_constant<uint,0>());
+    }
+
+    void add_cuboid() {
+        cuboid<double> object(D);
+        add(object);
+    }
+
+    virtual void draw_point(std::pair<uint,uint> p) {
+        drawn.push_back(p);
+    }
+
+    virtual void draw_line(std::pair<uint,uint> p1, std::pair<uint,uint> p2) {
+        drawn.push_back(p1);
+        drawn.push_back(p2);
+    }
+
+    std::vector< std::pair<uint,uint> > drawn;
+};
+
+// overrides transform without knowing about fixed_transform
+class counter : public Plot<double> {
+public:
+    counter(uint n)
+        : Plot<double>(n, recorder::clip(n), 400, 400),
+          calls(0)
+    {
+        cuboid<double> object(n);
+        add(object);
+    }
+
+    virtual void draw_point(std::pair<uint,uint>) {}
+    virtual void draw_line(std::pair<uint,uint>, std::pair<uint,uint>) {}
+
+    mutable uint calls;
+
+protected:
+    virtual vertex<double> transform(const vertex<double>& v) const {
+        calls++;
+        return Plot<double>::transform(v);
+    }
+};
+
+bool check_product() {
+    matrix<double> a = random_matrix<double>(5, 5);
+    matrix<double> b = random_matrix<double>(5, 3);
+
+    fixed_matrix<double,5,5> fa(a);
+    fixed_matrix<double,5,3> fb(b);
+    matrix<double> got = fa * fb;
+    matrix<double> expected = a * b;
+
+    for(uint i = 0; i < 5; i++) {
+        for(uint j = 0; j < 3; j++) {
+            if(std::abs(got(i,j) - expected(i,j)) > 1e-12) {
+                std::cerr << "math_fixed_test: product (" << i << "," << j << ") is "
+                          << got(i,j) << " expected " << expected(i,j) << std::endl;
+                return false;
+            }
+        }
+    }
+
+    try {
+        fixed_matrix<double,4,4> wrong(a);
+        std::cerr << "math_fixed_test: 5x5 matrix converted to fixed_matrix<4,4>" << std::endl;
+        return false;
+    } catch(matrix<double>::mismatched&) {
+    }
+
+    return true;
+}
+
+// the same scene through fixed_matrix and through matrix
+bool check_plot(uint n) {
+    recorder fixed(n);
+    recorder dynamic(n);
+    for(uint i = 0; i < n; i++) {
+        for(uint j = i + 1; j < n; j++) {
+            plane p; p.i = i; p.j = j;
+            fixed * matrix<double>::rotate(n, p, 0.1 * (i + 1) + 0.03 * j);
+            dynamic * matrix<double>::rotate(n, p, 0.1 * (i + 1) + 0.03 * j);
+        }
+    }
+
+    fixed.draw();
+    dynamic.draw_matrix();
+
+    if(fixed.drawn.size() != dynamic.drawn.size()) {
+        std::cerr << "math_fixed_test: " << n << "d drew " << fixed.drawn.size()
+                  << " points, expected " << dynamic.drawn.size() << std::endl;
+        return false;
+    }
+
+    for(uint i = 0; i < fixed.drawn.size(); i++) {
+        // the fixed path multiplies projection by modelview once, so allow rounding to move a pixel
+        const int dx = int(fixed.drawn[i].first) - int(dynamic.drawn[i].first);
+        const int dy = int(fixed.drawn[i].second) - int(dynamic.drawn[i].second);
+        if(std::abs(dx) > 1 || std::abs(dy) > 1) {
+            std::cerr << "math_fixed_test: " << n << "d point " << i << " is (" << fixed.drawn[i].first << ","
+                      << fixed.drawn[i].second << ") expected (" << dynamic.drawn[i].first << ","
+                      << dynamic.drawn[i].second << ")" << std::endl;
+            return false;
+        }
+    }
+
+    // what a frame allocates must not depend on how many vertices it has
+    allocator::set_pooling(false);
+    fixed.drawn.reserve(1 << 16);
+
+    std::size_t before = allocations() + allocator::system_allocations();
+    fixed.draw();
+    const std::size_t one = allocations() + allocator::system_allocations() - before;
+
+    fixed.add_cuboid();
+    fixed.add_cuboid();
+    fixed.draw();
+
+    before = allocations() + allocator::system_allocations();
+    fixed.draw();
+    const std::size_t three = allocations() + allocator::system_allocations() - before;
+    allocator::set_pooling(true);
+
+    if(three != one) {
+        std::cerr << "math_fixed_test: " << n << "d frame allocates " << one << " times for one cuboid, "
+                  << three << " for three" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+// draw() calls an overridden transform for every vertex, in any dimension
+bool check_override() {
+    for(uint n = 2; n <= 12; n++) {
+        counter c(n);
+        c.draw();
+        if(c.calls != (1u << n)) {
+            std::cerr << "math_fixed_test: " << n << "d transform called " << c.calls
+                      << " times for " << (1u << n) << " vertices" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool check_assign() {
+    // a whole column carries its homogeneous coordinate over
+    fixed_matrix<double,4,1> full;
+    full(0,0) = 2; full(1,0) = 4; full(2,0) = 6; full(3,0) = 2;
+    fixed_vertex<double,3> v;
+    v = full;
+    if(v[0] != 2 || v[1] != 4 || v[2] != 6 || v[3] != 2) {
+        std::cerr << "math_fixed_test: assigned (2,4,6,2), got (" << v[0] << "," << v[1]
+                  << "," << v[2] << "," << v[3] << ")" << std::endl;
+        return false;
+    }
+    v.normalize();
+    if(v[0] != 1 || v[1] != 2 || v[2] != 3 || v[3] != 1) {
+        std::cerr << "math_fixed_test: (2,4,6,2) normalized to (" << v[0] << "," << v[1]
+                  << "," << v[2] << "," << v[3] << ")" << std::endl;
+        return false;
+    }
+
+    // a shorter one leaves the rest alone, as vertex<T> does
+    fixed_matrix<double,2,1> part;
+    part(0,0) = 5; part(1,0) = 7;
+    fixed_vertex<double,3> w;
+    w[2] = 9; w[3] = 3;
+    w = part;
+    if(w[0] != 5 || w[1] != 7 || w[2] != 9 || w[3] != 3) {
+        std::cerr << "math_fixed_test: assigned (5,7) over (.,.,9,3), got (" << w[0] << "," << w[1]
+                  << "," << w[2] << "," << w[3] << ")" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    constexpr fixed_matrix<double,4,4> identity = fixed_matrix<double,4,4>::identity();
+    static_assert(identity(3,3) == 1 && identity(0,3) == 0, "identity is not constant");
+
+    if(!check_product() || !check_assign() || !check_override())
+        return 1;
+
+    for(uint n = 2; n <= 7; n++) {
+        if(!check_plot(n))
+            return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,339 @@
+/* -*- mode: C++ c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2026 Joey Yandle <xoloki@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <cmath>
+
+#include <jlib/math/matrix.hh>
+
+using jlib::math::matrix;
+namespace kernel = jlib::math::kernel;
+
+std::default_random_engine generator;
+
+template<typename T>
+matrix<T> random_matrix(uint m, uint n) {
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    matrix<T> ret(m, n);
+    ret.foreach([&](T& x) {
+            x = dist(generator);
+        });
+    return ret;
+}
+
+// the old operator*, through the bounds and transpose aware accessor
+template<typename T>
+matrix<T> naive(const matrix<T>& a, const matrix<T>& b) {
+    matrix<T> ret(a.M, b.N);
+    for(uint j = 0; j < b.N; j++) {
+        for(uint i = 0; i < a.M; i++) {
+            T sum = 0;
+            for(uint k = 0; k < a.N; k++) {
+                sum += a(i,k) * b(k,j);
+            }
+            ret(i,j) = sum;
+        }
+    }
+    return ret;
+}
+
+template<typename T>
+bool close(const matrix<T>& x, const matrix<T>& y, uint k, T eps) {
+    for(uint i = 0; i < x.M; i++) {
+        for(uint j = 0; j < x.N; j++) {
+            if(std::abs(x(i,j) - y(i,j)) > eps * k) {
+                std::cerr << "element (" << i << "," << j << ") is " << x(i,j) << " expected " << y(i,j) << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template<typename T>
+bool check(uint m, uint n, uint k, T eps) {
+    matrix<T> a = random_matrix<T>(m, k);
+    matrix<T> at = random_matrix<T>(k, m);
+    matrix<T> b = random_matrix<T>(k, n);
+    matrix<T> bt = random_matrix<T>(n, k);
+
+    if(!close(a * b, naive(a, b), k, eps) ||
+       !close(at.transpose() * b, naive(at.transpose(), b), k, eps) ||
+       !close(a * bt.transpose(), naive(a, bt.transpose()), k, eps) ||
+       !close(at.transpose() * bt.transpose(), naive(at.transpose(), bt.transpose()), k, eps)) {
+        std::cerr << "math_gemm_test: " << kernel::name(kernel::get_isa()) << " product of ["
+                  << m << "," << k << "] * [" << k << "," << n << "] is wrong" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+// the parallel split must not change a single bit of the result
+template<typename T>
+bool check_threads(uint m, uint n, uint k) {
+    matrix<T> a = random_matrix<T>(m, k);
+    matrix<T> b = random_matrix<T>(k, n);
+    matrix<T> bt = random_matrix<T>(n, k);
+
+    jlib::math::set_threads(1);
+    matrix<T> serial = a * b, serialt = a * bt.transpose(), serialh = (a ^ a) - a.transpose().transpose() * T(2);
+
+    jlib::math::set_threads(4);
+    matrix<T> par = a * b, part = a * bt.transpose(), parh = (a ^ a) - a.transpose().transpose() * T(2);
+    jlib::math::set_threads(1);
+
+    if(par != serial || part != serialt || parh != serialh) {
+        std::cerr << "math_gemm_test: threaded product of ["
+                  << m << "," << k << "] * [" << k << "," << n << "] differs from serial" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+// strassen trades some accuracy for speed, so it only has to be close
+template<typename T>
+bool check_strassen(uint m, uint n, uint k, T eps) {
+    matrix<T> a = random_matrix<T>(m, k);
+    matrix<T> bt = random_matrix<T>(n, k);
+
+    if(!close(strassen(a, bt.transpose()), naive(a, bt.transpose()), k, eps) ||
+       !close(strassen(bt, a.transpose()), naive(bt, a.transpose()), k, eps)) {
+        std::cerr << "math_gemm_test: strassen product of ["
+                  << m << "," << k << "] * [" << k << "," << n << "] is wrong" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+// the fused training update against the same thing spelled out element by element
+template<typename T>
+bool check_fused(uint m, uint n, uint k, T eps) {
+    matrix<T> e = random_matrix<T>(m, k);
+    matrix<T> o = random_matrix<T>(m, k);
+    matrix<T> h = random_matrix<T>(n, k);
+    matrix<T> w = random_matrix<T>(m, n);
+    const double rate = 0.1;
+
+    matrix<T> d(m, k);
+    for(uint i = 0; i < m; i++) {
+        for(uint j = 0; j < k; j++) {
+            d(i,j) = e(i,j) * o(i,j) * (T(1) - o(i,j));
+        }
+    }
+    matrix<T> expected = naive(d, h.transpose());
+    for(uint i = 0; i < m; i++) {
+        for(uint j = 0; j < n; j++) {
+            expected(i,j) = w(i,j) + T(rate) * expected(i,j);
+        }
+    }
+
+    w += rate * ((e ^ o ^ (1.0 - o)) * h.transpose());
+
+    // mixed layouts fall back to the indexed walk
+    matrix<T> et = random_matrix<T>(k, m);
+    matrix<T> mixed = (et.transpose() - e) * T(2) + 1.0;
+    matrix<T> acc(k, m);
+    acc += e.transpose() ^ o.transpose();
+
+    for(uint i = 0; i < m; i++) {
+        for(uint j = 0; j < k; j++) {
+            if(mixed(i,j) != (et(j,i) - e(i,j)) * T(2) + T(1) || acc(j,i) != e(i,j) * o(i,j)) {
+                std::cerr << "math_gemm_test: mixed layout expression is wrong" << std::endl;
+                return false;
+            }
+        }
+    }
+
+    if(!close(w, expected, k, eps)) {
+        std::cerr << "math_gemm_test: fused update of [" << m << "," << n << "] is wrong" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+// the in-place forms must write through to the caller's storage
+bool check_inplace() {
+    matrix<double> a = random_matrix<double>(40, 30);
+    matrix<double> b = random_matrix<double>(50, 30);
+    matrix<double> c = random_matrix<double>(40, 50);
+    matrix<double> ct = random_matrix<double>(50, 40).transpose();
+    const double* storage = c.data();
+
+    matrix<double> expected = naive(a, b.transpose());
+    for(uint i = 0; i < c.M; i++) {
+        for(uint j = 0; j < c.N; j++) {
+            expected(i,j) = 2 * expected(i,j) + 0.5 * c(i,j);
+        }
+    }
+
+    jlib::math::gemm(2.0, a, jlib::math::NOTRANS, b, jlib::math::TRANS, 0.5, c);
+    jlib::math::gemm(1.0, a.transpose(), jlib::math::TRANS, b.transpose(), jlib::math::NOTRANS, 0.0, ct);
+    if(c.data() != storage || !close(c, expected, 30, 1e-13) || !close(ct, naive(a, b.transpose()), 30, 1e-13)) {
+        std::cerr << "math_gemm_test: in-place gemm is wrong" << std::endl;
+        return false;
+    }
+
+    matrix<double> x = random_matrix<double>(40, 50);
+    matrix<double> y = random_matrix<double>(40, 50);
+    matrix<double> y0 = y * 1.0;
+    jlib::math::axpy(-3.0, x, y);
+    jlib::math::hadamard_into(x, y, y);
+    jlib::math::scale_inplace(y, 0.25);
+    for(uint i = 0; i < y.M; i++) {
+        for(uint j = 0; j < y.N; j++) {
+            if(std::abs(y(i,j) - 0.25 * x(i,j) * (y0(i,j) - 3.0 * x(i,j))) > 1e-13) {
+                std::cerr << "math_gemm_test: axpy/hadamard_into/scale_inplace are wrong" << std::endl;
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// a product accumulated into one of its own operands, directly or through
+// a transposed view of the same storage
+bool check_alias(uint n) {
+    matrix<double> e = random_matrix<double>(n, n);
+    matrix<double> o = random_matrix<double>(n, n);
+    matrix<double> d = e ^ o;
+    matrix<double> c = random_matrix<double>(n, n);
+    matrix<double> c0 = c * 1.0;
+
+    c += (e ^ o) * c;
+    matrix<double> expected = c0 + naive(d, c0);
+    if(!close(c, expected, n, 1e-12)) {
+        std::cerr << "math_gemm_test: c += x * c of [" << n << "," << n << "] is wrong" << std::endl;
+        return false;
+    }
+
+    c0 = c * 1.0;
+    c -= (e ^ o) * c.transpose();
+    expected = c0 - naive(d, c0.transpose());
+    if(!close(c, expected, n, 1e-12)) {
+        std::cerr << "math_gemm_test: c -= x * c^T of [" << n << "," << n << "] is wrong" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+// products and nodes mixed the ways plain matrices always could be
+bool check_mixed(uint n) {
+    matrix<double> a = random_matrix<double>(n, n);
+    matrix<double> b = random_matrix<double>(n, n);
+    matrix<double> c = random_matrix<double>(n, n);
+    matrix<double> p = naive(matrix<double>(a ^ b), c);
+    matrix<double> s = a + b;
+
+    matrix<double> x = (a ^ b) * c + c;
+    matrix<double> y = c * ((a ^ b) * c);
+    matrix<double> z = 2.0 * ((a ^ b) * c) - 1.0;
+    if(!close(x, matrix<double>(p + c), n, 1e-12) || !close(y, naive(c, p), n * n, 1e-12) ||
+       !close(z, matrix<double>(2.0 * p - 1.0), n, 1e-12)) {
+        std::cerr << "math_gemm_test: nested product of [" << n << "," << n << "] is wrong" << std::endl;
+        return false;
+    }
+
+    matrix<double> t = (a + b).transpose();
+    if(t.M != n || t.N != n || t != s.transpose() || (a + b) != s || !(s == a + b) ||
+       (a + b) != (b + a) || ((a ^ b) * c) == c) {
+        std::cerr << "math_gemm_test: transpose or == of a node of [" << n << "," << n << "] is wrong" << std::endl;
+        return false;
+    }
+
+    // the node keeps a temporary operand alive
+    auto lazy = matrix<double>(n, n) + a;
+    matrix<double> filler = random_matrix<double>(n, n);
+    if(matrix<double>(lazy) != a) {
+        std::cerr << "math_gemm_test: node outlived its operand" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv) {
+    // shapes straddle the register tiles, the cache blocks and the small product cutoff
+    const uint shapes[][3] = {
+        { 1, 1, 1 }, { 4, 4, 4 }, { 5, 5, 5 }, { 33, 17, 65 }, { 64, 64, 64 },
+        { 97, 101, 103 }, { 300, 7, 530 }, { 7, 300, 530 }, { 784, 3, 100 }, { 200, 1, 784 }, { 1, 300, 200 },
+    };
+
+    for(int i = kernel::SCALAR; i <= kernel::detect(); i++) {
+        kernel::set_isa(static_cast<kernel::isa>(i));
+
+        for(auto& s : shapes) {
+            if(!check<double>(s[0], s[1], s[2], 1e-13) || !check<float>(s[0], s[1], s[2], 1e-5f))
+                return 1;
+        }
+    }
+
+    // split even small products so the thread pool actually gets exercised
+    jlib::math::set_parallel_threshold(1);
+    const uint threaded[][3] = {
+        { 97, 101, 103 }, { 500, 300, 70 }, { 1300, 1, 200 }, { 1, 1300, 200 }, { 2000, 2, 50 },
+    };
+    for(auto& s : threaded) {
+        if(!check_threads<double>(s[0], s[1], s[2]) || !check_threads<float>(s[0], s[1], s[2]))
+            return 1;
+    }
+
+    // a tiny cutoff forces several levels of recursion and padding
+    kernel::set_strassen_cutoff(16);
+    const uint fast[][3] = {
+        { 8, 8, 8 }, { 64, 64, 64 }, { 100, 100, 100 }, { 67, 45, 131 }, { 200, 17, 33 },
+    };
+    for(auto& s : fast) {
+        if(!check_strassen<double>(s[0], s[1], s[2], 1e-12) || !check_strassen<float>(s[0], s[1], s[2], 1e-4f))
+            return 1;
+    }
+
+    if(!check_fused<double>(50, 30, 20, 1e-13) || !check_fused<float>(70, 1, 300, 1e-5f) ||
+       !check_fused<double>(200, 784, 1, 1e-13))
+        return 1;
+
+    if(!check_inplace())
+        return 1;
+
+    if(!check_alias(5) || !check_alias(97))
+        return 1;
+
+    if(!check_mixed(5) || !check_mixed(64))
+        return 1;
+
+    // integer products go through the generic kernel and must be exact
+    matrix<int> a(70, 40), b(40, 50);
+    a.foreach_index([](uint r, uint c, int& x) { x = int(r) - int(c); });
+    b.foreach_index([](uint r, uint c, int& x) { x = int(r * c % 7) - 3; });
+    if(a * b != naive(a, b)) {
+        std::cerr << "math_gemm_test: integer product is wrong" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
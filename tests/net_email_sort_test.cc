@@ -0,0 +1,61 @@
+#include <iostream>
+#include <algorithm>
+#include <vector>
+
+#include <jlib/net/Email.hh>
+
+std::string order(const std::vector<jlib::net::Email>& mails) {
+    std::string s;
+    for(unsigned int i = 0; i < mails.size(); i++) {
+        s += mails[i]["SUBJECT"];
+    }
+    return s;
+}
+
+int main(int argc, char** argv) {
+    const char* raw[] = {
+        "Date: Mon, 29 Oct 2001 00:59:52 -0800\nSubject: b\n\nsecond\n",
+        "Date: Tue, 30 Oct 2001 08:15:00 -0800\nSubject: c\n\nthird\n",
+        "Date: Sun, 28 Oct 2001 23:01:10 -0800\nSubject: a\n\nfirst\n",
+    };
+
+    std::vector<jlib::net::Email> mails;
+    for(unsigned int i = 0; i < 3; i++) {
+        mails.push_back(jlib::net::Email(raw[i]));
+        mails.back().set_data_size(10 - i);
+    }
+
+    std::sort(mails.begin(), mails.end());
+    if(order(mails) != "abc") {
+        std::cerr << "sorted by DATE to " << order(mails) << std::endl;
+        return 1;
+    }
+
+    // the key follows the header
+    mails[0].set("Date", "Wed, 31 Oct 2001 12:00:00 -0800");
+    std::sort(mails.begin(), mails.end());
+    if(order(mails) != "bca") {
+        std::cerr << "sorted by changed DATE to " << order(mails) << std::endl;
+        return 1;
+    }
+
+    for(unsigned int i = 0; i < mails.size(); i++) {
+        mails[i].sort("SIZE");
+    }
+    std::sort(mails.begin(), mails.end());
+    if(order(mails) != "acb") {
+        std::cerr << "sorted by SIZE to " << order(mails) << std::endl;
+        return 1;
+    }
+
+    for(unsigned int i = 0; i < mails.size(); i++) {
+        mails[i].sort("SUBJECT");
+    }
+    std::sort(mails.begin(), mails.end());
+    if(order(mails) != "abc") {
+        std::cerr << "sorted by SUBJECT to " << order(mails) << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
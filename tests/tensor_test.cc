@@ -19,8 +19,12 @@
  */
 
 #include <iostream>
+#include <random>
 #include <sstream>
 #include <string>
+#include <vector>
+
+#include <cmath>
 
 #include <jlib/math/tensor.hh>
 #include <jlib/util/util.hh>
@@ -29,6 +33,121 @@ using namespace jlib::math;
 
 typedef double T;
 
+std::default_random_engine generator;
+
+tensor<T> random_tensor(const std::vector<unsigned int>& shape) {
+    std::uniform_real_distribution<T> dist(-1.0, 1.0);
+    tensor<T> ret(shape);
+    T* p = ret.data();
+    for(std::size_t i = 0; i < ret.elements(); i++) {
+        p[i] = dist(generator);
+    }
+    return ret;
+}
+
+// a[i,j,k] b[k,l,j] summed over j and k, against the obvious loops, for a
+// dense b and for b as a transposed view that has to be copied for gemm
+bool check_contract() {
+    tensor<T> a = random_tensor({ 3, 4, 5 });
+    tensor<T> b = random_tensor({ 5, 6, 4 });
+    tensor<T> bt = random_tensor({ 4, 6, 5 }).transpose();
+
+    for(const tensor<T>* x : { &b, &bt }) {
+        tensor<T> c = contract(a, *x, { { 1, 2 }, { 2, 0 } });
+        if(c.rank() != 2 || c.size(0) != 3 || c.size(1) != 6) {
+            std::cerr << "tensor_test: contraction has the wrong shape" << std::endl;
+            return false;
+        }
+
+        for(unsigned int i = 0; i < 3; i++) {
+            for(unsigned int l = 0; l < 6; l++) {
+                T expected = 0;
+                for(unsigned int j = 0; j < 4; j++) {
+                    for(unsigned int k = 0; k < 5; k++) {
+                        expected += a.at(i, j, k) * x->at(k, l, j);
+                    }
+                }
+                if(std::abs(c.at(i, l) - expected) > 1e-12) {
+                    std::cerr << "tensor_test: contraction (" << i << "," << l << ") is "
+                              << c.at(i, l) << " expected " << expected << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+
+    // the outer product of two vectors
+    tensor<T> u = random_tensor({ 3 });
+    tensor<T> v = random_tensor({ 4 });
+    tensor<T> uv = u * v;
+    if(uv.rank() != 2 || std::abs(uv.at(2, 3) - u.at(2) * v.at(3)) > 1e-15) {
+        std::cerr << "tensor_test: outer product is wrong" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+// a batch of inputs as one rank 3 tensor against one column matrix per sample
+bool check_batch() {
+    const unsigned int batch = 7, in = 20, out = 9;
+    matrix<T> w(out, in);
+    w.foreach([](T& x) { x = std::uniform_real_distribution<T>(-1.0, 1.0)(generator); });
+
+    tensor<T> inputs = random_tensor({ batch, in, 1 });
+    tensor<T> outputs = contract(tensor<T>(w), inputs, { { 1, 1 } });
+
+    for(unsigned int s = 0; s < batch; s++) {
+        matrix<T> expected = w * inputs[s].to_matrix();
+        for(unsigned int i = 0; i < out; i++) {
+            if(std::abs(outputs.at(i, s, 0) - expected(i, 0)) > 1e-12) {
+                std::cerr << "tensor_test: sample " << s << " output " << i << " is "
+                          << outputs.at(i, s, 0) << " expected " << expected(i, 0) << std::endl;
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool check_views() {
+    tensor<T> a = random_tensor({ 2, 3, 4 });
+
+    // slices and transposes share storage
+    tensor<T> s = a[1];
+    s.at(2, 3) = 42;
+    if(a.at(1, 2, 3) != 42 || a.transpose().at(3, 2, 1) != 42) {
+        std::cerr << "tensor_test: slice is not a view" << std::endl;
+        return false;
+    }
+
+    // a row broadcast down every row
+    tensor<T> row = random_tensor({ 4 });
+    tensor<T> sum = a + row;
+    if(sum.rank() != 3 || sum.at(1, 1, 2) != a.at(1, 1, 2) + row.at(2)) {
+        std::cerr << "tensor_test: broadcast sum is wrong" << std::endl;
+        return false;
+    }
+
+    // matrices go in and out without a copy
+    matrix<T> m(3, 4);
+    m(2, 1) = 5;
+    tensor<T> t(m);
+    if(t.at(2, 1) != 5 || t.to_matrix().data() != m.data() ||
+       tensor<T>(m.transpose()).at(1, 2) != 5 || t.transpose().to_matrix()(1, 2) != 5) {
+        std::cerr << "tensor_test: matrix round trip is wrong" << std::endl;
+        return false;
+    }
+
+    if(a.transpose().reshape({ 24 }).contiguous() != true || a.reshape({ 4, 6 }).data() != a.data()) {
+        std::cerr << "tensor_test: reshape is wrong" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
 int main(int argc, char** argv) {
     tensor<T> scalar(0);
     tensor<T> vector(1, 5);
@@ -51,6 +170,9 @@ int main(int argc, char** argv) {
         return 1;
     }
 
+    if(!check_contract() || !check_batch() || !check_views())
+        return 1;
+
     return 0;
 }
 
@@ -0,0 +1,108 @@
+#include <iostream>
+#include <sstream>
+
+#include <jlib/util/Date.hh>
+
+#include <cstdlib>
+#include <cstring>
+
+using namespace jlib::util;
+
+// the fast path and auto_parse give the same time for dates they both read
+bool same(const std::string& s) {
+    Date fast;
+    fast.set(s);
+
+    Date slow;
+    std::memset(slow.stm(), 0, sizeof(struct tm));
+    std::istringstream is(s);
+    slow.auto_parse(is);
+    slow.reinit();
+
+    if(fast.time() != slow.time()) {
+        std::cerr << "error: '" << s << "' parsed to " << fast.time()
+                  << ", auto_parse gave " << slow.time() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool check(const std::string& s, int year, int mon, int mday, int hour, int min, int sec, int offset) {
+    struct tm t;
+    int tz = -1;
+    if(!Date::parse(s, &t, &tz)) {
+        std::cerr << "error: Date::parse rejected '" << s << "'" << std::endl;
+        return false;
+    }
+    if(t.tm_year != year - 1900 || t.tm_mon != mon || t.tm_mday != mday ||
+       t.tm_hour != hour || t.tm_min != min || t.tm_sec != sec || tz != offset) {
+        std::cerr << "error: Date::parse('" << s << "') gave " << t.tm_year + 1900 << "/"
+                  << t.tm_mon << "/" << t.tm_mday << " " << t.tm_hour << ":" << t.tm_min
+                  << ":" << t.tm_sec << " " << tz << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if(!check("Mon, 5 Jan 2004 12:34:56 -0500", 2004, 0, 5, 12, 34, 56, -300) ||
+       !check("  Tue, 30 Nov 1999 23:59:59 +0530 (IST)\r\n", 1999, 10, 30, 23, 59, 59, 330) ||
+       !check("fri, 01 MAR 2019 08:00 GMT", 2019, 2, 1, 8, 0, 0, 0) ||
+       !check("1 Jul 2010 00:00:01 PDT", 2010, 6, 1, 0, 0, 1, -420) ||
+       !check("Sun, 9 Sep 01 01:46:40 (comment (nested))", 2001, 8, 9, 1, 46, 40, 0) ||
+       !check("Mon Jan  5 12:34:56 2004", 2004, 0, 5, 12, 34, 56, 0) ||
+       !check("Thu Jan  1 00:00:00 +0000 1970", 1970, 0, 1, 0, 0, 0, 0) ||
+       !check("Sat Feb 29 10:00:00 2020 CET", 2020, 1, 29, 10, 0, 0, 60))
+        exit(1);
+
+    const char* bad[] = {
+        "", "Monday, 5 Jan 2004 12:34:56", "5 January 2004 12:34:56",
+        "Mon, 5 Jan 2004 12:34:56 -05", "Mon, 5 Jan 2004 25:00:00",
+        "Mon, 32 Jan 2004 12:00:00", "Mon, 5 Jan 2004 12:34:56 XYZ",
+        "Mon, 5 Jan 2004 12:34:56 (open", "2004-01-05T12:34:56Z", "Mon Jan 5 2004"
+    };
+    for(unsigned int i=0; i<sizeof(bad)/sizeof(bad[0]); i++) {
+        struct tm t;
+        if(Date::parse(bad[i], &t)) {
+            std::cerr << "error: Date::parse accepted '" << bad[i] << "'" << std::endl;
+            exit(1);
+        }
+    }
+
+    int offset;
+    if(!Date::find_zone("edt", &offset) || offset != -240 ||
+       !Date::find_zone("UTC", &offset) || offset != 0 ||
+       !Date::find_zone("NZDT", &offset) || offset != 780 ||
+       Date::find_zone("EDTX", &offset) || Date::find_zone("", &offset)) {
+        std::cerr << "error: in jlib::util::Date::find_zone" << std::endl;
+        exit(1);
+    }
+
+    // every name in the table is found, so it is still sorted
+    std::map<std::string,int> vals = Date::create_tz_vals();
+    for(std::map<std::string,int>::iterator i = vals.begin(); i != vals.end(); i++) {
+        if(!Date::find_zone(i->first, &offset) || offset / 60 != i->second) {
+            std::cerr << "error: zone " << i->first << " not found" << std::endl;
+            exit(1);
+        }
+    }
+
+    if(!same("Mon, 5 Jan 2004 12:34:56 -0500") ||
+       !same("Tue, 30 Nov 1999 23:59:59 EST") ||
+       !same("1 Jul 2010 06:07:08 +0000 (UTC)") ||
+       !same("Mon Jan  5 12:34:56 2004"))
+        exit(1);
+
+    // long names aren't on the fast path, but set still reads them
+    Date fallback;
+    fallback.set("Monday, January 5 2004 12:34:56");
+    Date fast;
+    fast.set("Mon, 5 Jan 2004 12:34:56");
+    if(fallback.time() != fast.time()) {
+        std::cerr << "error: auto_parse fallback gave " << fallback.time()
+                  << ", expected " << fast.time() << std::endl;
+        exit(1);
+    }
+
+    return 0;
+}